@@ -0,0 +1,50 @@
+/**
+ * Standalone branch prediction simulator
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include "runner.h"
+
+#include <infra/config/config.h>
+#include <infra/config/main_wrapper.h>
+
+#include <iostream>
+#include <sstream>
+
+namespace config {
+    static const AliasedRequiredValue<std::string> file = { "t", "tracename", "file name with branch trace"};
+    static const AliasedValue<std::string> configs = { "c", "configs", "", "space-separated predictor configurations 'mode[:option=value,...]', options are 'bp-*' ones without the prefix; 'bp-mode' is used if empty"};
+    static const Value<uint32> threads = { "threads", 1, "Number of host threads simulating configurations in parallel"};
+} // namespace config
+
+static std::vector<std::string> get_configs( const std::string& mode)
+{
+    std::vector<std::string> result;
+    std::istringstream iss( std::string( config::configs));
+    for ( std::string spec; iss >> spec;)
+        result.push_back( spec);
+
+    if ( result.empty())
+        result.push_back( mode);
+
+    return result;
+}
+
+class Main : public MainWrapper
+{
+    using MainWrapper::MainWrapper;
+private:
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays, modernize-avoid-c-arrays, hicpp-avoid-c-arrays)
+    int impl( int argc, const char* argv[]) const final {
+        config::handleArgs( argc, argv, 1);
+        const auto base = PerfConfig::create_configured().bp;
+        for ( const auto& result : BPRunner::run_parallel( config::file, get_configs( base.mode), base, config::threads))
+            std::cout << result;
+        return 0;
+    }
+};
+
+int main( int argc, const char* argv[])
+{
+    return Main( "MIPT-V Standalone branch prediction simulator.").run( argc, argv);
+}
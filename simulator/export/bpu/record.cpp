@@ -0,0 +1,57 @@
+/**
+ * Recorder of branch traces for standalone branch prediction simulator
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include "trace.h"
+
+#include <func_sim/func_sim.h>
+#include <infra/config/config.h>
+#include <infra/config/main_wrapper.h>
+#include <kernel/kernel.h>
+#include <memory/memory.h>
+
+#include <fstream>
+#include <iostream>
+
+namespace config {
+    static const AliasedRequiredValue<std::string> binary_filename = { "b", "binary", "input binary file"};
+    static const AliasedValue<uint64> num_steps = { "n", "numsteps", MAX_VAL64, "number of instructions to run"};
+    static const AliasedRequiredValue<std::string> output = { "o", "output", "output branch trace"};
+} // namespace config
+
+class Main : public MainWrapper
+{
+    using MainWrapper::MainWrapper;
+private:
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays, modernize-avoid-c-arrays, hicpp-avoid-c-arrays)
+    int impl( int argc, const char* argv[]) const final {
+        config::handleArgs( argc, argv, 1);
+        auto memory = FuncMemory::create_default_hierarchied_memory();
+
+        auto sim = BasicFuncSim::create_configured_simulator();
+        sim->set_memory( memory);
+        sim->write_csr_register( "mscratch", 0x400'0000);
+
+        auto kernel = Kernel::create_configured_kernel();
+        kernel->set_simulator( sim);
+        kernel->connect_memory( memory);
+        kernel->connect_exception_handler();
+        kernel->load_file( config::binary_filename);
+        sim->set_kernel( kernel);
+        sim->set_pc( kernel->get_start_pc());
+
+        std::ofstream out( config::output, std::ios::binary);
+        if ( !out)
+            throw InvalidBranchTrace( "cannot open " + std::string( config::output));
+
+        const auto jumps = record_branch_trace( sim.get(), config::num_steps, out);
+        std::cout << "recorded jumps: " << jumps << std::endl;
+        return sim->get_exit_code();
+    }
+};
+
+int main( int argc, const char* argv[])
+{
+    return Main( "MIPT-V branch trace recorder.").run( argc, argv);
+}
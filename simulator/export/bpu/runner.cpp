@@ -0,0 +1,204 @@
+/**
+ * Standalone branch prediction simulator
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include "runner.h"
+
+#include <infra/macro.h>
+#include <modules/fetch/bpu/bpu.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <thread>
+
+static void dump_jumps( std::ostream& out, std::string_view name, const BPRunnerResults::Jumps& jumps)
+{
+    out << name << " - " << ( jumps.get_misprediction_rate() * 100) << "% of " << jumps.jumps;
+}
+
+std::ostream& operator<<( std::ostream& out, const BPRunnerResults& rhs)
+{
+    out << rhs.name << ": ";
+    dump_jumps( out, "mispredictions", rhs.all);
+    out << ", ";
+    dump_jumps( out, "conditional", rhs.conditional);
+    out << ", ";
+    dump_jumps( out, "returns", rhs.returns);
+    out << ", ";
+    dump_jumps( out, "indirect", rhs.indirect);
+    return out << std::endl;
+}
+
+BPRunner::BPRunner( std::string name, const PerfConfig::BP& config)
+    : name( std::move( name))
+    , bp( BaseBP::create_bp( config, 32))
+{ }
+
+BPRunner::~BPRunner() = default;
+
+// Compare next PC, as Branch stage does
+static bool is_misprediction( const BPInterface& prediction, const BPInterface& record)
+{
+    const Addr fallthrough = record.pc + 4;
+    const Addr predicted = prediction.is_hit && prediction.is_taken ? prediction.target : fallthrough;
+    const Addr actual = record.is_taken ? record.target : fallthrough;
+    return predicted != actual;
+}
+
+void BPRunner::account( const BPInterface& record, BPRunnerResults* result)
+{
+    const auto prediction = bp->predict( record.pc);
+
+    // Keep speculative state checkpointed by prediction
+    BPInterface bp_upd = prediction;
+    bp_upd.pc = record.pc;
+    bp_upd.is_taken = record.is_taken;
+    bp_upd.target = record.target;
+    bp_upd.is_hit = true;
+    bp_upd.kind = record.kind;
+    bp->update( bp_upd);
+
+    const bool has_misprediction = is_misprediction( prediction, record);
+    if ( has_misprediction)
+        bp->repair( bp_upd);
+
+    auto* jumps = record.kind.is_conditional ? &result->conditional
+                : record.kind.is_return ? &result->returns
+                : record.kind.is_indirect ? &result->indirect
+                : nullptr;
+
+    for ( auto* counter : { &result->all, jumps }) {
+        if ( counter == nullptr)
+            continue;
+        ++counter->jumps;
+        if ( has_misprediction)
+            ++counter->mispredictions;
+    }
+}
+
+BPRunnerResults BPRunner::run( BranchTrace::Reader reader)
+{
+    BPRunnerResults result;
+    result.name = name;
+
+    BPInterface record;
+    while ( reader.read( &record))
+        account( record, &result);
+
+    return result;
+}
+
+std::vector<BPRunnerResults> BPRunner::run_parallel( const std::string& filename, const std::vector<std::string>& configs, const PerfConfig::BP& base, size_t threads)
+{
+    // Validate all configurations before the simulation
+    std::vector<std::unique_ptr<BPRunner>> runners;
+    for ( const auto& spec : configs)
+        runners.emplace_back( std::make_unique<BPRunner>( spec, parse_bp_config( spec, base)));
+
+    const BranchTrace trace( filename);
+    std::vector<BPRunnerResults> results( runners.size());
+    std::vector<std::exception_ptr> exceptions( runners.size());
+    std::atomic<size_t> next_runner = 0;
+
+    const auto worker = [&]() {
+        for ( size_t i = next_runner++; i < runners.size(); i = next_runner++) {
+            try {
+                results[i] = runners[i]->run( trace.get_reader());
+            }
+            catch ( ...) {
+                exceptions[i] = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    const auto threads_num = std::min( std::max<size_t>( threads, 1), runners.size());
+    for ( size_t i = 1; i < threads_num; ++i)
+        pool.emplace_back( worker);
+    worker();
+    for ( auto& thread : pool)
+        thread.join();
+
+    for ( const auto& exception : exceptions)
+        if ( exception != nullptr)
+            std::rethrow_exception( exception);
+
+    return results;
+}
+
+static uint32 parse_uint32( const std::string& key, const std::string& value)
+{
+    try {
+        size_t length = 0;
+        const auto result = std::stoul( value, &length, 0);
+        if ( length == value.size() && result <= MAX_VAL32)
+            return narrow_cast<uint32>( result);
+    }
+    catch ( const std::logic_error&) { } // handled below
+
+    throw InvalidBPConfiguration( "invalid value of " + key + ": " + value);
+}
+
+using BPConfigSetter = std::function<void( PerfConfig::BP*, const std::string&, const std::string&)>;
+
+static BPConfigSetter set_uint32( uint32 PerfConfig::BP::* field)
+{
+    return [field]( PerfConfig::BP* config, const std::string& key, const std::string& value) {
+        config->*field = parse_uint32( key, value);
+    };
+}
+
+static BPConfigSetter set_string( std::string PerfConfig::BP::* field)
+{
+    return [field]( PerfConfig::BP* config, const std::string& /* key */, const std::string& value) {
+        config->*field = value;
+    };
+}
+
+static const std::map<std::string, BPConfigSetter>& get_bp_config_setters()
+{
+    static const std::map<std::string, BPConfigSetter> setters = {
+        { "lru", set_string( &PerfConfig::BP::lru) },
+        { "size", set_uint32( &PerfConfig::BP::size) },
+        { "ways", set_uint32( &PerfConfig::BP::ways) },
+        { "global-history", set_uint32( &PerfConfig::BP::global_history) },
+        { "table-size", set_uint32( &PerfConfig::BP::table_size) },
+        { "tage-tables", set_uint32( &PerfConfig::BP::tage_tables) },
+        { "tage-min-history", set_uint32( &PerfConfig::BP::tage_min_history) },
+        { "tage-max-history", set_uint32( &PerfConfig::BP::tage_max_history) },
+        { "tage-tag-bits", set_uint32( &PerfConfig::BP::tage_tag_bits) },
+        { "ras-size", set_uint32( &PerfConfig::BP::ras_size) },
+        { "indirect-mode", set_string( &PerfConfig::BP::indirect_mode) },
+    };
+    return setters;
+}
+
+PerfConfig::BP parse_bp_config( const std::string& spec, PerfConfig::BP base)
+{
+    const auto colon = spec.find( ':');
+    base.mode = spec.substr( 0, colon);
+    if ( base.mode.empty())
+        throw InvalidBPConfiguration( "no mode in '" + spec + "'");
+
+    if ( colon == std::string::npos)
+        return base;
+
+    std::istringstream overrides( spec.substr( colon + 1));
+    std::string item;
+    while ( std::getline( overrides, item, ',')) {
+        const auto equal = item.find( '=');
+        const auto key = item.substr( 0, equal);
+        const auto it = get_bp_config_setters().find( key);
+        if ( equal == std::string::npos || it == get_bp_config_setters().end())
+            throw InvalidBPConfiguration( "unknown option '" + item + "' in '" + spec + "'");
+
+        it->second( &base, key, item.substr( equal + 1));
+    }
+    return base;
+}
@@ -0,0 +1,80 @@
+/**
+ * Standalone branch prediction simulator
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef BPU_RUNNER_H
+#define BPU_RUNNER_H
+
+#include "trace.h"
+
+#include <infra/exception.h>
+#include <infra/types.h>
+#include <modules/core/perf_config.h>
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+class BaseBP;
+
+struct InvalidBPConfiguration final : Exception
+{
+    explicit InvalidBPConfiguration( const std::string& msg)
+        : Exception( "Invalid branch predictor configuration", msg)
+    { }
+};
+
+struct BPRunnerResults
+{
+    struct Jumps
+    {
+        uint64 jumps = 0;
+        uint64 mispredictions = 0;
+        double get_misprediction_rate() const noexcept { return jumps == 0 ? 0 : double( mispredictions) / double( jumps); }
+    };
+
+    std::string name;
+    Jumps all;
+    Jumps conditional;
+    Jumps returns;
+    Jumps indirect;
+
+    friend std::ostream& operator<<( std::ostream& out, const BPRunnerResults& rhs);
+};
+
+/*
+ * Predictor is looked up only at jumps of the trace: it is updated
+ * with the actual outcome after each prediction and repaired
+ * immediately after a misprediction, there are no wrong path lookups.
+ */
+class BPRunner
+{
+public:
+    BPRunner( std::string name, const PerfConfig::BP& config);
+    ~BPRunner();
+    BPRunner( const BPRunner&) = delete;
+    BPRunner( BPRunner&&) = delete;
+    BPRunner& operator=( const BPRunner&) = delete;
+    BPRunner& operator=( BPRunner&&) = delete;
+
+    BPRunnerResults run( BranchTrace::Reader reader);
+
+    // Configurations are simulated in parallel threads over the same mapped trace
+    static std::vector<BPRunnerResults> run_parallel( const std::string& filename, const std::vector<std::string>& configs, const PerfConfig::BP& base, size_t threads);
+
+private:
+    void account( const BPInterface& record, BPRunnerResults* result);
+
+    const std::string name;
+    std::unique_ptr<BaseBP> bp;
+};
+
+/*
+ * Configuration is a mode with optional overrides of 'bp-*' options,
+ * for example: 'tage:table-size=1024,tage-tables=6,ras-size=16'
+ */
+PerfConfig::BP parse_bp_config( const std::string& spec, PerfConfig::BP base);
+
+#endif
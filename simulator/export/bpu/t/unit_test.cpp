@@ -0,0 +1,204 @@
+/**
+ * Standalone branch prediction simulator unit test
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include <export/bpu/runner.h>
+#include <export/bpu/trace.h>
+#include <func_sim/func_sim.h>
+#include <kernel/kernel.h>
+#include <memory/memory.h>
+#include <modules/fetch/bpu/bpu.h>
+
+#include <boost/iostreams/device/null.hpp>
+#include <boost/iostreams/stream.hpp>
+
+#include <catch.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+static auto& nullout()
+{
+    static boost::iostreams::stream<boost::iostreams::null_sink> instance{ boost::iostreams::null_sink{} };
+    return instance;
+}
+
+static std::string get_temp_file( const std::string& name)
+{
+    return ( std::filesystem::temp_directory_path() / name).string();
+}
+
+static BPInterface get_record( Addr pc, bool is_taken, Addr target, const BranchKind& kind)
+{
+    BPInterface record( pc, is_taken, target, true);
+    record.kind = kind;
+    return record;
+}
+
+static void write_trace( const std::string& filename, const std::vector<BPInterface>& records)
+{
+    std::ofstream out( filename, std::ios::binary);
+    BranchTraceWriter writer( out);
+    for ( const auto& record : records)
+        writer.write( record);
+}
+
+static std::vector<BPInterface> read_all( const std::string& filename)
+{
+    const BranchTrace trace( filename);
+    auto reader = trace.get_reader();
+    std::vector<BPInterface> result;
+    BPInterface record;
+    while ( reader.read( &record))
+        result.push_back( record);
+    return result;
+}
+
+TEST_CASE("Branch trace: round trip")
+{
+    const std::vector<BPInterface> records = {
+        get_record( 0x400000, true, 0x400100, { true, false, false, false }),
+        get_record( 0x400100, false, 0x3ff000, { true, false, false, false }),
+        get_record( 0x400104, true, 0x500000, { false, true, false, false }),
+        get_record( 0x500040, true, 0x400108, { false, false, true, true }),
+        get_record( 0xffff'ffff'0000, true, 0x10, { false, false, false, true })
+    };
+
+    const auto filename = get_temp_file( "mipt_branch_trace_round_trip.bin");
+    write_trace( filename, records);
+
+    const auto result = read_all( filename);
+    REQUIRE( result.size() == records.size());
+    for ( size_t i = 0; i < records.size(); ++i) {
+        CHECK( result[i].pc == records[i].pc);
+        CHECK( result[i].is_taken == records[i].is_taken);
+        CHECK( result[i].target == records[i].target);
+        CHECK( result[i].kind.is_conditional == records[i].kind.is_conditional);
+        CHECK( result[i].kind.is_call == records[i].kind.is_call);
+        CHECK( result[i].kind.is_return == records[i].kind.is_return);
+        CHECK( result[i].kind.is_indirect == records[i].kind.is_indirect);
+    }
+    std::filesystem::remove( filename);
+}
+
+TEST_CASE("Branch trace: loop takes two bytes per record")
+{
+    const auto filename = get_temp_file( "mipt_branch_trace_loop.bin");
+    write_trace( filename, std::vector<BPInterface>( 100, get_record( 0x1000, true, 0x1000 - 0x20, BranchKind())));
+    CHECK( std::filesystem::file_size( filename) == 8 + 4 + 99 * 2);
+    std::filesystem::remove( filename);
+}
+
+TEST_CASE("Branch trace: invalid files")
+{
+    const auto filename = get_temp_file( "mipt_branch_trace_invalid.bin");
+    write_trace( filename, { get_record( 0x1000'0000, true, 0x2000'0000, BranchKind()) });
+    std::filesystem::resize_file( filename, std::filesystem::file_size( filename) - 1);
+    CHECK_THROWS_AS( read_all( filename), InvalidBranchTrace);
+
+    std::filesystem::resize_file( filename, 4);
+    CHECK_THROWS_AS( BranchTrace( filename), InvalidBranchTrace);
+    std::filesystem::remove( filename);
+
+    CHECK_THROWS_AS( BranchTrace( TEST_PATH "/topology_root_test.json"), InvalidBranchTrace);
+    CHECK_THROWS_AS( BranchTrace( get_temp_file( "mipt_branch_trace_does_not_exist.bin")), CannotMapFile);
+}
+
+TEST_CASE("BPRunner: parse configuration")
+{
+    const PerfConfig::BP base;
+    CHECK( parse_bp_config( "gshare", base).mode == "gshare");
+    CHECK( parse_bp_config( "gshare", base).table_size == base.table_size);
+
+    const auto config = parse_bp_config( "tage:table-size=1024,tage-tables=6,indirect-mode=ittage,ras-size=0x10", base);
+    CHECK( config.mode == "tage");
+    CHECK( config.table_size == 1024);
+    CHECK( config.tage_tables == 6);
+    CHECK( config.indirect_mode == "ittage");
+    CHECK( config.ras_size == 16);
+    CHECK( config.size == base.size);
+
+    CHECK_THROWS_AS( parse_bp_config( "", base), InvalidBPConfiguration);
+    CHECK_THROWS_AS( parse_bp_config( ":size=4", base), InvalidBPConfiguration);
+    CHECK_THROWS_AS( parse_bp_config( "gshare:history=4", base), InvalidBPConfiguration);
+    CHECK_THROWS_AS( parse_bp_config( "gshare:size", base), InvalidBPConfiguration);
+    CHECK_THROWS_AS( parse_bp_config( "gshare:size=big", base), InvalidBPConfiguration);
+    CHECK_THROWS_AS( parse_bp_config( "gshare:size=-1", base), InvalidBPConfiguration);
+}
+
+TEST_CASE("BPRunner: results dump")
+{
+    BPRunnerResults r;
+    r.name = "gshare";
+    r.all = { 10, 3 };
+    r.conditional = { 8, 2 };
+    r.indirect = { 1, 1 };
+    std::ostringstream oss;
+    oss << r;
+    CHECK( oss.str() == "gshare: mispredictions - 30% of 10, conditional - 25% of 8, returns - 0% of 0, indirect - 100% of 1\n");
+}
+
+TEST_CASE("BPRunner: global history predictors learn a pattern")
+{
+    const std::vector<bool> pattern = { true, true, false, true, false, false};
+    std::vector<BPInterface> records;
+    for ( size_t i = 0; i < 6000; ++i)
+        records.push_back( get_record( 0x1000, pattern[ i % pattern.size()], 0x2000, BranchKind()));
+
+    const auto filename = get_temp_file( "mipt_branch_trace_pattern.bin");
+    write_trace( filename, records);
+
+    const auto results = BPRunner::run_parallel( filename, { "saturating_two_bits", "gshare", "tage"}, PerfConfig::BP(), 3);
+    REQUIRE( results.size() == 3);
+    CHECK( results[0].name == "saturating_two_bits");
+    CHECK( results[0].all.jumps == records.size());
+    CHECK( results[0].conditional.jumps == records.size());
+    CHECK( results[1].all.mispredictions < results[0].all.mispredictions / 10);
+    CHECK( results[2].all.mispredictions < results[0].all.mispredictions / 10);
+    std::filesystem::remove( filename);
+}
+
+static uint64 record_tt_trace( const std::string& filename)
+{
+    auto sim = BasicFuncSim::create_simulator( "mars", false);
+    auto mem = FuncMemory::create_default_hierarchied_memory();
+    sim->set_memory( mem);
+
+    auto kernel = Kernel::create_kernel( true, std::cin, nullout(), nullout());
+    kernel->set_simulator( sim);
+    kernel->connect_memory( mem);
+    kernel->connect_exception_handler();
+    kernel->load_file( TEST_PATH "/mips/mips-tt-no-delayed-branches.bin");
+    sim->set_kernel( kernel);
+    sim->set_pc( kernel->get_start_pc());
+
+    std::ofstream out( filename, std::ios::binary);
+    return record_branch_trace( sim.get(), MAX_VAL64, out);
+}
+
+TEST_CASE("BPRunner: parallel run over a recorded trace")
+{
+    const auto filename = get_temp_file( "mipt_branch_trace_tt.bin");
+    const auto records = record_tt_trace( filename);
+    CHECK( records > 0);
+
+    const std::vector<std::string> configs = { "saturating_two_bits", "gshare:global-history=8", "perceptron", "tage:ras-size=8,indirect-mode=ittage"};
+    const auto serial = BPRunner::run_parallel( filename, configs, PerfConfig::BP(), 1);
+    const auto parallel = BPRunner::run_parallel( filename, configs, PerfConfig::BP(), 4);
+    REQUIRE( serial.size() == configs.size());
+    REQUIRE( parallel.size() == configs.size());
+    for ( size_t i = 0; i < configs.size(); ++i) {
+        CHECK( serial[i].name == configs[i]);
+        CHECK( serial[i].all.jumps == records);
+        CHECK( serial[i].all.mispredictions > 0);
+        CHECK( serial[i].returns.jumps > 0);
+        CHECK( parallel[i].all.mispredictions == serial[i].all.mispredictions);
+        CHECK( parallel[i].returns.mispredictions == serial[i].returns.mispredictions);
+    }
+
+    CHECK_THROWS_AS( BPRunner::run_parallel( filename, { "gshare", "unknown"}, PerfConfig::BP(), 2), BPInvalidMode);
+    std::filesystem::remove( filename);
+}
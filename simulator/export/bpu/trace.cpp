@@ -0,0 +1,104 @@
+/**
+ * Branch traces for standalone branch prediction simulator
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include "trace.h"
+
+#include <func_sim/func_sim.h>
+#include <infra/macro.h>
+#include <infra/varint.h>
+
+#include <algorithm>
+#include <array>
+#include <ostream>
+
+static const std::array<char, 8> branch_trace_magic = { 'M', 'I', 'P', 'T', 'B', 'R', 'T', '1' };
+
+static const constexpr uint32 kind_bits = 4;
+
+static uint64 encode_kind( const BranchKind& kind)
+{
+    return ( kind.is_conditional ? 1U : 0U)
+         | ( kind.is_call ? 2U : 0U)
+         | ( kind.is_return ? 4U : 0U)
+         | ( kind.is_indirect ? 8U : 0U);
+}
+
+static BranchKind decode_kind( uint64 value)
+{
+    return { ( value & 1U) != 0, ( value & 2U) != 0, ( value & 4U) != 0, ( value & 8U) != 0 };
+}
+
+BranchTraceWriter::BranchTraceWriter( std::ostream& out) : out( out)
+{
+    out.write( branch_trace_magic.data(), branch_trace_magic.size());
+}
+
+void BranchTraceWriter::write( const BPInterface& record)
+{
+    const uint64 delta = zigzag_encode( record.pc, last_pc);
+    if ( delta >> ( bitwidth<uint64> - kind_bits - 1) != 0)
+        throw InvalidBranchTrace( "too large PC delta for branch trace");
+
+    write_varint( out, ( delta << ( kind_bits + 1)) | ( encode_kind( record.kind) << 1U) | ( record.is_taken ? 1U : 0U));
+    write_varint( out, zigzag_encode( record.target, record.pc));
+    last_pc = record.pc;
+}
+
+BranchTrace::BranchTrace( const std::string& filename) : file( filename)
+{
+    if ( file.get_size() < branch_trace_magic.size()
+        || !std::equal( branch_trace_magic.begin(), branch_trace_magic.end(), file.begin()))
+    {
+        throw InvalidBranchTrace( filename + " is not a branch trace");
+    }
+}
+
+BranchTrace::Reader BranchTrace::get_reader() const
+{
+    return Reader( file.begin() + branch_trace_magic.size(), file.end());
+}
+
+uint64 BranchTrace::Reader::read_next()
+{
+    uint64 value = 0;
+    if ( !read_varint( &ptr, end, &value))
+        throw InvalidBranchTrace( "unexpected end or too long varint");
+
+    return value;
+}
+
+bool BranchTrace::Reader::read( BPInterface* record)
+{
+    if ( ptr == end)
+        return false;
+
+    const auto header = read_next();
+    *record = BPInterface();
+    record->pc = last_pc = zigzag_decode( header >> ( kind_bits + 1), last_pc);
+    record->kind = decode_kind( header >> 1U);
+    record->is_taken = ( header & 1U) != 0;
+    record->target = zigzag_decode( read_next(), record->pc);
+    return true;
+}
+
+uint64 record_branch_trace( BasicFuncSim* sim, uint64 instrs_to_run, std::ostream& out)
+{
+    BranchTraceWriter writer( out);
+    uint64 count = 0;
+    sim->set_jump_observer( [&]( const BPInterface& record) {
+        writer.write( record);
+        ++count;
+    });
+
+    try {
+        sim->run( instrs_to_run);
+    }
+    catch ( ...) {
+        sim->set_jump_observer( nullptr);
+        throw;
+    }
+    sim->set_jump_observer( nullptr);
+    return count;
+}
@@ -0,0 +1,77 @@
+/**
+ * Branch traces for standalone branch prediction simulator
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef BPU_TRACE_H
+#define BPU_TRACE_H
+
+#include <infra/exception.h>
+#include <infra/mapped_file.h>
+#include <infra/types.h>
+#include <modules/fetch/bpu/bp_interface.h>
+
+#include <iosfwd>
+#include <string>
+
+class BasicFuncSim;
+
+struct InvalidBranchTrace final : Exception
+{
+    explicit InvalidBranchTrace( const std::string& msg)
+        : Exception( "Invalid branch trace", msg)
+    { }
+};
+
+/*
+ * Trace is a header followed by records of two LEB128 varints.
+ * The first varint packs zigzag-encoded delta from the previous PC
+ * with branch kind and direction: ( delta << 5) | ( kind << 1) | is_taken.
+ * The second one is zigzag-encoded delta from PC to the target.
+ * Records are updates of branch predictor as Branch stage makes them:
+ * the target of a direct jump is the decoded one even if it is not taken.
+ */
+class BranchTraceWriter
+{
+public:
+    explicit BranchTraceWriter( std::ostream& out);
+    void write( const BPInterface& record);
+
+private:
+    std::ostream& out;
+    Addr last_pc = 0;
+};
+
+// Trace is mapped to memory once, each reader iterates it independently
+class BranchTrace
+{
+public:
+    explicit BranchTrace( const std::string& filename);
+
+    class Reader
+    {
+    public:
+        Reader( const unsigned char* begin, const unsigned char* end) : ptr( begin), end( end) { }
+
+        // Returns false at the end of the trace
+        bool read( BPInterface* record);
+
+    private:
+        uint64 read_next();
+
+        const unsigned char* ptr;
+        const unsigned char* const end;
+        Addr last_pc = 0;
+    };
+
+    Reader get_reader() const;
+    size_t get_size() const { return file.get_size(); }
+
+private:
+    MappedFile file;
+};
+
+// Runs the simulator and writes executed jumps, returns the number of records
+uint64 record_branch_trace( BasicFuncSim* sim, uint64 instrs_to_run, std::ostream& out);
+
+#endif
@@ -0,0 +1,33 @@
+/**
+ * Converter of memory traces for standalone cache simulator
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include "trace.h"
+
+#include <infra/config/config.h>
+#include <infra/config/main_wrapper.h>
+
+#include <iostream>
+
+namespace config {
+    static const AliasedRequiredValue<std::string> input = { "i", "input", "input trace, binary or JSON"};
+    static const AliasedRequiredValue<std::string> output = { "o", "output", "output trace, JSON if file name ends with '.json', binary otherwise"};
+} // namespace config
+
+class Main : public MainWrapper
+{
+    using MainWrapper::MainWrapper;
+private:
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays, modernize-avoid-c-arrays, hicpp-avoid-c-arrays)
+    int impl( int argc, const char* argv[]) const final {
+        config::handleArgs( argc, argv, 1);
+        std::cout << "converted accesses: " << convert_trace( config::input, config::output) << std::endl;
+        return 0;
+    }
+};
+
+int main( int argc, const char* argv[])
+{
+    return Main( "MIPT-V memory trace converter.").run( argc, argv);
+}
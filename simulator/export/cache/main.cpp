@@ -4,6 +4,7 @@
  */
 
 #include "runner.h"
+#include "stack_distance.h"
 
 #include <infra/cache/cache_tag_array.h>
 #include <infra/config/config.h>
@@ -17,8 +18,15 @@ namespace config {
 
     static const AliasedValue<std::string> replacement = { "r", "replacement", "LRU", "Cache replacement scheme"};
     static const Value<uint32> line_size = { "line_size", 64, "Line size of instruction level 1 cache (in bytes)"};
+    static const Value<uint32> threads = { "threads", 1, "Number of host threads simulating disjoint groups of sets"};
+    static const Switch stack_distance = { "stack-distance", "evaluate all LRU caches up to the given size and ways in a single pass"};
 } // namespace config
 
+static void dump_history_memory( size_t bytes)
+{
+    std::cout << "compulsory miss tracking memory: " << bytes / 1024 << " KiB" << std::endl;
+}
+
 class Main : public MainWrapper
 {
     using MainWrapper::MainWrapper;
@@ -26,8 +34,25 @@ private:
     // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays, modernize-avoid-c-arrays, hicpp-avoid-c-arrays)
     int impl( int argc, const char* argv[]) const final {
         config::handleArgs( argc, argv, 1);
+        if ( config::stack_distance) {
+            StackDistanceAnalyzer analyzer( config::size, config::ways, config::line_size);
+            analyzer.run( config::file);
+            analyzer.dump( std::cout);
+            dump_history_memory( analyzer.get_history_memory());
+            return 0;
+        }
+
+        if ( config::threads > 1) {
+            const auto result = CacheRunner::create_parallel( config::replacement, config::size, config::ways, config::line_size, config::threads)->run( config::file);
+            std::cout << result;
+            dump_history_memory( result.history_memory);
+            return 0;
+        }
+
         auto cache = CacheTagArray::create( config::replacement, config::size, config::ways, config::line_size, 32);
-        std::cout << CacheRunner::create( cache.get())->run( config::file);
+        const auto result = CacheRunner::create( cache.get(), config::line_size)->run( config::file);
+        std::cout << result;
+        dump_history_memory( result.history_memory);
         return 0;
     }
 };
@@ -4,16 +4,21 @@
  */
  
 #include "runner.h"
+#include "trace.h"
 
 #include <infra/cache/cache_tag_array.h>
 #include <infra/macro.h>
+#include <infra/paged_bitset.h>
+#include <infra/replacement/cache_replacement.h>
 
-// #include <sparsehash/dense_hash_map.h> FIXME(pikryuko) install
-
-#include <boost/property_tree/json_parser.hpp>
-#include <boost/property_tree/ptree.hpp>
-
-#include <unordered_set>
+#include <bit>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
 
 static void dump_percentage( std::ostream& out, std::string_view name, double value)
 {
@@ -29,56 +34,257 @@ std::ostream& operator<<( std::ostream& out, const CacheRunnerResults& rhs)
     return out;
 }
 
-class CommonCacheRunner : public CacheRunner
+// Replacement policies use the address itself if PC is not traced
+static Addr get_pc( const MemoryAccess& access)
+{
+    return access.has_pc ? access.pc : access.addr;
+}
+
+// Hits and compulsory misses of a single cache
+class CacheAccounting
 {
 public:
-    explicit CommonCacheRunner( CacheTagArray* cache) : cache( cache)
-    {
-//        history.set_empty_key( all_ones<PhysAddr>());
-    }
+    CacheAccounting( CacheTagArray* cache, uint32 line_size)
+        : cache( cache)
+        , line_bits( is_power_of_two( line_size) ? std::countr_zero( line_size) : 0)
+    { }
 
-    CacheRunnerResults run( const std::string& filename) final;
+    // 'cache_addr' is an address as it is seen by the tag array
+    void account_access( Addr addr, Addr cache_addr, Addr pc, CacheRunnerResults* result);
+    size_t get_history_memory() const { return history.get_memory_usage(); }
 
 private:
-    void account_access( Addr addr, CacheRunnerResults* result);
-    void account_miss( Addr addr, CacheRunnerResults* result);
+    void account_miss( Addr addr, Addr cache_addr, Addr pc, CacheRunnerResults* result);
 
-//    google::dense_hash_set<Addr> history;
-    std::unordered_set<Addr> history;
+    PagedBitset history;
     CacheTagArray* cache;
+    const size_t line_bits;
 };
 
-void CommonCacheRunner::account_access( Addr addr, CacheRunnerResults* result)
+void CacheAccounting::account_access( Addr addr, Addr cache_addr, Addr pc, CacheRunnerResults* result)
 {
     result->accesses++;
-    if ( cache->lookup( addr))
+    if ( cache->lookup( cache_addr))
         result->hits++;
     else
-        account_miss( addr, result);
+        account_miss( addr, cache_addr, pc, result);
 }
 
-void CommonCacheRunner::account_miss( Addr addr, CacheRunnerResults* result)
+void CacheAccounting::account_miss( Addr addr, Addr cache_addr, Addr pc, CacheRunnerResults* result)
 {
-    cache->write( addr);
-    if ( history.count( addr) == 0) {
+    cache->write( cache_addr, pc);
+    if ( !history.test_and_set( addr >> line_bits))
         ++result->compulsory_misses;
-        history.insert( addr);
-    }
 }
 
+class CommonCacheRunner : public CacheRunner
+{
+public:
+    CommonCacheRunner( CacheTagArray* cache, uint32 line_size) : accounting( cache, line_size) { }
+
+    CacheRunnerResults run( const std::string& filename) final;
+
+private:
+    CacheAccounting accounting;
+};
+
 CacheRunnerResults CommonCacheRunner::run( const std::string& filename)
 {
     CacheRunnerResults result;
-    boost::property_tree::ptree trace;
-    read_json( filename, trace);
+    auto trace = TraceReader::create( filename);
+
+    MemoryAccess access;
+    while ( trace->read( &access))
+        accounting.account_access( access.addr, access.addr, get_pc( access), &result);
+
+    result.history_memory = accounting.get_history_memory();
+    return result;
+}
+
+struct TracedAccess
+{
+    Addr addr;
+    Addr pc;
+};
+
+// Blocking queue of access batches with bounded length
+class BatchQueue
+{
+public:
+    void push( std::vector<TracedAccess>&& batch)
+    {
+        std::unique_lock lock( mutex);
+        not_full.wait( lock, [this]() { return batches.size() < max_batches; });
+        batches.emplace_back( std::move( batch));
+        not_empty.notify_one();
+    }
+
+    // Returns false if the queue is closed and empty
+    bool pop( std::vector<TracedAccess>* batch)
+    {
+        std::unique_lock lock( mutex);
+        not_empty.wait( lock, [this]() { return !batches.empty() || closed; });
+        if ( batches.empty())
+            return false;
+
+        *batch = std::move( batches.front());
+        batches.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard lock( mutex);
+        closed = true;
+        not_empty.notify_all();
+    }
+
+private:
+    static const constexpr size_t max_batches = 16;
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<std::vector<TracedAccess>> batches;
+    bool closed = false;
+};
 
-    for ( const auto& access : trace.get_child( "memory_trace"))
-        account_access( std::stoul( access.second.get_value<std::string>(), nullptr, 0), &result);
-    
+/*
+ * Sets of the cache are independent, so the trace is split by the lowest
+ * set bits into shards simulated by separate threads.
+ * Each shard has its own tag array with the remaining sets,
+ * the shard bits are removed from addresses before lookup.
+ * Policies sharing state between sets are simulated by a single shard.
+ */
+class ParallelCacheRunner : public CacheRunner
+{
+public:
+    ParallelCacheRunner( const std::string& type, uint32 size_in_bytes, uint32 ways, uint32 line_size, size_t threads);
+
+    CacheRunnerResults run( const std::string& filename) final;
+
+private:
+    struct Shard
+    {
+        Shard( std::unique_ptr<CacheTagArray> c, uint32 line_size) : cache( std::move( c)), accounting( cache.get(), line_size) { }
+        std::unique_ptr<CacheTagArray> cache;
+        CacheAccounting accounting;
+        CacheRunnerResults result;
+        BatchQueue queue;
+        std::exception_ptr exception = nullptr;
+    };
+
+    size_t get_shard( Addr addr) const { return narrow_cast<size_t>( ( ( addr & addr_mask) >> line_bits) & ( shards.size() - 1)); }
+    Addr get_cache_addr( Addr addr) const;
+    void run_shard( Shard* shard) const;
+
+    static const constexpr size_t batch_size = 4096;
+    static const constexpr Addr addr_mask = bitmask<Addr>( 32);
+    const size_t line_bits;
+    size_t shard_bits = 0;
+    std::vector<std::unique_ptr<Shard>> shards;
+};
+
+static bool can_partition( const std::string& type)
+{
+    return type != "always_hit" && type != "infinite" && can_partition_sets( type);
+}
+
+ParallelCacheRunner::ParallelCacheRunner( const std::string& type, uint32 size_in_bytes, uint32 ways, uint32 line_size, size_t threads)
+    : line_bits( std::countr_zero( line_size))
+{
+    // Validate configuration in the same way as the common runner does
+    CacheTagArray::create( type, size_in_bytes, ways, line_size, 32);
+
+    const uint32 sets = can_partition( type) ? size_in_bytes / ( ways * line_size) : 1;
+    while ( ( size_t{ 2} << shard_bits) <= threads && ( 2U << shard_bits) <= sets)
+        ++shard_bits;
+
+    const size_t shards_num = size_t{ 1} << shard_bits;
+    for ( size_t i = 0; i < shards_num; ++i)
+        shards.emplace_back( std::make_unique<Shard>( CacheTagArray::create( type, narrow_cast<uint32>( size_in_bytes >> shard_bits), ways, line_size, narrow_cast<uint32>( 32 - shard_bits)), line_size));
+}
+
+Addr ParallelCacheRunner::get_cache_addr( Addr addr) const
+{
+    if ( shard_bits == 0)
+        return addr;
+
+    const Addr offset = addr & bitmask<Addr>( line_bits);
+    const Addr line = ( addr & addr_mask) >> line_bits;
+    return ( ( line >> shard_bits) << line_bits) | offset;
+}
+
+void ParallelCacheRunner::run_shard( Shard* shard) const
+{
+    std::vector<TracedAccess> batch;
+    while ( shard->queue.pop( &batch)) {
+        if ( shard->exception != nullptr)
+            continue; // drain the queue so the reader is not blocked
+
+        try {
+            for ( const auto& access : batch)
+                shard->accounting.account_access( access.addr, get_cache_addr( access.addr), access.pc, &shard->result);
+        }
+        catch ( ...) {
+            shard->exception = std::current_exception();
+        }
+    }
+}
+
+CacheRunnerResults ParallelCacheRunner::run( const std::string& filename)
+{
+    std::vector<std::thread> threads;
+    threads.reserve( shards.size());
+    for ( auto& shard : shards)
+        threads.emplace_back( [this, s = shard.get()]() { run_shard( s); });
+
+    std::exception_ptr exception = nullptr;
+    try {
+        auto trace = TraceReader::create( filename);
+        std::vector<std::vector<TracedAccess>> batches( shards.size());
+        MemoryAccess access;
+        while ( trace->read( &access)) {
+            const auto index = get_shard( access.addr);
+            auto& batch = batches[ index];
+            batch.push_back( { access.addr, get_pc( access) });
+            if ( batch.size() == batch_size)
+                shards[ index]->queue.push( std::exchange( batch, {}));
+        }
+        for ( size_t i = 0; i < shards.size(); ++i)
+            if ( !batches[i].empty())
+                shards[i]->queue.push( std::move( batches[i]));
+    }
+    catch ( ...) {
+        exception = std::current_exception();
+    }
+
+    for ( auto& shard : shards)
+        shard->queue.close();
+    for ( auto& thread : threads)
+        thread.join();
+
+    if ( exception != nullptr)
+        std::rethrow_exception( exception);
+
+    CacheRunnerResults result;
+    for ( const auto& shard : shards) {
+        if ( shard->exception != nullptr)
+            std::rethrow_exception( shard->exception);
+        result.accesses += shard->result.accesses;
+        result.hits += shard->result.hits;
+        result.compulsory_misses += shard->result.compulsory_misses;
+        result.history_memory += shard->accounting.get_history_memory();
+    }
     return result;
 }
 
-std::unique_ptr<CacheRunner> CacheRunner::create( CacheTagArray* cache)
+std::unique_ptr<CacheRunner> CacheRunner::create( CacheTagArray* cache, uint32 line_size)
+{
+    return std::make_unique<CommonCacheRunner>( cache, line_size);
+}
+
+std::unique_ptr<CacheRunner> CacheRunner::create_parallel( const std::string& type, uint32 size_in_bytes, uint32 ways, uint32 line_size, size_t threads)
 {
-    return std::make_unique<CommonCacheRunner>( cache);
+    return std::make_unique<ParallelCacheRunner>( type, size_in_bytes, ways, line_size, threads);
 }
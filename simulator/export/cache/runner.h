@@ -10,6 +10,7 @@
 
 #include <iostream>
 #include <memory>
+#include <string>
 
 class CacheTagArray;
 
@@ -18,6 +19,7 @@ struct CacheRunnerResults
     uint64 accesses = 0;
     uint64 hits = 0;
     uint64 compulsory_misses = 0;
+    uint64 history_memory = 0; // bytes used to track compulsory misses
 
     auto get_hit_rate() const noexcept  { return accesses == 0 ? 0 : double( hits) / accesses; }
     auto get_miss_rate() const noexcept { return 1 - get_hit_rate(); }
@@ -37,7 +39,11 @@ public:
     CacheRunner& operator=( const CacheRunner&) = delete;
     CacheRunner& operator=( CacheRunner&&) = delete;
 
-    static std::unique_ptr<CacheRunner> create( CacheTagArray* cache);
+    // Compulsory misses are tracked with granularity of line_size bytes
+    static std::unique_ptr<CacheRunner> create( CacheTagArray* cache, uint32 line_size = 1);
+
+    // Simulates disjoint groups of sets in parallel threads, results are the same as of a single cache
+    static std::unique_ptr<CacheRunner> create_parallel( const std::string& type, uint32 size_in_bytes, uint32 ways, uint32 line_size, size_t threads);
 
     virtual CacheRunnerResults run( const std::string& filename) = 0;
 };
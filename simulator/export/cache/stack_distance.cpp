@@ -0,0 +1,122 @@
+/**
+ * Single-pass evaluation of LRU caches with stack distance analysis
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include "stack_distance.h"
+#include "trace.h"
+
+#include <infra/macro.h>
+
+#include <algorithm>
+#include <bit>
+#include <iomanip>
+#include <numeric>
+#include <ostream>
+
+StackDistanceAnalyzer::StackDistanceAnalyzer( uint32 max_size_in_bytes, uint32 max_ways, uint32 line_size)
+    : max_size( max_size_in_bytes)
+    , max_ways( max_ways)
+    , line_size( line_size)
+    , line_bits( std::countr_zero( line_size))
+{
+    if ( line_size == 0 || !is_power_of_two( line_size))
+        throw StackDistanceInvalidSize( "line size should be a power of 2");
+
+    if ( max_size_in_bytes < line_size || !is_power_of_two( max_size_in_bytes))
+        throw StackDistanceInvalidSize( "cache size should be a power of 2 not less than line size");
+
+    if ( max_ways == 0)
+        throw StackDistanceInvalidSize( "number of ways should be greater than zero");
+
+    const uint32 max_lines = max_size / line_size;
+    for ( uint32 sets = 1; sets <= max_lines; sets *= 2) {
+        const uint32 depth = std::min( max_ways, max_lines / sets);
+        levels.push_back( { sets, depth, std::vector<Addr>( size_t{ sets} * depth), std::vector<uint32>( sets), std::vector<uint64>( depth) });
+    }
+}
+
+void StackDistanceAnalyzer::access( SetCount* level, Addr line)
+{
+    const auto set = narrow_cast<size_t>( line & ( level->sets - 1));
+    auto* stack = level->stacks.data() + set * level->depth;
+    auto& filled = level->filled[set];
+
+    auto* end = stack + filled;
+    auto* it = std::find( stack, end, line);
+    if ( it != end) {
+        ++level->histogram[ it - stack];
+    }
+    else if ( filled < level->depth) {
+        ++filled;
+    }
+    else {
+        --it; // the least recently used line is evicted
+    }
+
+    // Move to front
+    std::copy_backward( stack, it, it + 1);
+    *stack = line;
+}
+
+void StackDistanceAnalyzer::access( Addr addr)
+{
+    // Same address space as in CacheTagArray
+    const Addr line = ( addr & bitmask<Addr>( 32)) >> line_bits;
+    ++accesses;
+    if ( !history.test_and_set( line))
+        ++compulsory_misses;
+
+    for ( auto& level : levels)
+        access( &level, line);
+}
+
+void StackDistanceAnalyzer::run( const std::string& filename)
+{
+    auto trace = TraceReader::create( filename);
+    MemoryAccess access;
+    while ( trace->read( &access))
+        this->access( access.addr);
+}
+
+const StackDistanceAnalyzer::SetCount& StackDistanceAnalyzer::get_level( uint32 sets) const
+{
+    if ( sets == 0 || !is_power_of_two( sets) || sets > levels.back().sets)
+        throw StackDistanceInvalidSize( "number of sets " + std::to_string( sets) + " is not analyzed");
+
+    return levels[ std::countr_zero( sets)];
+}
+
+const std::vector<uint64>& StackDistanceAnalyzer::get_histogram( uint32 sets) const
+{
+    return get_level( sets).histogram;
+}
+
+uint64 StackDistanceAnalyzer::get_hits( uint32 size_in_bytes, uint32 ways) const
+{
+    if ( ways == 0 || size_in_bytes % ( ways * line_size) != 0)
+        throw StackDistanceInvalidSize( "cache size should be multiple of line size multiplied by ways");
+
+    const auto& level = get_level( size_in_bytes / ( ways * line_size));
+    if ( ways > level.depth)
+        throw StackDistanceInvalidSize( std::to_string( ways) + " ways are not analyzed");
+
+    const auto& histogram = level.histogram;
+    return std::accumulate( histogram.begin(), std::next( histogram.begin(), ways), uint64{ 0});
+}
+
+void StackDistanceAnalyzer::dump( std::ostream& out) const
+{
+    out << "total accesses: " << accesses << std::endl
+        << "compulsory misses: " << compulsory_misses << std::endl
+        << std::setw( 12) << "size" << std::setw( 8) << "sets" << std::setw( 6) << "ways" << std::setw( 12) << "hit rate" << std::endl;
+
+    for ( uint32 size = line_size; size <= max_size; size *= 2) {
+        for ( uint32 ways = 1; ways <= max_ways && ways * line_size <= size; ways *= 2) {
+            const auto hits = get_hits( size, ways);
+            const auto hit_rate = accesses == 0 ? 0 : double( hits) / double( accesses);
+            out << std::setw( 12) << size << std::setw( 8) << size / ( ways * line_size) << std::setw( 6) << ways
+                << std::setw( 11) << ( hit_rate * 100) << '%' << std::endl;
+        }
+    }
+}
@@ -0,0 +1,79 @@
+/**
+ * Single-pass evaluation of LRU caches with stack distance analysis
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef CACHE_STACK_DISTANCE_H
+#define CACHE_STACK_DISTANCE_H
+
+#include <infra/exception.h>
+#include <infra/paged_bitset.h>
+#include <infra/types.h>
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+struct StackDistanceInvalidSize final : Exception
+{
+    explicit StackDistanceInvalidSize( const std::string& msg)
+        : Exception( "Invalid stack distance analysis parameters", msg)
+    { }
+};
+
+/*
+ * LRU has the inclusion property: a cache with N ways of a set contains
+ * N most recently used lines of the set. So, if a line is found at position D
+ * of the set's LRU stack, the access hits in all caches with more than D ways
+ * and the same number of sets (Mattson et al., 1970).
+ *
+ * One pass over a trace maintains stacks for all power-of-two set counts
+ * and builds histograms of stack distances. Stack depth is bounded by
+ * the maximal associativity, deeper reuses are misses in all studied caches.
+ */
+class StackDistanceAnalyzer
+{
+public:
+    StackDistanceAnalyzer( uint32 max_size_in_bytes, uint32 max_ways, uint32 line_size);
+
+    void access( Addr addr);
+    void run( const std::string& filename);
+
+    uint64 get_accesses() const { return accesses; }
+    uint64 get_compulsory_misses() const { return compulsory_misses; }
+    size_t get_history_memory() const { return history.get_memory_usage(); }
+
+    // Histogram of distances for the given number of sets, index is a distance
+    const std::vector<uint64>& get_histogram( uint32 sets) const;
+
+    // Results of LRU cache of the given geometry
+    uint64 get_hits( uint32 size_in_bytes, uint32 ways) const;
+
+    // Table of hit rates for all power-of-two geometries
+    void dump( std::ostream& out) const;
+
+private:
+    struct SetCount
+    {
+        uint32 sets;
+        uint32 depth;
+        std::vector<Addr> stacks; // 'depth' lines for each set, MRU first
+        std::vector<uint32> filled;
+        std::vector<uint64> histogram;
+    };
+
+    static void access( SetCount* level, Addr line);
+    const SetCount& get_level( uint32 sets) const;
+
+    const uint32 max_size;
+    const uint32 max_ways;
+    const uint32 line_size;
+    const uint32 line_bits;
+    std::vector<SetCount> levels;
+
+    uint64 accesses = 0;
+    uint64 compulsory_misses = 0;
+    PagedBitset history;
+};
+
+#endif
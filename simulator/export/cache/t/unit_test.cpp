@@ -4,10 +4,16 @@
  */
 
 #include <export/cache/runner.h>
+#include <export/cache/stack_distance.h>
+#include <export/cache/trace.h>
 #include <infra/cache/cache_tag_array.h>
 
 #include <catch.hpp>
+#include <filesystem>
+#include <fstream>
+#include <random>
 #include <sstream>
+#include <vector>
 
 TEST_CASE("CacheRunner: results zero dump")
 {
@@ -50,3 +56,243 @@ TEST_CASE("CacheRunner: small cache")
     CHECK( r.hits == 0);
     CHECK( r.compulsory_misses == 3);
 }
+
+static std::string get_temp_file( const std::string& name)
+{
+    return ( std::filesystem::temp_directory_path() / name).string();
+}
+
+static std::vector<MemoryAccess> read_all( const std::string& filename)
+{
+    std::vector<MemoryAccess> result;
+    auto reader = TraceReader::create( filename);
+    MemoryAccess access;
+    while ( reader->read( &access))
+        result.emplace_back( access);
+    return result;
+}
+
+TEST_CASE("Trace: binary round trip")
+{
+    const std::vector<MemoryAccess> accesses = {
+        { 0x1000, 0, MemoryAccessType::READ, false },
+        { 0x1008, 0x400000, MemoryAccessType::WRITE, true },
+        { 0x0, 0x400004, MemoryAccessType::FETCH, true },
+        { 0xffff'ffff'0000, 0x3ff000, MemoryAccessType::READ, true },
+        { 0x10, 0, MemoryAccessType::WRITE, false }
+    };
+
+    const auto filename = get_temp_file( "mipt_trace_round_trip.bin");
+    {
+        std::ofstream out( filename, std::ios::binary);
+        BinaryTraceWriter writer( out);
+        for ( const auto& access : accesses)
+            writer.write( access);
+    }
+
+    const auto result = read_all( filename);
+    REQUIRE( result.size() == accesses.size());
+    for ( size_t i = 0; i < accesses.size(); ++i) {
+        CHECK( result[i].addr == accesses[i].addr);
+        CHECK( result[i].type == accesses[i].type);
+        CHECK( result[i].has_pc == accesses[i].has_pc);
+        CHECK( result[i].pc == accesses[i].pc);
+    }
+    std::filesystem::remove( filename);
+}
+
+TEST_CASE("Trace: sequential accesses take one byte")
+{
+    const auto filename = get_temp_file( "mipt_trace_sequential.bin");
+    {
+        std::ofstream out( filename, std::ios::binary);
+        BinaryTraceWriter writer( out);
+        for ( Addr addr = 0; addr < 0x100; addr += 4)
+            writer.write( { addr, 0, MemoryAccessType::READ, false });
+    }
+    CHECK( std::filesystem::file_size( filename) == 8 + 0x40);
+    std::filesystem::remove( filename);
+}
+
+TEST_CASE("Trace: truncated binary trace")
+{
+    const auto filename = get_temp_file( "mipt_trace_truncated.bin");
+    {
+        std::ofstream out( filename, std::ios::binary);
+        BinaryTraceWriter writer( out);
+        writer.write( { 0x1000'0000, 0, MemoryAccessType::READ, false });
+    }
+    std::filesystem::resize_file( filename, std::filesystem::file_size( filename) - 1);
+    CHECK_THROWS_AS( read_all( filename), InvalidTrace);
+    std::filesystem::remove( filename);
+}
+
+TEST_CASE("CacheRunner: JSON and binary traces give the same results")
+{
+    const auto binary = get_temp_file( "mipt_trace_converted.bin");
+    const auto json = get_temp_file( "mipt_trace_converted.json");
+    CHECK( convert_trace( TEST_PATH "/mem_trace.json", binary) == 4);
+    CHECK( convert_trace( binary, json) == 4);
+
+    auto cache = CacheTagArray::create( "LRU", 2048, 8, 64, 32);
+    auto r = CacheRunner::create( cache.get())->run( binary);
+    CHECK( r.accesses == 4);
+    CHECK( r.hits == 1);
+    CHECK( r.compulsory_misses == 3);
+
+    auto cache_json = CacheTagArray::create( "LRU", 2048, 8, 64, 32);
+    auto r_json = CacheRunner::create( cache_json.get())->run( json);
+    CHECK( r_json.accesses == 4);
+    CHECK( r_json.hits == 1);
+
+    std::filesystem::remove( binary);
+    std::filesystem::remove( json);
+}
+
+static std::string write_random_trace( const std::string& name, size_t size)
+{
+    const auto filename = get_temp_file( name);
+    std::ofstream out( filename, std::ios::binary);
+    BinaryTraceWriter writer( out);
+    std::mt19937 engine( 42);
+    std::geometric_distribution<Addr> distance( 0.02);
+    std::vector<Addr> recent = { 0 };
+    for ( size_t i = 0; i < size; ++i) {
+        const auto back = std::min<size_t>( distance( engine), recent.size() - 1);
+        const Addr addr = i % 7 == 0 ? engine() : recent[ recent.size() - 1 - back];
+        writer.write( { addr, 0, MemoryAccessType::READ, false });
+        recent.push_back( addr);
+    }
+    return filename;
+}
+
+TEST_CASE("CacheRunner: parallel runner gives the same results")
+{
+    const auto filename = write_random_trace( "mipt_trace_parallel.bin", 50000);
+    for ( const std::string type : { "LRU", "pseudo-LRU", "infinite", "always_hit" }) {
+        for ( size_t threads : { 1, 2, 3, 8 }) {
+            auto cache = CacheTagArray::create( type, 2048, 2, 32, 32);
+            const auto expected = CacheRunner::create( cache.get())->run( filename);
+            const auto r = CacheRunner::create_parallel( type, 2048, 2, 32, threads)->run( filename);
+            CHECK( r.accesses == expected.accesses);
+            CHECK( r.hits == expected.hits);
+            CHECK( r.compulsory_misses == expected.compulsory_misses);
+        }
+    }
+
+    // Fully associative cache has a single set to simulate
+    auto cache = CacheTagArray::create( "LRU", 1024, 32, 32, 32);
+    const auto expected = CacheRunner::create( cache.get())->run( filename);
+    const auto r = CacheRunner::create_parallel( "LRU", 1024, 32, 32, 4)->run( filename);
+    CHECK( r.hits == expected.hits);
+    std::filesystem::remove( filename);
+}
+
+TEST_CASE("CacheRunner: parallel runner errors")
+{
+    CHECK_THROWS_AS( CacheRunner::create_parallel( "LRU", 1000, 2, 32, 4), CacheTagArrayInvalidSizeException);
+    CHECK_THROWS_AS( CacheRunner::create_parallel( "LRU", 2048, 2, 32, 4)->run( TEST_PATH "/topology_root_test.json"), std::runtime_error);
+}
+
+TEST_CASE("StackDistance: invalid parameters")
+{
+    CHECK_THROWS_AS( StackDistanceAnalyzer( 1000, 4, 64), StackDistanceInvalidSize);
+    CHECK_THROWS_AS( StackDistanceAnalyzer( 1024, 4, 48), StackDistanceInvalidSize);
+    CHECK_THROWS_AS( StackDistanceAnalyzer( 32, 4, 64), StackDistanceInvalidSize);
+    CHECK_THROWS_AS( StackDistanceAnalyzer( 1024, 0, 64), StackDistanceInvalidSize);
+
+    StackDistanceAnalyzer analyzer( 1024, 4, 64);
+    CHECK_THROWS_AS( analyzer.get_hits( 2048, 4), StackDistanceInvalidSize);
+    CHECK_THROWS_AS( analyzer.get_hits( 1024, 8), StackDistanceInvalidSize);
+    CHECK_THROWS_AS( analyzer.get_hits( 1024, 3), StackDistanceInvalidSize);
+    CHECK_THROWS_AS( analyzer.get_histogram( 32), StackDistanceInvalidSize);
+}
+
+TEST_CASE("StackDistance: histogram")
+{
+    StackDistanceAnalyzer analyzer( 256, 4, 64);
+    for ( Addr addr : { 0x0, 0x40, 0x80, 0x0, 0x0, 0x80, 0xc0, 0x100, 0x0})
+        analyzer.access( addr);
+
+    CHECK( analyzer.get_accesses() == 9);
+    CHECK( analyzer.get_compulsory_misses() == 5);
+    CHECK( analyzer.get_histogram( 1) == std::vector<uint64>{ 1, 1, 1, 1});
+    CHECK( analyzer.get_histogram( 2) == std::vector<uint64>{ 1, 2});
+    CHECK( analyzer.get_hits( 256, 4) == 4);
+    CHECK( analyzer.get_hits( 128, 2) == 2);
+    CHECK( analyzer.get_hits( 256, 2) == 3);
+}
+
+TEST_CASE("StackDistance: same results as LRU caches")
+{
+    const auto filename = write_random_trace( "mipt_trace_stack_distance.bin", 20000);
+
+    StackDistanceAnalyzer analyzer( 4096, 8, 32);
+    analyzer.run( filename);
+    for ( uint32 size = 32; size <= 4096; size *= 2) {
+        for ( uint32 ways = 1; ways <= 8 && ways * 32 <= size; ways *= 2) {
+            auto cache = CacheTagArray::create( "LRU", size, ways, 32, 32);
+            const auto r = CacheRunner::create( cache.get())->run( filename);
+            CHECK( analyzer.get_accesses() == r.accesses);
+            CHECK( analyzer.get_compulsory_misses() == r.compulsory_misses);
+            CHECK( analyzer.get_hits( size, ways) == r.hits);
+        }
+    }
+    std::filesystem::remove( filename);
+}
+
+TEST_CASE("StackDistance: dump")
+{
+    StackDistanceAnalyzer analyzer( 128, 2, 64);
+    for ( Addr addr : { 0x0, 0x40, 0x0, 0x80})
+        analyzer.access( addr);
+
+    std::ostringstream oss;
+    analyzer.dump( oss);
+    CHECK( oss.str() ==
+        "total accesses: 4\n"
+        "compulsory misses: 3\n"
+        "        size    sets  ways    hit rate\n"
+        "          64       1     1          0%\n"
+        "         128       2     1         25%\n"
+        "         128       1     2         25%\n");
+}
+
+TEST_CASE("CacheRunner: parallel runner with replacement policies")
+{
+    const auto filename = write_random_trace( "mipt_trace_parallel_policies.bin", 20000);
+    for ( const std::string type : { "SRRIP", "BRRIP", "DRRIP", "SHiP", "random", "FIFO" }) {
+        auto cache = CacheTagArray::create( type, 2048, 4, 32, 32);
+        const auto expected = CacheRunner::create( cache.get())->run( filename);
+        const auto r = CacheRunner::create_parallel( type, 2048, 4, 32, 4)->run( filename);
+        CHECK( r.accesses == expected.accesses);
+        CHECK( r.hits == expected.hits);
+        CHECK( r.compulsory_misses == expected.compulsory_misses);
+    }
+    std::filesystem::remove( filename);
+}
+
+TEST_CASE("CacheRunner: compulsory misses are tracked by lines")
+{
+    const auto filename = get_temp_file( "mipt_trace_lines.bin");
+    {
+        std::ofstream out( filename, std::ios::binary);
+        BinaryTraceWriter writer( out);
+        for ( Addr addr : { 0x1000, 0x1008, 0x1040, 0x1000})
+            writer.write( { addr, 0, MemoryAccessType::READ, false });
+    }
+
+    // Lines are evicted, but only the first access of each line is a compulsory miss
+    auto cache = CacheTagArray::create( "LRU", 64, 1, 64, 32);
+    const auto r = CacheRunner::create( cache.get(), 64)->run( filename);
+    CHECK( r.accesses == 4);
+    CHECK( r.hits == 1);
+    CHECK( r.compulsory_misses == 2);
+    CHECK( r.history_memory >= 4096);
+
+    auto infinite = CacheTagArray::create( "infinite", 64, 1, 64, 32);
+    const auto r_infinite = CacheRunner::create( infinite.get(), 64)->run( filename);
+    CHECK( r_infinite.hits == 2);
+    CHECK( r_infinite.compulsory_misses == 2);
+    std::filesystem::remove( filename);
+}
@@ -0,0 +1,159 @@
+/**
+ * Memory traces for standalone cache simulator
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include "trace.h"
+
+#include <infra/macro.h>
+#include <infra/mapped_file.h>
+#include <infra/varint.h>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <array>
+#include <fstream>
+
+static const std::array<char, 8> binary_trace_magic = { 'M', 'I', 'P', 'T', 'T', 'R', 'C', '1' };
+
+class BinaryTraceReader : public TraceReader
+{
+public:
+    explicit BinaryTraceReader( const std::string& filename)
+        : file( filename)
+        , ptr( file.begin() + binary_trace_magic.size())
+    { }
+
+    bool read( MemoryAccess* access) final;
+
+private:
+    uint64 read_next();
+
+    MappedFile file;
+    const unsigned char* ptr;
+    Addr last_addr = 0;
+    Addr last_pc = 0;
+};
+
+uint64 BinaryTraceReader::read_next()
+{
+    uint64 value = 0;
+    if ( !read_varint( &ptr, file.end(), &value))
+        throw InvalidTrace( "unexpected end or too long varint in binary trace");
+
+    return value;
+}
+
+bool BinaryTraceReader::read( MemoryAccess* access)
+{
+    if ( ptr == file.end())
+        return false;
+
+    const auto header = read_next();
+    const auto type = header & 3U;
+    if ( type > uint64( MemoryAccessType::FETCH))
+        throw InvalidTrace( "unknown access type in binary trace");
+
+    access->type = MemoryAccessType( type);
+    access->has_pc = ( header & 4U) != 0;
+    access->addr = last_addr = zigzag_decode( header >> 3U, last_addr);
+    access->pc = access->has_pc ? ( last_pc = zigzag_decode( read_next(), last_pc)) : 0;
+    return true;
+}
+
+// Legacy format: { "memory_trace": [ "0x1000", ... ] }
+class JSONTraceReader : public TraceReader
+{
+public:
+    explicit JSONTraceReader( const std::string& filename)
+    {
+        read_json( filename, trace);
+        accesses = &trace.get_child( "memory_trace");
+        it = accesses->begin();
+    }
+
+    bool read( MemoryAccess* access) final
+    {
+        if ( it == accesses->end())
+            return false;
+
+        *access = MemoryAccess();
+        access->addr = std::stoull( it->second.get_value<std::string>(), nullptr, 0);
+        ++it;
+        return true;
+    }
+
+private:
+    boost::property_tree::ptree trace;
+    const boost::property_tree::ptree* accesses = nullptr;
+    boost::property_tree::ptree::const_iterator it;
+};
+
+static bool is_binary_trace( const std::string& filename)
+{
+    std::ifstream file( filename, std::ios::binary);
+    std::array<char, binary_trace_magic.size()> magic = {};
+    file.read( magic.data(), magic.size());
+    return file && magic == binary_trace_magic;
+}
+
+std::unique_ptr<TraceReader> TraceReader::create( const std::string& filename)
+{
+    if ( is_binary_trace( filename))
+        return std::make_unique<BinaryTraceReader>( filename);
+
+    return std::make_unique<JSONTraceReader>( filename);
+}
+
+BinaryTraceWriter::BinaryTraceWriter( std::ostream& out) : out( out)
+{
+    out.write( binary_trace_magic.data(), binary_trace_magic.size());
+}
+
+void BinaryTraceWriter::write( const MemoryAccess& access)
+{
+    const uint64 delta = zigzag_encode( access.addr, last_addr);
+    if ( delta >> 61U != 0)
+        throw InvalidTrace( "too large address delta for binary trace");
+
+    write_varint( out, ( delta << 3U) | ( access.has_pc ? 4U : 0U) | uint64( access.type));
+    last_addr = access.addr;
+
+    if ( access.has_pc) {
+        write_varint( out, zigzag_encode( access.pc, last_pc));
+        last_pc = access.pc;
+    }
+}
+
+static bool has_json_extension( const std::string& filename)
+{
+    const std::string_view extension = ".json";
+    return filename.size() >= extension.size()
+        && filename.compare( filename.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+uint64 convert_trace( const std::string& input, const std::string& output)
+{
+    auto reader = TraceReader::create( input);
+    std::ofstream out( output, std::ios::binary);
+    if ( !out)
+        throw InvalidTrace( "cannot open " + output);
+
+    uint64 count = 0;
+    MemoryAccess access;
+    if ( has_json_extension( output)) {
+        out << "{\n    \"memory_trace\":\n    [";
+        while ( reader->read( &access))
+            out << ( count++ == 0 ? "\n" : ",\n") << "        \"0x" << std::hex << access.addr << '"';
+        out << "\n    ]\n}\n";
+        return count;
+    }
+
+    BinaryTraceWriter writer( out);
+    while ( reader->read( &access)) {
+        writer.write( access);
+        ++count;
+    }
+    return count;
+}
@@ -0,0 +1,78 @@
+/**
+ * Memory traces for standalone cache simulator
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef CACHE_TRACE_H
+#define CACHE_TRACE_H
+
+#include <infra/exception.h>
+#include <infra/types.h>
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+
+struct InvalidTrace final : Exception
+{
+    explicit InvalidTrace( const std::string& msg)
+        : Exception( "Invalid memory trace", msg)
+    { }
+};
+
+enum class MemoryAccessType : uint8
+{
+    READ,
+    WRITE,
+    FETCH
+};
+
+struct MemoryAccess
+{
+    Addr addr = 0;
+    Addr pc = 0;
+    MemoryAccessType type = MemoryAccessType::READ;
+    bool has_pc = false;
+};
+
+/*
+ * Binary trace is a header followed by records of one or two LEB128 varints.
+ * The first varint packs zigzag-encoded delta from the previous address,
+ * presence of PC and access type: ( delta << 3) | ( has_pc << 2) | type.
+ * If PC is present, it follows as a zigzag-encoded delta from the previous PC.
+ * A record without PC takes a single byte if the delta is within [-8, 7],
+ * and two bytes if it is within [-1024, 1023], e.g. for 64-byte line strides.
+ */
+class TraceReader
+{
+public:
+    TraceReader() = default;
+    virtual ~TraceReader() = default;
+    TraceReader( const TraceReader&) = delete;
+    TraceReader( TraceReader&&) = delete;
+    TraceReader& operator=( const TraceReader&) = delete;
+    TraceReader& operator=( TraceReader&&) = delete;
+
+    // Detects trace format by its header, JSON is read as a legacy format
+    static std::unique_ptr<TraceReader> create( const std::string& filename);
+
+    // Returns false at the end of the trace
+    virtual bool read( MemoryAccess* access) = 0;
+};
+
+class BinaryTraceWriter
+{
+public:
+    explicit BinaryTraceWriter( std::ostream& out);
+    void write( const MemoryAccess& access);
+
+private:
+    std::ostream& out;
+    Addr last_addr = 0;
+    Addr last_pc = 0;
+};
+
+// Output format is selected by extension: '.json' for legacy format, binary otherwise
+uint64 convert_trace( const std::string& input, const std::string& output);
+
+#endif
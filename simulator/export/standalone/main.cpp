@@ -5,16 +5,23 @@
  */
 
 /* Simulator modules. */
+#include <func_sim/multi_hart_sim.h>
 #include <infra/config/config.h>
 #include <infra/config/main_wrapper.h>
 #include <kernel/kernel.h>
 #include <memory/memory.h>
+#include <modules/core/multi_core_sim.h>
+#include <modules/core/perf_config.h>
 #include <simulator.h>
 
+#include <type_traits>
+
 namespace config {
     static const AliasedRequiredValue<std::string> binary_filename = { "b", "binary", "input binary file"};
     static const AliasedValue<uint64> num_steps = { "n", "numsteps", MAX_VAL64, "number of instructions to run"};
     static const Value<std::string> trap_mode = { "trap_mode",  "", "trap handler mode"};
+    static const Value<uint32> harts = { "harts", 1, "number of harts sharing memory"};
+    static const Value<uint64> hart_quantum = { "hart-quantum", 0, "harts synchronization quantum in instructions (functional) or cycles (performance), 0 runs functional harts freely and performance cores exactly: data accesses are ordered cycle by cycle, cores are run sequentially if they outnumber host threads, and code must not be modified during the run"};
 } // namespace config
 
 class Main : public MainWrapper
@@ -23,14 +30,60 @@ class Main : public MainWrapper
 private:
     // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays, modernize-avoid-c-arrays, hicpp-avoid-c-arrays)
     int impl( int argc, const char* argv[]) const final; 
+    static int run_multi_hart();
 };
 
-// NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays, modernize-avoid-c-arrays, hicpp-avoid-c-arrays)
-int Main::impl( int argc, const char* argv[]) const {
-    config::handleArgs( argc, argv, 1);
-    auto memory = FuncMemory::create_default_hierarchied_memory();
+// Each hart has its own kernel, the binary is loaded once to the shared memory
+template<typename Sim, typename Hart>
+static int run_harts( const std::vector<std::shared_ptr<Hart>>& harts)
+{
+    Sim sim( harts);
+    sim.set_memory( FuncMemory::create_default_hierarchied_memory());
+    sim.set_quantum( config::hart_quantum);
+    if constexpr ( std::is_same_v<Sim, MultiCoreSim>) {
+        auto perf_config = PerfConfig::create_configured();
+        if ( perf_config.coherence.enabled)
+            sim.enable_coherence( perf_config);
+    }
 
-    auto sim = Simulator::create_configured_simulator();
+    std::vector<std::shared_ptr<Kernel>> kernels;
+    for ( size_t i = 0; i < harts.size(); ++i) {
+        harts[i]->write_csr_register( "mscratch", 0x400'0000);
+        auto kernel = Kernel::create_configured_kernel();
+        kernel->set_simulator( harts[i]);
+        kernel->connect_memory( sim.get_memory( i));
+        kernel->connect_exception_handler();
+        harts[i]->set_kernel( kernel);
+        kernels.emplace_back( kernel);
+    }
+
+    kernels.front()->load_file( config::binary_filename);
+    sim.set_pc( kernels.front()->get_start_pc());
+    sim.run( config::num_steps);
+    return sim.get_exit_code();
+}
+
+int Main::run_multi_hart()
+{
+    std::vector<std::shared_ptr<Simulator>> harts;
+    std::vector<std::shared_ptr<CycleAccurateSimulator>> cores;
+    for ( uint32 i = 0; i < config::harts; ++i) {
+        harts.emplace_back( Simulator::create_configured_simulator());
+        auto core = std::dynamic_pointer_cast<CycleAccurateSimulator>( harts.back());
+        if ( core != nullptr)
+            cores.emplace_back( std::move( core));
+    }
+
+    if ( cores.size() == harts.size())
+        return run_harts<MultiCoreSim>( cores);
+
+    return run_harts<MultiHartSim>( harts);
+}
+
+// Hardware threads run their own copies of the binary in separate memories
+static void load_program( const std::shared_ptr<Simulator>& sim)
+{
+    auto memory = FuncMemory::create_default_hierarchied_memory();
     sim->set_memory( memory);
     sim->write_csr_register( "mscratch", 0x400'0000);
 
@@ -42,8 +95,27 @@ int Main::impl( int argc, const char* argv[]) const {
     sim->set_kernel( kernel);
 
     sim->set_pc( kernel->get_start_pc());
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays, modernize-avoid-c-arrays, hicpp-avoid-c-arrays)
+int Main::impl( int argc, const char* argv[]) const {
+    config::handleArgs( argc, argv, 1);
+    if ( config::harts > 1)
+        return run_multi_hart();
+
+    auto sim = Simulator::create_configured_simulator();
+    load_program( sim);
+    for ( size_t i = 1; i < sim->get_threads_num(); ++i) {
+        auto thread = sim->get_thread( i);
+        thread->write_csr_register( "mhartid", i);
+        load_program( thread);
+    }
+
     sim->run( config::num_steps);
-    return sim->get_exit_code();
+    auto exit_code = sim->get_exit_code();
+    for ( size_t i = 1; i < sim->get_threads_num() && exit_code == 0; ++i)
+        exit_code = sim->get_thread( i)->get_exit_code();
+    return exit_code;
 }
 
 int main( int argc, const char* argv[]) {
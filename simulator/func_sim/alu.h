@@ -35,6 +35,7 @@ struct ALU
     // Generic
     using Predicate = bool (*)( const Instr*);
     using Execute = void (*)( Instr*);
+    using AtomicOp = typename Instr::AtomicOp;
     using RegisterUInt = typename Instr::RegisterUInt;
     using RegisterSInt = typename Instr::RegisterSInt;
     
@@ -113,6 +114,38 @@ struct ALU
 
     static void addr( Instr* instr) { instr->mem_addr = narrow_cast<Addr>( instr->v_src[0] + instr->v_imm); }
 
+    // Atomics: the value is stored by memory, destination register is not masked
+    static void atomic_addr( Instr* instr) {
+        addr( instr);
+        if ( instr->mem_addr % instr->mem_size != 0)
+            instr->trap = Trap::UNALIGNED_STORE;
+    }
+
+    static void riscv_store_conditional( Instr* instr) {
+        atomic_addr( instr);
+        instr->sc_returns_zero_on_success = true;
+    }
+
+    template<AtomicOp op> static void atomic( Instr* instr) {
+        atomic_addr( instr);
+        instr->atomic_op = op;
+    }
+
+    // Read-modify-write operations applied by memory to the loaded value
+    static RegisterUInt amo_swap( RegisterUInt /* loaded */, RegisterUInt src) { return src; }
+    static RegisterUInt amo_add( RegisterUInt loaded, RegisterUInt src) { return loaded + src; }
+    static RegisterUInt amo_xor( RegisterUInt loaded, RegisterUInt src) { return loaded ^ src; }
+    static RegisterUInt amo_and( RegisterUInt loaded, RegisterUInt src) { return loaded & src; }
+    static RegisterUInt amo_or( RegisterUInt loaded, RegisterUInt src)  { return loaded | src; }
+    template<typename T> static RegisterUInt amo_min( RegisterUInt loaded, RegisterUInt src)
+        { return narrow_cast<sign_t<T>>( loaded) < narrow_cast<sign_t<T>>( src) ? loaded : src; }
+    template<typename T> static RegisterUInt amo_max( RegisterUInt loaded, RegisterUInt src)
+        { return narrow_cast<sign_t<T>>( loaded) > narrow_cast<sign_t<T>>( src) ? loaded : src; }
+    template<typename T> static RegisterUInt amo_minu( RegisterUInt loaded, RegisterUInt src)
+        { return narrow_cast<T>( loaded) < narrow_cast<T>( src) ? loaded : src; }
+    template<typename T> static RegisterUInt amo_maxu( RegisterUInt loaded, RegisterUInt src)
+        { return narrow_cast<T>( loaded) > narrow_cast<T>( src) ? loaded : src; }
+
     // Predicate helpers - unary
     static bool lez( const Instr* instr) { return narrow_cast<RegisterSInt>( instr->v_src[0]) <= 0; }
     static bool gez( const Instr* instr) { return narrow_cast<RegisterSInt>( instr->v_src[0]) >= 0; }
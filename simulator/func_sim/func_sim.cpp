@@ -40,6 +40,15 @@ void FuncSim<ISA>::update_and_check_nop_counter( const FuncInstr& instr)
         throw BearingLost();
 }
 
+template <typename FuncInstr>
+static BPInterface get_jump_record( const FuncInstr& instr)
+{
+    const Addr target = instr.is_indirect_jump() ? instr.get_new_PC() : instr.get_decoded_target();
+    BPInterface record( instr.get_PC(), instr.is_taken(), target, true);
+    record.kind = { instr.is_branch(), instr.is_call(), instr.is_return(), instr.is_indirect_jump() };
+    return record;
+}
+
 template <typename ISA>
 typename FuncSim<ISA>::FuncInstr FuncSim<ISA>::step()
 {
@@ -48,10 +57,12 @@ typename FuncSim<ISA>::FuncInstr FuncSim<ISA>::step()
     sequence_id++;
     rf.read_sources( &instr);
     instr.execute();
-    mem->load_store( &instr);
+    mem->load_store( &instr, &reservation);
     rf.write_dst( instr);
     update_pc( instr);
     update_and_check_nop_counter( instr);
+    if ( jump_observer && instr.is_jump())
+        jump_observer( get_jump_record( instr));
     return instr;
 }
 
@@ -83,7 +94,6 @@ Trap FuncSim<ISA>::driver_step( const Operation& instr)
 template <typename ISA>
 Trap FuncSim<ISA>::run( uint64 instrs_to_run)
 {
-    nops_in_a_row = 0;
     for ( uint64 i = 0; i < instrs_to_run; ++i) {
         auto instr = step();
         sout << instr << std::endl;
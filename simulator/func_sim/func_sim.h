@@ -13,8 +13,10 @@
 #include <infra/config/config.h>
 #include <infra/exception.h>
 #include <memory/memory.h>
+#include <modules/fetch/bpu/bp_interface.h>
 #include <simulator.h>
 
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -23,8 +25,17 @@ class Operation;
 
 // NOLINTNEXTLINE(fuchsia-multiple-inheritance) Cannot inherit Simulator from Log, since PerfSim inherits Module as well
 class BasicFuncSim : public Simulator, public Log {
+public:
+    // Observer gets each executed jump as an update of branch predictor, e.g. to record a branch trace
+    using JumpObserver = std::function<void( const BPInterface&)>;
+    void set_jump_observer( JumpObserver observer) { jump_observer = std::move( observer); }
+
+    static std::shared_ptr<BasicFuncSim> create_simulator( const std::string& isa, bool log);
+    static std::shared_ptr<BasicFuncSim> create_configured_simulator();
+
 protected:
     explicit BasicFuncSim( std::string_view isa) : Simulator( isa) { }
+    JumpObserver jump_observer;
 };
 
 template <typename ISA>
@@ -38,6 +49,7 @@ class FuncSim : public BasicFuncSim
         RF<FuncInstr> rf;
         uint64 sequence_id = 0;
         std::shared_ptr<FuncMemory> mem;
+        Reservation reservation;
         InstrMemoryCached<ISA> imem;
         std::shared_ptr<Kernel> kernel;
         std::unique_ptr<Driver> driver;
@@ -68,6 +80,7 @@ class FuncSim : public BasicFuncSim
             pc[0] = target.address;
             delayed_slots = 0;
             sequence_id = target.sequence_id;
+            nops_in_a_row = 0;
         }
         Addr get_pc() const final { return pc[0]; }
 
@@ -0,0 +1,106 @@
+/*
+ * multi_hart_sim.cpp - functional simulation of several harts sharing memory
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include "multi_hart_sim.h"
+
+#include <memory/memory.h>
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+
+MultiHartSim::MultiHartSim( std::vector<std::shared_ptr<Simulator>> h) : harts( std::move( h))
+{
+    if ( harts.empty())
+        throw InvalidHartsNumber( "at least one hart is required");
+
+    for ( size_t i = 0; i < harts.size(); ++i)
+        harts[i]->write_csr_register( "mhartid", i);
+}
+
+void MultiHartSim::set_memory( std::shared_ptr<FuncMemory> m)
+{
+    memory = FuncMemory::create_synchronized_memory( std::move( m));
+    for ( auto& hart : harts)
+        hart->set_memory( memory);
+}
+
+void MultiHartSim::set_pc( Addr pc)
+{
+    for ( auto& hart : harts)
+        hart->set_pc( pc);
+}
+
+Trap MultiHartSim::run( uint64 instrs_per_hart)
+{
+    return quantum == 0 ? run_threaded( instrs_per_hart) : run_interleaved( instrs_per_hart);
+}
+
+int MultiHartSim::get_exit_code() const
+{
+    for ( const auto& hart : harts)
+        if ( hart->get_exit_code() != 0)
+            return hart->get_exit_code();
+
+    return 0;
+}
+
+Trap MultiHartSim::run_threaded( uint64 instrs_per_hart)
+{
+    std::vector<Trap> traps( harts.size(), Trap( Trap::NO_TRAP));
+    std::vector<std::exception_ptr> exceptions( harts.size());
+    std::vector<std::thread> threads;
+    threads.reserve( harts.size());
+
+    for ( size_t i = 0; i < harts.size(); ++i)
+        threads.emplace_back( [this, i, instrs_per_hart, &traps, &exceptions]() {
+            try {
+                traps[i] = harts[i]->run( instrs_per_hart);
+            }
+            catch ( ...) {
+                exceptions[i] = std::current_exception();
+            }
+        });
+
+    for ( auto& thread : threads)
+        thread.join();
+
+    for ( const auto& e : exceptions)
+        if ( e != nullptr)
+            std::rethrow_exception( e);
+
+    return merge_traps( traps);
+}
+
+Trap MultiHartSim::run_interleaved( uint64 instrs_per_hart)
+{
+    std::vector<Trap> traps( harts.size(), Trap( Trap::BREAKPOINT));
+    for ( uint64 remaining = instrs_per_hart; remaining > 0; ) {
+        auto instrs = std::min( quantum, remaining);
+        remaining -= instrs;
+        bool any_running = false;
+        for ( size_t i = 0; i < harts.size(); ++i) {
+            if ( traps[i] != Trap::BREAKPOINT)
+                continue;
+
+            traps[i] = harts[i]->run( instrs);
+            any_running |= traps[i] == Trap::BREAKPOINT;
+        }
+        if ( !any_running)
+            break;
+    }
+    return merge_traps( traps);
+}
+
+Trap MultiHartSim::merge_traps( const std::vector<Trap>& traps)
+{
+    auto it = std::find_if( traps.begin(), traps.end(),
+                            []( Trap t) { return t != Trap::HALT && t != Trap::BREAKPOINT; });
+    if ( it != traps.end())
+        return *it;
+
+    bool all_halted = std::all_of( traps.begin(), traps.end(), []( Trap t) { return t == Trap::HALT; });
+    return all_halted ? Trap( Trap::HALT) : Trap( Trap::BREAKPOINT);
+}
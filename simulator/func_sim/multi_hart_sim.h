@@ -0,0 +1,58 @@
+/*
+ * multi_hart_sim.h - functional simulation of several harts sharing memory
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef MULTI_HART_SIM_H
+#define MULTI_HART_SIM_H
+
+#include <infra/exception.h>
+#include <simulator.h>
+
+#include <memory>
+#include <vector>
+
+class FuncMemory;
+
+struct InvalidHartsNumber final : Exception
+{
+    explicit InvalidHartsNumber( const std::string& msg)
+        : Exception( "Invalid number of harts", msg)
+    { }
+};
+
+class MultiHartSim
+{
+public:
+    explicit MultiHartSim( std::vector<std::shared_ptr<Simulator>> harts);
+
+    size_t get_harts_num() const { return harts.size(); }
+    const std::shared_ptr<Simulator>& get_hart( size_t index) const { return harts.at( index); }
+
+    // Memory is wrapped to be safely shared between host threads
+    void set_memory( std::shared_ptr<FuncMemory> memory);
+    const std::shared_ptr<FuncMemory>& get_memory() const { return memory; }
+    const std::shared_ptr<FuncMemory>& get_memory( size_t /* hart */) const { return memory; }
+
+    void set_pc( Addr pc);
+
+    // Zero quantum runs each hart in its own host thread,
+    // otherwise harts are interleaved by the quantum of instructions in a deterministic order
+    void set_quantum( uint64 value) { quantum = value; }
+
+    Trap run( uint64 instrs_per_hart);
+
+    // The first non-zero exit code of harts, so a failure of any hart is reported
+    int get_exit_code() const;
+
+private:
+    Trap run_threaded( uint64 instrs_per_hart);
+    Trap run_interleaved( uint64 instrs_per_hart);
+    static Trap merge_traps( const std::vector<Trap>& traps);
+
+    std::vector<std::shared_ptr<Simulator>> harts;
+    std::shared_ptr<FuncMemory> memory;
+    uint64 quantum = 0;
+};
+
+#endif // MULTI_HART_SIM_H
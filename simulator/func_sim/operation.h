@@ -37,6 +37,9 @@ enum OperationType : uint8
     OUT_LOADU,
     OUT_PARTIAL_LOAD,
     OUT_STORE,
+    OUT_LOAD_RESERVED,
+    OUT_STORE_CONDITIONAL,
+    OUT_ATOMIC,
     OUT_J_JUMP,
     OUT_J_SPECIAL,
     OUT_FPU,
@@ -101,7 +104,13 @@ public:
     bool is_partial_load()  const { return operation == OUT_PARTIAL_LOAD; }
     bool is_unsigned_load() const { return operation == OUT_LOADU; }
     bool is_signed_load()   const { return operation == OUT_LOAD; }
-    bool is_load() const { return is_unsigned_load() || is_signed_load() || is_partial_load(); }
+    bool is_load_reserved() const { return operation == OUT_LOAD_RESERVED; }
+    bool is_store_conditional() const { return operation == OUT_STORE_CONDITIONAL; }
+    bool is_atomic() const { return operation == OUT_ATOMIC; }
+
+    // Atomics deliver their destination value from memory as loads do
+    bool is_load() const { return is_unsigned_load() || is_signed_load() || is_partial_load()
+                               || is_load_reserved() || is_store_conditional() || is_atomic(); }
 
     int8 get_accumulation_type() const
     {
@@ -114,9 +123,11 @@ public:
     bool is_divmult() const { return operation == OUT_DIVMULT || get_accumulation_type() != 0; }
 
     bool is_explicit_trap() const { return operation == OUT_TRAP; }
+    // system calls, breakpoints and traps redirect the flow only at writeback
+    bool is_system() const { return operation == OUT_SYSCALL || operation == OUT_BREAK || is_explicit_trap(); }
     bool has_trap() const { return trap_type() != Trap::NO_TRAP; }
     void set_trap( Trap value) { trap = value; }
-    bool is_store() const { return operation == OUT_STORE; }
+    bool is_store() const { return operation == OUT_STORE || is_store_conditional() || is_atomic(); }
 
     auto get_mem_addr() const { return mem_addr; }
     auto get_mem_size() const { return mem_size; }
@@ -171,6 +182,7 @@ public:
     friend MIPSMultALU<Datapath>;
 
     using Execute = void (*)(Datapath*);
+    using AtomicOp = T (*)(T, T);
     using RegisterUInt = T;
     using RegisterSInt = sign_t<RegisterUInt>;
 
@@ -189,6 +201,8 @@ public:
     bool is_dst_complete() const { return is_load() ? memory_complete : complete; }
 
     void load( const T& value);
+    void store_conditional( bool success);
+    T get_atomic_result( const T& loaded) const { return atomic_op( loaded, get_v_src( 1)); }
     void execute();
 
 protected:
@@ -200,6 +214,8 @@ protected:
     T mask = all_ones<T>();
 
     Execute executor;
+    AtomicOp atomic_op = nullptr;
+    bool sc_returns_zero_on_success = false;
 
 private:
     bool complete   = false;
@@ -221,6 +237,14 @@ void Datapath<T>::load( const T& value)
     set_v_dst( is_unsigned_load() ? value : sign_extension_for_load(value), 0);
 }
 
+template<typename T>
+void Datapath<T>::store_conditional( bool success)
+{
+    memory_complete = true;
+    assert( is_store_conditional());
+    set_v_dst( success != sc_returns_zero_on_success ? 1 : 0, 0);
+}
+
 template<typename T, typename R>
 class BaseInstruction : public Datapath<T>
 {
@@ -233,6 +257,10 @@ public:
     void set_src( R reg, size_t index) { src.at( index) = reg; }
     void set_dst( R reg, size_t index) { dst.at( index) = reg; }
 
+    // Calls and returns are recognized by the link register, as return address stacks do
+    bool is_call() const { return this->is_jump() && get_dst( 0) == R::return_address(); }
+    bool is_return() const { return this->is_indirect_jump() && !is_call() && get_src( 0) == R::return_address(); }
+
     std::ostream& dump_content( std::ostream& out, const std::string& disasm) const;
 
 protected:
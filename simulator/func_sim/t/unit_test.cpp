@@ -6,6 +6,7 @@
 #include <catch.hpp>
 
 #include <func_sim/func_sim.h>
+#include <func_sim/multi_hart_sim.h>
 #include <kernel/kernel.h>
 #include <memory/memory.h>
 #include <mips/mips_register/mips_register.h>
@@ -202,3 +203,114 @@ TEST_CASE( "Torture_Test: integration")
     CHECK( riscv_tt("riscv64", TEST_PATH "/riscv/rv64ui-p-simple", "default"));
     CHECK( riscv_tt("riscv64", TEST_PATH "/riscv/rv64uc-p-rvc", "mars"));
 }
+
+// Each hart increments a shared counter with ll/sc loop and exits
+static void write_counter_program( const std::shared_ptr<FuncMemory>& mem, Addr pc, uint16 iterations)
+{
+    const std::vector<uint32> program = {
+        0x3c081001,               // lui   $t0, 0x1001
+        0x24090000U | iterations, // addiu $t1, $zero, iterations
+        0xc10a0000,               // ll    $t2, 0($t0)
+        0x254a0001,               // addiu $t2, $t2, 1
+        0xe10a0000,               // sc    $t2, 0($t0)
+        0x1140fffc,               // beq   $t2, $zero, -4
+        0x2529ffff,               // addiu $t1, $t1, -1
+        0x1520fffa,               // bne   $t1, $zero, -6
+        0x2402000a,               // addiu $v0, $zero, 10
+        0x0000000c                // syscall
+    };
+    for ( size_t i = 0; i < program.size(); ++i)
+        mem->write<uint32, std::endian::little>( program[i], pc + i * 4);
+}
+
+static uint32 run_counter_harts( size_t harts_num, uint64 quantum)
+{
+    std::vector<std::shared_ptr<Simulator>> harts;
+    for ( size_t i = 0; i < harts_num; ++i)
+        harts.emplace_back( Simulator::create_functional_simulator( "mars"));
+
+    MultiHartSim sim( harts);
+    sim.set_memory( FuncMemory::create_default_hierarchied_memory());
+    sim.set_quantum( quantum);
+    for ( const auto& hart : harts) {
+        auto kernel = Kernel::create_kernel( true, std::cin, nullout(), nullout());
+        kernel->set_simulator( hart);
+        kernel->connect_memory( sim.get_memory());
+        kernel->connect_exception_handler();
+        hart->set_kernel( kernel);
+    }
+
+    // Counter crosses the halfword boundary, so sc has to store the full word
+    const uint32 initial = 0xfff0;
+    sim.get_memory()->write<uint32, std::endian::little>( initial, 0x10010000);
+    write_counter_program( sim.get_memory(), 0x400000, 1000);
+    sim.set_pc( 0x400000);
+    CHECK( sim.run( 100000) == Trap::HALT);
+    return sim.get_memory()->read<uint32, std::endian::little>( 0x10010000) - initial;
+}
+
+TEST_CASE( "MultiHartSim: no harts")
+{
+    CHECK_THROWS_AS( MultiHartSim( {}), InvalidHartsNumber);
+}
+
+TEST_CASE( "MultiHartSim: ll/sc counter, threads")
+{
+    CHECK( run_counter_harts( 4, 0) == 4000);
+}
+
+TEST_CASE( "MultiHartSim: ll/sc counter, deterministic quantum")
+{
+    CHECK( run_counter_harts( 1, 7) == 1000);
+    CHECK( run_counter_harts( 4, 1) == 4000);
+    CHECK( run_counter_harts( 4, 7) == 4000);
+}
+
+TEST_CASE( "MultiHartSim: budget exhaustion")
+{
+    std::vector<std::shared_ptr<Simulator>> harts = { Simulator::create_functional_simulator( "mars") };
+    MultiHartSim sim( harts);
+    sim.set_memory( FuncMemory::create_default_hierarchied_memory());
+    sim.set_quantum( 3);
+    write_counter_program( sim.get_memory(), 0x400000, 1000);
+    sim.set_pc( 0x400000);
+    CHECK( sim.run( 10) == Trap::BREAKPOINT);
+    CHECK( sim.get_hart( 0)->get_pc() == 0x400000 + 4 * 4);
+}
+
+TEST_CASE( "MultiHartSim: exit code of a failed secondary hart")
+{
+    for ( uint64 quantum : { 0, 1}) {
+        std::vector<std::shared_ptr<Simulator>> harts;
+        for ( size_t i = 0; i < 2; ++i)
+            harts.emplace_back( Simulator::create_functional_simulator( "mars"));
+
+        MultiHartSim sim( harts);
+        sim.set_memory( FuncMemory::create_default_hierarchied_memory());
+        sim.set_quantum( quantum);
+        for ( const auto& hart : harts) {
+            auto kernel = Kernel::create_kernel( true, std::cin, nullout(), nullout());
+            kernel->set_simulator( hart);
+            kernel->connect_memory( sim.get_memory());
+            kernel->connect_exception_handler();
+            hart->set_kernel( kernel);
+        }
+
+        // The first hart exits with 0, the second one with 3
+        const std::vector<uint32> program = {
+            0x2402000a,     // addiu $v0, $zero, 10
+            0x0000000c,     // syscall
+            0x24040003,     // addiu $a0, $zero, 3
+            0x24020011,     // addiu $v0, $zero, 17
+            0x0000000c      // syscall
+        };
+        for ( size_t i = 0; i < program.size(); ++i)
+            sim.get_memory()->write<uint32, std::endian::little>( program[i], 0x400000 + i * 4);
+
+        sim.set_pc( 0x400000);
+        sim.get_hart( 1)->set_pc( 0x400008);
+        CHECK( sim.run( 100) == Trap::HALT);
+        CHECK( sim.get_hart( 0)->get_exit_code() == 0);
+        CHECK( sim.get_exit_code() == 3);
+    }
+}
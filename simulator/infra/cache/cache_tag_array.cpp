@@ -7,10 +7,12 @@
 
 #include "infra/cache/cache_tag_array.h"
 #include "infra/macro.h"
+#include "infra/paged_bitset.h"
 #include "infra/replacement/cache_replacement.h"
 
 #include <sparsehash/dense_hash_map.h>
 
+#include <bit>
 #include <utility>
 #include <vector>
 
@@ -19,53 +21,31 @@ class AlwaysHitCacheTagArray : public CacheTagArray
     public:
         uint32 set( Addr /* unused */) const final { return 0; }
         Addr tag( Addr addr) const final { return addr; }
-        int32 write( Addr /* unused */) final { return -1; }
+        int32 write( Addr /* unused */, Addr /* pc */) final { return -1; }
         std::pair<bool, int32> read( Addr addr) final { return read_no_touch( addr); }
         std::pair<bool, int32> read_no_touch( Addr /* unused */) const final { return {true, -1}; }
+        void invalidate( Addr /* unused */) final { }
 };
 
+// Tracks lines in a bitset, so memory is bounded by the touched address space
 class InfiniteCacheTagArray : public CacheTagArray
 {
     public:
-        InfiniteCacheTagArray() {
-            lookup_helper.set_empty_key( impossible_key);
-            lookup_helper.set_deleted_key( impossible_key - 1);
-        }
+        explicit InfiniteCacheTagArray( uint32 line_size)
+            : line_bits( is_power_of_two( line_size) ? std::countr_zero( line_size) : 0)
+        { }
 
         uint32 set( Addr /* unused */) const final { return 0; }
         Addr tag( Addr addr) const final { return addr; }
-        int32 write( Addr addr) final;
+        int32 write( Addr addr, Addr /* pc */) final { lines.test_and_set( addr >> line_bits); return -1; }
         std::pair<bool, int32> read( Addr addr) final { return read_no_touch( addr); }
-        std::pair<bool, int32> read_no_touch( Addr addr) const final;
+        std::pair<bool, int32> read_no_touch( Addr addr) const final { return { lines.test( addr >> line_bits), -1 }; }
+        void invalidate( Addr addr) final { lines.reset( addr >> line_bits); }
     private:
-        std::vector<Addr> tags;
-
-        // hash table to lookup tags in O(1)
-        google::dense_hash_map<Addr, int32> lookup_helper;
-        const int32 impossible_key = INT32_MAX;
+        const size_t line_bits;
+        PagedBitset lines;
 };
 
-std::pair<bool, int32> InfiniteCacheTagArray::read_no_touch( Addr addr) const
-{
-    auto res = lookup_helper.find( addr);
-    return res == lookup_helper.end()
-        ? std::pair{ false, -1 }
-        : std::pair{ true, res->second };
-}
-
-int32 InfiniteCacheTagArray::write( Addr addr)
-{
-    auto result = read_no_touch( addr);
-    if ( result.first)
-        return result.second;
-
-    auto way = narrow_cast<int32>( tags.size());
-    tags.emplace_back( addr);
-    lookup_helper.emplace( addr, way);
-
-    return way;
-}
-
 // Cache tag array module implementation
 class CacheTagArraySizeCheck : public CacheTagArray
 {
@@ -83,15 +63,11 @@ class CacheTagArraySizeCheck : public CacheTagArray
         const uint32 addr_size_in_bits;
 };
 
-CacheTagArraySizeCheck::CacheTagArraySizeCheck(
+void check_cache_tag_array_size(
     uint32 size_in_bytes,
     uint32 ways,
     uint32 line_size,
     uint32 addr_size_in_bits)
-    : size_in_bytes( size_in_bytes)
-    , ways( ways)
-    , line_size( line_size)
-    , addr_size_in_bits( addr_size_in_bits)
 {
     if ( size_in_bytes == 0)
         throw CacheTagArrayInvalidSizeException("Cache size should be greater than zero");
@@ -122,6 +98,19 @@ CacheTagArraySizeCheck::CacheTagArraySizeCheck(
         throw CacheTagArrayInvalidSizeException("Cache size should be multiple of");
 }
 
+CacheTagArraySizeCheck::CacheTagArraySizeCheck(
+    uint32 size_in_bytes,
+    uint32 ways,
+    uint32 line_size,
+    uint32 addr_size_in_bits)
+    : size_in_bytes( size_in_bytes)
+    , ways( ways)
+    , line_size( line_size)
+    , addr_size_in_bits( addr_size_in_bits)
+{
+    check_cache_tag_array_size( size_in_bytes, ways, line_size, addr_size_in_bits);
+}
+
 class CacheTagArraySize : public CacheTagArraySizeCheck
 {
     protected:
@@ -154,18 +143,16 @@ class ReplacementModule
     public:
         ReplacementModule( std::size_t number_of_sets, std::size_t number_of_ways, const std::string& replacement_policy);
         void touch( uint32 num_set, uint32 num_way) { replacement_info[ num_set]->touch( num_way); }
-        auto update( uint32 num_set) { return replacement_info[ num_set]->update(); }
+        auto update( uint32 num_set, Addr pc) { return replacement_info[ num_set]->update_with_pc( pc); }
+        void set_to_erase( uint32 num_set, uint32 num_way) { replacement_info[ num_set]->set_to_erase( num_way); }
 
     private:
         std::vector<std::unique_ptr<CacheReplacement>> replacement_info;
 };
 
 ReplacementModule::ReplacementModule( std::size_t number_of_sets, std::size_t number_of_ways, const std::string& replacement_policy)
-    : replacement_info( number_of_sets)
-{
-    for (auto& e : replacement_info)
-        e = create_cache_replacement( replacement_policy, number_of_ways);
-}
+    : replacement_info( create_cache_replacements( replacement_policy, number_of_sets, number_of_ways))
+{ }
 
 class SimpleCacheTagArray : public CacheTagArraySize
 {
@@ -178,9 +165,10 @@ class SimpleCacheTagArray : public CacheTagArraySize
             const std::string& repl_policy
         );
 
-        int32 write( Addr addr) final;
+        int32 write( Addr addr, Addr pc) final;
         std::pair<bool, int32> read( Addr addr) final;
         std::pair<bool, int32> read_no_touch( Addr addr) const final;
+        void invalidate( Addr addr) final;
 
     private:
         struct Tag
@@ -242,13 +230,13 @@ std::pair<bool, int32> SimpleCacheTagArray::read_no_touch( Addr addr) const
            : std::pair{ false, -1};
 }
 
-int32 SimpleCacheTagArray::write( Addr addr)
+int32 SimpleCacheTagArray::write( Addr addr, Addr pc)
 {
     const Addr new_tag = tag( addr);
 
     // get cache coordinates
     const uint32 num_set = set( addr);
-    const auto way = narrow_cast<int32>( replacement_module->update( num_set));
+    const auto way = narrow_cast<int32>( replacement_module->update( num_set, pc));
 
     // get an old tag
     auto& entry = tags[ num_set][ way];
@@ -266,6 +254,18 @@ int32 SimpleCacheTagArray::write( Addr addr)
     return way;
 }
 
+void SimpleCacheTagArray::invalidate( Addr addr)
+{
+    const auto [is_hit, way] = read_no_touch( addr);
+    if ( !is_hit)
+        return;
+
+    const uint32 num_set = set( addr);
+    lookup_helper[ num_set].erase( tag( addr));
+    tags[ num_set][ way].is_valid = false;
+    replacement_module->set_to_erase( num_set, way); // invalid way is the next victim
+}
+
 std::unique_ptr<CacheTagArray> CacheTagArray::create(
     const std::string& type,
     uint32 size_in_bytes,
@@ -276,7 +276,7 @@ std::unique_ptr<CacheTagArray> CacheTagArray::create(
     if ( type == "always_hit")
         return std::make_unique<AlwaysHitCacheTagArray>();
     if ( type == "infinite")
-        return std::make_unique<InfiniteCacheTagArray>();
+        return std::make_unique<InfiniteCacheTagArray>( line_size);
 
     return std::make_unique<SimpleCacheTagArray>( size_in_bytes, ways, line_size, addr_size_in_bits, type);
 }
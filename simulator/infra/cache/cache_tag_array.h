@@ -20,6 +20,9 @@ struct CacheTagArrayInvalidSizeException final : Exception
     { }
 };
 
+// Throws CacheTagArrayInvalidSizeException if the geometry is not supported
+void check_cache_tag_array_size( uint32 size_in_bytes, uint32 ways, uint32 line_size, uint32 addr_size_in_bits);
+
 class CacheTagArray : public Log
 {
 public:
@@ -36,8 +39,12 @@ public:
      * policy.
      *
      * Returns # of updated way
+     *
+     * PC of the access is used by PC-aware replacement policies,
+     * address itself is used if PC is not known.
      */
-    virtual int32 write( Addr addr) = 0;
+    virtual int32 write( Addr addr, Addr pc) = 0;
+    int32 write( Addr addr) { return write( addr, addr); }
 
     /**
      * Returns true and way if the byte with the given address is stored in the cache,
@@ -55,6 +62,12 @@ public:
      */        
     virtual std::pair<bool, int32> read_no_touch( Addr addr) const = 0;
 
+    /**
+     * Removes the block containing the byte with the given address
+     * from the cache, e.g. on coherence invalidation.
+     */
+    virtual void invalidate( Addr addr) = 0;
+
     bool lookup( Addr addr) { return read( addr).first; }; // hit or not
 
     /**
@@ -0,0 +1,65 @@
+/**
+ * flat_tag_array.cpp
+ * Set-associative tag array with contiguous ways.
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include "infra/cache/flat_tag_array.h"
+#include "infra/cache/cache_tag_array.h"
+#include "infra/replacement/cache_replacement.h"
+
+#include <bit>
+
+static uint32 check_and_get_sets( uint32 size_in_bytes, uint32 ways, uint32 line_size, uint32 addr_size_in_bits)
+{
+    check_cache_tag_array_size( size_in_bytes, ways, line_size, addr_size_in_bits);
+    return size_in_bytes / ( ways * line_size);
+}
+
+FlatTagArray::FlatTagArray( const std::string& repl_policy, uint32 size_in_bytes, uint32 ways, uint32 line_size, uint32 addr_size_in_bits)
+    : ways( ways)
+    , stride( ( ways + 3) & ~3U)
+    , sets( check_and_get_sets( size_in_bytes, ways, line_size, addr_size_in_bits))
+    , line_bits( std::countr_zero( line_size))
+    , set_bits( std::countr_zero( sets) + line_bits)
+    , addr_mask( bitmask<Addr>( addr_size_in_bits))
+    , tags( size_t{ sets} * stride, invalid_tag)
+    , replacement( create_cache_replacements( repl_policy, sets, ways))
+{ }
+
+FlatTagArray::~FlatTagArray() = default;
+
+std::pair<bool, int32> FlatTagArray::read( Addr addr)
+{
+    const auto num_set = set( addr);
+    const auto way = find_way( num_set, tag( addr));
+    if ( way < 0)
+        return { false, -1 };
+
+    touch( num_set, way);
+    return { true, way };
+}
+
+void FlatTagArray::touch( uint32 num_set, int32 way)
+{
+    replacement[ num_set]->touch( narrow_cast<size_t>( way));
+}
+
+int32 FlatTagArray::write( Addr addr, Addr pc)
+{
+    const auto num_set = set( addr);
+    const auto way = replacement[ num_set]->update_with_pc( pc);
+    tags[ size_t{ num_set} * stride + way] = tag( addr);
+    return narrow_cast<int32>( way);
+}
+
+void FlatTagArray::invalidate( Addr addr)
+{
+    const auto num_set = set( addr);
+    const auto way = find_way( num_set, tag( addr));
+    if ( way < 0)
+        return;
+
+    tags[ size_t{ num_set} * stride + narrow_cast<size_t>( way)] = invalid_tag;
+    replacement[ num_set]->set_to_erase( narrow_cast<size_t>( way)); // invalid way is the next victim
+}
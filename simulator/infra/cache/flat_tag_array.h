@@ -0,0 +1,123 @@
+/**
+ * flat_tag_array.h
+ * Set-associative tag array with contiguous ways.
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef FLAT_TAG_ARRAY_H
+#define FLAT_TAG_ARRAY_H
+
+#include <infra/macro.h>
+#include <infra/types.h>
+
+#include <bit>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+class CacheReplacement;
+
+/*
+ * Unlike CacheTagArray, this class has no virtual methods, so lookups
+ * may be inlined into hot paths like branch target buffers.
+ * Tags of a set are stored contiguously and padded to a multiple of 4,
+ * so a lookup is a sequence of vector compares of all ways.
+ * Replacement policy is chosen at run time, so LRU updates on hits
+ * and writes still call CacheReplacement. Ideal "always_hit" and
+ * "infinite" arrays have no ways and are available only via CacheTagArray.
+ */
+class FlatTagArray
+{
+public:
+    FlatTagArray( const std::string& repl_policy, uint32 size_in_bytes, uint32 ways, uint32 line_size, uint32 addr_size_in_bits);
+    ~FlatTagArray();
+    FlatTagArray( const FlatTagArray&) = delete;
+    FlatTagArray( FlatTagArray&&) = delete;
+    FlatTagArray& operator=( const FlatTagArray&) = delete;
+    FlatTagArray& operator=( FlatTagArray&&) = delete;
+
+    uint32 set( Addr addr) const { return narrow_cast<uint32>( ( ( addr & addr_mask) >> line_bits) & ( sets - 1)); }
+    Addr tag( Addr addr) const { return ( addr & addr_mask) >> set_bits; }
+
+    // Same semantics as in CacheTagArray
+    std::pair<bool, int32> read_no_touch( Addr addr) const
+    {
+        const auto way = find_way( set( addr), tag( addr));
+        return { way >= 0, way };
+    }
+
+    // Set and way (-1 on miss) for callers which keep per-way data next to the tags
+    std::pair<uint32, int32> probe( Addr addr) const
+    {
+        const auto num_set = set( addr);
+        return { num_set, find_way( num_set, tag( addr)) };
+    }
+
+    std::pair<bool, int32> read( Addr addr);
+    bool lookup( Addr addr) { return read( addr).first; }
+    void touch( uint32 num_set, int32 way);
+    int32 write( Addr addr, Addr pc);
+    int32 write( Addr addr) { return write( addr, addr); }
+    void invalidate( Addr addr);
+
+    uint32 get_ways() const { return ways; }
+    uint32 get_sets() const { return sets; }
+
+private:
+    int32 find_way( uint32 num_set, Addr num_tag) const;
+
+    // Tags have at most 32 bits, so this value never matches
+    static constexpr const uint64 invalid_tag = all_ones<uint64>();
+
+    const uint32 ways;
+    const uint32 stride;
+    const uint32 sets;
+    const size_t line_bits;
+    const size_t set_bits;
+    const Addr addr_mask;
+
+    std::vector<uint64> tags;
+    std::vector<std::unique_ptr<CacheReplacement>> replacement;
+};
+
+// Returns the first matching way or -1
+inline int32 FlatTagArray::find_way( uint32 num_set, Addr num_tag) const
+{
+    const uint64* ptr = tags.data() + size_t{ num_set} * stride;
+    uint32 way = 0;
+    // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast, cppcoreguidelines-pro-bounds-pointer-arithmetic) intrinsics API
+#if defined(__AVX2__)
+    const __m256i key = _mm256_set1_epi64x( narrow_cast<int64>( num_tag));
+    for ( ; way < stride; way += 4) {
+        const __m256i cmp = _mm256_cmpeq_epi64( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( ptr + way)), key);
+        const auto mask = narrow_cast<uint32>( _mm256_movemask_pd( _mm256_castsi256_pd( cmp)));
+        if ( mask != 0)
+            return narrow_cast<int32>( way + std::countr_zero( mask));
+    }
+#elif defined(__SSE2__)
+    // SSE2 has no 64-bit compare, so halves of each lane are compared separately
+    const __m128i key = _mm_set1_epi64x( narrow_cast<int64>( num_tag));
+    for ( ; way < stride; way += 2) {
+        const __m128i cmp32 = _mm_cmpeq_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>( ptr + way)), key);
+        const __m128i cmp = _mm_and_si128( cmp32, _mm_shuffle_epi32( cmp32, _MM_SHUFFLE( 2, 3, 0, 1)));
+        const auto mask = narrow_cast<uint32>( _mm_movemask_pd( _mm_castsi128_pd( cmp)));
+        if ( mask != 0)
+            return narrow_cast<int32>( way + std::countr_zero( mask));
+    }
+#else
+    for ( ; way < stride; ++way)
+        if ( ptr[way] == num_tag)
+            return narrow_cast<int32>( way);
+#endif
+    // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast, cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return -1;
+}
+
+#endif // FLAT_TAG_ARRAY_H
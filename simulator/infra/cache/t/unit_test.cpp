@@ -6,6 +6,7 @@
 #include <catch.hpp>
 
 #include <infra/cache/cache_tag_array.h>
+#include <infra/cache/flat_tag_array.h>
 #include <infra/replacement/cache_replacement.h>
 #include <infra/types.h>
 
@@ -122,3 +123,144 @@ TEST_CASE( "Check infinite CacheTagArray model with multiple sets")
     for ( uint32 i = 0; i < cache_ways + 1; i++)
         CHECK( test_tags->lookup( i * 0x10000000) == true);
 }
+
+TEST_CASE( "Invalidate line in LRU CacheTagArray")
+{
+    auto test_tags = CacheTagArray::create( "LRU", 128, 4, 4, addr_size_in_bits);
+    test_tags->write( 0x1000);
+    test_tags->write( 0x2000);
+    test_tags->invalidate( 0x1002);
+    CHECK_FALSE( test_tags->read_no_touch( 0x1000).first);
+    CHECK( test_tags->read_no_touch( 0x2000).first);
+
+    // invalidation of absent line is harmless
+    test_tags->invalidate( 0x3000);
+    CHECK( test_tags->read_no_touch( 0x2000).first);
+
+    test_tags->write( 0x1000);
+    CHECK( test_tags->read_no_touch( 0x1000).first);
+}
+
+TEST_CASE( "Invalidate line in infinite and always_hit CacheTagArray")
+{
+    auto infinite = CacheTagArray::create( "infinite", cache_size, cache_ways, cache_line_size, addr_size_in_bits);
+    infinite->write( 0x1000);
+    infinite->invalidate( 0x1000);
+    CHECK_FALSE( infinite->read_no_touch( 0x1000).first);
+
+    auto always_hit = CacheTagArray::create( "always_hit", cache_size, cache_ways, cache_line_size, addr_size_in_bits);
+    always_hit->invalidate( 0x1000);
+    CHECK( always_hit->read_no_touch( 0x1000).first);
+}
+
+TEST_CASE( "FlatTagArray: wrong arguments")
+{
+    CHECK_THROWS_AS( FlatTagArray( "LRU", 128, 0, 4, 32), CacheTagArrayInvalidSizeException);
+    CHECK_THROWS_AS( FlatTagArray( "LRU", 500, 16, 4, 32), CacheTagArrayInvalidSizeException);
+    CHECK_THROWS_AS( FlatTagArray( "LRU", 128, 4, 4, 48), CacheTagArrayInvalidSizeException);
+    CHECK_THROWS_AS( FlatTagArray( "abracadabra", 4096, 16, 64, 32), CacheReplacementException);
+}
+
+TEST_CASE( "FlatTagArray: same results as CacheTagArray")
+{
+    for ( uint32 ways : { 1, 2, 4, 8, 16, 32}) {
+        FlatTagArray flat( "LRU", 1024, ways, 4, addr_size_in_bits);
+        auto reference = CacheTagArray::create( "LRU", 1024, ways, 4, addr_size_in_bits);
+        CHECK( flat.get_ways() == ways);
+        CHECK( flat.get_sets() == 256 / ways);
+
+        Addr seed = 1;
+        for ( size_t i = 0; i < 20000; ++i) {
+            seed = seed * 1103515245 + 12345;
+            const Addr addr = ( seed >> 8U) & 0x1fffU;
+            CHECK( flat.set( addr) == reference->set( addr));
+            CHECK( flat.tag( addr) == reference->tag( addr));
+            REQUIRE( flat.read_no_touch( addr) == reference->read_no_touch( addr));
+            const auto result = flat.read( addr);
+            REQUIRE( result == reference->read( addr));
+            if ( !result.first)
+                REQUIRE( flat.write( addr) == reference->write( addr));
+        }
+    }
+}
+
+TEST_CASE( "FlatTagArray: invalidate line")
+{
+    FlatTagArray tags( "LRU", 128, 4, 4, addr_size_in_bits);
+    tags.write( 0x1000);
+    tags.write( 0x2000);
+    tags.invalidate( 0x1002);
+    CHECK_FALSE( tags.read_no_touch( 0x1000).first);
+    CHECK( tags.read_no_touch( 0x2000) == std::pair<bool, int32>{ true, 1});
+
+    tags.invalidate( 0x3000);
+    CHECK( tags.read_no_touch( 0x2000).first);
+
+    // Tag of all ones must not match empty ways
+    FlatTagArray full( "LRU", 4, 1, 4, addr_size_in_bits);
+    CHECK_FALSE( full.read_no_touch( 0xffff'ffff).first);
+    full.write( 0xffff'ffff);
+    CHECK( full.lookup( 0xffff'fffc));
+}
+
+// Lines of the same set, the most recent one is invalidated and the set is refilled
+template<typename Tags>
+static void check_refill_after_invalidation( Tags* tags)
+{
+    std::vector<Addr> lines;
+    for ( Addr line : { 0x1000, 0x1020, 0x1040, 0x1060 })
+        tags->write( line);
+    for ( Addr line : { 0x1000, 0x1020, 0x1040, 0x1060 })
+        if ( tags->read( line).first)
+            lines.push_back( line);
+
+    // Random policy may replace its own fills, the lines present are kept anyway
+    REQUIRE( !lines.empty());
+    tags->invalidate( lines.back());
+    lines.pop_back();
+    tags->write( 0x1080);
+    for ( const auto line : lines)
+        CHECK( tags->read_no_touch( line).first);
+    CHECK( tags->read_no_touch( 0x1080).first);
+}
+
+TEST_CASE( "Invalidated way is refilled first")
+{
+    for ( const std::string policy : { "LRU", "list-LRU", "pseudo-LRU", "SRRIP", "BRRIP", "DRRIP", "SHiP", "random", "FIFO" }) {
+        INFO( policy);
+        auto tags = CacheTagArray::create( policy, 128, 4, 4, addr_size_in_bits);
+        check_refill_after_invalidation( tags.get());
+
+        FlatTagArray flat( policy, 128, 4, 4, addr_size_in_bits);
+        check_refill_after_invalidation( &flat);
+    }
+}
+
+TEST_CASE( "FlatTagArray: probe and touch")
+{
+    FlatTagArray tags( "LRU", 128, 4, 4, addr_size_in_bits);
+    CHECK( tags.probe( 0x1000) == std::pair<uint32, int32>{ tags.set( 0x1000), -1});
+
+    // Ways 0 and 1 of the same set
+    tags.write( 0x1000);
+    tags.write( 0x1080);
+    CHECK( tags.probe( 0x1080) == std::pair<uint32, int32>{ tags.set( 0x1000), 1});
+
+    // Touched way is not replaced
+    tags.touch( tags.set( 0x1000), 0);
+    tags.write( 0x1100);
+    tags.write( 0x1180);
+    tags.write( 0x1200);
+    CHECK( tags.probe( 0x1000).second == 0);
+    CHECK( tags.probe( 0x1080).second == -1);
+}
+
+TEST_CASE( "Infinite cache: line granularity")
+{
+    auto test_tags = CacheTagArray::create( "infinite", 4096, 4, 64, addr_size_in_bits);
+    test_tags->write( 0x1000);
+    CHECK( test_tags->lookup( 0x1020));
+    CHECK( test_tags->lookup( 0x103f));
+    CHECK_FALSE( test_tags->lookup( 0x1040));
+    CHECK_FALSE( test_tags->lookup( 0xfff));
+}
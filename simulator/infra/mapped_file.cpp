@@ -0,0 +1,65 @@
+/**
+ * mapped_file.cpp - read-only view of a whole file
+ * Copyright 2020 MIPT-MIPS team
+ */
+
+#include "mapped_file.h"
+
+#include <infra/macro.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <iterator>
+#endif
+
+#ifndef _WIN32
+MappedFile::MappedFile( const std::string& filename)
+{
+    const int fd = open( filename.c_str(), O_RDONLY);
+    if ( fd < 0)
+        throw CannotMapFile( "cannot open " + filename);
+
+    struct stat info = {};
+    if ( fstat( fd, &info) != 0) {
+        close( fd);
+        throw CannotMapFile( "cannot get size of " + filename);
+    }
+
+    size = narrow_cast<size_t>( info.st_size);
+    if ( size != 0) {
+        void* ptr = mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if ( ptr == MAP_FAILED) {
+            close( fd);
+            throw CannotMapFile( "cannot map " + filename);
+        }
+        madvise( ptr, size, MADV_SEQUENTIAL);
+        data = static_cast<const unsigned char*>( ptr);
+    }
+    close( fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if ( data != nullptr)
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast) munmap API
+        munmap( const_cast<unsigned char*>( data), size);
+}
+#else
+MappedFile::MappedFile( const std::string& filename)
+{
+    std::ifstream file( filename, std::ios::binary);
+    if ( !file)
+        throw CannotMapFile( "cannot open " + filename);
+
+    buffer.assign( std::istreambuf_iterator<char>( file), std::istreambuf_iterator<char>());
+    data = buffer.data();
+    size = buffer.size();
+}
+
+MappedFile::~MappedFile() = default;
+#endif
@@ -0,0 +1,45 @@
+/**
+ * mapped_file.h - read-only view of a whole file
+ * Copyright 2020 MIPT-MIPS team
+ */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <infra/exception.h>
+#include <infra/types.h>
+
+#include <string>
+#include <vector>
+
+struct CannotMapFile final : Exception
+{
+    explicit CannotMapFile( const std::string& msg)
+        : Exception( "Cannot read file", msg)
+    { }
+};
+
+// File is mapped to memory where it is possible, so threads may read it concurrently
+class MappedFile
+{
+public:
+    explicit MappedFile( const std::string& filename);
+    ~MappedFile();
+    MappedFile( const MappedFile&) = delete;
+    MappedFile( MappedFile&&) = delete;
+    MappedFile& operator=( const MappedFile&) = delete;
+    MappedFile& operator=( MappedFile&&) = delete;
+
+    const unsigned char* begin() const { return data; }
+    const unsigned char* end() const { return data + size; }
+    size_t get_size() const { return size; }
+
+private:
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    std::vector<unsigned char> buffer;
+#endif
+};
+
+#endif
@@ -0,0 +1,80 @@
+/**
+ * paged_bitset.h - sparse set of integers with bounded memory.
+ * Copyright 2020 MIPT-MIPS team
+ */
+
+#ifndef PAGED_BITSET_H
+#define PAGED_BITSET_H
+
+#include <infra/types.h>
+
+#include <bitset>
+#include <memory>
+#include <unordered_map>
+
+/*
+ * Two-level bitset: a hash map of pages, each page is a bitset of 2^15 consecutive indices.
+ * Memory is allocated only for touched pages, so a set of cache lines
+ * takes at most a bit per line of the touched address space.
+ */
+class PagedBitset
+{
+public:
+    // Returns the previous value of the bit
+    bool test_and_set( uint64 index)
+    {
+        auto& bits = get_page( index >> page_bits);
+        const auto offset = get_offset( index);
+        const bool result = bits.test( offset);
+        bits.set( offset);
+        return result;
+    }
+
+    bool test( uint64 index) const
+    {
+        const auto it = pages.find( index >> page_bits);
+        return it != pages.end() && it->second->test( get_offset( index));
+    }
+
+    void reset( uint64 index)
+    {
+        const auto it = pages.find( index >> page_bits);
+        if ( it != pages.end())
+            it->second->reset( get_offset( index));
+    }
+
+    size_t get_memory_usage() const
+    {
+        // Estimation of hash map memory: a node and a bucket per page
+        return pages.size() * ( sizeof( Page) + sizeof( Pages::value_type) + 2 * sizeof( void*))
+            + pages.bucket_count() * sizeof( void*);
+    }
+
+private:
+    static const constexpr size_t page_bits = 15;
+    using Page = std::bitset<size_t{ 1} << page_bits>;
+    using Pages = std::unordered_map<uint64, std::unique_ptr<Page>>;
+
+    static size_t get_offset( uint64 index) { return narrow_cast<size_t>( index & ( ( uint64{ 1} << page_bits) - 1)); }
+
+    Page& get_page( uint64 page)
+    {
+        // Accesses are mostly local, so the last page is cached
+        if ( last_page != nullptr && page == last_page_index)
+            return *last_page;
+
+        auto& ptr = pages[ page];
+        if ( ptr == nullptr)
+            ptr = std::make_unique<Page>();
+
+        last_page_index = page;
+        last_page = ptr.get();
+        return *last_page;
+    }
+
+    Pages pages;
+    uint64 last_page_index = 0;
+    Page* last_page = nullptr;
+};
+
+#endif // PAGED_BITSET_H
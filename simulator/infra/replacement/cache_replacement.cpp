@@ -7,9 +7,13 @@
 #include "infra/replacement/cache_replacement.h"
 #include "infra/macro.h"
 
+#include <algorithm>
+#include <array>
 #include <list>
+#include <utility>
 #include <vector>
 
+// Reference LRU implementation, ways are kept in the recency order
 class LRU : public CacheReplacement
 {
     public:
@@ -52,12 +56,83 @@ std::size_t LRU::update()
 
 //////////////////////////////////////////////////////////////////
 
+/*
+ * LRU with age counters: 0 is the most recently used way, ways - 1 is the least.
+ * Ages of all ways are stored contiguously, so touch is a branchless loop
+ * which is vectorized for short fixed-size arrays.
+ * Behavior is the same as of the list implementation above.
+ */
+template<typename Ages>
+class AgeLRU : public CacheReplacement
+{
+    public:
+        explicit AgeLRU( std::size_t ways);
+
+        void touch( std::size_t way) final;
+        void set_to_erase( std::size_t way) final;
+        std::size_t update() final;
+        std::size_t get_ways() const final { return ways; }
+
+    private:
+        using Age = typename Ages::value_type;
+        Ages ages{};
+        const std::size_t ways;
+};
+
+// Ages of unused elements of the array never match any way
+template<typename Age, std::size_t N>
+static void init_ages( std::array<Age, N>* ages, std::size_t /* ways */) { ages->fill( all_ones<Age>()); }
+
+template<typename Age>
+static void init_ages( std::vector<Age>* ages, std::size_t ways) { ages->resize( ways); }
+
+template<typename Ages>
+AgeLRU<Ages>::AgeLRU( std::size_t ways) : ways( ways)
+{
+    init_ages( &ages, ways);
+    // Initially, way 0 is the least recently used one, like in the list implementation
+    for ( std::size_t i = 0; i < ways; ++i)
+        ages[i] = narrow_cast<Age>( ways - 1 - i);
+}
+
+template<typename Ages>
+void AgeLRU<Ages>::touch( std::size_t way)
+{
+    const Age age = ages[way];
+    for ( auto& e : ages)
+        e += e < age ? 1 : 0;
+    ages[way] = 0;
+}
+
+template<typename Ages>
+void AgeLRU<Ages>::set_to_erase( std::size_t way)
+{
+    const Age age = ages[way];
+    for ( std::size_t i = 0; i < ways; ++i)
+        ages[i] -= ages[i] > age ? 1 : 0;
+    ages[way] = narrow_cast<Age>( ways - 1);
+}
+
+template<typename Ages>
+std::size_t AgeLRU<Ages>::update()
+{
+    const auto way = narrow_cast<std::size_t>( std::find( ages.begin(), ages.end(), narrow_cast<Age>( ways - 1)) - ages.begin());
+    touch( way);
+    return way;
+}
+
+// Fits a single vector register for caches with up to 16 ways
+using SmallLRU = AgeLRU<std::array<uint8, 16>>;
+using LargeLRU = AgeLRU<std::vector<uint32>>;
+
+//////////////////////////////////////////////////////////////////
+
 class PseudoLRU : public CacheReplacement
 {
     public:
         explicit PseudoLRU( std::size_t ways);
         void touch( std::size_t way) override;
-        void set_to_erase( std::size_t /* unused */) override;
+        void set_to_erase( std::size_t way) override;
         std::size_t update() override;
         std::size_t get_ways() const override { return ways; }
 
@@ -108,20 +183,321 @@ std::size_t PseudoLRU::update()
     return way;
 }
 
-void PseudoLRU::set_to_erase( std::size_t /* way */)
+// Opposite to touch: all nodes on the path point to the way, so it is the next victim
+void PseudoLRU::set_to_erase( std::size_t way)
 {
-    throw CacheReplacementException( "PLRU does not support inverted access");
+    auto node = way + nodes.size();
+    while ( node != 0) {
+        const auto parent = ( node - 1) / 2;
+        nodes[parent] = get_direction_to_prev_node( node);
+        node = parent;
+    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////
 
-std::unique_ptr<CacheReplacement> create_cache_replacement( const std::string& name, std::size_t ways)
+/*
+ * Re-Reference Interval Prediction (Jaleel et al., ISCA 2010)
+ * Each way has a 2-bit prediction of its re-reference interval:
+ * 0 is "near", 3 is "distant". Hits promote the way to "near",
+ * a victim is the first "distant" way, all ways age if there is no such.
+ */
+class RRIP : public CacheReplacement
+{
+    public:
+        explicit RRIP( std::size_t ways) : rrpv( ways, max_rrpv) { }
+
+        void touch( std::size_t way) override { rrpv[way] = 0; }
+        void set_to_erase( std::size_t way) final { rrpv[way] = max_rrpv; }
+        std::size_t update() override;
+        std::size_t get_ways() const final { return rrpv.size(); }
+
+    protected:
+        static const constexpr uint8 max_rrpv = 3;
+        static const constexpr uint8 long_rrpv = max_rrpv - 1;
+
+        std::size_t find_victim();
+        void insert( std::size_t way, uint8 value) { rrpv[way] = value; }
+
+        // Insertion prediction
+        virtual uint8 get_insertion() { return long_rrpv; }
+
+    private:
+        std::vector<uint8> rrpv;
+};
+
+std::size_t RRIP::find_victim()
+{
+    const auto oldest = *std::max_element( rrpv.begin(), rrpv.end());
+    if ( oldest != max_rrpv)
+        for ( auto& e : rrpv)
+            e += max_rrpv - oldest;
+
+    return narrow_cast<std::size_t>( std::find( rrpv.begin(), rrpv.end(), max_rrpv) - rrpv.begin());
+}
+
+std::size_t RRIP::update()
+{
+    const auto way = find_victim();
+    insert( way, get_insertion());
+    return way;
+}
+
+// Inserts most of the lines with "distant" prediction, so they do not thrash the set
+class BimodalInsertion
+{
+    public:
+        bool is_long() { return ++counter % throttle == 0; }
+
+    private:
+        static const constexpr uint32 throttle = 32;
+        uint32 counter = 0;
+};
+
+class BRRIP : public RRIP
+{
+    public:
+        using RRIP::RRIP;
+
+    private:
+        uint8 get_insertion() final { return bimodal.is_long() ? long_rrpv : max_rrpv; }
+        BimodalInsertion bimodal;
+};
+
+// Policy selection counter, misses of leader sets move it to the opposite policy
+class SetDueling
 {
+    public:
+        enum class Role { FOLLOWER, SRRIP_LEADER, BRRIP_LEADER };
+
+        static Role get_role( std::size_t set, std::size_t sets)
+        {
+            const auto period = std::min<std::size_t>( sets, 32);
+            if ( set % period == 0)
+                return Role::SRRIP_LEADER;
+            if ( set % period == period - 1)
+                return Role::BRRIP_LEADER;
+            return Role::FOLLOWER;
+        }
+
+        bool use_brrip( Role role)
+        {
+            switch ( role) {
+            case Role::SRRIP_LEADER:
+                psel = std::min<uint32>( psel + 1, psel_max);
+                return false;
+            case Role::BRRIP_LEADER:
+                psel = psel == 0 ? 0 : psel - 1;
+                return true;
+            default:
+                return psel > psel_max / 2;
+            }
+        }
+
+    private:
+        static const constexpr uint32 psel_max = 1023;
+        uint32 psel = psel_max / 2;
+};
+
+class DRRIP : public RRIP
+{
+    public:
+        DRRIP( std::size_t ways, std::shared_ptr<SetDueling> dueling, SetDueling::Role role)
+            : RRIP( ways), dueling( std::move( dueling)), role( role)
+        { }
+
+    private:
+        uint8 get_insertion() final
+        {
+            if ( dueling->use_brrip( role))
+                return bimodal.is_long() ? long_rrpv : max_rrpv;
+            return long_rrpv;
+        }
+
+        std::shared_ptr<SetDueling> dueling;
+        const SetDueling::Role role;
+        BimodalInsertion bimodal;
+};
+
+/*
+ * Signature-based Hit Predictor (Wu et al., MICRO 2011)
+ * Lines are inserted with "distant" prediction if lines brought by
+ * the same PC signature were evicted without reuse.
+ */
+class SHiP : public RRIP
+{
+    public:
+        using Counters = std::vector<uint8>;
+
+        SHiP( std::size_t ways, std::shared_ptr<Counters> shct)
+            : RRIP( ways), shct( std::move( shct)), lines( ways)
+        { }
+
+        void touch( std::size_t way) final;
+        std::size_t update() final { return update_with_pc( 0); }
+        std::size_t update_with_pc( Addr pc) final;
+
+        static const constexpr std::size_t table_size = 16384;
+
+    private:
+        static const constexpr uint8 counter_max = 7;
+
+        struct Line
+        {
+            uint32 signature = 0;
+            bool is_valid = false;
+            bool is_reused = false;
+        };
+
+        static uint32 get_signature( Addr pc)
+        {
+            return narrow_cast<uint32>( ( pc ^ ( pc >> 14U) ^ ( pc >> 28U)) % table_size);
+        }
+
+        std::shared_ptr<Counters> shct;
+        std::vector<Line> lines;
+};
+
+void SHiP::touch( std::size_t way)
+{
+    RRIP::touch( way);
+    auto& line = lines[way];
+    line.is_reused = true;
+    auto& counter = ( *shct)[ line.signature];
+    counter = std::min<uint8>( counter + 1, counter_max);
+}
+
+std::size_t SHiP::update_with_pc( Addr pc)
+{
+    const auto way = find_victim();
+    auto& line = lines[way];
+    if ( line.is_valid && !line.is_reused) {
+        auto& counter = ( *shct)[ line.signature];
+        counter = counter == 0 ? 0 : counter - 1;
+    }
+
+    line = { get_signature( pc), true, false };
+    insert( way, ( *shct)[ line.signature] == 0 ? max_rrpv : long_rrpv);
+    return way;
+}
+
+// Deterministic pseudo-random victims, seeded by the set index
+class RandomReplacement : public CacheReplacement
+{
+    public:
+        RandomReplacement( std::size_t ways, std::size_t seed) : ways( ways), state( seed * 0x9e37'79b9'7f4a'7c15ULL + 1) { }
+
+        void touch( std::size_t /* way */) final { }
+        void set_to_erase( std::size_t way) final { erased = way; }
+        std::size_t update() final;
+        std::size_t get_ways() const final { return ways; }
+
+    private:
+        const std::size_t ways;
+        uint64 state;
+        std::size_t erased = NO_VAL<std::size_t>;
+};
+
+std::size_t RandomReplacement::update()
+{
+    if ( erased != NO_VAL<std::size_t>)
+        return std::exchange( erased, NO_VAL<std::size_t>);
+
+    // xorshift64
+    state ^= state << 13U;
+    state ^= state >> 7U;
+    state ^= state << 17U;
+    return narrow_cast<std::size_t>( state % ways);
+}
+
+class FIFO : public CacheReplacement
+{
+    public:
+        explicit FIFO( std::size_t ways) : ways( ways) { }
+
+        void touch( std::size_t /* way */) final { }
+        void set_to_erase( std::size_t way) final { erased = way; }
+        std::size_t update() final;
+        std::size_t get_ways() const final { return ways; }
+
+    private:
+        const std::size_t ways;
+        std::size_t next = 0;
+        std::size_t erased = NO_VAL<std::size_t>;
+};
+
+std::size_t FIFO::update()
+{
+    if ( erased != NO_VAL<std::size_t>)
+        return std::exchange( erased, NO_VAL<std::size_t>);
+
+    const auto way = next;
+    next = ( next + 1) % ways;
+    return way;
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+
+static const char* const supported_policies = "LRU\nlist-LRU\npseudo-LRU\nSRRIP\nBRRIP\nDRRIP\nSHiP\nrandom\nFIFO\n";
+
+static std::unique_ptr<CacheReplacement> create_set_replacement( const std::string& name, std::size_t set, std::size_t ways)
+{
+    if (name == "LRU" && ways <= 16)
+        return std::make_unique<SmallLRU>( ways);
+
     if (name == "LRU")
+        return std::make_unique<LargeLRU>( ways);
+
+    if (name == "list-LRU")
         return std::make_unique<LRU>( ways);
 
     if (name == "pseudo-LRU")
         return std::make_unique<PseudoLRU>( ways);
 
-    throw CacheReplacementException("\"" + name + "\" replacement policy is not defined, supported polices are:\nLRU\npseudo-LRU\n");
+    if (name == "SRRIP")
+        return std::make_unique<RRIP>( ways);
+
+    if (name == "BRRIP")
+        return std::make_unique<BRRIP>( ways);
+
+    if (name == "random")
+        return std::make_unique<RandomReplacement>( ways, set);
+
+    if (name == "FIFO")
+        return std::make_unique<FIFO>( ways);
+
+    throw CacheReplacementException("\"" + name + "\" replacement policy is not defined, supported polices are:\n" + supported_policies);
+}
+
+std::vector<std::unique_ptr<CacheReplacement>> create_cache_replacements( const std::string& name, std::size_t sets, std::size_t ways)
+{
+    if ( ways == 0)
+        throw CacheReplacementException( "Number of ways must be greater than zero");
+
+    std::vector<std::unique_ptr<CacheReplacement>> result( sets);
+    if ( name == "DRRIP") {
+        auto dueling = std::make_shared<SetDueling>();
+        for ( std::size_t i = 0; i < sets; ++i)
+            result[i] = std::make_unique<DRRIP>( ways, dueling, SetDueling::get_role( i, sets));
+    }
+    else if ( name == "SHiP") {
+        auto shct = std::make_shared<SHiP::Counters>( SHiP::table_size, 1);
+        for ( auto& e : result)
+            e = std::make_unique<SHiP>( ways, shct);
+    }
+    else {
+        for ( std::size_t i = 0; i < sets; ++i)
+            result[i] = create_set_replacement( name, i, ways);
+    }
+    return result;
+}
+
+std::unique_ptr<CacheReplacement> create_cache_replacement( const std::string& name, std::size_t ways)
+{
+    return std::move( create_cache_replacements( name, 1, ways).front());
+}
+
+bool can_partition_sets( const std::string& name)
+{
+    return name != "DRRIP" && name != "SHiP" && name != "random";
 }
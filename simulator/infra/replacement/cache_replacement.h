@@ -8,8 +8,11 @@
 #define CACHEREPLACEMENT_H
 
 #include <infra/exception.h>
+#include <infra/types.h>
 
 #include <memory>
+#include <string>
+#include <vector>
 
 struct CacheReplacementException final : Exception
 {
@@ -32,8 +35,17 @@ public:
     virtual void set_to_erase( std::size_t) = 0;
     virtual std::size_t update() = 0;
     virtual std::size_t get_ways() const = 0;
+
+    // PC of the access which causes the replacement, used by PC-aware policies
+    virtual std::size_t update_with_pc( Addr /* pc */) { return update(); }
 };
 
 std::unique_ptr<CacheReplacement> create_cache_replacement( const std::string& name, std::size_t ways);
 
+// Policies with set dueling or shared predictors need all sets to be created together
+std::vector<std::unique_ptr<CacheReplacement>> create_cache_replacements( const std::string& name, std::size_t sets, std::size_t ways);
+
+// False if the policy depends on other sets or on the index of the set
+bool can_partition_sets( const std::string& name);
+
 #endif // CACHEREPLACEMENT_H
@@ -70,10 +70,15 @@ TEST_CASE( "Pseudo-LRU: Check_get_ways_method")
     CHECK(test_pseudo_lru_module->get_ways() == 4);
 }
 
-TEST_CASE( "Pseudo-LRU: Check_forbidden_to_call_methods")
+TEST_CASE( "Pseudo-LRU: Check_set_to_erase_method")
 {
     auto test_pseudo_lru_module = create_cache_replacement( "pseudo-LRU", 4);
-    CHECK_THROWS_AS( test_pseudo_lru_module->set_to_erase( 0), CacheReplacementException);
+    for ( std::size_t way = 0; way < 4; ++way)
+        test_pseudo_lru_module->touch( way);
+    test_pseudo_lru_module->set_to_erase( 2);
+    CHECK( test_pseudo_lru_module->update() == 2);
+    test_pseudo_lru_module->set_to_erase( 1);
+    CHECK( test_pseudo_lru_module->update() == 1);
 }
 
 TEST_CASE( "Pseudo-LRU: Check_bad_way_number_in_touch_method")
@@ -131,3 +136,123 @@ TEST_CASE ( "Pseudo-LRU: Check_touch_method_with_big_number_of elements")
     CHECK( test_lru_module->update() == 1024);
     CHECK( test_lru_module->update() == 512);
 }
+
+static void check_same_as_list_lru( std::size_t ways)
+{
+    auto reference = create_cache_replacement( "list-LRU", ways);
+    auto lru = create_cache_replacement( "LRU", ways);
+    CHECK( lru->get_ways() == ways);
+
+    // Simple linear congruential generator to mix all the operations
+    std::size_t seed = 1;
+    for ( std::size_t i = 0; i < 10000; ++i) {
+        seed = seed * 1103515245 + 12345;
+        const auto way = ( seed >> 16U) % ways;
+        switch ( ( seed >> 8U) % 8) {
+        case 0:
+            reference->set_to_erase( way);
+            lru->set_to_erase( way);
+            break;
+        case 1:
+        case 2:
+            REQUIRE( lru->update() == reference->update());
+            break;
+        default:
+            reference->touch( way);
+            lru->touch( way);
+        }
+    }
+}
+
+TEST_CASE( "LRU: same as list implementation")
+{
+    for ( std::size_t ways : { 1, 2, 3, 4, 8, 15, 16, 17, 32, 100})
+        check_same_as_list_lru( ways);
+}
+
+TEST_CASE( "SRRIP: scan does not evict reused lines")
+{
+    auto srrip = create_cache_replacement( "SRRIP", 4);
+    CHECK( srrip->get_ways() == 4);
+    CHECK( srrip->update() == 0);
+    CHECK( srrip->update() == 1);
+    srrip->touch( 0);
+    srrip->touch( 1);
+    CHECK( srrip->update() == 2);
+    CHECK( srrip->update() == 3);
+    // Ways 2 and 3 were not reused, so they are evicted first
+    CHECK( srrip->update() == 2);
+    CHECK( srrip->update() == 3);
+    CHECK( srrip->update() == 2);
+    srrip->set_to_erase( 1);
+    CHECK( srrip->update() == 1);
+}
+
+TEST_CASE( "BRRIP: most insertions are distant")
+{
+    auto brrip = create_cache_replacement( "BRRIP", 4);
+    for ( std::size_t i = 0; i < 4; ++i)
+        brrip->touch( brrip->update());
+
+    // Scanning lines replace the same way
+    CHECK( brrip->update() == 0);
+    CHECK( brrip->update() == 0);
+    CHECK( brrip->update() == 0);
+}
+
+TEST_CASE( "DRRIP: create all sets")
+{
+    auto sets = create_cache_replacements( "DRRIP", 64, 4);
+    REQUIRE( sets.size() == 64);
+    for ( auto& set : sets) {
+        CHECK( set->get_ways() == 4);
+        CHECK( set->update() == 0);
+    }
+    CHECK_FALSE( can_partition_sets( "DRRIP"));
+    CHECK( can_partition_sets( "SRRIP"));
+}
+
+TEST_CASE( "SHiP: signatures without reuse are inserted as distant")
+{
+    auto ship = create_cache_replacement( "SHiP", 2);
+    // PC 0x100 brings lines which are never reused
+    for ( std::size_t i = 0; i < 4; ++i)
+        ship->update_with_pc( 0x100);
+
+    // PC 0x200 brings a reused line
+    const auto reused = ship->update_with_pc( 0x200);
+    ship->touch( reused);
+
+    // Lines of 0x100 are predicted dead and evicted first
+    const auto dead = ship->update_with_pc( 0x100);
+    CHECK( dead != reused);
+    CHECK( ship->update_with_pc( 0x100) == dead);
+    CHECK( ship->update() == dead);
+}
+
+TEST_CASE( "Random: victims are within the set")
+{
+    auto random = create_cache_replacement( "random", 8);
+    bool has_other_than_zero = false;
+    for ( std::size_t i = 0; i < 100; ++i) {
+        const auto way = random->update();
+        CHECK( way < 8);
+        has_other_than_zero |= way != 0;
+    }
+    CHECK( has_other_than_zero);
+    random->set_to_erase( 5);
+    CHECK( random->update() == 5);
+}
+
+TEST_CASE( "FIFO: touch does not change order")
+{
+    auto fifo = create_cache_replacement( "FIFO", 3);
+    CHECK( fifo->update() == 0);
+    CHECK( fifo->update() == 1);
+    fifo->touch( 2);
+    CHECK( fifo->update() == 2);
+    CHECK( fifo->update() == 0);
+    fifo->set_to_erase( 2);
+    CHECK( fifo->update() == 2);
+    CHECK( fifo->update() == 1);
+}
@@ -12,6 +12,7 @@
 #include <infra/exception.h>
 #include <infra/log.h>
 #include <infra/macro.h>
+#include <infra/paged_bitset.h>
 #include <infra/target.h>
 #include <infra/uint128.h>
 
@@ -194,3 +195,26 @@ TEST_CASE("Valid target print")
     oss << std::hex << Target( 0x400, 15);
     CHECK( oss.str() == "400" );
 }
+
+TEST_CASE("PagedBitset")
+{
+    PagedBitset bits;
+    CHECK( bits.get_memory_usage() < 4096);
+    CHECK_FALSE( bits.test( 5));
+    CHECK_FALSE( bits.test_and_set( 5));
+    CHECK( bits.test_and_set( 5));
+    CHECK( bits.test( 5));
+    CHECK_FALSE( bits.test( 6));
+
+    // Far indices allocate separate pages
+    const auto one_page = bits.get_memory_usage();
+    CHECK( one_page >= 4096);
+    CHECK_FALSE( bits.test_and_set( 0xffff'ffff'ffff'fff0ULL));
+    CHECK( bits.test( 0xffff'ffff'ffff'fff0ULL));
+    CHECK( bits.get_memory_usage() > one_page);
+
+    bits.reset( 5);
+    CHECK_FALSE( bits.test( 5));
+    bits.reset( 0x1234'5678); // no page, no effect
+    CHECK_FALSE( bits.test( 0x1234'5678));
+}
@@ -31,6 +31,13 @@ public:
         , valid( true)
     { }
 
+    // Hardware threads of a core number their instructions in disjoint ranges,
+    // so the thread is known from any sequence id
+    static constexpr const size_t THREAD_ID_SHIFT = 56;
+    static uint64 get_first_sequence_id( size_t thread) { return uint64{ thread} << THREAD_ID_SHIFT; }
+    static size_t get_thread( uint64 sequence_id) { return sequence_id >> THREAD_ID_SHIFT; }
+    size_t get_thread() const { return get_thread( sequence_id); }
+
     friend std::ostream& operator<<( std::ostream& out, const Target& target);
 };
 
@@ -0,0 +1,51 @@
+/**
+ * varint.h - LEB128 and zigzag encoding of integers for compact binary files
+ * Copyright 2020 MIPT-MIPS team
+ */
+
+#ifndef VARINT_H
+#define VARINT_H
+
+#include <infra/macro.h>
+#include <infra/types.h>
+
+#include <ostream>
+
+// Small deltas of either sign are encoded to small unsigned values
+inline uint64 zigzag_encode( Addr current, Addr previous)
+{
+    const auto delta = narrow_cast<int64>( current - previous);
+    return ( uint64( delta) << 1U) ^ uint64( delta >> 63);
+}
+
+inline Addr zigzag_decode( uint64 value, Addr previous)
+{
+    return previous + ( ( value >> 1U) ^ ( ~( value & 1U) + 1));
+}
+
+inline void write_varint( std::ostream& out, uint64 value)
+{
+    while ( value >= 0x80U) {
+        out.put( narrow_cast<char>( ( value & 0x7fU) | 0x80U));
+        value >>= 7U;
+    }
+    out.put( narrow_cast<char>( value));
+}
+
+// Returns false if the buffer ends before the value or the value is too long
+inline bool read_varint( const unsigned char** ptr, const unsigned char* end, uint64* value)
+{
+    *value = 0;
+    for ( size_t shift = 0; shift < bitwidth<uint64>; shift += 7) {
+        if ( *ptr == end)
+            return false;
+
+        const uint64 byte = *( *ptr)++;
+        *value |= ( byte & 0x7fU) << shift;
+        if ( ( byte & 0x80U) == 0)
+            return true;
+    }
+    return false;
+}
+
+#endif
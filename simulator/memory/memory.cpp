@@ -7,6 +7,7 @@
 #include <infra/uint128.h>
 #include <memory/memory.h>
 
+#include <algorithm>
 #include <sstream>
 #include <vector>
 
@@ -128,3 +129,29 @@ ReadableAndWriteableMemory::~ReadableAndWriteableMemory() = default;
 FuncMemory::FuncMemory() = default;
 FuncMemory::~FuncMemory() = default;
 
+
+bool FuncMemory::compare_exchange( Addr addr, const std::byte* expected, const std::byte* desired, size_t size)
+{
+    std::vector<std::byte> current( size);
+    memcpy_guest_to_host( current.data(), addr, size);
+    if ( !std::equal( current.begin(), current.end(), expected))
+        return false;
+
+    memcpy_host_to_guest( addr, desired, size);
+    return true;
+}
+
+template<typename T, std::endian endian> bool
+FuncMemory::compare_exchange_integer( T expected, T desired, Addr addr, size_t size)
+{
+    switch ( size) {
+        case 1:  return compare_exchange_value<uint8, endian>  ( narrow_cast<uint8>  ( expected), narrow_cast<uint8>  ( desired), addr);
+        case 2:  return compare_exchange_value<uint16, endian> ( narrow_cast<uint16> ( expected), narrow_cast<uint16> ( desired), addr);
+        case 4:  return compare_exchange_value<uint32, endian> ( narrow_cast<uint32> ( expected), narrow_cast<uint32> ( desired), addr);
+        case 8:  return compare_exchange_value<uint64, endian> ( narrow_cast<uint64> ( expected), narrow_cast<uint64> ( desired), addr);
+        default: assert( false); return false;
+    }
+}
+
+template bool FuncMemory::compare_exchange_integer<uint64, std::endian::little>(uint64, uint64, Addr, size_t);
+template bool FuncMemory::compare_exchange_integer<uint64, std::endian::big>(uint64, uint64, Addr, size_t);
@@ -142,6 +142,15 @@ public:
     ReadableAndWriteableMemory& operator=( ReadableAndWriteableMemory&&) = delete;
 };
 
+// Address and value observed by the last load-reserved of a hart
+struct Reservation
+{
+    Addr addr = 0;
+    size_t size = 0;
+    uint64 value = 0;
+    bool valid = false;
+};
+
 class FuncMemory : public ReadableAndWriteableMemory
 {
 public:
@@ -164,16 +173,36 @@ public:
         return create_plain_memory( 22);
     }
 
+    // Wraps memory to be shared by several host threads
+    static std::shared_ptr<FuncMemory> create_synchronized_memory( std::shared_ptr<FuncMemory> memory);
+
+    // Writes 'desired' if memory contains 'expected', must be atomic for shared memories
+    virtual bool compare_exchange( Addr addr, const std::byte* expected, const std::byte* desired, size_t size);
+
+    template<typename T, std::endian endian>
+    bool compare_exchange_integer( T expected, T desired, Addr addr, size_t size);
+
     template<typename T, std::endian endian> void masked_write( T value, Addr addr, T mask)
     {
         T combined_value = ( value & mask) | ( this->read<T, endian>( addr) & ~mask);
         write<T, endian>( combined_value, addr);
     }
 
-    template<typename Instr> void load_store( Instr* instr);
+    template<typename Instr> void load_store( Instr* instr) { load_store( instr, nullptr); }
+    template<typename Instr> void load_store( Instr* instr, Reservation* reservation);
 private:
+    template<typename T, std::endian endian> bool compare_exchange_value( T expected, T desired, Addr addr)
+    {
+        const auto& expected_bytes = unpack_array<T, endian>( expected);
+        const auto& desired_bytes = unpack_array<T, endian>( desired);
+        return compare_exchange( addr, expected_bytes.data(), desired_bytes.data(), expected_bytes.size());
+    }
+
     template<typename Instr, std::endian endian> void store( const Instr& instr);
     template<typename Instr, std::endian endian> void masked_store( const Instr& instr);
+    template<typename Instr, std::endian endian> void store_conditional( Instr* instr, Reservation* reservation);
+    template<typename M, std::endian endian, typename Instr> void atomic_sized( Instr* instr);
+    template<typename Instr, std::endian endian> void atomic( Instr* instr);
 };
 
 template<typename Instr, std::endian endian>
@@ -190,11 +219,71 @@ void FuncMemory::store( const Instr& instr)
         masked_write<SrcType, endian>( instr.get_v_src( 1), instr.get_mem_addr(), instr.get_mask());
 }
 
+template<typename Instr, std::endian endian>
+void FuncMemory::store_conditional( Instr* instr, Reservation* reservation)
+{
+    // Without reservation tracking SC always succeeds, as in single-threaded mode
+    if ( reservation == nullptr) {
+        store<Instr, endian>( *instr);
+        instr->store_conditional( true);
+        return;
+    }
+
+    // Value-based check: the store succeeds if memory was not changed since the LR
+    bool success = reservation->valid
+        && reservation->addr == instr->get_mem_addr()
+        && reservation->size == instr->get_mem_size()
+        && compare_exchange_integer<uint64, endian>( reservation->value, narrow_cast<uint64>( instr->get_v_src( 1)),
+                                                     instr->get_mem_addr(), instr->get_mem_size());
+    reservation->valid = false;
+    instr->store_conditional( success);
+}
+
+template<typename M, std::endian endian, typename Instr>
+void FuncMemory::atomic_sized( Instr* instr)
+{
+    using DstType = decltype( std::declval<Instr>().get_v_dst( 0));
+    M loaded{};
+    M result{};
+    do {
+        loaded = read<M, endian>( instr->get_mem_addr());
+        result = narrow_cast<M>( instr->get_atomic_result( narrow_cast<DstType>( loaded)));
+    } while ( !compare_exchange_value<M, endian>( loaded, result, instr->get_mem_addr()));
+    instr->load( narrow_cast<DstType>( loaded));
+}
+
+template<typename Instr, std::endian endian>
+void FuncMemory::atomic( Instr* instr)
+{
+    switch ( instr->get_mem_size()) {
+    case 4: atomic_sized<uint32, endian>( instr); break;
+    case 8: atomic_sized<uint64, endian>( instr); break;
+    default: assert( false);
+    }
+}
+
 template<typename Instr>
-void FuncMemory::load_store( Instr* instr)
+void FuncMemory::load_store( Instr* instr, Reservation* reservation)
 {
-    if ( instr->is_load()) {
+    if ( instr->is_atomic()) {
+        if ( instr->get_endian() == std::endian::little)
+            atomic<Instr, std::endian::little>( instr);
+        else
+            atomic<Instr, std::endian::big>( instr);
+    }
+    else if ( instr->is_store_conditional()) {
+        if ( instr->get_endian() == std::endian::little)
+            store_conditional<Instr, std::endian::little>( instr, reservation);
+        else
+            store_conditional<Instr, std::endian::big>( instr, reservation);
+    }
+    else if ( instr->is_load()) {
         load( instr);
+        if ( instr->is_load_reserved() && reservation != nullptr) {
+            using DstType = decltype( std::declval<Instr>().get_v_dst( 0));
+            auto value = instr->get_v_dst( 0) & bitmask<DstType>( instr->get_mem_size() * CHAR_BIT);
+            *reservation = { instr->get_mem_addr(), instr->get_mem_size(), narrow_cast<uint64>( value), true };
+        }
     }
     else if ( instr->is_store()) {
         if ( instr->get_endian() == std::endian::little)
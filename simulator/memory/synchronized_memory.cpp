@@ -0,0 +1,63 @@
+/**
+ * synchronized_memory.cpp - memory shared by several host threads
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include <memory/memory.h>
+
+#include <mutex>
+#include <shared_mutex>
+
+// Writes may allocate pages of the underlying memory, so they are exclusive
+// while reads may run concurrently
+class SynchronizedMemory : public FuncMemory
+{
+public:
+    explicit SynchronizedMemory( std::shared_ptr<FuncMemory> memory) : memory( std::move( memory)) { }
+
+    size_t memcpy_guest_to_host( std::byte* dst, Addr src, size_t size) const noexcept final
+    {
+        std::shared_lock lock( mutex);
+        return memory->memcpy_guest_to_host( dst, src, size);
+    }
+
+    size_t memcpy_host_to_guest( Addr dst, const std::byte* src, size_t size) final
+    {
+        std::unique_lock lock( mutex);
+        return memory->memcpy_host_to_guest( dst, src, size);
+    }
+
+    bool compare_exchange( Addr addr, const std::byte* expected, const std::byte* desired, size_t size) final
+    {
+        std::unique_lock lock( mutex);
+        return memory->compare_exchange( addr, expected, desired, size);
+    }
+
+    void duplicate_to( std::shared_ptr<WriteableMemory> target) const final
+    {
+        std::shared_lock lock( mutex);
+        memory->duplicate_to( std::move( target));
+    }
+
+    std::string dump() const final
+    {
+        std::shared_lock lock( mutex);
+        return memory->dump();
+    }
+
+    size_t strlen( Addr addr) const final
+    {
+        std::shared_lock lock( mutex);
+        return memory->strlen( addr);
+    }
+
+private:
+    std::shared_ptr<FuncMemory> memory;
+    mutable std::shared_mutex mutex;
+};
+
+std::shared_ptr<FuncMemory>
+FuncMemory::create_synchronized_memory( std::shared_ptr<FuncMemory> memory)
+{
+    return std::make_shared<SynchronizedMemory>( std::move( memory));
+}
@@ -100,7 +100,7 @@ template<typename I> const auto mips_nor     = MIPSALU<I>::nor;
 template<typename I> const auto mips_or      = MIPSALU<I>::orv;
 template<typename I> const auto mips_ori     = MIPSALU<I>::ori;
 template<typename I> const auto mips_sb      = MIPSALU<I>::store_addr;
-template<typename I> const auto mips_sc      = MIPSALU<I>::store_addr_aligned;
+template<typename I> const auto mips_sc      = MIPSALU<I>::atomic_addr;
 template<typename I> const auto mips_sd      = MIPSALU<I>::store_addr_aligned;
 template<typename I> const auto mips_sdl     = MIPSALU<I>::store_addr;
 template<typename I> const auto mips_sdr     = MIPSALU<I>::store_addr;
@@ -442,11 +442,11 @@ static const Table<I> isaMapIJ =
     {0x2E, { "swr", mips_swr<I>, OUT_STORE, 4, 'I', Imm::ADDR, { Src::RS, Src::RT }, { Dst::ZERO }, MIPS_I_Instr} },
 //  {0x2F, { "cache"
     // Advanced loads and stores
-    {0x30, { "ll",   mips_ll<I>,   OUT_LOAD,  2, 'I', Imm::ADDR, { Src::RS },          { Dst::RT },   MIPS_I_Instr} },
+    {0x30, { "ll",   mips_ll<I>,   OUT_LOAD_RESERVED,  4, 'I', Imm::ADDR, { Src::RS },          { Dst::RT },   MIPS_I_Instr} },
     {0x31, { "lwc1", mips_lwc1<I>, OUT_LOAD,  4, 'I', Imm::ADDR, { Src::RS },          { Dst::FT },   MIPS_I_Instr} },
     {0x35, { "ldc1", mips_ldc1<I>, OUT_LOAD,  8, 'I', Imm::ADDR, { Src::RS },          { Dst::FT },   MIPS_II_Instr} },
     {0x37, { "ld",   mips_ld<I>,   OUT_LOAD,  8, 'I', Imm::ADDR, { Src::RS },          { Dst::RT },   MIPS_III_Instr} },
-    {0x38, { "sc",   mips_sc<I>,   OUT_STORE, 2, 'I', Imm::ADDR, { Src::RS, Src::RT }, { Dst::ZERO }, MIPS_I_Instr} },
+    {0x38, { "sc",   mips_sc<I>,   OUT_STORE_CONDITIONAL, 4, 'I', Imm::ADDR, { Src::RS, Src::RT }, { Dst::RT }, MIPS_I_Instr} },
     {0x39, { "swc1", mips_swc1<I>, OUT_STORE, 4, 'I', Imm::ADDR, { Src::RS },          { Dst::FT },   MIPS_I_Instr} },
     {0x3D, { "sdc1", mips_sdc1<I>, OUT_STORE, 8, 'I', Imm::ADDR, { Src::RS },          { Dst::FT },   MIPS_II_Instr} },
     {0x3F, { "sd",   mips_sd<I>,   OUT_STORE, 8, 'I', Imm::ADDR, { Src::RS, Src::RT }, { Dst::ZERO }, MIPS_III_Instr} },
@@ -202,18 +202,18 @@ TEST_CASE( "MIPS32_instr: ll (most significant bit is 0)")
     CHECK( instr.get_mem_addr() == 0x1000);
 
     get_plain_memory_with_data()->load_store( &instr);
-    CHECK( instr.get_v_dst( 0) == 0x1234);
+    CHECK( instr.get_v_dst( 0) == 0xABCD'1234);
 }
 
 TEST_CASE( "MIPS32_instr: ll (most significant bit is 1)")
 {
     MIPS32Instr instr( "ll", 0x0fff);
-    instr.set_v_src( 3, 0);
+    instr.set_v_src( 5, 0);
     instr.execute();
-    CHECK( instr.get_mem_addr() == 0x1002);
+    CHECK( instr.get_mem_addr() == 0x1004);
 
     get_plain_memory_with_data()->load_store( &instr);
-    CHECK( instr.get_v_dst( 0) == 0xffff'ABCD);
+    CHECK( instr.get_v_dst( 0) == 0xBADC'5678);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -367,22 +367,23 @@ TEST_CASE( "MIPS32_instr: swr (instr->mem_addr % 4 = 2)")
 }
 ////////////////////////////////////////////////////////////////////////////////
 
-//Data cache model is not implemeted so sc is tested like sh
+//Data cache model is not implemeted so sc is tested like sw
 TEST_CASE( "MIPS32_instr: sc 0xdead")
 {
     CHECK(MIPS32Instr(0xe13104d2).get_disasm() == "sc $s1, 0x4d2($t1)");
     CHECK(MIPS32Instr(0xe131fb2e).get_disasm() == "sc $s1, 0xfb2e($t1)");
 
     MIPS32Instr instr( "sc", 0x1000);
-    instr.set_v_src( 1, 0);
+    instr.set_v_src( 4, 0);
     instr.set_v_src( 0xdead, 1);
     instr.execute();
-    CHECK( instr.get_mem_addr() == 0x1001);
+    CHECK( instr.get_mem_addr() == 0x1004);
 
     auto memory = get_plain_memory_with_data();
     memory->load_store( &instr);
-    auto value = memory->read<uint32, std::endian::little>( 0x1001);
-    CHECK( value == 0x78ab'dead);
+    auto value = memory->read<uint32, std::endian::little>( 0x1004);
+    CHECK( value == 0x0000'dead);
+    CHECK( instr.get_v_dst( 0) == 1);
 }
 
 TEST_CASE( "MIPS32_instr: load dump")
@@ -24,6 +24,22 @@ Branch<FuncInstr>::Branch( Module* parent) : Module( parent, "branch")
     wp_bypassing_unit_flush_notify = make_write_port<bool>("BRANCH_2_BYPASSING_UNIT_FLUSH_NOTIFY", Port::BW);
 }
 
+template <typename FuncInstr>
+void Branch<FuncInstr>::count_jump( const Instr& instr, bool is_misprediction)
+{
+    auto* stats = instr.is_branch() ? &conditional_stats
+                : instr.is_return() ? &return_stats
+                : instr.is_indirect_jump() ? &indirect_stats
+                : nullptr;
+
+    if ( stats == nullptr)
+        return;
+
+    ++stats->jumps;
+    if ( is_misprediction)
+        ++stats->mispredictions;
+}
+
 template <typename FuncInstr>
 void Branch<FuncInstr>::clock( Cycle cycle)
 {
@@ -46,7 +62,9 @@ void Branch<FuncInstr>::clock( Cycle cycle)
         num_jumps++;
 
     /* handle misprediction */
-    if ( is_misprediction( instr, instr.get_bp_data()))
+    const bool has_misprediction = is_misprediction( instr, instr.get_bp_data());
+    count_jump( instr, has_misprediction);
+    if ( has_misprediction)
     {
         num_mispredictions++;
 
@@ -65,7 +83,7 @@ void Branch<FuncInstr>::clock( Cycle cycle)
     sout << instr << std::endl;
 
     /* bypass data */
-    wp_bypass->write( instr.get_v_dst(), cycle);
+    wp_bypass->write( instr.get_bypassed_data(), cycle);
 
     /* data path */
     wp_datapath->write( std::move( instr), cycle);
@@ -13,16 +13,27 @@
 
 class FuncMemory;
 
+struct JumpStatistics
+{
+    uint64 jumps = 0;
+    uint64 mispredictions = 0;
+};
+
 template <typename FuncInstr>
 class Branch : public Module
 {
     using Instr = PerfInstr<FuncInstr>;
     using RegisterUInt = typename FuncInstr::RegisterUInt;
-    using InstructionOutput = std::array< RegisterUInt, MAX_DST_NUM>;
+    using InstructionOutput = BypassedData<RegisterUInt>;
 
     private:
         uint64 num_mispredictions = 0;
         uint64 num_jumps          = 0;
+        JumpStatistics conditional_stats;
+        JumpStatistics return_stats;
+        JumpStatistics indirect_stats; // except of returns
+
+        void count_jump( const Instr& instr, bool is_misprediction);
 
         ReadPort<Instr>* rp_datapath = nullptr;
         WritePort<Instr>* wp_datapath = nullptr;
@@ -45,6 +56,9 @@ class Branch : public Module
         void clock( Cycle cycle);
         auto get_mispredictions_num() const { return num_mispredictions; }
         auto get_jumps_num() const { return num_jumps; }
+        const auto& get_conditional_statistics() const { return conditional_stats; }
+        const auto& get_return_statistics() const { return return_stats; }
+        const auto& get_indirect_statistics() const { return indirect_stats; }
 
         static bool is_misprediction( const Instr& instr, const BPInterface& bp_data)
         {
@@ -16,7 +16,7 @@ class BranchTestingEnvironment : public Module {
 public:
     using Instr = PerfInstr<BranchTestInstr>;
     using RegisterUInt = typename BranchTestInstr::RegisterUInt;
-    using InstructionOutput = std::array< RegisterUInt, MAX_DST_NUM>;
+    using InstructionOutput = BypassedData<RegisterUInt>;
 
     ReadPort<bool> *rp_flush = nullptr;
     WritePort<bool> *wp_trap = nullptr;
@@ -164,9 +164,10 @@ TEST_CASE( "bypass check", "[branch_module]")
 
     CHECK_PORT_READY( t.env.rp_bypass);
     auto bypass_data = t.env.rp_bypass->read( cl_assert);
+    CHECK( bypass_data.producer_id == instr.get_sequence_id());
     for ( int i = 0; i < MAX_DST_NUM; ++i) {
         INFO( "i = " << i);
-        CHECK( bypass_data.at( i) == dsts.at( i));
+        CHECK( bypass_data.value.at( i) == dsts.at( i));
     }
 }
 
@@ -0,0 +1,52 @@
+/*
+ * cpi_stack.cpp - attribution of cycles to reasons of pipeline stalls
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include "cpi_stack.h"
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <numeric>
+#include <string>
+
+namespace pt = boost::property_tree;
+
+static const std::array<std::string, CPIStack::COMPONENTS_NUM> json_keys =
+{
+    "base", "long_alu", "data_hazard", "dcache_miss", "icache_miss",
+    "decode_misprediction", "branch_misprediction", "flush", "frontend"
+};
+
+uint64 CPIStack::get_total_cycles() const
+{
+    return std::accumulate( components.begin(), components.end(), uint64{ 0});
+}
+
+void CPIStack::dump( std::ostream& out, uint64 instrs) const
+{
+    out << "CPI stack:  base - " << get_cpi( BASE, instrs)
+        << ", long ALU - " << get_cpi( LONG_ALU, instrs)
+        << ", data hazards - " << get_cpi( DATA_HAZARD, instrs)
+        << ", L1D misses - " << get_cpi( DCACHE_MISS, instrs) << std::endl
+        << "            L1I misses - " << get_cpi( ICACHE_MISS, instrs)
+        << ", mispredictions on decode - " << get_cpi( DECODE_MISPREDICTION, instrs)
+        << ", on branch - " << get_cpi( BRANCH_MISPREDICTION, instrs)
+        << ", flushes - " << get_cpi( FLUSH, instrs)
+        << ", empty front end - " << get_cpi( FRONTEND, instrs) << std::endl;
+}
+
+void CPIStack::dump_json( std::ostream& out, uint64 instrs) const
+{
+    pt::ptree stack;
+    stack.put( "instrs", instrs);
+    stack.put( "cycles", get_total_cycles());
+    for ( uint8 i = 0; i < COMPONENTS_NUM; ++i)
+    {
+        const auto reason = static_cast<Component>( i);
+        stack.put( "components." + json_keys.at( reason) + ".cycles", get_cycles( reason));
+        stack.put( "components." + json_keys.at( reason) + ".cpi", get_cpi( reason, instrs));
+    }
+    pt::write_json( out, stack);
+}
@@ -0,0 +1,86 @@
+/*
+ * cpi_stack.h - attribution of cycles to reasons of pipeline stalls
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef CPI_STACK_H
+#define CPI_STACK_H
+
+#include <infra/macro.h>
+#include <infra/types.h>
+
+#include <algorithm>
+#include <array>
+#include <ostream>
+
+// Each cycle in which writeback has not retired an instruction is blamed on a single reason.
+// Back end stalls of the cycle are the most important, as they hold the oldest instructions.
+// Otherwise the cycle is blamed on the latest front end event, i.e. a flush or an instruction cache miss,
+// until the first instruction delayed by the event is retired.
+class CPIStack
+{
+public:
+    // sorted by priority
+    enum Component : uint8
+    {
+        BASE,                 // at least one instruction is retired
+        LONG_ALU,             // long arithmetic unit is occupied
+        DATA_HAZARD,          // decode waits for source operands
+        DCACHE_MISS,          // whole pipeline waits for data cache
+        ICACHE_MISS,
+        DECODE_MISPREDICTION,
+        BRANCH_MISPREDICTION,
+        FLUSH,                // writeback has redirected fetch after a trap
+        FRONTEND,             // fetch has not delivered instructions for other reasons
+        COMPONENTS_NUM
+    };
+
+    void retire( uint64 id)
+    {
+        has_retired = true;
+        if ( delayed_id != NO_VAL64 && id >= delayed_id)
+        {
+            delay_reason = FRONTEND;
+            delayed_id = NO_VAL64;
+        }
+    }
+
+    // instructions starting from the given one are delayed by a front end event
+    void delay( Component reason, uint64 id)
+    {
+        delay_reason = reason;
+        delayed_id = id;
+    }
+
+    // back end has stalled in the current cycle
+    void stall( Component reason) { stall_reason = std::min( stall_reason, reason); }
+
+    void close_cycle()
+    {
+        add( has_retired ? BASE : std::min( stall_reason, delay_reason));
+        has_retired = false;
+        stall_reason = FRONTEND;
+    }
+
+    void add( Component reason, uint64 cycles = 1) { components.at( reason) += cycles; }
+
+    uint64 get_cycles( Component reason) const { return components.at( reason); }
+    uint64 get_total_cycles() const;
+
+    void dump( std::ostream& out, uint64 instrs) const;
+    void dump_json( std::ostream& out, uint64 instrs) const;
+
+private:
+    double get_cpi( Component reason, uint64 instrs) const
+    {
+        return instrs != 0 ? double( components.at( reason)) / double( instrs) : 0;
+    }
+
+    std::array<uint64, COMPONENTS_NUM> components = {};
+    bool has_retired = false;
+    Component stall_reason = FRONTEND;
+    Component delay_reason = FRONTEND;
+    uint64 delayed_id = NO_VAL64;
+};
+
+#endif // CPI_STACK_H
@@ -0,0 +1,240 @@
+/*
+ * multi_core_sim.cpp - several performance simulators sharing memory
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include "multi_core_sim.h"
+
+#include "perf_config.h"
+
+#include <memory/memory.h>
+#include <modules/mem/coherence/mesi_directory.h>
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <thread>
+
+// Memory view of a single core, waits for the turn of the core before each access
+class OrderedMemory : public FuncMemory
+{
+public:
+    OrderedMemory( std::shared_ptr<FuncMemory> memory, std::function<void()> wait_for_turn)
+        : memory( std::move( memory)), wait_for_turn( std::move( wait_for_turn))
+    { }
+
+    size_t memcpy_guest_to_host( std::byte* dst, Addr src, size_t size) const noexcept final
+    {
+        wait_for_turn();
+        return memory->memcpy_guest_to_host( dst, src, size);
+    }
+
+    size_t memcpy_host_to_guest( Addr dst, const std::byte* src, size_t size) final
+    {
+        wait_for_turn();
+        return memory->memcpy_host_to_guest( dst, src, size);
+    }
+
+    bool compare_exchange( Addr addr, const std::byte* expected, const std::byte* desired, size_t size) final
+    {
+        wait_for_turn();
+        return memory->compare_exchange( addr, expected, desired, size);
+    }
+
+    void duplicate_to( std::shared_ptr<WriteableMemory> target) const final
+    {
+        wait_for_turn();
+        memory->duplicate_to( std::move( target));
+    }
+
+    std::string dump() const final
+    {
+        wait_for_turn();
+        return memory->dump();
+    }
+
+    size_t strlen( Addr addr) const final
+    {
+        wait_for_turn();
+        return memory->strlen( addr);
+    }
+
+private:
+    std::shared_ptr<FuncMemory> memory;
+    std::function<void()> wait_for_turn;
+};
+
+MultiCoreSim::MultiCoreSim( std::vector<std::shared_ptr<CycleAccurateSimulator>> c)
+    : cores( std::move( c))
+    , host_threads( std::thread::hardware_concurrency())
+    , progress( cores.size())
+    , exceptions( cores.size())
+{
+    if ( cores.empty())
+        throw InvalidCoresNumber( "at least one core is required");
+
+    for ( size_t i = 0; i < cores.size(); ++i)
+        cores[i]->write_csr_register( "mhartid", i);
+}
+
+void MultiCoreSim::set_memory( std::shared_ptr<FuncMemory> m)
+{
+    memory = FuncMemory::create_synchronized_memory( std::move( m));
+    core_memories.clear();
+    for ( size_t i = 0; i < cores.size(); ++i) {
+        core_memories.emplace_back( std::make_shared<OrderedMemory>( memory, [this, i]() { wait_for_memory_turn( i); }));
+        cores[i]->set_memory( core_memories.back());
+        // Cores do not write code, so instruction fetch does not wait for other cores
+        cores[i]->set_instruction_memory( memory);
+    }
+}
+
+void MultiCoreSim::enable_coherence( const PerfConfig& config)
+{
+    directory = std::make_shared<MESIDirectory>( cores.size(), config.dcache, config.coherence);
+    for ( size_t i = 0; i < cores.size(); ++i)
+        cores[i]->set_coherent_cache( std::make_shared<CoherentCache>( directory, i, [this, i]() { wait_for_memory_turn( i); }));
+}
+
+void MultiCoreSim::set_pc( Addr pc)
+{
+    for ( auto& core : cores)
+        core->set_pc( pc);
+}
+
+void MultiCoreSim::start( uint64 instrs_per_core)
+{
+    for ( size_t i = 0; i < cores.size(); ++i) {
+        // Checkers have private memory copies and cannot track stores of other cores
+        cores[i]->disable_checker();
+        cores[i]->start( instrs_per_core);
+        progress[i].cycles = 0;
+        exceptions[i] = nullptr;
+    }
+    aborted = false;
+}
+
+Trap MultiCoreSim::run( uint64 instrs_per_core)
+{
+    // Exact mode has the results of sequential simulation, but slower if host threads are shared
+    if ( quantum == 0 && cores.size() > host_threads)
+        return run_sequentially( instrs_per_core);
+
+    start( instrs_per_core);
+
+    running = true;
+    std::vector<std::thread> threads;
+    threads.reserve( cores.size());
+    for ( size_t i = 0; i < cores.size(); ++i)
+        threads.emplace_back( [this, i]() { run_core( i); });
+
+    for ( auto& thread : threads)
+        thread.join();
+    running = false;
+
+    for ( const auto& e : exceptions)
+        if ( e != nullptr)
+            std::rethrow_exception( e);
+
+    dump_statistics();
+    return merge_traps();
+}
+
+Trap MultiCoreSim::run_sequentially( uint64 instrs_per_core)
+{
+    start( instrs_per_core);
+
+    bool any_running = true;
+    while ( any_running) {
+        any_running = false;
+        for ( auto& core : cores) {
+            if ( core->get_trap() != Trap::NO_TRAP)
+                continue;
+
+            core->clock();
+            any_running = true;
+        }
+    }
+
+    dump_statistics();
+    return merge_traps();
+}
+
+void MultiCoreSim::run_core( size_t index)
+{
+    auto& core = cores[index];
+    try {
+        while ( core->get_trap() == Trap::NO_TRAP && !aborted) {
+            auto cycle = progress[index].cycles.load();
+            if ( quantum != 0 && cycle % quantum == 0)
+                wait_for_quantum( index, cycle);
+
+            core->clock();
+            progress[index].cycles = cycle + 1;
+        }
+    }
+    catch ( ...) {
+        exceptions[index] = std::current_exception();
+        aborted = true;
+    }
+
+    // Finished core does not block the others anymore
+    progress[index].cycles = MAX_VAL64;
+}
+
+bool MultiCoreSim::is_ready( size_t index, uint64 cycle, bool inclusive) const
+{
+    return aborted || progress[index].cycles >= ( inclusive ? cycle + 1 : cycle);
+}
+
+void MultiCoreSim::wait_for_quantum( size_t index, uint64 cycle) const
+{
+    for ( size_t i = 0; i < cores.size(); ++i)
+        while ( i != index && !is_ready( i, cycle, false))
+            std::this_thread::yield();
+}
+
+void MultiCoreSim::wait_for_memory_turn( size_t index) const
+{
+    if ( !running || quantum != 0)
+        return;
+
+    // In sequential simulation cores with lower indices are clocked first,
+    // a store is seen by the others in the next cycle, so they may be a cycle behind at most
+    auto cycle = progress[index].cycles.load();
+    for ( size_t i = 0; i < cores.size(); ++i)
+        while ( i != index && !is_ready( i, cycle, i < index))
+            std::this_thread::yield();
+}
+
+void MultiCoreSim::dump_statistics() const
+{
+    for ( const auto& core : cores)
+        core->dump_statistics();
+
+    if ( directory != nullptr)
+        directory->dump_statistics( std::cout);
+}
+
+int MultiCoreSim::get_exit_code() const
+{
+    for ( const auto& core : cores)
+        if ( core->get_exit_code() != 0)
+            return core->get_exit_code();
+
+    return 0;
+}
+
+Trap MultiCoreSim::merge_traps() const
+{
+    auto it = std::find_if( cores.begin(), cores.end(), []( const auto& core) {
+        return core->get_trap() != Trap::HALT && core->get_trap() != Trap::BREAKPOINT;
+    });
+    if ( it != cores.end())
+        return ( *it)->get_trap();
+
+    bool all_halted = std::all_of( cores.begin(), cores.end(), []( const auto& core) {
+        return core->get_trap() == Trap::HALT;
+    });
+    return all_halted ? Trap( Trap::HALT) : Trap( Trap::BREAKPOINT);
+}
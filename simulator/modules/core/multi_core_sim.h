@@ -0,0 +1,94 @@
+/*
+ * multi_core_sim.h - several performance simulators sharing memory
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef MULTI_CORE_SIM_H
+#define MULTI_CORE_SIM_H
+
+#include <infra/exception.h>
+#include <simulator.h>
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <vector>
+
+class FuncMemory;
+class MESIDirectory;
+struct PerfConfig;
+
+struct InvalidCoresNumber final : Exception
+{
+    explicit InvalidCoresNumber( const std::string& msg)
+        : Exception( "Invalid number of cores", msg)
+    { }
+};
+
+// Each core is clocked by its own host thread. With non-zero quantum
+// a core may run ahead of the others by at most the quantum of cycles.
+// With zero quantum synchronization is conservative: a core accesses memory
+// only when all the preceding accesses of sequential simulation are done,
+// so the results are exactly the same as if cores were clocked in turn.
+// Stores are visible to loads of other cores in the next cycle, so the lookahead
+// of data accesses is a single cycle. Instruction fetch is not ordered, as cores
+// do not write code, and cores outnumbering host threads are clocked sequentially.
+class MultiCoreSim
+{
+public:
+    explicit MultiCoreSim( std::vector<std::shared_ptr<CycleAccurateSimulator>> cores);
+
+    size_t get_cores_num() const { return cores.size(); }
+    const std::shared_ptr<CycleAccurateSimulator>& get_core( size_t index) const { return cores.at( index); }
+
+    void set_memory( std::shared_ptr<FuncMemory> memory);
+    const std::shared_ptr<FuncMemory>& get_memory() const { return memory; }
+    const std::shared_ptr<FuncMemory>& get_memory( size_t core) const { return core_memories.at( core); }
+
+    // Private data caches of cores are kept coherent by MESI directory
+    void enable_coherence( const PerfConfig& config);
+    const std::shared_ptr<MESIDirectory>& get_directory() const { return directory; }
+
+    void set_pc( Addr pc);
+    void set_quantum( uint64 value) { quantum = value; }
+
+    // Exact mode clocks cores sequentially if they outnumber host threads
+    void set_host_threads( size_t value) { host_threads = value; }
+
+    Trap run( uint64 instrs_per_core);
+
+    // Reference mode: all cores are clocked in turn by a single host thread
+    Trap run_sequentially( uint64 instrs_per_core);
+
+    // The first non-zero exit code of cores, so a failure of any core is reported
+    int get_exit_code() const;
+
+private:
+    // Keep counters of different cores in different cache lines
+    struct alignas(64) Progress
+    {
+        std::atomic<uint64> cycles = 0;
+    };
+
+    void start( uint64 instrs_per_core);
+    void run_core( size_t index);
+    void wait_for_quantum( size_t index, uint64 cycle) const;
+    void wait_for_memory_turn( size_t index) const;
+    bool is_ready( size_t index, uint64 cycle, bool inclusive) const;
+    Trap merge_traps() const;
+    void dump_statistics() const;
+
+    std::vector<std::shared_ptr<CycleAccurateSimulator>> cores;
+    std::shared_ptr<FuncMemory> memory;
+    std::vector<std::shared_ptr<FuncMemory>> core_memories;
+    std::shared_ptr<MESIDirectory> directory;
+    uint64 quantum = 0;
+    size_t host_threads;
+
+    std::vector<Progress> progress;
+    std::vector<std::exception_ptr> exceptions;
+    std::atomic<bool> running = false;
+    std::atomic<bool> aborted = false;
+};
+
+#endif // MULTI_CORE_SIM_H
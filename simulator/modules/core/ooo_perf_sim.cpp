@@ -0,0 +1,232 @@
+/*
+ * ooo_perf_sim.cpp - out-of-order performance simulator
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include "ooo_perf_sim.h"
+#include <func_sim/instr_memory.h>
+
+#include <iostream>
+
+template <typename ISA>
+OOOPerfSim<ISA>::OOOPerfSim( std::endian endian, std::string_view isa, const PerfConfig& config)
+    : CycleAccurateSimulator( isa)
+    , rfs( config.smt.threads)
+    , endian( endian)
+    , fetch( this, config), backend( this, config), writeback( this, endian, config)
+    , width( config.pipeline.width)
+    , has_branch_oracle( config.oracle.bp)
+{
+    rp_halt = make_read_port<Trap>("WRITEBACK_2_CORE_HALT", Port::LATENCY);
+    rp_icache_miss = make_read_port<Target>("FETCH_2_CORE_ICACHE_MISS", Port::LATENCY);
+
+    for ( size_t i = 0; i < rfs.size(); ++i) {
+        threads.emplace_back( std::make_shared<HardwareThread<ISA>>( this, i));
+        backend.set_RF( &rfs[i], i);
+        writeback.set_RF( &rfs[i], i);
+        // drivers redirect threads with their own sequence ids
+        writeback.set_driver( ISA::create_driver( i == 0 ? static_cast<Simulator*>( this) : threads[i].get()), i);
+    }
+
+    if ( MemoryHierarchy::is_enabled( config))
+    {
+        memory_hierarchy = std::make_shared<MemoryHierarchy>( config);
+        fetch.set_memory_hierarchy( memory_hierarchy);
+        backend.set_memory_hierarchy( memory_hierarchy);
+        writeback.set_memory_hierarchy( memory_hierarchy);
+    }
+
+    init_portmap();
+    enable_logging( config.units_to_log);
+    topology_dumping( config.topology_dump, "topology.json");
+}
+
+template <typename ISA>
+std::shared_ptr<Simulator> OOOPerfSim<ISA>::get_thread( size_t index)
+{
+    return threads.at( index);
+}
+
+template <typename ISA>
+void OOOPerfSim<ISA>::set_memory( std::shared_ptr<FuncMemory> m)
+{
+    set_thread_memory( m, 0);
+}
+
+template <typename ISA>
+void OOOPerfSim<ISA>::set_thread_memory( const std::shared_ptr<FuncMemory>& m, size_t thread)
+{
+    set_thread_instruction_memory( m, thread);
+    backend.set_memory( m, thread);
+}
+
+template <typename ISA>
+void OOOPerfSim<ISA>::set_thread_instruction_memory( const std::shared_ptr<ReadableMemory>& m, size_t thread)
+{
+    auto imemory = std::make_unique<InstrMemoryCached<ISA>>( endian);
+    imemory->set_memory( m);
+    fetch.set_memory( std::move( imemory), thread);
+}
+
+template <typename ISA>
+void OOOPerfSim<ISA>::set_thread_kernel( const std::shared_ptr<Kernel>& k, size_t thread)
+{
+    if ( has_branch_oracle)
+        fetch.set_oracle( std::make_unique<FuncSimOracle<ISA>>( endian, k.get(), get_isa()), thread);
+
+    writeback.set_kernel( k, get_isa(), thread);
+}
+
+template <typename ISA>
+void OOOPerfSim<ISA>::set_target( const Target& target)
+{
+    set_thread_target( target, 0);
+}
+
+template <typename ISA>
+void OOOPerfSim<ISA>::set_thread_target( const Target& target, size_t thread)
+{
+    writeback.set_target( Target( target.address, Target::get_first_sequence_id( thread) | target.sequence_id), curr_cycle);
+}
+
+template<typename ISA>
+void OOOPerfSim<ISA>::start( uint64 instrs_to_run)
+{
+    current_trap = Trap( Trap::NO_TRAP);
+
+    writeback.set_instrs_to_run( instrs_to_run);
+
+    start_time = std::chrono::high_resolution_clock::now();
+}
+
+template<typename ISA>
+Trap OOOPerfSim<ISA>::run( uint64 instrs_to_run)
+{
+    start( instrs_to_run);
+
+    while (current_trap == Trap::NO_TRAP)
+        clock();
+
+    dump_statistics();
+
+    return current_trap;
+}
+
+template<typename ISA>
+void OOOPerfSim<ISA>::clock()
+{
+    clock_tree( curr_cycle);
+    curr_cycle.inc();
+}
+
+template<typename ISA>
+void OOOPerfSim<ISA>::clock_tree( Cycle cycle)
+{
+    fetch.clock( cycle);
+    backend.clock( cycle);
+    writeback.clock( cycle);
+    /* any thread stops the whole core, writeback sends nothing of a thread after its trap */
+    while ( rp_halt->is_ready( cycle)) {
+        const auto trap = rp_halt->read( cycle);
+        if ( trap != Trap::NO_TRAP)
+            current_trap = trap;
+    }
+    sout << "******************\n";
+}
+
+template<typename ISA>
+void OOOPerfSim<ISA>::dump_statistics() const
+{
+    const auto rate = []( uint64 piece, uint64 total) { return total != 0 ? 100.0 * double( piece) / double( total) : 0; };
+    const auto average = []( uint64 sum, uint64 cycles) { return cycles != 0 ? double( sum) / double( cycles) : 0; };
+    const auto jump_rate = [&rate]( const JumpStatistics& stats) { return rate( stats.mispredictions, stats.jumps); };
+
+    auto executed_instrs = writeback.get_executed_instrs();
+    auto now_time = std::chrono::high_resolution_clock::now();
+    auto time = std::chrono::duration<double, std::milli>(now_time - start_time).count();
+    auto cycles = curr_cycle;
+    auto frequency = double{ cycles} / time; // cycles per millisecond = kHz
+    auto ipc = 1.0 * executed_instrs / double{ cycles};
+    auto simips = executed_instrs / time;
+    const auto& conditional = backend.get_conditional_statistics();
+    const auto& returns = backend.get_return_statistics();
+    const auto& indirect = backend.get_indirect_statistics();
+    const auto& dcache = backend.get_dcache_statistics();
+    const auto& ooo = backend.get_statistics();
+
+    std::cout << std::endl << "****************************"
+              << std::endl << "instrs:     " << executed_instrs
+              << std::endl << "cycles:     " << cycles
+              << std::endl << "IPC:        " << ipc
+              << std::endl << "sim freq:   " << frequency << " kHz"
+              << std::endl << "sim IPS:    " << simips    << " kips"
+              << std::endl << "instr size: " << sizeof(Instr) << " bytes"
+              << std::endl << "mispredict: detected on decode stage - " << rate( backend.get_decode_mispredictions_num(), backend.get_decode_jumps_num()) << "%"
+              << std::endl << "            detected on branch stage - " << rate( backend.get_mispredictions_num(), backend.get_jumps_num()) << "%"
+              << std::endl << "            conditional - " << jump_rate( conditional) << "% of " << conditional.jumps
+              << ", returns - " << jump_rate( returns) << "% of " << returns.jumps
+              << ", indirect - " << jump_rate( indirect) << "% of " << indirect.jumps
+              << std::endl << "L1I misses: " << fetch.get_icache_misses() << ", prefetched lines - " << fetch.get_icache_prefetches()
+              << std::endl << "L1D misses: loads - " << rate( dcache.load_misses, dcache.loads) << "%, stores - " << rate( dcache.store_misses, dcache.stores) << "%"
+              << std::endl << "L1D MSHRs:  merged misses - " << dcache.mshr_merges << ", waits for free MSHR - " << dcache.mshr_full
+              << std::endl << "occupancy:  ROB - " << average( ooo.rob_occupancy, ooo.cycles)
+              << ", IQ - " << average( ooo.iq_occupancy, ooo.cycles)
+              << ", LSQ - " << average( ooo.lsq_occupancy, ooo.cycles)
+              << std::endl << "dispatch stalls: ROB full - " << ooo.rob_full << ", IQ full - " << ooo.iq_full
+              << ", LSQ full - " << ooo.lsq_full << ", no free registers - " << ooo.registers_full
+              << std::endl << "memory order: forwarded loads - " << ooo.forwarded_loads
+              << ", waits for store addresses - " << ooo.address_waits << " cycles, partial overlaps - " << ooo.store_waits << " cycles"
+              << std::endl << "              violations - " << ooo.order_violations << ", replayed instructions - " << ooo.replayed_instrs
+              << ", store buffer full - " << ooo.store_buffer_full << " cycles"
+              << std::endl;
+
+    if ( threads.size() > 1) {
+        std::cout << "threads:   ";
+        for ( size_t i = 0; i < threads.size(); ++i)
+            std::cout << " " << writeback.get_executed_instrs( i);
+        std::cout << " instrs" << std::endl;
+    }
+
+    if ( width > 1)
+        std::cout << "fetched:    " << fetch.get_width_statistics() << std::endl
+                  << "issued:     " << backend.get_width_statistics() << std::endl
+                  << "retired:    " << writeback.get_width_statistics() << std::endl;
+
+    if ( memory_hierarchy != nullptr)
+        memory_hierarchy->dump_statistics( std::cout);
+
+    std::cout << "****************************" << std::endl;
+}
+
+template <typename ISA>
+uint64 OOOPerfSim<ISA>::read_gdb_register( size_t regno, size_t thread) const
+{
+    if ( regno == Register::get_gdb_pc_index())
+        return writeback.get_next_PC( thread);
+
+    return read_register( Register::from_gdb_index( regno), thread);
+}
+
+template <typename ISA>
+void OOOPerfSim<ISA>::write_gdb_register( size_t regno, uint64 value, size_t thread)
+{
+    if ( regno == Register::get_gdb_pc_index())
+        set_thread_target( Target( value, 0), thread);
+    else
+        write_register( Register::from_gdb_index( regno), value, thread);
+}
+
+#include <mips/mips.h>
+#include <risc_v/risc_v.h>
+
+template class OOOPerfSim<MIPSI>;
+template class OOOPerfSim<MIPSII>;
+template class OOOPerfSim<MIPSIII>;
+template class OOOPerfSim<MIPSIV>;
+template class OOOPerfSim<MIPS32>;
+template class OOOPerfSim<MIPS64>;
+template class OOOPerfSim<MARS>;
+template class OOOPerfSim<MARS64>;
+template class OOOPerfSim<RISCV32>;
+template class OOOPerfSim<RISCV64>;
+template class OOOPerfSim<RISCV128>;
@@ -0,0 +1,145 @@
+/*
+ * ooo_perf_sim.h - out-of-order performance simulator
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef OOO_PERF_SIM_H
+#define OOO_PERF_SIM_H
+
+#include "perf_config.h"
+#include "perf_instr.h"
+
+#include <modules/fetch/fetch.h>
+#include <modules/ooo/backend.h>
+#include <modules/ports_instance.h>
+#include <modules/writeback/writeback.h>
+#include <simulator.h>
+
+#include <chrono>
+#include <vector>
+
+template <typename ISA>
+class HardwareThread;
+
+// Shares fetch and writeback with the in-order pipeline,
+// the rest of the stages are replaced by the out-of-order backend.
+// Simulator interface of the core controls its first hardware thread.
+template <typename ISA>
+class OOOPerfSim : public CycleAccurateSimulator
+{
+    friend class HardwareThread<ISA>;
+public:
+    using Register = typename ISA::Register;
+    using RegisterUInt = typename ISA::RegisterUInt;
+    OOOPerfSim( std::endian endian, std::string_view isa, const PerfConfig& config);
+    Trap run( uint64 instrs_to_run) final;
+    void set_target( const Target& target) final;
+    void set_memory( std::shared_ptr<FuncMemory> memory) final;
+    void set_instruction_memory( std::shared_ptr<ReadableMemory> memory) final { set_thread_instruction_memory( memory, 0); }
+    void set_kernel( std::shared_ptr<Kernel> k) final { set_thread_kernel( k, 0); }
+    size_t get_threads_num() const final { return threads.size(); }
+    std::shared_ptr<Simulator> get_thread( size_t index) final;
+    void disable_checker() final { writeback.disable_checker(); }
+    void clock() final;
+    void start( uint64 instrs_to_run) final;
+    Trap get_trap() const final { return current_trap; }
+    void dump_statistics() const final;
+    void set_coherent_cache( std::shared_ptr<CoherentCache> cache) final { backend.set_coherent_cache( std::move( cache)); }
+    void enable_driver_hooks() final { writeback.enable_driver_hooks(); }
+    int get_exit_code() const noexcept final { return writeback.get_exit_code(); }
+
+    size_t sizeof_register() const final { return bytewidth<RegisterUInt>; }
+    size_t max_cpu_register() const final { return Register::MAX_REG; }
+
+    Addr get_pc() const final { return writeback.get_next_PC(); }
+
+    uint64 read_cpu_register( size_t regno) const final { return read_register( Register::from_cpu_index( regno)); }
+    uint64 read_gdb_register( size_t regno) const final { return read_gdb_register( regno, 0); }
+    uint64 read_csr_register( std::string_view reg_name) const final { return read_register( Register::from_csr_name( reg_name)); }
+
+    void write_cpu_register( size_t regno, uint64 value) final { write_register( Register::from_cpu_index( regno), value); }
+    void write_gdb_register( size_t regno, uint64 value) final { write_gdb_register( regno, value, 0); }
+    void write_csr_register( std::string_view reg_name, uint64 value) final { write_register( Register::from_csr_name( reg_name), value); }
+
+    // Rule of five
+    OOOPerfSim( const OOOPerfSim&) = delete;
+    OOOPerfSim( OOOPerfSim&&) = delete;
+    OOOPerfSim operator=( const OOOPerfSim&) = delete;
+    OOOPerfSim operator=( OOOPerfSim&&) = delete;
+    ~OOOPerfSim() override = default;
+private:
+    using FuncInstr = typename ISA::FuncInstr;
+    using Instr = PerfInstr<FuncInstr>;
+
+    Cycle curr_cycle = 0_cl;
+    decltype( std::chrono::high_resolution_clock::now()) start_time = {};
+
+    /* simulator units */
+    std::vector<RF<FuncInstr>> rfs;
+    const std::endian endian;
+
+    Fetch<FuncInstr> fetch;
+    Backend<FuncInstr> backend;
+    Writeback<ISA> writeback;
+    const uint32 width;
+    const bool has_branch_oracle;
+
+    // Lower memory levels shared by instruction fetch and data accesses
+    std::shared_ptr<MemoryHierarchy> memory_hierarchy;
+
+    std::vector<std::shared_ptr<HardwareThread<ISA>>> threads;
+
+    /* ports */
+    ReadPort<Trap>* rp_halt = nullptr;
+    // fetch reports instruction cache misses to CPI stack, which is kept by in-order core only
+    ReadPort<Target>* rp_icache_miss = nullptr;
+
+    void clock_tree( Cycle cycle);
+    Trap current_trap = Trap(Trap::NO_TRAP);
+
+    void set_thread_target( const Target& target, size_t thread);
+    void set_thread_memory( const std::shared_ptr<FuncMemory>& memory, size_t thread);
+    void set_thread_instruction_memory( const std::shared_ptr<ReadableMemory>& memory, size_t thread);
+    void set_thread_kernel( const std::shared_ptr<Kernel>& k, size_t thread);
+    uint64 read_gdb_register( size_t regno, size_t thread) const;
+    void write_gdb_register( size_t regno, uint64 value, size_t thread);
+    uint64 read_register( Register index, size_t thread = 0) const { return narrow_cast<uint64>( rfs.at( thread).read( index)); }
+    void write_register( Register index, uint64 value, size_t thread = 0) { rfs.at( thread).write( index, narrow_cast<RegisterUInt>( value)); }
+};
+
+// Simulator interface of a hardware thread, the core is run and configured as a whole
+template <typename ISA>
+class HardwareThread final : public Simulator
+{
+public:
+    using Register = typename ISA::Register;
+    using RegisterUInt = typename ISA::RegisterUInt;
+    HardwareThread( OOOPerfSim<ISA>* core, size_t index) : Simulator( core->get_isa()), core( core), index( index) { }
+
+    Trap run( uint64 instrs_to_run) final { return core->run( instrs_to_run); }
+    void set_target( const Target& target) final { core->set_thread_target( target, index); }
+    void set_memory( std::shared_ptr<FuncMemory> memory) final { core->set_thread_memory( memory, index); }
+    void set_kernel( std::shared_ptr<Kernel> k) final { core->set_thread_kernel( k, index); }
+    void disable_checker() final { core->writeback.disable_checker( index); }
+    void enable_driver_hooks() final { core->writeback.enable_driver_hooks( index); }
+    int get_exit_code() const noexcept final { return core->writeback.get_exit_code( index); }
+
+    size_t sizeof_register() const final { return bytewidth<RegisterUInt>; }
+    size_t max_cpu_register() const final { return Register::MAX_REG; }
+
+    Addr get_pc() const final { return core->writeback.get_next_PC( index); }
+
+    uint64 read_cpu_register( size_t regno) const final { return core->read_register( Register::from_cpu_index( regno), index); }
+    uint64 read_gdb_register( size_t regno) const final { return core->read_gdb_register( regno, index); }
+    uint64 read_csr_register( std::string_view reg_name) const final { return core->read_register( Register::from_csr_name( reg_name), index); }
+
+    void write_cpu_register( size_t regno, uint64 value) final { core->write_register( Register::from_cpu_index( regno), value, index); }
+    void write_gdb_register( size_t regno, uint64 value) final { core->write_gdb_register( regno, value, index); }
+    void write_csr_register( std::string_view reg_name, uint64 value) final { core->write_register( Register::from_csr_name( reg_name), value, index); }
+
+private:
+    OOOPerfSim<ISA>* const core;
+    const size_t index;
+};
+
+#endif
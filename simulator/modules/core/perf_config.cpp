@@ -0,0 +1,186 @@
+/*
+ * perf_config.cpp - configuration of performance simulator instance
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include "perf_config.h"
+
+#include <infra/config/config.h>
+
+namespace config {
+    /* Command line defaults are the values of default-constructed configuration */
+    static const PerfConfig defaults;
+
+    /* Pipeline parameters */
+    static const PredicatedValue<uint32> pipeline_width = { "pipeline-width", defaults.pipeline.width, "Number of instructions fetched, decoded, executed and written back per cycle",
+                                                [](uint32 val) { return val >= 1 && val <= 16; } };
+    static const PredicatedValue<uint32> mem_ports = { "mem-ports", defaults.pipeline.mem_ports, "Number of memory instructions issued per cycle",
+                                                [](uint32 val) { return val >= 1; } };
+    /* Out-of-order core parameters */
+    static const Switch out_of_order = { "out-of-order", "model out-of-order core instead of in-order pipeline"};
+    static const PredicatedValue<uint32> rob_size = { "rob-size", defaults.ooo.rob_size, "Number of reorder buffer entries of out-of-order core",
+                                                [](uint32 val) { return val >= 1; } };
+    static const PredicatedValue<uint32> rename_registers = { "rename-registers", defaults.ooo.rename_registers, "Number of physical registers in addition to architectural ones",
+                                                [](uint32 val) { return val >= 2; } };
+    static const Value<std::string> iq_mode = { "iq-mode", defaults.ooo.iq_mode, "Issue queues of out-of-order core: unified or distributed (one per execution unit)"};
+    static const PredicatedValue<uint32> iq_size = { "iq-size", defaults.ooo.iq_size, "Number of entries of each issue queue",
+                                                [](uint32 val) { return val >= 1; } };
+    static const PredicatedValue<uint32> lsq_size = { "lsq-size", defaults.ooo.lsq_size, "Number of load-store queue entries",
+                                                [](uint32 val) { return val >= 1; } };
+    static const PredicatedValue<uint32> store_buffer_size = { "store-buffer-size", defaults.ooo.store_buffer_size, "Number of committed stores waiting for data cache",
+                                                [](uint32 val) { return val >= 1; } };
+    static const Value<std::string> memory_dependence = { "memory-dependence", defaults.ooo.memory_dependence, "Speculation of loads over older stores: conservative, aggressive or store-sets"};
+    static const PredicatedValue<uint32> ssit_size = { "ssit-size", defaults.ooo.ssit_size, "Number of store set identifier table entries",
+                                                [](uint32 val) { return val >= 1; } };
+    static const PredicatedValue<uint32> lfst_size = { "lfst-size", defaults.ooo.lfst_size, "Number of last fetched store table entries",
+                                                [](uint32 val) { return val >= 1; } };
+    /* Simultaneous multithreading parameters */
+    static const PredicatedValue<uint32> smt_threads = { "smt-threads", defaults.smt.threads, "Number of hardware threads of out-of-order core",
+                                                [](uint32 val) { return val >= 1 && val <= 16; } };
+    static const Value<std::string> smt_fetch_policy = { "smt-fetch-policy", defaults.smt.fetch_policy, "Hardware thread fetched in each cycle: round-robin or icount"};
+    /* Branch prediction parameters */
+    static const Value<std::string> bp_mode = { "bp-mode", defaults.bp.mode, "branch prediction mode"};
+    static const Value<std::string> bp_lru = { "bp-lru", defaults.bp.lru, "branch prediction replacement policy"};
+    static const Value<uint32> bp_size = { "bp-size", defaults.bp.size, "BTB size in entries"};
+    static const Value<uint32> bp_ways = { "bp-ways", defaults.bp.ways, "number of ways in BTB"};
+    static const Value<uint32> bp_global_history = { "bp-global-history", defaults.bp.global_history, "global history length of gshare and perceptron predictors (in branches)"};
+    static const Value<uint32> bp_table_size = { "bp-table-size", defaults.bp.table_size, "number of entries in each table of global history predictors"};
+    static const Value<uint32> bp_tage_tables = { "bp-tage-tables", defaults.bp.tage_tables, "number of tagged tables of TAGE predictor"};
+    static const Value<uint32> bp_tage_min_history = { "bp-tage-min-history", defaults.bp.tage_min_history, "history length of the shortest TAGE table (in branches)"};
+    static const Value<uint32> bp_tage_max_history = { "bp-tage-max-history", defaults.bp.tage_max_history, "history length of the longest TAGE table (in branches)"};
+    static const Value<uint32> bp_tage_tag_bits = { "bp-tage-tag-bits", defaults.bp.tage_tag_bits, "tag width of TAGE tables"};
+    static const Value<uint32> bp_ras_size = { "bp-ras-size", defaults.bp.ras_size, "number of entries in return address stack, 0 disables it"};
+    static const Value<std::string> bp_indirect_mode = { "bp-indirect-mode", defaults.bp.indirect_mode, "indirect jump target prediction: btb or ittage (uses TAGE geometry)"};
+    /* Cache parameters */
+    static const Value<std::string> instruction_cache_type = { "icache-type", defaults.icache.type, "Type of instruction level 1 cache (in bytes)"};
+    static const Value<uint32> instruction_cache_size = { "icache-size", defaults.icache.size, "Size of instruction level 1 cache (in bytes)"};
+    static const Value<uint32> instruction_cache_ways = { "icache-ways", defaults.icache.ways, "Amount of ways in instruction level 1 cache"};
+    static const Value<uint32> instruction_cache_line_size = { "icache-line-size", defaults.icache.line_size, "Line size of instruction level 1 cache (in bytes)"};
+    static const Value<std::string> data_cache_type = { "dcache-type", defaults.dcache.type, "Type of data level 1 cache"};
+    static const Value<uint32> data_cache_size = { "dcache-size", defaults.dcache.size, "Size of data level 1 cache (in bytes)"};
+    static const Value<uint32> data_cache_ways = { "dcache-ways", defaults.dcache.ways, "Amount of ways in data level 1 cache"};
+    static const Value<uint32> data_cache_line_size = { "dcache-line-size", defaults.dcache.line_size, "Line size of data level 1 cache (in bytes)"};
+    static const PredicatedValue<uint64> data_cache_hit_latency = { "dcache-hit-latency", defaults.dcache_timing.hit_latency, "Latency of data level 1 cache hit (in cycles)",
+                                                [](uint64 val) { return val >= 1; } };
+    static const Value<uint64> data_cache_miss_latency = { "dcache-miss-latency", defaults.dcache_timing.miss_latency, "Latency of data level 1 cache miss, or of memory beyond the last cache level if L2 is enabled and DRAM is not (in cycles)"};
+    static const PredicatedValue<uint32> data_cache_mshrs = { "dcache-mshrs", defaults.dcache_timing.mshrs, "Number of miss status holding registers of data level 1 cache",
+                                                [](uint32 val) { return val >= 1; } };
+    static const Value<std::string> data_cache_write_policy = { "dcache-write-policy", defaults.dcache_timing.write_policy, "Write policy of data level 1 cache: write-back or write-through"};
+    /* Lower memory levels */
+    static const Value<std::string> l2_type = { "l2-type", defaults.memory.l2.type, "Type of unified level 2 cache"};
+    static const Value<uint32> l2_size = { "l2-size", defaults.memory.l2.size, "Size of unified level 2 cache (in bytes), 0 disables it"};
+    static const Value<uint32> l2_ways = { "l2-ways", defaults.memory.l2.ways, "Amount of ways in unified level 2 cache"};
+    static const Value<uint32> l2_line_size = { "l2-line-size", defaults.memory.l2.line_size, "Line size of unified level 2 cache (in bytes)"};
+    static const Value<uint64> l2_latency = { "l2-latency", defaults.memory.l2_latency, "Latency of unified level 2 cache (in cycles)"};
+    static const Value<std::string> l3_type = { "l3-type", defaults.memory.l3.type, "Type of unified level 3 cache"};
+    static const Value<uint32> l3_size = { "l3-size", defaults.memory.l3.size, "Size of unified level 3 cache (in bytes), 0 disables it"};
+    static const Value<uint32> l3_ways = { "l3-ways", defaults.memory.l3.ways, "Amount of ways in unified level 3 cache"};
+    static const Value<uint32> l3_line_size = { "l3-line-size", defaults.memory.l3.line_size, "Line size of unified level 3 cache (in bytes)"};
+    static const Value<uint64> l3_latency = { "l3-latency", defaults.memory.l3_latency, "Latency of unified level 3 cache (in cycles)"};
+    static const Value<uint32> dram_banks = { "dram-banks", defaults.memory.dram.banks, "Number of DRAM banks, 0 disables DRAM model"};
+    static const Value<uint32> dram_row_size = { "dram-row-size", defaults.memory.dram.row_size, "Size of DRAM row (in bytes)"};
+    static const Value<uint64> dram_row_hit_latency = { "dram-row-hit-latency", defaults.memory.dram.row_hit_latency, "Latency of access to the open DRAM row (in cycles)"};
+    static const Value<uint64> dram_row_empty_latency = { "dram-row-empty-latency", defaults.memory.dram.row_empty_latency, "Latency of access to DRAM bank without open row (in cycles)"};
+    static const Value<uint64> dram_row_conflict_latency = { "dram-row-conflict-latency", defaults.memory.dram.row_conflict_latency, "Latency of access which closes other DRAM row (in cycles)"};
+    static const Value<uint64> dram_burst_cycles = { "dram-burst-cycles", defaults.memory.dram.burst_cycles, "Cycles of DRAM data bus occupied by a line transfer"};
+    /* Coherence parameters */
+    static const Switch coherence = { "coherence", "model MESI coherence of private data caches in multi-core runs"};
+    static const Value<uint64> directory_latency = { "directory-latency", defaults.coherence.directory_latency, "Latency of MESI directory lookup (in cycles)"};
+    static const Value<uint64> cache_to_cache_latency = { "cache-to-cache-latency", defaults.coherence.cache_to_cache_latency, "Latency of line transfer between data caches (in cycles)"};
+    static const Value<uint64> invalidation_latency = { "invalidation-latency", defaults.coherence.invalidation_latency, "Latency of invalidation of line copies in other data caches (in cycles)"};
+    /* Prefetch parameters */
+    static const Value<uint32> fetchahead_distance = { "fetchahead-size", defaults.prefetch.fetchahead_distance, "Fetchahead distance size"};
+    static const Value<std::string> prefetch_method = { "prefetch-method", defaults.prefetch.method, "Type of a Instruction prefetching method"};
+    static const Value<uint32> ftq_size = { "ftq-size", defaults.prefetch.ftq_size, "Number of fetch blocks in fetch target queue of fetch-directed prefetcher"};
+    static const Value<std::string> data_prefetch_method = { "data-prefetch-method", defaults.data_prefetch.method, "Type of level 1 data cache prefetcher"};
+    static const Value<uint32> data_prefetch_degree = { "data-prefetch-degree", defaults.data_prefetch.degree, "Number of lines requested by data prefetcher at once"};
+    static const Value<uint32> data_prefetch_table_size = { "data-prefetch-table-size", defaults.data_prefetch.table_size, "Number of entries in PC-indexed table of stride prefetcher"};
+    static const Value<uint32> data_prefetch_streams = { "data-prefetch-streams", defaults.data_prefetch.streams, "Number of streams tracked by stream prefetcher"};
+    static const Value<uint32> data_prefetch_queue_size = { "data-prefetch-queue-size", defaults.data_prefetch.queue_size, "Number of data prefetches waiting for free MSHR, the oldest ones are dropped"};
+    /* Execution parameters */
+    static const PredicatedValue<uint64> long_alu_latency = { "long-alu-latency", defaults.long_alu_latency, "Latency of long arithmetic logic unit",
+                                                [](uint64 val) { return val >= 2 && val < 64; } };
+    /* Oracle parameters */
+    static const Switch oracle_bp = { "oracle-bp", "perfect branch prediction by functional simulation running ahead of fetch"};
+    static const Switch oracle_icache = { "oracle-icache", "instruction level 1 cache always hits"};
+    static const Switch oracle_dcache = { "oracle-dcache", "data level 1 cache always hits"};
+    static const Switch oracle_alu = { "oracle-alu", "long arithmetic takes one cycle and never stalls dependent instructions"};
+    /* Debug parameters */
+    static const AliasedValue<std::string> units_to_log = { "l", "logs", defaults.units_to_log, "print logs for modules"};
+    static const Switch topology_dump = { "tdump", "module topology dump into topology.json" };
+    static const Switch cpi_stack_dump = { "cpidump", "CPI stack dump into cpi_stack.json" };
+} // namespace config
+
+PerfConfig PerfConfig::create_configured()
+{
+    PerfConfig c;
+    c.pipeline.width = config::pipeline_width;
+    c.pipeline.mem_ports = config::mem_ports;
+    c.ooo.enabled = config::out_of_order;
+    c.ooo.rob_size = config::rob_size;
+    c.ooo.rename_registers = config::rename_registers;
+    c.ooo.iq_mode = config::iq_mode;
+    c.ooo.iq_size = config::iq_size;
+    c.ooo.lsq_size = config::lsq_size;
+    c.ooo.store_buffer_size = config::store_buffer_size;
+    c.ooo.memory_dependence = config::memory_dependence;
+    c.ooo.ssit_size = config::ssit_size;
+    c.ooo.lfst_size = config::lfst_size;
+    c.smt.threads = config::smt_threads;
+    c.smt.fetch_policy = config::smt_fetch_policy;
+    c.bp.mode = config::bp_mode;
+    c.bp.lru = config::bp_lru;
+    c.bp.size = config::bp_size;
+    c.bp.ways = config::bp_ways;
+    c.bp.global_history = config::bp_global_history;
+    c.bp.table_size = config::bp_table_size;
+    c.bp.tage_tables = config::bp_tage_tables;
+    c.bp.tage_min_history = config::bp_tage_min_history;
+    c.bp.tage_max_history = config::bp_tage_max_history;
+    c.bp.tage_tag_bits = config::bp_tage_tag_bits;
+    c.bp.ras_size = config::bp_ras_size;
+    c.bp.indirect_mode = config::bp_indirect_mode;
+    c.icache.type = config::instruction_cache_type;
+    c.icache.size = config::instruction_cache_size;
+    c.icache.ways = config::instruction_cache_ways;
+    c.icache.line_size = config::instruction_cache_line_size;
+    c.dcache.type = config::data_cache_type;
+    c.dcache.size = config::data_cache_size;
+    c.dcache.ways = config::data_cache_ways;
+    c.dcache.line_size = config::data_cache_line_size;
+    c.dcache_timing.hit_latency = config::data_cache_hit_latency;
+    c.dcache_timing.miss_latency = config::data_cache_miss_latency;
+    c.dcache_timing.mshrs = config::data_cache_mshrs;
+    c.dcache_timing.write_policy = config::data_cache_write_policy;
+    c.memory.l2 = { config::l2_type, config::l2_size, config::l2_ways, config::l2_line_size };
+    c.memory.l2_latency = config::l2_latency;
+    c.memory.l3 = { config::l3_type, config::l3_size, config::l3_ways, config::l3_line_size };
+    c.memory.l3_latency = config::l3_latency;
+    c.memory.dram.banks = config::dram_banks;
+    c.memory.dram.row_size = config::dram_row_size;
+    c.memory.dram.row_hit_latency = config::dram_row_hit_latency;
+    c.memory.dram.row_empty_latency = config::dram_row_empty_latency;
+    c.memory.dram.row_conflict_latency = config::dram_row_conflict_latency;
+    c.memory.dram.burst_cycles = config::dram_burst_cycles;
+    c.coherence.enabled = config::coherence;
+    c.coherence.directory_latency = config::directory_latency;
+    c.coherence.cache_to_cache_latency = config::cache_to_cache_latency;
+    c.coherence.invalidation_latency = config::invalidation_latency;
+    c.prefetch.fetchahead_distance = config::fetchahead_distance;
+    c.prefetch.method = config::prefetch_method;
+    c.prefetch.ftq_size = config::ftq_size;
+    c.data_prefetch.method = config::data_prefetch_method;
+    c.data_prefetch.degree = config::data_prefetch_degree;
+    c.data_prefetch.table_size = config::data_prefetch_table_size;
+    c.data_prefetch.streams = config::data_prefetch_streams;
+    c.data_prefetch.queue_size = config::data_prefetch_queue_size;
+    c.long_alu_latency = config::long_alu_latency;
+    c.oracle.bp = config::oracle_bp;
+    c.oracle.icache = config::oracle_icache;
+    c.oracle.dcache = config::oracle_dcache;
+    c.oracle.alu = config::oracle_alu;
+    c.units_to_log = config::units_to_log;
+    c.topology_dump = config::topology_dump;
+    c.cpi_stack_dump = config::cpi_stack_dump;
+    return c;
+}
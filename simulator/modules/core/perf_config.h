@@ -0,0 +1,151 @@
+/*
+ * perf_config.h - configuration of performance simulator instance
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef PERF_CONFIG_H
+#define PERF_CONFIG_H
+
+#include <infra/types.h>
+
+#include <string>
+
+/*
+ * All tunables of a single performance simulator instance,
+ * so several differently configured simulators can live in one process.
+ * Default-constructed object provides the defaults of command line options.
+ */
+struct PerfConfig
+{
+    // Superscalar in-order pipeline
+    struct Pipeline {
+        uint32 width = 1;           // instructions fetched, decoded, executed and written back per cycle
+        uint32 mem_ports = 1;       // memory instructions issued per cycle
+    };
+
+    // Out-of-order core replaces decode, execute, memory and branch stages of the pipeline
+    struct OutOfOrder {
+        bool enabled = false;
+        uint32 rob_size = 64;               // reorder buffer entries
+        uint32 rename_registers = 64;       // physical registers in addition to architectural ones
+        std::string iq_mode = "unified";    // single issue queue, or "distributed" with a queue per execution unit
+        uint32 iq_size = 32;                // entries of each issue queue
+        uint32 lsq_size = 32;               // loads and stores between dispatch and commit
+        uint32 store_buffer_size = 8;       // committed stores waiting for data cache
+        // loads pass older stores with unknown addresses if predicted independent,
+        // never in "conservative" mode and always in "aggressive" mode
+        std::string memory_dependence = "store-sets";
+        uint32 ssit_size = 1024;            // store set identifier table, indexed by PC
+        uint32 lfst_size = 128;             // last fetched store table, indexed by store set
+    };
+
+    // Simultaneous multithreading: hardware threads share fetch, branch predictor,
+    // caches and out-of-order backend, but have their own register files
+    struct SMT {
+        uint32 threads = 1;
+        std::string fetch_policy = "round-robin"; // or "icount": thread with the fewest instructions in flight
+    };
+
+    struct BP {
+        std::string mode = "saturating_two_bits";
+        std::string lru = "pseudo-LRU";
+        uint32 size = 128;
+        uint32 ways = 16;
+        uint32 global_history = 16;     // history bits of gshare and perceptron
+        uint32 table_size = 4096;       // entries of each table of global history predictors
+        uint32 tage_tables = 4;         // tagged tables of TAGE
+        uint32 tage_min_history = 4;    // history lengths of tagged tables form a geometric series
+        uint32 tage_max_history = 64;
+        uint32 tage_tag_bits = 9;
+        uint32 ras_size = 0;            // return address stack entries, 0 disables it
+        std::string indirect_mode = "btb";  // ITTAGE uses the same geometry as TAGE
+    };
+
+    struct Cache {
+        std::string type = "LRU";
+        uint32 size = 2048;
+        uint32 ways = 4;
+        uint32 line_size = 64;
+    };
+
+    struct DataCacheTiming {
+        uint64 hit_latency = 1;
+        uint64 miss_latency = 30;
+        uint32 mshrs = 4;
+        std::string write_policy = "write-back";
+    };
+
+    struct Coherence {
+        bool enabled = false;
+        uint64 directory_latency = 10;
+        uint64 cache_to_cache_latency = 20;
+        uint64 invalidation_latency = 15;
+    };
+
+    struct DRAM {
+        uint32 banks = 0; // DRAM model is disabled
+        uint32 row_size = 2048;
+        uint64 row_hit_latency = 20;
+        uint64 row_empty_latency = 40;
+        uint64 row_conflict_latency = 60;
+        uint64 burst_cycles = 4;
+    };
+
+    // Levels with zero size are disabled
+    struct MemoryHierarchy {
+        Cache l2 = { "LRU", 0, 8, 64 };
+        uint64 l2_latency = 12;
+        Cache l3 = { "LRU", 0, 16, 64 };
+        uint64 l3_latency = 40;
+        DRAM dram;
+    };
+
+    struct Prefetch {
+        uint32 fetchahead_distance = 32;
+        std::string method = "wrong-path";
+        uint32 ftq_size = 8;        // fetch blocks predicted ahead by FDIP
+    };
+
+    struct DataPrefetch {
+        std::string method = "no-prefetch";
+        uint32 degree = 2;          // lines requested by one prediction
+        uint32 table_size = 64;     // entries of PC-indexed stride table
+        uint32 streams = 4;         // tracked streams of stream prefetcher
+        uint32 queue_size = 8;      // predictions waiting for a free MSHR
+    };
+
+    // Limit studies: a structure is made ideal while the rest is modelled in detail
+    struct Oracle {
+        bool bp = false;        // fetch follows the path of functional simulation running ahead
+        bool icache = false;    // instruction fetch always hits in level 1 cache
+        bool dcache = false;    // loads and stores always hit in level 1 data cache
+        bool alu = false;       // long arithmetic takes a cycle and does not stall consumers
+    };
+
+    Pipeline pipeline;
+    OutOfOrder ooo;
+    SMT smt;
+    BP bp;
+    Cache icache;
+    Cache dcache;
+    DataCacheTiming dcache_timing;
+    Coherence coherence;
+    MemoryHierarchy memory;
+    Prefetch prefetch;
+    DataPrefetch data_prefetch;
+    uint64 long_alu_latency = 3;
+    Oracle oracle;
+
+    std::string units_to_log = "nothing";
+    bool topology_dump = false;
+    bool cpi_stack_dump = false;
+
+    // Geometry of level 1 caches, oracle caches keep it only for line size
+    Cache get_icache() const { return oracle.icache ? Cache{ "always_hit", icache.size, icache.ways, icache.line_size} : icache; }
+    Cache get_dcache() const { return oracle.dcache ? Cache{ "always_hit", dcache.size, dcache.ways, dcache.line_size} : dcache; }
+
+    // Instance filled from command line arguments
+    static PerfConfig create_configured();
+};
+
+#endif // PERF_CONFIG_H
@@ -7,6 +7,7 @@
 #define PERF_INSTR_H
 
 #include <infra/types.h>
+#include <modules/decode/bypass/data_bypass_interface.h>
 #include <modules/fetch/bpu/bp_interface.h>
 
 #include <utility>
@@ -43,7 +44,18 @@ public:
     }
 
     BPInterface get_bp_upd() const {
-        return BPInterface( this->get_PC(), this->is_taken(), this->get_bp_upd_address(), true);
+        // Keep speculative state checkpointed by prediction
+        BPInterface bp_upd = bp_data;
+        bp_upd.pc = this->get_PC();
+        bp_upd.is_taken = this->is_taken();
+        bp_upd.target = this->get_bp_upd_address();
+        bp_upd.is_hit = true;
+        bp_upd.kind = { this->is_branch(), this->is_call(), this->is_return(), this->is_indirect_jump() };
+        return bp_upd;
+    }
+
+    auto get_bypassed_data() const {
+        return BypassedData<typename FuncInstr::RegisterUInt>{ this->get_sequence_id(), this->get_v_dst()};
     }
 
     bool is_bypassible() const { return !this->is_conditional_move() &&
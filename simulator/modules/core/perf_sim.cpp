@@ -8,20 +8,31 @@
 #include <memory/elf/elf_loader.h>
 
 #include <chrono>
+#include <fstream>
 #include <iostream>
 
-namespace config {
-    static const AliasedValue<std::string> units_to_log = { "l", "logs", "nothing", "print logs for modules"};
-    static const Switch topology_dump = { "tdump", "module topology dump into topology.json" };
-} // namespace config
-
 template <typename ISA>
-PerfSim<ISA>::PerfSim( std::endian endian, std::string_view isa)
+PerfSim<ISA>::PerfSim( std::endian endian, std::string_view isa, const PerfConfig& config)
     : CycleAccurateSimulator( isa)
     , endian( endian)
-    , fetch( this), decode( this), execute( this), mem( this), branch( this), writeback( this, endian)
+    , fetch( this, config), decode( this, config), execute( this, config), mem( this, config), branch( this), writeback( this, endian, config)
+    , width( config.pipeline.width)
+    , has_branch_oracle( config.oracle.bp)
+    , cpi_stack_dump( config.cpi_stack_dump)
 {
+    if ( config.smt.threads > 1)
+        throw InvalidSMTConfiguration( "hardware threads are hosted by out-of-order core");
+
     rp_halt = make_read_port<Trap>("WRITEBACK_2_CORE_HALT", Port::LATENCY);
+    rp_mem_stall = make_read_port<Latency>("MEMORY_2_CORE_STALL", Port::LATENCY);
+
+    rp_retired = make_read_port<InstructionOutput>("WRITEBACK_2_EXECUTE_BYPASS", Port::LATENCY);
+    rp_icache_miss = make_read_port<Target>("FETCH_2_CORE_ICACHE_MISS", Port::LATENCY);
+    rp_decode_flush_target = make_read_port<Target>("DECODE_2_FETCH_TARGET", Port::LATENCY);
+    rp_branch_flush_target = make_read_port<Target>("BRANCH_2_FETCH_TARGET", Port::LATENCY);
+    rp_trap_target = make_read_port<Target>("WRITEBACK_2_FETCH_TARGET", Port::LATENCY);
+    rp_data_hazard = make_read_port<bool>("DECODE_2_CORE_DATA_HAZARD", Port::LATENCY);
+    rp_long_alu_busy = make_read_port<bool>("EXECUTE_2_CORE_LONG_ALU_BUSY", Port::LATENCY);
 
     decode.set_RF( &rf);
     writeback.set_RF( &rf);
@@ -29,19 +40,42 @@ PerfSim<ISA>::PerfSim( std::endian endian, std::string_view isa)
 
     set_writeback_bandwidth( Port::BW);
 
+    if ( MemoryHierarchy::is_enabled( config))
+    {
+        memory_hierarchy = std::make_shared<MemoryHierarchy>( config);
+        fetch.set_memory_hierarchy( memory_hierarchy);
+        mem.set_memory_hierarchy( memory_hierarchy);
+        writeback.set_memory_hierarchy( memory_hierarchy);
+    }
+
     init_portmap();
-    enable_logging( config::units_to_log);
-    topology_dumping( config::topology_dump, "topology.json");
+    enable_logging( config.units_to_log);
+    topology_dumping( config.topology_dump, "topology.json");
 }
 
 template <typename ISA>
 void PerfSim<ISA>::set_memory( std::shared_ptr<FuncMemory> m)
 {
     memory = m;
+    set_instruction_memory( m);
+    mem.set_memory( m);
+}
+
+template <typename ISA>
+void PerfSim<ISA>::set_instruction_memory( std::shared_ptr<ReadableMemory> m)
+{
     auto imemory = std::make_unique<InstrMemoryCached<ISA>>( endian);
     imemory->set_memory( m);
     fetch.set_memory( std::move( imemory));
-    mem.set_memory( m);
+}
+
+template <typename ISA>
+void PerfSim<ISA>::set_kernel( std::shared_ptr<Kernel> k)
+{
+    if ( has_branch_oracle)
+        fetch.set_oracle( std::make_unique<FuncSimOracle<ISA>>( endian, k.get(), get_isa()));
+
+    writeback.set_kernel( k, get_isa());
 }
 
 template <typename ISA>
@@ -57,13 +91,19 @@ Addr PerfSim<ISA>::get_pc() const
 }
 
 template<typename ISA>
-Trap PerfSim<ISA>::run( uint64 instrs_to_run)
+void PerfSim<ISA>::start( uint64 instrs_to_run)
 {
     current_trap = Trap( Trap::NO_TRAP);
 
     writeback.set_instrs_to_run( instrs_to_run);
 
     start_time = std::chrono::high_resolution_clock::now();
+}
+
+template<typename ISA>
+Trap PerfSim<ISA>::run( uint64 instrs_to_run)
+{
+    start( instrs_to_run);
 
     while (current_trap == Trap::NO_TRAP)
         clock();
@@ -76,6 +116,17 @@ Trap PerfSim<ISA>::run( uint64 instrs_to_run)
 template<typename ISA>
 void PerfSim<ISA>::clock()
 {
+    if ( stall_left == 0_lt && rp_mem_stall->is_ready( curr_cycle))
+        stall_left = rp_mem_stall->read( curr_cycle);
+
+    if ( stall_left != 0_lt)
+    {
+        stall_left = stall_left - 1_lt;
+        ++stall_cycles;
+        cpi_stack.add( CPIStack::DCACHE_MISS);
+        return;
+    }
+
     clock_tree( curr_cycle);
     curr_cycle.inc();
 }
@@ -89,11 +140,42 @@ void PerfSim<ISA>::clock_tree( Cycle cycle)
     mem.clock( cycle);
     branch.clock( cycle);
     writeback.clock( cycle);
-    if ( rp_halt->is_ready( cycle))
+    update_cpi_stack( cycle);
+    /* only the youngest written back instruction may stop the core */
+    while ( rp_halt->is_ready( cycle))
         current_trap = rp_halt->read( cycle);
     sout << "******************\n";
 }
 
+template<typename ISA>
+void PerfSim<ISA>::update_cpi_stack( Cycle cycle)
+{
+    /* events are read in the next cycle, so the previous cycle is accounted */
+    while ( rp_retired->is_ready( cycle))
+        cpi_stack.retire( rp_retired->read( cycle).producer_id);
+
+    /* the oldest instruction redirects fetch last */
+    if ( rp_icache_miss->is_ready( cycle))
+        cpi_stack.delay( CPIStack::ICACHE_MISS, rp_icache_miss->read( cycle).sequence_id);
+
+    if ( rp_decode_flush_target->is_ready( cycle))
+        cpi_stack.delay( CPIStack::DECODE_MISPREDICTION, rp_decode_flush_target->read( cycle).sequence_id);
+
+    if ( rp_branch_flush_target->is_ready( cycle))
+        cpi_stack.delay( CPIStack::BRANCH_MISPREDICTION, rp_branch_flush_target->read( cycle).sequence_id);
+
+    while ( rp_trap_target->is_ready( cycle))
+        cpi_stack.delay( CPIStack::FLUSH, rp_trap_target->read( cycle).sequence_id);
+
+    if ( rp_data_hazard->is_ready( cycle) && rp_data_hazard->read( cycle))
+        cpi_stack.stall( CPIStack::DATA_HAZARD);
+
+    if ( rp_long_alu_busy->is_ready( cycle) && rp_long_alu_busy->read( cycle))
+        cpi_stack.stall( CPIStack::LONG_ALU);
+
+    cpi_stack.close_cycle();
+}
+
 auto get_rate( int total, float64 piece)
 {
     return total != 0 ? ( piece / total * 100) : 0;
@@ -105,23 +187,65 @@ void PerfSim<ISA>::dump_statistics() const
     auto executed_instrs = writeback.get_executed_instrs();
     auto now_time = std::chrono::high_resolution_clock::now();
     auto time = std::chrono::duration<double, std::milli>(now_time - start_time).count();
-    auto frequency = double{ curr_cycle} / time; // cycles per millisecond = kHz
-    auto ipc = 1.0 * executed_instrs / double{ curr_cycle};
+    auto cycles = get_total_cycles();
+    auto frequency = double{ cycles} / time; // cycles per millisecond = kHz
+    auto ipc = 1.0 * executed_instrs / double{ cycles};
     auto simips = executed_instrs / time;
     auto decode_mispredict_rate = 1.0 * get_rate( decode.get_jumps_num(), decode.get_mispredictions_num());
     auto branch_mispredict_rate = 1.0 * get_rate( branch.get_jumps_num(), branch.get_mispredictions_num());
-    
+    const auto jump_rate = []( const JumpStatistics& stats) { return 1.0 * get_rate( stats.jumps, stats.mispredictions); };
+    const auto& conditional = branch.get_conditional_statistics();
+    const auto& returns = branch.get_return_statistics();
+    const auto& indirect = branch.get_indirect_statistics();
+    const auto& dcache = mem.get_dcache_statistics();
+    auto load_miss_rate = dcache.loads != 0 ? 100.0 * double( dcache.load_misses) / double( dcache.loads) : 0;
+    auto store_miss_rate = dcache.stores != 0 ? 100.0 * double( dcache.store_misses) / double( dcache.stores) : 0;
+
     std::cout << std::endl << "****************************"
               << std::endl << "instrs:     " << executed_instrs
-              << std::endl << "cycles:     " << curr_cycle
+              << std::endl << "cycles:     " << cycles
               << std::endl << "IPC:        " << ipc
               << std::endl << "sim freq:   " << frequency << " kHz"
               << std::endl << "sim IPS:    " << simips    << " kips"
               << std::endl << "instr size: " << sizeof(Instr) << " bytes"
               << std::endl << "mispredict: detected on decode stage - " << decode_mispredict_rate << "%"
               << std::endl << "            detected on branch stage - " << branch_mispredict_rate << "%"
-              << std::endl << "****************************"
+              << std::endl << "            conditional - " << jump_rate( conditional) << "% of " << conditional.jumps
+              << ", returns - " << jump_rate( returns) << "% of " << returns.jumps
+              << ", indirect - " << jump_rate( indirect) << "% of " << indirect.jumps
+              << std::endl << "L1I misses: " << fetch.get_icache_misses() << ", prefetched lines - " << fetch.get_icache_prefetches()
+              << std::endl << "L1D misses: loads - " << load_miss_rate << "%, stores - " << store_miss_rate << "%"
+              << std::endl << "L1D MSHRs:  merged misses - " << dcache.mshr_merges << ", waits for free MSHR - " << dcache.mshr_full
+              << std::endl << "L1D stalls: " << stall_cycles << " cycles, writebacks - " << dcache.writebacks
               << std::endl;
+
+    cpi_stack.dump( std::cout, executed_instrs);
+
+    if ( width > 1)
+        std::cout << "fetched:    " << fetch.get_width_statistics() << std::endl
+                  << "issued:     " << decode.get_width_statistics() << std::endl
+                  << "retired:    " << writeback.get_width_statistics() << std::endl;
+
+    if ( dcache.prefetches != 0)
+    {
+        const auto rate = []( uint64 piece, uint64 total) { return total != 0 ? 100.0 * double( piece) / double( total) : 0; };
+        const auto demand_misses = dcache.load_misses + dcache.store_misses;
+        std::cout << "L1D prefetches: issued - " << dcache.prefetches << ", dropped - " << dcache.dropped_prefetches
+                  << ", accuracy - " << rate( dcache.useful_prefetches, dcache.prefetches)
+                  << "%, coverage - " << rate( dcache.useful_prefetches, dcache.useful_prefetches + demand_misses)
+                  << "%, late - " << rate( dcache.late_prefetches, dcache.useful_prefetches) << "%" << std::endl;
+    }
+
+    if ( memory_hierarchy != nullptr)
+        memory_hierarchy->dump_statistics( std::cout);
+
+    std::cout << "****************************" << std::endl;
+
+    if ( cpi_stack_dump)
+    {
+        std::ofstream json( "cpi_stack.json");
+        cpi_stack.dump_json( json, executed_instrs);
+    }
 }
 
 template <typename ISA>
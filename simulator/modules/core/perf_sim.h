@@ -6,6 +6,8 @@
 #ifndef PERF_SIM_H
 #define PERF_SIM_H
 
+#include "cpi_stack.h"
+#include "perf_config.h"
 #include "perf_instr.h"
 
 #include <modules/branch/branch.h>
@@ -25,13 +27,18 @@ class PerfSim : public CycleAccurateSimulator
 public:
     using Register = typename ISA::Register;
     using RegisterUInt = typename ISA::RegisterUInt;
-    explicit PerfSim( std::endian endian, std::string_view isa);
+    PerfSim( std::endian endian, std::string_view isa, const PerfConfig& config);
     Trap run( uint64 instrs_to_run) final;
     void set_target( const Target& target) final;
     void set_memory( std::shared_ptr<FuncMemory> memory) final;
-    void set_kernel( std::shared_ptr<Kernel> k) final { writeback.set_kernel( k, get_isa()); }
+    void set_instruction_memory( std::shared_ptr<ReadableMemory> memory) final;
+    void set_kernel( std::shared_ptr<Kernel> k) final;
     void disable_checker() final { writeback.disable_checker(); }
     void clock() final;
+    void start( uint64 instrs_to_run) final;
+    Trap get_trap() const final { return current_trap; }
+    void dump_statistics() const final;
+    void set_coherent_cache( std::shared_ptr<CoherentCache> cache) final { mem.set_coherent_cache( std::move( cache)); }
     void enable_driver_hooks() final { writeback.enable_driver_hooks(); }
     void set_writeback_bandwidth( uint32 wb_bandwidth) { decode.set_wb_bandwidth( wb_bandwidth);}
     int get_exit_code() const noexcept final { return writeback.get_exit_code(); }
@@ -58,6 +65,7 @@ public:
 private:
     using FuncInstr = typename ISA::FuncInstr;
     using Instr = PerfInstr<FuncInstr>;
+    using InstructionOutput = BypassedData<RegisterUInt>;
 
     Cycle curr_cycle = 0_cl;
     decltype( std::chrono::high_resolution_clock::now()) start_time = {};
@@ -73,12 +81,34 @@ private:
     Mem<FuncInstr> mem;
     Branch<FuncInstr> branch;
     Writeback<ISA> writeback;
+    const uint32 width;
+    const bool has_branch_oracle;
+
+    // Lower memory levels shared by instruction fetch and data accesses
+    std::shared_ptr<MemoryHierarchy> memory_hierarchy;
 
     /* ports */
     ReadPort<Trap>* rp_halt = nullptr;
+    ReadPort<Latency>* rp_mem_stall = nullptr;
+
+    // Events which explain cycles without retired instructions
+    ReadPort<InstructionOutput>* rp_retired = nullptr;
+    ReadPort<Target>* rp_icache_miss = nullptr;
+    ReadPort<Target>* rp_decode_flush_target = nullptr;
+    ReadPort<Target>* rp_branch_flush_target = nullptr;
+    ReadPort<Target>* rp_trap_target = nullptr;
+    ReadPort<bool>* rp_data_hazard = nullptr;
+    ReadPort<bool>* rp_long_alu_busy = nullptr;
+    CPIStack cpi_stack;
+    const bool cpi_stack_dump;
+
+    // Whole pipeline is frozen while data cache serves a miss
+    Latency stall_left = 0_lt;
+    uint64 stall_cycles = 0;
+    Cycle get_total_cycles() const { return curr_cycle + Latency( narrow_cast<int64>( stall_cycles)); }
 
     void clock_tree( Cycle cycle);
-    void dump_statistics() const;
+    void update_cpi_stack( Cycle cycle);
     Trap current_trap = Trap(Trap::NO_TRAP);
 
     uint64 read_register( Register index) const { return narrow_cast<uint64>( rf.read( index)); }
@@ -5,10 +5,20 @@
 
 #include <catch.hpp>
 
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
 #include <kernel/kernel.h>
+#include <modules/core/cpi_stack.h>
+#include <modules/core/multi_core_sim.h>
+#include <modules/core/ooo_perf_sim.h>
 #include <modules/core/perf_sim.h>
+#include <modules/core/width_histogram.h>
 #include <modules/writeback/writeback.h>
 
+#include <numeric>
+#include <sstream>
+
 static auto init( const std::string& isa)
 {
     // Just call a constructor
@@ -131,9 +141,9 @@ TEST_CASE( "Perf_Sim: Register size")
     CHECK( CycleAccurateSimulator::create_simulator( "mips64")->sizeof_register() == bytewidth<uint64>);
 }
 
-static auto create_mars_sim( const std::string& isa, const std::string& binary_name, std::istream& kernel_in, std::ostream& kernel_out, bool has_hooks)
+static auto create_mars_sim( const std::string& isa, const std::string& binary_name, std::istream& kernel_in, std::ostream& kernel_out, bool has_hooks, const PerfConfig& config)
 {
-    auto sim = CycleAccurateSimulator::create_simulator( isa);
+    auto sim = CycleAccurateSimulator::create_simulator( isa, config);
     auto mem = FuncMemory::create_default_hierarchied_memory();
     sim->set_memory( mem);
 
@@ -150,6 +160,11 @@ static auto create_mars_sim( const std::string& isa, const std::string& binary_n
     return sim;
 }
 
+static auto create_mars_sim( const std::string& isa, const std::string& binary_name, std::istream& kernel_in, std::ostream& kernel_out, bool has_hooks)
+{
+    return create_mars_sim( isa, binary_name, kernel_in, kernel_out, has_hooks, PerfConfig::create_configured());
+}
+
 TEST_CASE( "Torture_Test: Perf_Sim, MARS 32, Core Universal")
 {
     std::istream nullin( nullptr);
@@ -172,6 +187,440 @@ TEST_CASE( "Torture_Test: Perf_Sim, MARS 32, Core Universal hooked")
     CHECK( sim->get_exit_code() == 0);
 }
 
+TEST_CASE( "Perf_Sim: invalid configuration")
+{
+    PerfConfig bad_bp;
+    bad_bp.bp.mode = "saturating_three_bits";
+    CHECK_THROWS_AS( CycleAccurateSimulator::create_simulator( "mips32", bad_bp), BPInvalidMode);
+
+    PerfConfig bad_prefetch;
+    bad_prefetch.prefetch.method = "previous-line";
+    CHECK_THROWS_AS( CycleAccurateSimulator::create_simulator( "mips32", bad_prefetch), PrefetchMethodException);
+
+    PerfConfig bad_data_prefetch;
+    bad_data_prefetch.data_prefetch.method = "previous-line";
+    CHECK_THROWS_AS( CycleAccurateSimulator::create_simulator( "mips32", bad_data_prefetch), InvalidDataPrefetcher);
+
+    PerfConfig bad_write_policy;
+    bad_write_policy.dcache_timing.write_policy = "write-around";
+    CHECK_THROWS_AS( CycleAccurateSimulator::create_simulator( "mips32", bad_write_policy), InvalidDataCacheConfiguration);
+}
+
+TEST_CASE( "Torture_Test: Perf_Sim, MARS 32, differently configured instances")
+{
+    PerfConfig small;
+    small.bp.mode = "always_not_taken";
+    small.icache.size = 256;
+    small.icache.ways = 2;
+    small.icache.line_size = 32;
+    small.prefetch.method = "next-line";
+    small.long_alu_latency = 10;
+    small.dcache.size = 256;
+    small.dcache.ways = 2;
+    small.dcache.line_size = 32;
+    small.dcache_timing.hit_latency = 2;
+    small.dcache_timing.miss_latency = 50;
+    small.dcache_timing.mshrs = 1;
+    small.dcache_timing.write_policy = "write-through";
+    small.data_prefetch.method = "stride";
+
+    std::istream nullin( nullptr);
+    std::ostream nullout( nullptr);
+    auto sim_default = create_mars_sim( "mars", TEST_PATH "/mips/mips-tt-no-delayed-branches.bin", nullin, nullout, false, PerfConfig());
+    auto sim_small = create_mars_sim( "mars", TEST_PATH "/mips/mips-tt-no-delayed-branches.bin", nullin, nullout, false, small);
+
+    CHECK( run_silent( sim_default) == Trap::HALT);
+    CHECK( run_silent( sim_small) == Trap::HALT);
+    CHECK( sim_default->get_exit_code() == 0);
+    CHECK( sim_small->get_exit_code() == 0);
+}
+
+TEST_CASE( "Torture_Test: Perf_Sim, MARS 32, fetch-directed prefetch")
+{
+    // Deep fetch target queue makes traps arrive during instruction cache misses
+    PerfConfig fdip;
+    fdip.prefetch.method = "fdip";
+    fdip.prefetch.ftq_size = 16;
+
+    std::istream nullin( nullptr);
+    std::ostream nullout( nullptr);
+    auto sim = create_mars_sim( "mars", TEST_PATH "/mips/mips-tt-no-delayed-branches.bin", nullin, nullout, false, fdip);
+    CHECK( run_silent( sim) == Trap::HALT);
+    CHECK( sim->get_exit_code() == 0);
+}
+
+TEST_CASE( "Torture_Test: Perf_Sim, MARS 32, global history predictors")
+{
+    for ( const auto& mode : { "gshare", "tage", "perceptron"}) {
+        PerfConfig config;
+        config.bp.mode = mode;
+
+        std::istream nullin( nullptr);
+        std::ostream nullout( nullptr);
+        auto sim = create_mars_sim( "mars", TEST_PATH "/mips/mips-tt-no-delayed-branches.bin", nullin, nullout, false, config);
+        CHECK( run_silent( sim) == Trap::HALT);
+        CHECK( sim->get_exit_code() == 0);
+    }
+}
+
+TEST_CASE( "Torture_Test: Perf_Sim, MARS 32, return address stack and ITTAGE")
+{
+    PerfConfig config;
+    config.bp.mode = "tage";
+    config.bp.ras_size = 16;
+    config.bp.indirect_mode = "ittage";
+
+    std::istream nullin( nullptr);
+    std::ostream nullout( nullptr);
+    auto sim = create_mars_sim( "mars", TEST_PATH "/mips/mips-tt-no-delayed-branches.bin", nullin, nullout, false, config);
+    CHECK( run_silent( sim) == Trap::HALT);
+    CHECK( sim->get_exit_code() == 0);
+}
+
+TEST_CASE( "Torture_Test: Perf_Sim, MARS 32, superscalar pipeline")
+{
+    for ( uint32 width = 2; width <= 4; ++width) {
+        PerfConfig config;
+        config.pipeline.width = width;
+        config.pipeline.mem_ports = width / 2;
+
+        std::istream nullin( nullptr);
+        std::ostream nullout( nullptr);
+        auto sim = create_mars_sim( "mars", TEST_PATH "/mips/mips-tt-no-delayed-branches.bin", nullin, nullout, false, config);
+        CHECK( run_silent( sim) == Trap::HALT);
+        CHECK( sim->get_exit_code() == 0);
+    }
+}
+
+TEST_CASE( "Torture_Test: Perf_Sim, MARS 32, out-of-order core")
+{
+    PerfConfig scalar;
+    scalar.ooo.enabled = true;
+
+    PerfConfig distributed;
+    distributed.ooo.enabled = true;
+    distributed.ooo.iq_mode = "distributed";
+    distributed.pipeline.width = 4;
+    distributed.pipeline.mem_ports = 2;
+
+    // small structures stall dispatch all the time
+    PerfConfig small;
+    small.ooo.enabled = true;
+    small.pipeline.width = 2;
+    small.ooo.rob_size = 4;
+    small.ooo.rename_registers = 2;
+    small.ooo.iq_size = 2;
+    small.ooo.lsq_size = 1;
+
+    PerfConfig conservative;
+    conservative.ooo.enabled = true;
+    conservative.ooo.memory_dependence = "conservative";
+
+    PerfConfig aggressive;
+    aggressive.ooo.enabled = true;
+    aggressive.ooo.memory_dependence = "aggressive";
+    aggressive.ooo.store_buffer_size = 1;
+
+    for ( const auto& config : { scalar, distributed, small, conservative, aggressive}) {
+        std::istream nullin( nullptr);
+        std::ostream nullout( nullptr);
+        auto sim = create_mars_sim( "mars", TEST_PATH "/mips/mips-tt-no-delayed-branches.bin", nullin, nullout, false, config);
+        CHECK( run_silent( sim) == Trap::HALT);
+        CHECK( sim->get_exit_code() == 0);
+    }
+}
+
+TEST_CASE( "Perf_Sim: out-of-order core configuration")
+{
+    PerfConfig config;
+    config.ooo.enabled = true;
+    config.ooo.iq_mode = "centralized";
+    CHECK_THROWS_AS( CycleAccurateSimulator::create_simulator( "mips32", config), InvalidOOOConfiguration);
+    config.ooo.iq_mode = "unified";
+    config.ooo.rob_size = 0;
+    CHECK_THROWS_AS( CycleAccurateSimulator::create_simulator( "mips32", config), InvalidOOOConfiguration);
+    config.ooo.rob_size = 64;
+    config.ooo.memory_dependence = "oracle";
+    CHECK_THROWS_AS( CycleAccurateSimulator::create_simulator( "mips32", config), InvalidOOOConfiguration);
+}
+
+// Hardware threads run their own copies of the program
+static void load_mars_thread( const std::shared_ptr<Simulator>& thread, const std::string& binary_name, std::istream& kernel_in, std::ostream& kernel_out)
+{
+    auto mem = FuncMemory::create_default_hierarchied_memory();
+    thread->set_memory( mem);
+
+    auto kernel = Kernel::create_kernel( true, kernel_in, kernel_out, std::cerr);
+    kernel->set_simulator( thread);
+    kernel->connect_memory( mem);
+    kernel->connect_exception_handler();
+    kernel->load_file( binary_name);
+    thread->set_kernel( kernel);
+    thread->set_pc( kernel->get_start_pc());
+}
+
+// Runs the simulator and returns the line of statistics which starts with the name
+static std::string run_for_statistics( const std::shared_ptr<Simulator>& sim, std::string_view name)
+{
+    std::ostringstream out;
+    {
+        OStreamWrapper cout_wrapper( std::cout, out);
+        CHECK( sim->run_no_limit() == Trap::HALT);
+    }
+
+    std::istringstream statistics( out.str());
+    std::string line;
+    while ( std::getline( statistics, line))
+        if ( line.starts_with( name))
+            return line;
+
+    return "";
+}
+
+static std::string run_for_cycles( const std::shared_ptr<Simulator>& sim)
+{
+    return run_for_statistics( sim, "cycles:");
+}
+
+// Parses "threads: <instrs> ... instrs" line of statistics
+static std::vector<uint64> get_executed_instrs( const std::string& line)
+{
+    std::istringstream in( line.substr( line.find( ':') + 1));
+    std::vector<uint64> result;
+    for ( uint64 value = 0; in >> value;)
+        result.push_back( value);
+
+    return result;
+}
+
+TEST_CASE( "Torture_Test: Perf_Sim, MARS 32, simultaneous multithreading")
+{
+    PerfConfig round_robin;
+    round_robin.ooo.enabled = true;
+    round_robin.smt.threads = 2;
+
+    PerfConfig icount;
+    icount.ooo.enabled = true;
+    icount.smt.threads = 4;
+    icount.smt.fetch_policy = "icount";
+    icount.pipeline.width = 4;
+    icount.pipeline.mem_ports = 2;
+
+    for ( const auto& config : { round_robin, icount}) {
+        std::istream nullin( nullptr);
+        std::ostream nullout( nullptr);
+        auto sim = create_mars_sim( "mars", TEST_PATH "/mips/mips-tt-no-delayed-branches.bin", nullin, nullout, false, config);
+        REQUIRE( sim->get_threads_num() == config.smt.threads);
+        for ( size_t i = 1; i < sim->get_threads_num(); ++i)
+            load_mars_thread( sim->get_thread( i), TEST_PATH "/mips/mips-tt-no-delayed-branches.bin", nullin, nullout);
+
+        const auto executed = get_executed_instrs( run_for_statistics( sim, "threads:"));
+        REQUIRE( executed.size() == sim->get_threads_num());
+        for ( size_t i = 0; i < sim->get_threads_num(); ++i) {
+            CHECK( sim->get_thread( i)->get_exit_code() == 0);
+            CHECK( executed[i] > 1000);
+        }
+    }
+}
+
+TEST_CASE( "Perf_Sim: trap of a hardware thread keeps instructions of other threads")
+{
+    PerfConfig config;
+    config.ooo.enabled = true;
+    config.smt.threads = 2;
+    config.pipeline.width = 4;
+    config.pipeline.mem_ports = 2;
+
+    // the first thread traps on system calls and address errors all the time
+    const std::vector<std::string> binaries = { TEST_PATH "/mips/mips-tt-no-delayed-branches.bin", TEST_PATH "/mips/mips-fib.bin" };
+    std::istream nullin( nullptr);
+    std::ostream nullout( nullptr);
+    auto sim = create_mars_sim( "mars", binaries[0], nullin, nullout, false, config);
+    load_mars_thread( sim->get_thread( 1), binaries[1], nullin, nullout);
+
+    const auto executed = get_executed_instrs( run_for_statistics( sim, "threads:"));
+    REQUIRE( executed.size() == 2);
+
+    // each thread is in the state of functional simulation after the same number of instructions
+    for ( size_t i = 0; i < 2; ++i) {
+        auto reference = Simulator::create_functional_simulator( "mars");
+        load_mars_thread( reference, binaries[i], nullin, nullout);
+        run_silent( reference, executed[i]);
+
+        const auto thread = sim->get_thread( i);
+        CHECK( thread->get_pc() == reference->get_pc());
+        for ( size_t reg = 0; reg < 32; ++reg)
+            CHECK( thread->read_cpu_register( reg) == reference->read_cpu_register( reg));
+    }
+}
+
+TEST_CASE( "Perf_Sim: idle hardware threads do not slow down the core")
+{
+    PerfConfig scalar;
+    scalar.ooo.enabled = true;
+    PerfConfig smt = scalar;
+    smt.smt.threads = 2;
+
+    std::istream nullin( nullptr);
+    std::ostream nullout( nullptr);
+    auto sim_scalar = create_mars_sim( "mars", TEST_PATH "/mips/mips-tt-no-delayed-branches.bin", nullin, nullout, false, scalar);
+    auto sim_smt = create_mars_sim( "mars", TEST_PATH "/mips/mips-tt-no-delayed-branches.bin", nullin, nullout, false, smt);
+    const auto cycles = run_for_cycles( sim_scalar);
+    CHECK( cycles.starts_with( "cycles:"));
+    CHECK( cycles == run_for_cycles( sim_smt));
+    CHECK( sim_smt->get_thread( 1)->get_pc() == 0);
+}
+
+TEST_CASE( "Perf_Sim: simultaneous multithreading configuration")
+{
+    PerfConfig in_order;
+    in_order.smt.threads = 2;
+    CHECK_THROWS_AS( CycleAccurateSimulator::create_simulator( "mips32", in_order), InvalidSMTConfiguration);
+
+    PerfConfig bad_policy;
+    bad_policy.ooo.enabled = true;
+    bad_policy.smt.fetch_policy = "random";
+    CHECK_THROWS_AS( CycleAccurateSimulator::create_simulator( "mips32", bad_policy), InvalidSMTConfiguration);
+
+    CHECK( Simulator::create_functional_simulator( "mips32")->get_threads_num() == 1);
+    CHECK( Simulator::create_functional_simulator( "mips32")->get_thread( 1) == nullptr);
+}
+
+static PerfConfig create_oracle_config( bool is_ooo)
+{
+    PerfConfig config;
+    config.ooo.enabled = is_ooo;
+    config.oracle.bp = true;
+    config.oracle.icache = true;
+    config.oracle.dcache = true;
+    config.oracle.alu = true;
+    return config;
+}
+
+TEST_CASE( "Torture_Test: Perf_Sim, MARS 32, oracle modes")
+{
+    PerfConfig smt = create_oracle_config( true);
+    smt.smt.threads = 2;
+
+    for ( const auto& config : { create_oracle_config( false), create_oracle_config( true), smt}) {
+        std::istream nullin( nullptr);
+        std::ostream nullout( nullptr);
+        auto sim = create_mars_sim( "mars", TEST_PATH "/mips/mips-tt-no-delayed-branches.bin", nullin, nullout, false, config);
+        for ( size_t i = 1; i < sim->get_threads_num(); ++i)
+            load_mars_thread( sim->get_thread( i), TEST_PATH "/mips/mips-tt-no-delayed-branches.bin", nullin, nullout);
+
+        CHECK( run_silent( sim) == Trap::HALT);
+        CHECK( sim->get_exit_code() == 0);
+    }
+}
+
+TEST_CASE( "Perf_Sim: oracle modes do not slow down the core")
+{
+    for ( const bool is_ooo : { false, true}) {
+        PerfConfig baseline;
+        baseline.ooo.enabled = is_ooo;
+
+        std::istream nullin( nullptr);
+        std::ostream nullout( nullptr);
+        auto sim_baseline = create_mars_sim( "mars", TEST_PATH "/mips/mips-tt-no-delayed-branches.bin", nullin, nullout, false, baseline);
+        auto sim_oracle = create_mars_sim( "mars", TEST_PATH "/mips/mips-tt-no-delayed-branches.bin", nullin, nullout, false, create_oracle_config( is_ooo));
+        const auto baseline_cycles = run_for_cycles( sim_baseline);
+        const auto oracle_cycles = run_for_cycles( sim_oracle);
+        REQUIRE( baseline_cycles.starts_with( "cycles:"));
+        REQUIRE( oracle_cycles.starts_with( "cycles:"));
+        CHECK( std::stoull( oracle_cycles.substr( 7)) < std::stoull( baseline_cycles.substr( 7)));
+    }
+}
+
+TEST_CASE( "Perf_Sim: width histogram")
+{
+    WidthHistogram histogram;
+    histogram.add( 0);
+    histogram.add( 2);
+    histogram.add( 2);
+    histogram.add( 1);
+    CHECK( histogram.get_cycles( 0) == 1);
+    CHECK( histogram.get_cycles( 2) == 2);
+    CHECK( histogram.get_cycles( 5) == 0);
+
+    std::ostringstream oss;
+    oss << histogram;
+    CHECK( oss.str() == "0 - 25%, 1 - 25%, 2 - 50%");
+}
+
+TEST_CASE( "Perf_Sim: CPI stack")
+{
+    CPIStack stack;
+    stack.retire( 0);
+    stack.close_cycle();
+
+    // the redirect delays instructions from 2, so the retirement of 1 does not clear it
+    stack.delay( CPIStack::BRANCH_MISPREDICTION, 2);
+    stack.retire( 1);
+    stack.close_cycle();
+    stack.close_cycle();
+    stack.stall( CPIStack::DATA_HAZARD);
+    stack.stall( CPIStack::LONG_ALU);
+    stack.close_cycle();
+    stack.retire( 2);
+    stack.close_cycle();
+    stack.close_cycle();
+    stack.add( CPIStack::DCACHE_MISS, 4);
+
+    CHECK( stack.get_cycles( CPIStack::BASE) == 3);
+    CHECK( stack.get_cycles( CPIStack::BRANCH_MISPREDICTION) == 1);
+    CHECK( stack.get_cycles( CPIStack::LONG_ALU) == 1);
+    CHECK( stack.get_cycles( CPIStack::DATA_HAZARD) == 0);
+    CHECK( stack.get_cycles( CPIStack::FRONTEND) == 1);
+    CHECK( stack.get_cycles( CPIStack::DCACHE_MISS) == 4);
+    CHECK( stack.get_total_cycles() == 10);
+
+    std::ostringstream text;
+    stack.dump( text, 3);
+    CHECK( text.str().starts_with( "CPI stack:  base - 1, long ALU - 0.333333"));
+
+    std::stringstream json;
+    stack.dump_json( json, 3);
+    boost::property_tree::ptree tree;
+    boost::property_tree::read_json( json, tree);
+    CHECK( tree.get<uint64>( "cycles") == 10);
+    CHECK( tree.get<uint64>( "components.dcache_miss.cycles") == 4);
+    CHECK( tree.get<double>( "components.base.cpi") == 1);
+}
+
+TEST_CASE( "Perf_Sim: CPI stack covers all cycles")
+{
+    PerfConfig config;
+    config.cpi_stack_dump = true;
+
+    std::istream nullin( nullptr);
+    std::ostream nullout( nullptr);
+    auto sim = create_mars_sim( "mars", TEST_PATH "/mips/mips-tt-no-delayed-branches.bin", nullin, nullout, false, config);
+    const auto cycles = run_for_cycles( sim);
+    REQUIRE( cycles.starts_with( "cycles:"));
+
+    boost::property_tree::ptree tree;
+    boost::property_tree::read_json( "cpi_stack.json", tree);
+    CHECK( tree.get<uint64>( "cycles") == std::stoull( cycles.substr( 7)));
+    CHECK( tree.get<uint64>( "components.base.cycles") == tree.get<uint64>( "instrs"));
+    CHECK( tree.get<uint64>( "components.branch_misprediction.cycles") != 0);
+    CHECK( tree.get<uint64>( "components.dcache_miss.cycles") != 0);
+}
+
+TEST_CASE( "Torture_Test: Perf_Sim, MARS 32, DRAM without prefetch")
+{
+    // Queued DRAM requests make instruction misses longer than the default deadlock timeout
+    PerfConfig dram;
+    dram.prefetch.method = "no-prefetch";
+    dram.memory.dram.banks = 8;
+
+    std::istream nullin( nullptr);
+    std::ostream nullout( nullptr);
+    auto sim = create_mars_sim( "mars", TEST_PATH "/mips/mips-tt-no-delayed-branches.bin", nullin, nullout, false, dram);
+    CHECK( run_silent( sim) == Trap::HALT);
+    CHECK( sim->get_exit_code() == 0);
+}
+
 TEST_CASE( "Perf_Sim: Run_SMC_Trace_WithChecker")
 {
     std::istream nullin( nullptr);
@@ -216,3 +665,164 @@ TEST_CASE( "Torture_Test: Perf_Sim, RISC-V 32 breakpoint")
     CHECK( sim->get_exit_code() == 0);
     CHECK( oss.str() == "  Interrupt 3  occurred\n  Exception 3  occurred\n");
 }
+
+// Each core increments a shared counter with ll/sc loop, counting failed attempts in $t3
+static void write_counter_program( const std::shared_ptr<FuncMemory>& mem, Addr pc, uint16 iterations)
+{
+    const std::vector<uint32> program = {
+        0x3c081001,               // lui   $t0, 0x1001
+        0x24090000U | iterations, // addiu $t1, $zero, iterations
+        0xc10a0000,               // ll    $t2, 0($t0)
+        0x254a0001,               // addiu $t2, $t2, 1
+        0xe10a0000,               // sc    $t2, 0($t0)
+        0x15400002,               // bne   $t2, $zero, 2
+        0x256b0001,               // addiu $t3, $t3, 1
+        0x1000fffa,               // beq   $zero, $zero, -6
+        0x2529ffff,               // addiu $t1, $t1, -1
+        0x1520fff8,               // bne   $t1, $zero, -8
+        0x2402000a,               // addiu $v0, $zero, 10
+        0x0000000c                // syscall
+    };
+    for ( size_t i = 0; i < program.size(); ++i)
+        mem->write<uint32, std::endian::little>( program[i], pc + i * 4);
+}
+
+static auto create_counter_cores( size_t cores_num, std::istream& kernel_in, std::ostream& kernel_out)
+{
+    std::vector<std::shared_ptr<CycleAccurateSimulator>> cores;
+    for ( size_t i = 0; i < cores_num; ++i)
+        cores.emplace_back( CycleAccurateSimulator::create_simulator( "mars"));
+
+    auto sim = std::make_unique<MultiCoreSim>( cores);
+    sim->set_memory( FuncMemory::create_default_hierarchied_memory());
+    for ( size_t i = 0; i < cores_num; ++i) {
+        auto kernel = Kernel::create_kernel( true, kernel_in, kernel_out, std::cerr);
+        kernel->set_simulator( cores[i]);
+        kernel->connect_memory( sim->get_memory( i));
+        kernel->connect_exception_handler();
+        cores[i]->set_kernel( kernel);
+    }
+
+    write_counter_program( sim->get_memory(), 0x400000, 100);
+    sim->set_pc( 0x400000);
+    return sim;
+}
+
+static auto get_sc_failures( const MultiCoreSim& sim)
+{
+    std::vector<uint64> result;
+    for ( size_t i = 0; i < sim.get_cores_num(); ++i)
+        result.emplace_back( sim.get_core( i)->read_cpu_register( 11));
+    return result;
+}
+
+TEST_CASE( "MultiCoreSim: no cores")
+{
+    CHECK_THROWS_AS( MultiCoreSim( {}), InvalidCoresNumber);
+}
+
+TEST_CASE( "MultiCoreSim: ll/sc counter, quantum")
+{
+    std::istream nullin( nullptr);
+    std::ostream nullout( nullptr);
+    OStreamWrapper cout_wrapper( std::cout, nullout);
+    auto sim = create_counter_cores( 4, nullin, nullout);
+    sim->set_quantum( 16);
+    CHECK( sim->run( MAX_VAL64) == Trap::HALT);
+    CHECK( sim->get_memory()->read<uint32, std::endian::little>( 0x10010000) == 400);
+}
+
+TEST_CASE( "MultiCoreSim: exact mode matches sequential simulation")
+{
+    std::istream nullin( nullptr);
+    std::ostream nullout( nullptr);
+    OStreamWrapper cout_wrapper( std::cout, nullout);
+    auto reference = create_counter_cores( 4, nullin, nullout);
+    CHECK( reference->run_sequentially( MAX_VAL64) == Trap::HALT);
+    CHECK( reference->get_memory()->read<uint32, std::endian::little>( 0x10010000) == 400);
+    auto failures = get_sc_failures( *reference);
+    CHECK( std::accumulate( failures.begin(), failures.end(), uint64{ 0}) > 0);
+
+    // Cores are clocked sequentially if they outnumber host threads, by own threads otherwise
+    for ( size_t host_threads : { 1, 4, 4, 4}) {
+        auto sim = create_counter_cores( 4, nullin, nullout);
+        sim->set_host_threads( host_threads);
+        CHECK( sim->run( MAX_VAL64) == Trap::HALT);
+        CHECK( sim->get_memory()->read<uint32, std::endian::little>( 0x10010000) == 400);
+        CHECK( get_sc_failures( *sim) == failures);
+    }
+}
+
+TEST_CASE( "MultiCoreSim: instructions budget")
+{
+    std::istream nullin( nullptr);
+    std::ostream nullout( nullptr);
+    OStreamWrapper cout_wrapper( std::cout, nullout);
+    auto sim = create_counter_cores( 2, nullin, nullout);
+    CHECK( sim->run( 10) == Trap::BREAKPOINT);
+}
+
+TEST_CASE( "MultiCoreSim: exit code of a failed secondary core")
+{
+    std::istream nullin( nullptr);
+    std::ostream nullout( nullptr);
+    std::vector<std::shared_ptr<CycleAccurateSimulator>> cores;
+    for ( size_t i = 0; i < 2; ++i)
+        cores.emplace_back( CycleAccurateSimulator::create_simulator( "mars"));
+
+    MultiCoreSim sim( cores);
+    sim.set_memory( FuncMemory::create_default_hierarchied_memory());
+    for ( size_t i = 0; i < cores.size(); ++i) {
+        auto kernel = Kernel::create_kernel( true, nullin, nullout, std::cerr);
+        kernel->set_simulator( cores[i]);
+        kernel->connect_memory( sim.get_memory( i));
+        kernel->connect_exception_handler();
+        cores[i]->set_kernel( kernel);
+    }
+
+    // The first core exits with 0, the second one with 3
+    const std::vector<uint32> program = {
+        0x2402000a,     // addiu $v0, $zero, 10
+        0x0000000c,     // syscall
+        0x24040003,     // addiu $a0, $zero, 3
+        0x24020011,     // addiu $v0, $zero, 17
+        0x0000000c      // syscall
+    };
+    for ( size_t i = 0; i < program.size(); ++i)
+        sim.get_memory()->write<uint32, std::endian::little>( program[i], 0x400000 + i * 4);
+    cores[0]->set_pc( 0x400000);
+    cores[1]->set_pc( 0x400008);
+
+    CHECK( sim.run( MAX_VAL64) == Trap::HALT);
+    CHECK( cores[0]->get_exit_code() == 0);
+    CHECK( sim.get_exit_code() == 3);
+}
+
+TEST_CASE( "MultiCoreSim: coherence traffic of shared counter")
+{
+    std::istream nullin( nullptr);
+    std::ostream nullout( nullptr);
+    OStreamWrapper cout_wrapper( std::cout, nullout);
+    auto reference = create_counter_cores( 2, nullin, nullout);
+    reference->enable_coherence( PerfConfig());
+    CHECK( reference->run_sequentially( MAX_VAL64) == Trap::HALT);
+
+    auto lines = reference->get_directory()->get_ping_pong_lines( 1);
+    REQUIRE( lines.size() == 1);
+    CHECK( lines.front().first == 0x10010000);
+    CHECK( reference->get_directory()->get_statistics( 0).invalidations_sent > 0);
+
+    auto sim = create_counter_cores( 2, nullin, nullout);
+    sim->enable_coherence( PerfConfig());
+    sim->set_host_threads( 2);
+    CHECK( sim->run( MAX_VAL64) == Trap::HALT);
+    CHECK( sim->get_memory()->read<uint32, std::endian::little>( 0x10010000) == 200);
+    for ( size_t i = 0; i < 2; ++i) {
+        auto expected = reference->get_directory()->get_statistics( i);
+        auto stats = sim->get_directory()->get_statistics( i);
+        CHECK( stats.loads == expected.loads);
+        CHECK( stats.stores == expected.stores);
+        CHECK( stats.misses == expected.misses);
+        CHECK( stats.ping_pongs == expected.ping_pongs);
+    }
+}
@@ -0,0 +1,45 @@
+/*
+ * width_histogram.h - utilization statistics of superscalar pipeline stages
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef WIDTH_HISTOGRAM_H
+#define WIDTH_HISTOGRAM_H
+
+#include <infra/types.h>
+
+#include <ostream>
+#include <vector>
+
+/* Numbers of cycles in which a stage has handled 0, 1, ..., N instructions */
+class WidthHistogram
+{
+public:
+    void add( size_t instrs)
+    {
+        if ( instrs >= cycles.size())
+            cycles.resize( instrs + 1);
+
+        ++cycles[ instrs];
+    }
+
+    uint64 get_cycles( size_t instrs) const { return instrs < cycles.size() ? cycles[ instrs] : 0; }
+
+    friend std::ostream& operator<<( std::ostream& out, const WidthHistogram& histogram)
+    {
+        uint64 total = 0;
+        for ( const auto value : histogram.cycles)
+            total += value;
+
+        for ( size_t i = 0; i < histogram.cycles.size(); ++i)
+            out << ( i != 0 ? ", " : "") << i << " - "
+                << ( total != 0 ? 100.0 * double( histogram.cycles[ i]) / double( total) : 0) << "%";
+
+        return out;
+    }
+
+private:
+    std::vector<uint64> cycles;
+};
+
+#endif // WIDTH_HISTOGRAM_H
@@ -12,8 +12,10 @@
 
 #include <modules/core/perf_instr.h>
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <vector>
 
 template <typename FuncInstr>
 class DataBypass
@@ -22,8 +24,10 @@ class DataBypass
     using Instr     = PerfInstr<FuncInstr>;
 
     public:
-        explicit DataBypass( uint64 long_alu_latency) noexcept
+        // ideal ALU executes long arithmetic in one cycle, as simple one
+        explicit DataBypass( uint64 long_alu_latency, bool is_ideal_alu = false) noexcept
             : long_alu_latency( long_alu_latency)
+            , is_ideal_alu( is_ideal_alu)
         { }
 
         // checks whether a source register of an instruction is in the RF
@@ -49,7 +53,8 @@ class DataBypass
                     ( !is_in_RF( instr, 1) && !is_bypassible( instr, 1)) ||
                     ( instruction_latency < writeback_stage_info.operation_latency &&
                       Latency( writeback_stage_info.writeback_bandwidth) < 
-                        writeback_stage_info.operation_latency)); 
+                        writeback_stage_info.operation_latency) ||
+                    is_group_hazard( instr));
         }
 
         // returns a bypass command for a source register of an instruction
@@ -57,7 +62,25 @@ class DataBypass
         auto get_bypass_command( const Instr& instr, size_t src_index) const noexcept
         {
             const auto reg_num = instr.get_src( src_index);
-            return BypassCommand<Register>( get_entry( reg_num).current_stage, long_alu_latency - 1_lt);
+            const auto& entry = get_entry( reg_num);
+            return BypassCommand<Register>( entry.current_stage, long_alu_latency - 1_lt, instr.get_sequence_id(), entry.producer_id);
+        }
+
+        // starts a group of instructions decoded in the same cycle
+        void start_group() noexcept
+        {
+            group_dsts.clear();
+            group_latency = 0_lt;
+        }
+
+        // adds a decoded instruction to the current group
+        void add_to_group( const Instr& instr)
+        {
+            for ( size_t i = 0; i < MAX_DST_NUM; ++i)
+                if ( !instr.get_dst( i).is_zero())
+                    group_dsts.push_back( instr.get_dst( i));
+
+            group_latency = std::max( group_latency, get_instruction_latency( instr));
         }
 
         // garners the information about a new instruction
@@ -76,20 +99,22 @@ class DataBypass
 
     private:
         const Latency long_alu_latency;
+        const bool is_ideal_alu;
 
         struct RegisterInfo
         {
             RegisterStage current_stage;
             RegisterStage ready_stage;
             RegisterStage next_stage_after_first_execution_stage;
+            uint64 producer_id = NO_VAL64;
             bool is_bypassible = false;
             bool is_traced = false;
 
             void reset() noexcept { *this = RegisterInfo(); }
 
-            void set_next_stage_after_first_execution_stage( const Instr& instr) noexcept
+            void set_next_stage_after_first_execution_stage( const Instr& instr, bool is_long_arithmetic) noexcept
             {
-                if ( instr.is_long_arithmetic())
+                if ( is_long_arithmetic)
                 {
                     next_stage_after_first_execution_stage.set_to_first_execution_stage();
                     next_stage_after_first_execution_stage.inc();
@@ -124,6 +149,23 @@ class DataBypass
         std::array<RegisterInfo, Register::MAX_REG> scoreboard = {};
         FuncUnitInfo writeback_stage_info = {};
 
+        /* Instructions of the same group execute in parallel */
+        std::vector<Register> group_dsts;
+        Latency group_latency = 0_lt;
+
+        // checks whether an instruction depends on the current group
+        // or would be written back before an older instruction of the group
+        bool is_group_hazard( const Instr& instr) const noexcept
+        {
+            const auto is_written_in_group = [this]( Register reg) {
+                return !reg.is_zero() && std::find( group_dsts.begin(), group_dsts.end(), reg) != group_dsts.end();
+            };
+
+            return is_written_in_group( instr.get_src( 0))
+                || is_written_in_group( instr.get_src( 1))
+                || get_instruction_latency( instr) < group_latency;
+        }
+
         RegisterInfo& get_entry( Register num) noexcept
         {
             auto idx = num.to_rf_index();
@@ -140,6 +182,11 @@ class DataBypass
             return scoreboard[ idx];
         }
 
+        bool is_long_arithmetic( const Instr& instr) const noexcept
+        {
+            return !is_ideal_alu && instr.is_long_arithmetic();
+        }
+
         // returns a latency of an instruction
         // in accordance with a type of the instruction
         Latency get_instruction_latency( const Instr& instr) const noexcept
@@ -147,7 +194,7 @@ class DataBypass
             if ( instr.is_mem_stage_required() || instr.is_branch_stage_required())
                 return 2_lt;
 
-            if ( instr.is_long_arithmetic())
+            if ( is_long_arithmetic( instr))
                 return long_alu_latency;
 
             return 1_lt;
@@ -166,10 +213,10 @@ void DataBypass<FuncInstr>::trace_new_dst_register( const Instr& instr, Register
     auto& entry = get_entry( num);
 
     entry.current_stage.set_to_first_execution_stage();
-    entry.set_next_stage_after_first_execution_stage( instr);
-
+    entry.set_next_stage_after_first_execution_stage( instr, is_long_arithmetic( instr));
+    entry.producer_id = instr.get_sequence_id();
 
-    if ( instr.is_long_arithmetic())
+    if ( is_long_arithmetic( instr))
     {
         entry.ready_stage.set_to_stage( long_alu_latency - 1_lt);
     }
@@ -200,7 +247,7 @@ void DataBypass<FuncInstr>::trace_new_dst2_register( const Instr& instr, Registe
     auto& entry = get_entry( num);
 
     entry.current_stage.set_to_first_execution_stage();
-    entry.set_next_stage_after_first_execution_stage( instr);
+    entry.set_next_stage_after_first_execution_stage( instr, is_long_arithmetic( instr));
 
     // values of registers used for the 2nd destination cannot be bypassed
     entry.ready_stage.set_to_in_RF();
@@ -8,10 +8,13 @@
 #ifndef DATA_BYPASS_INTERFACE_H
 #define DATA_BYPASS_INTERFACE_H
 
+#include <func_sim/operation.h>
 #include <infra/macro.h>
 #include <infra/ports/timing.h>
 #include <infra/types.h>
 
+#include <array>
+
 class RegisterStage
 {
 public:
@@ -77,15 +80,31 @@ private:
 };
 
 
+/*
+ * Several instructions may pass a bypassing stage in the same cycle,
+ * so the data is tagged with the sequence id of the producer
+ */
+template<typename T>
+struct BypassedData
+{
+    uint64 producer_id = NO_VAL64;
+    std::array<T, MAX_DST_NUM> value = {};
+};
+
 template<typename Register>
 class BypassCommand
 {
 public:
-    BypassCommand(RegisterStage bypassing_stage, Latency last_execution_stage) noexcept
+    BypassCommand(RegisterStage bypassing_stage, Latency last_execution_stage, uint64 consumer_id, uint64 producer_id) noexcept
         : bypassing_stage(bypassing_stage)
         , last_execution_stage(last_execution_stage)
+        , consumer_id(consumer_id)
+        , producer_id(producer_id)
     { }
 
+    auto get_consumer_id() const noexcept { return consumer_id; }
+    auto get_producer_id() const noexcept { return producer_id; }
+
     // returns an index of the port where bypassed data should be get from
     size_t get_bypass_direction() const noexcept
     {
@@ -97,6 +116,8 @@ public:
 private:
     const RegisterStage bypassing_stage;
     const Latency last_execution_stage;
+    const uint64 consumer_id;
+    const uint64 producer_id;
 };
 
 #endif // DATA_BYPASS_INTERFACE_H
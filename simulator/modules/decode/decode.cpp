@@ -8,9 +8,11 @@
 #include <modules/execute/execute.h>
 
 template <typename FuncInstr>
-Decode<FuncInstr>::Decode( Module* parent) : Module( parent, "decode")
+Decode<FuncInstr>::Decode( Module* parent, const PerfConfig& config) : Module( parent, "decode")
+    , width( config.pipeline.width)
+    , mem_ports( config.pipeline.mem_ports)
 {
-    bypassing_unit = std::make_unique<BypassingUnit>( config::long_alu_latency);
+    bypassing_unit = std::make_unique<BypassingUnit>( config.long_alu_latency, config.oracle.alu);
 
     rp_datapath = make_read_port<Instr>("FETCH_2_DECODE", Port::LATENCY);
     rp_stall_datapath = make_read_port<Instr>("DECODE_2_DECODE", Port::LATENCY);
@@ -20,24 +22,29 @@ Decode<FuncInstr>::Decode( Module* parent) : Module( parent, "decode")
     rp_flush_fetch = make_read_port<bool>("DECODE_2_FETCH_FLUSH", Port::LATENCY);
     rp_trap = make_read_port<bool>("WRITEBACK_2_ALL_FLUSH", Port::LATENCY);
 
-    wp_datapath = make_write_port<Instr>("DECODE_2_EXECUTE", Port::BW);
-    wp_stall_datapath = make_write_port<Instr>("DECODE_2_DECODE", Port::BW);
+    wp_datapath = make_write_port<Instr>("DECODE_2_EXECUTE", width);
+    wp_stall_datapath = make_write_port<Instr>("DECODE_2_DECODE", width);
     wp_stall = make_write_port<bool>("DECODE_2_FETCH_STALL", Port::BW);
-    wps_command[0] = make_write_port<BypassCommand<Register>>("DECODE_2_EXECUTE_SRC1_COMMAND", Port::BW);
-    wps_command[1] = make_write_port<BypassCommand<Register>>("DECODE_2_EXECUTE_SRC2_COMMAND", Port::BW);
-    wp_bypassing_unit_notify = make_write_port<Instr>("DECODE_2_BYPASSING_UNIT_NOTIFY", Port::BW);
+    wp_data_hazard = make_write_port<bool>("DECODE_2_CORE_DATA_HAZARD", Port::BW);
+    wps_command[0] = make_write_port<BypassCommand<Register>>("DECODE_2_EXECUTE_SRC1_COMMAND", width);
+    wps_command[1] = make_write_port<BypassCommand<Register>>("DECODE_2_EXECUTE_SRC2_COMMAND", width);
+    wp_bypassing_unit_notify = make_write_port<Instr>("DECODE_2_BYPASSING_UNIT_NOTIFY", width);
     wp_flush_fetch = make_write_port<bool>("DECODE_2_FETCH_FLUSH", Port::BW);
     wp_flush_target = make_write_port<Target>("DECODE_2_FETCH_TARGET", Port::BW);
     wp_bp_update = make_write_port<BPInterface>("DECODE_2_FETCH", Port::BW);
 }
 
 template <typename FuncInstr>
-auto Decode<FuncInstr>::read_instr( Cycle cycle) const
+auto Decode<FuncInstr>::read_instrs( Cycle cycle) const
 {
-    if ( rp_stall_datapath->is_ready( cycle))
-        return std::pair{ rp_stall_datapath->read( cycle), true};
+    const bool from_stall = rp_stall_datapath->is_ready( cycle);
+    auto* port = from_stall ? rp_stall_datapath : rp_datapath;
 
-    return std::pair{ rp_datapath->read( cycle), false};
+    std::vector<Instr> result;
+    while ( port->is_ready( cycle))
+        result.emplace_back( port->read( cycle));
+
+    return std::pair{ std::move( result), from_stall};
 }
 
 template <typename FuncInstr>
@@ -72,8 +79,8 @@ void Decode<FuncInstr>::clock( Cycle cycle)
 
     bypassing_unit->update();
 
-    /* trace new instruction if needed */
-    if ( rp_bypassing_unit_notify->is_ready( cycle))
+    /* trace new instructions if needed */
+    while ( rp_bypassing_unit_notify->is_ready( cycle))
     {
         auto instr = rp_bypassing_unit_notify->read( cycle);
         bypassing_unit->trace_new_instr( instr);
@@ -86,6 +93,7 @@ void Decode<FuncInstr>::clock( Cycle cycle)
     if ( has_flush || has_trap)
     {
         sout << "flush\n";
+        issued_instrs.add( 0);
         return;
     }
 
@@ -93,67 +101,108 @@ void Decode<FuncInstr>::clock( Cycle cycle)
     if ( !rp_datapath->is_ready( cycle) && !rp_stall_datapath->is_ready( cycle))
     {
         sout << "bubble\n";
+        issued_instrs.add( 0);
         return;
     }
 
-    auto[instr, from_stall] = read_instr( cycle);
-
-    if ( instr.is_jump())
-        num_jumps++;
+    auto[instrs, from_stall] = read_instrs( cycle);
 
-    /* handle misprediction */
-    if ( is_misprediction( instr, instr.get_bp_data()))
+    bypassing_unit->start_group();
+    uint32 mem_instrs = 0;
+    size_t issued = 0;
+    bool is_stall = false;
+    bool has_data_hazard = false;
+    bool is_group_closed = false;
+    for ( auto& instr : instrs)
     {
-        num_mispredictions++;
-
-        /* acquiring real information for BPU */
-        wp_bp_update->write( instr.get_bp_upd(), cycle);
-
-        // flushing fetch stage, instr fetch will appear at decode stage next clock,
-        // so we send flush signal to decode
-        if ( !bypassing_unit->is_stall( instr))
-            wp_flush_fetch->write( true, cycle);
-
-        /* sending valid PC to fetch stage */
+        /* instructions are issued in order, so the rest of the group waits for the stalled one */
+        has_data_hazard = has_data_hazard || ( !is_stall && !is_group_closed && bypassing_unit->is_stall( instr));
+        is_stall = is_stall
+            || is_group_closed
+            || has_data_hazard
+            || ( instr.is_mem_stage_required() && mem_instrs == mem_ports);
+
+        /* stalled instructions have already been checked when they came from fetch */
         if ( !from_stall)
+            handle_misprediction( instr, is_stall, cycle);
+
+        if ( is_stall)
         {
-            wp_flush_target->write( instr.get_actual_decoded_target(), cycle);
-            sout << "\nmisprediction on ";
+            // data hazard, stalling pipeline
+            wp_stall_datapath->write( instr, cycle);
+            sout << instr << " (data hazard)\n";
+            continue;
         }
+
+        if ( instr.is_mem_stage_required())
+            ++mem_instrs;
+
+        /* younger instructions must not overtake a system call on the way to memory */
+        is_group_closed = instr.is_system();
+
+        issue_instr( &instr, cycle);
+        ++issued;
     }
 
-    if ( bypassing_unit->is_stall( instr))
-    {
-        // data hazard, stalling pipeline
+    if ( is_stall)
         wp_stall->write( true, cycle);
-        wp_stall_datapath->write( instr, cycle);
-        sout << instr << " (data hazard)\n";
+
+    if ( has_data_hazard)
+        wp_data_hazard->write( true, cycle);
+
+    issued_instrs.add( issued);
+}
+
+template <typename FuncInstr>
+void Decode<FuncInstr>::handle_misprediction( const Instr& instr, bool is_stall, Cycle cycle)
+{
+    if ( instr.is_jump())
+        num_jumps++;
+
+    if ( !is_misprediction( instr, instr.get_bp_data()))
         return;
-    }
 
+    num_mispredictions++;
+
+    /* acquiring real information for BPU */
+    wp_bp_update->write( instr.get_bp_upd(), cycle);
+
+    // flushing fetch stage, instr fetch will appear at decode stage next clock,
+    // so we send flush signal to decode
+    if ( !is_stall)
+        wp_flush_fetch->write( true, cycle);
+
+    /* sending valid PC to fetch stage */
+    wp_flush_target->write( instr.get_actual_decoded_target(), cycle);
+    sout << "\nmisprediction on ";
+}
+
+template <typename FuncInstr>
+void Decode<FuncInstr>::issue_instr( Instr* instr, Cycle cycle)
+{
     for ( size_t src_index = 0; src_index < SRC_REGISTERS_NUM; src_index++)
     {
-        if ( bypassing_unit->is_in_RF( instr, src_index))
+        if ( bypassing_unit->is_in_RF( *instr, src_index))
         {
-            rf->read_source( &instr, src_index);
+            rf->read_source( instr, src_index);
         }
-        else if ( bypassing_unit->is_bypassible( instr, src_index))
+        else if ( bypassing_unit->is_bypassible( *instr, src_index))
         {
-            const auto bypass_command = bypassing_unit->get_bypass_command( instr, src_index);
+            const auto bypass_command = bypassing_unit->get_bypass_command( *instr, src_index);
             wps_command.at( src_index)->write( bypass_command, cycle);
         }
     }
 
     /* notify bypassing unit about new instruction */
-    wp_bypassing_unit_notify->write( instr, cycle);
+    bypassing_unit->add_to_group( *instr);
+    wp_bypassing_unit_notify->write( *instr, cycle);
 
     /* log */
-    sout << instr << std::endl;
+    sout << *instr << std::endl;
 
-    wp_datapath->write( std::move( instr), cycle);
+    wp_datapath->write( std::move( *instr), cycle);
 }
 
-
 #include <mips/mips.h>
 #include <risc_v/risc_v.h>
 
@@ -10,7 +10,9 @@
 #include "bypass/data_bypass.h"
 
 #include <func_sim/rf/rf.h>
+#include <modules/core/perf_config.h>
 #include <modules/core/perf_instr.h>
+#include <modules/core/width_histogram.h>
 #include <modules/ports_instance.h>
 
 template <typename FuncInstr>
@@ -22,20 +24,29 @@ class Decode : public Module
     static constexpr const uint8 SRC_REGISTERS_NUM = 2;
 
 public:
-    explicit Decode( Module* parent);
+    Decode( Module* parent, const PerfConfig& config);
     void clock( Cycle cycle);
     void set_RF( RF<FuncInstr>* value) { rf = value;}
     void set_wb_bandwidth( uint32 wb_bandwidth) { bypassing_unit->set_bandwidth( wb_bandwidth);}
     auto get_mispredictions_num() const { return num_mispredictions; }
     auto get_jumps_num() const { return num_jumps; }
+    const auto& get_width_statistics() const { return issued_instrs; }
+
+    // checks whether a misprediction can be fixed as soon as the instruction is decoded
+    static bool is_misprediction( const Instr& instr, const BPInterface& bp_data);
 
 private:
-    auto read_instr( Cycle cycle) const;
+    auto read_instrs( Cycle cycle) const;
     bool is_flush( Cycle cycle) const;
-    static bool is_misprediction( const Instr& instr, const BPInterface& bp_data);
+    void handle_misprediction( const Instr& instr, bool is_stall, Cycle cycle);
+    void issue_instr( Instr* instr, Cycle cycle);
+
+    const uint32 width;
+    const uint32 mem_ports;
 
     uint64 num_jumps          = 0;
     uint64 num_mispredictions = 0;
+    WidthHistogram issued_instrs;
 
     RF<FuncInstr>* rf = nullptr;
     std::unique_ptr<BypassingUnit> bypassing_unit = nullptr;
@@ -53,6 +64,7 @@ private:
     WritePort<Instr>* wp_datapath = nullptr;
     WritePort<Instr>* wp_stall_datapath = nullptr;
     WritePort<bool>* wp_stall = nullptr;
+    WritePort<bool>* wp_data_hazard = nullptr; // for CPI stack of the core
     WritePort<Instr>* wp_bypassing_unit_notify = nullptr;
     WritePort<BPInterface>* wp_bp_update = nullptr;
     std::array<WritePort<BypassCommand<Register>>*, SRC_REGISTERS_NUM> wps_command;
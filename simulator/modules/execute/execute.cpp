@@ -3,50 +3,116 @@
  * Copyright 2015-2018 MIPT-MIPS
  */
 
-#include <infra/config/config.h>
-
 #include "execute.h"
 
-namespace config {
-    const PredicatedValue<uint64> long_alu_latency = { "long-alu-latency", 3, "Latency of long arithmetic logic unit",
-                                                [](uint64 val) { return val >= 2 && val < 64; } };
-} // namespace config
+#include <algorithm>
 
 template <typename FuncInstr>
-Execute<FuncInstr>::Execute( Module* parent) : Module( parent, "execute")
-    , last_execution_stage_latency( Latency( config::long_alu_latency - 1))
+Execute<FuncInstr>::Execute( Module* parent, const PerfConfig& config) : Module( parent, "execute")
+    , last_execution_stage_latency( Latency( config.long_alu_latency - 1))
+    , is_ideal_alu( config.oracle.alu)
 {
-    wp_mem_datapath = make_write_port<Instr>("EXECUTE_2_MEMORY" , Port::BW );
-    wp_branch_datapath = make_write_port<Instr>("EXECUTE_2_BRANCH" , Port::BW );
-    wp_writeback_datapath = make_write_port<Instr>("EXECUTE_2_WRITEBACK", Port::BW);
+    const auto width = config.pipeline.width;
+    wp_mem_datapath = make_write_port<Instr>("EXECUTE_2_MEMORY" , width);
+    wp_branch_datapath = make_write_port<Instr>("EXECUTE_2_BRANCH" , width);
+    // long and simple ALUs may finish in the same cycle
+    wp_writeback_datapath = make_write_port<Instr>("EXECUTE_2_WRITEBACK", 2 * width);
     rp_datapath = make_read_port<Instr>("DECODE_2_EXECUTE", Port::LATENCY);
     rp_trap = make_read_port<bool>("WRITEBACK_2_ALL_FLUSH", Port::LATENCY);
 
-    wp_long_latency_execution_unit = make_write_port<Instr>("EXECUTE_2_EXECUTE_LONG_LATENCY", Port::BW);
+    wp_long_latency_execution_unit = make_write_port<Instr>("EXECUTE_2_EXECUTE_LONG_LATENCY", width);
     rp_long_latency_execution_unit = make_read_port<Instr>("EXECUTE_2_EXECUTE_LONG_LATENCY", last_execution_stage_latency);
 
     rp_flush = make_read_port<bool>("BRANCH_2_ALL_FLUSH", Port::LATENCY);
 
-    rps_bypass[0].command_port = make_read_port<BypassCommand<Register>>("DECODE_2_EXECUTE_SRC1_COMMAND", Port::LATENCY);
-    rps_bypass[1].command_port = make_read_port<BypassCommand<Register>>("DECODE_2_EXECUTE_SRC2_COMMAND", Port::LATENCY);
+    rps_command[0] = make_read_port<BypassCommand<Register>>("DECODE_2_EXECUTE_SRC1_COMMAND", Port::LATENCY);
+    rps_command[1] = make_read_port<BypassCommand<Register>>("DECODE_2_EXECUTE_SRC2_COMMAND", Port::LATENCY);
+
+    wp_bypass = make_write_port<InstructionOutput>("EXECUTE_2_EXECUTE_BYPASS", width);
+    wp_long_arithmetic_bypass = make_write_port<InstructionOutput>("EXECUTE_COMPLEX_ALU_2_EXECUTE_BYPASS", width);
+    wp_long_alu_busy = make_write_port<bool>("EXECUTE_2_CORE_LONG_ALU_BUSY", Port::BW);
+
+    rps_bypass[0] = make_read_port<InstructionOutput>("EXECUTE_2_EXECUTE_BYPASS", Port::LATENCY);
+    rps_bypass[1] = make_read_port<InstructionOutput>("EXECUTE_COMPLEX_ALU_2_EXECUTE_BYPASS", Port::LATENCY);
+    rps_bypass[2] = make_read_port<InstructionOutput>("MEMORY_2_EXECUTE_BYPASS", Port::LATENCY);
+    rps_bypass[3] = make_read_port<InstructionOutput>("WRITEBACK_2_EXECUTE_BYPASS", Port::LATENCY);
+    rps_bypass[4] = make_read_port<InstructionOutput>("BRANCH_2_EXECUTE_BYPASS", Port::LATENCY);
+}
+
+template <typename FuncInstr>
+void Execute<FuncInstr>::read_bypass_ports( Cycle cycle)
+{
+    for ( size_t i = 0; i < SRC_REGISTERS_NUM; ++i)
+    {
+        commands.at( i).clear();
+        while ( rps_command.at( i)->is_ready( cycle))
+            commands.at( i).push_back( rps_command.at( i)->read( cycle));
+    }
 
-    wp_bypass = make_write_port<InstructionOutput>("EXECUTE_2_EXECUTE_BYPASS", Port::BW);
-    wp_long_arithmetic_bypass = make_write_port<InstructionOutput>("EXECUTE_COMPLEX_ALU_2_EXECUTE_BYPASS", Port::BW);
+    for ( size_t i = 0; i < RegisterStage::BYPASSING_STAGES_NUMBER; ++i)
+    {
+        bypassed_data.at( i).clear();
+        while ( rps_bypass.at( i)->is_ready( cycle))
+            bypassed_data.at( i).push_back( rps_bypass.at( i)->read( cycle));
+    }
+}
+
+template <typename FuncInstr>
+void Execute<FuncInstr>::bypass_sources( Instr* instr) const
+{
+    for ( size_t src_index = 0; src_index < SRC_REGISTERS_NUM; ++src_index)
+    {
+        /* check whether bypassing is needed for a source register */
+        const auto& src_commands = commands.at( src_index);
+        const auto command = std::find_if( src_commands.begin(), src_commands.end(), [instr]( const auto& c) {
+            return c.get_consumer_id() == instr->get_sequence_id();
+        });
+        if ( command == src_commands.end())
+            continue;
+
+        /* several instructions may pass the bypassing stage, take the producer one */
+        const auto& data = bypassed_data.at( command->get_bypass_direction());
+        const auto producer = std::find_if( data.begin(), data.end(), [&command]( const auto& d) {
+            return d.producer_id == command->get_producer_id();
+        });
+        instr->set_v_src( producer != data.end() ? producer->value[0] : RegisterUInt{}, src_index);
+    }
+}
 
-    rps_bypass[0].data_ports[0] = make_read_port<InstructionOutput>("EXECUTE_2_EXECUTE_BYPASS", Port::LATENCY);
-    rps_bypass[1].data_ports[0] = make_read_port<InstructionOutput>("EXECUTE_2_EXECUTE_BYPASS", Port::LATENCY);
+template <typename FuncInstr>
+void Execute<FuncInstr>::execute_instr( Instr instr, Cycle cycle)
+{
+    bypass_sources( &instr);
 
-    rps_bypass[0].data_ports[1] = make_read_port<InstructionOutput>("EXECUTE_COMPLEX_ALU_2_EXECUTE_BYPASS", Port::LATENCY);
-    rps_bypass[1].data_ports[1] = make_read_port<InstructionOutput>("EXECUTE_COMPLEX_ALU_2_EXECUTE_BYPASS", Port::LATENCY);
+    /* perform execution */
+    instr.execute();
 
-    rps_bypass[0].data_ports[2] = make_read_port<InstructionOutput>("MEMORY_2_EXECUTE_BYPASS", Port::LATENCY);
-    rps_bypass[1].data_ports[2] = make_read_port<InstructionOutput>("MEMORY_2_EXECUTE_BYPASS", Port::LATENCY);
+    /* log */
+    sout << instr << std::endl;
 
-    rps_bypass[0].data_ports[3] = make_read_port<InstructionOutput>("WRITEBACK_2_EXECUTE_BYPASS", Port::LATENCY);
-    rps_bypass[1].data_ports[3] = make_read_port<InstructionOutput>("WRITEBACK_2_EXECUTE_BYPASS", Port::LATENCY);
+    if ( instr.is_long_arithmetic() && !is_ideal_alu)
+    {
+        long_alu_ready_cycle = cycle + last_execution_stage_latency;
+        wp_long_latency_execution_unit->write( std::move( instr), cycle);
+    }
+    else
+    {
+        /* bypass data */
+        wp_bypass->write( instr.get_bypassed_data(), cycle);
 
-    rps_bypass[0].data_ports[4] = make_read_port<InstructionOutput>("BRANCH_2_EXECUTE_BYPASS", Port::LATENCY);
-    rps_bypass[1].data_ports[4] = make_read_port<InstructionOutput>("BRANCH_2_EXECUTE_BYPASS", Port::LATENCY);
+        if ( instr.is_jump())
+        {
+            wp_branch_datapath->write( std::move( instr), cycle);
+        }
+        else if ( instr.is_mem_stage_required())
+        {
+            wp_mem_datapath->write( std::move( instr), cycle);
+        }
+        else
+        {
+            wp_writeback_datapath->write( std::move( instr), cycle);
+        }
+    }
 }
 
 template <typename FuncInstr>
@@ -64,22 +130,25 @@ void Execute<FuncInstr>::clock( Cycle cycle)
     if (is_flush)
     {
         save_flush();
+        long_alu_ready_cycle = cycle;
         sout << "flush\n";
         return;
     }
 
-    /* get the instruction from long ALU if it is ready */
-    if ( rp_long_latency_execution_unit->is_ready( cycle))
+    /* get instructions from long ALUs if they are ready */
+    while ( rp_long_latency_execution_unit->is_ready( cycle))
     {
         auto instr = rp_long_latency_execution_unit->read( cycle);
 
         if ( has_flush_expired())
         {
-            wp_long_arithmetic_bypass->write( instr.get_v_dst(), cycle);
+            wp_long_arithmetic_bypass->write( instr.get_bypassed_data(), cycle);
             wp_writeback_datapath->write( instr, cycle);
         }
     }
 
+    if ( cycle < long_alu_ready_cycle)
+        wp_long_alu_busy->write( true, cycle);
 
     /* check if there is something to process */
     if ( !rp_datapath->is_ready( cycle))
@@ -88,52 +157,11 @@ void Execute<FuncInstr>::clock( Cycle cycle)
         return;
     }
 
-    auto instr = rp_datapath->read( cycle);
-
-    auto src_index = 0;
-    for ( auto& bypass_source : rps_bypass)
-    {
-        /* check whether bypassing is needed for a source register */
-        if ( bypass_source.command_port->is_ready( cycle))
-        {
-            const auto bypass_direction = bypass_source.command_port->read( cycle).get_bypass_direction();
-            auto& port = bypass_source.data_ports.at( bypass_direction);
-            RegisterUInt data{};
-            while ( port->is_ready( cycle))
-                data = port->read( cycle)[0];
-            instr.set_v_src( data, src_index);
-        }
-        ++src_index;
-    }
-
-    /* perform execution */
-    instr.execute();
-
-    /* log */
-    sout << instr << std::endl;
-
-    if ( instr.is_long_arithmetic()) 
-    {
-        wp_long_latency_execution_unit->write( std::move( instr), cycle);
-    }
-    else
-    {
-        /* bypass data */
-        wp_bypass->write( instr.get_v_dst(), cycle);
+    read_bypass_ports( cycle);
 
-        if ( instr.is_jump())
-        {
-            wp_branch_datapath->write( std::move( instr), cycle);
-        }
-        else if ( instr.is_mem_stage_required())
-        {
-            wp_mem_datapath->write( std::move( instr), cycle);
-        }
-        else
-        {
-            wp_writeback_datapath->write( std::move( instr), cycle);
-        }
-    }
+    /* each instruction of the group has its own ALU */
+    while ( rp_datapath->is_ready( cycle))
+        execute_instr( rp_datapath->read( cycle), cycle);
 }
 
 
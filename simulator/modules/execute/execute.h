@@ -7,14 +7,12 @@
 #define EXECUTE_H
 
 #include <func_sim/operation.h>
-#include <infra/config/config.h>
+#include <modules/core/perf_config.h>
 #include <modules/core/perf_instr.h>
 #include <modules/decode/bypass/data_bypass_interface.h>
 #include <modules/ports_instance.h>
 
-namespace config {
-    extern const PredicatedValue<uint64> long_alu_latency;
-} // namespace config
+#include <vector>
 
 template <typename FuncInstr>
 class Execute : public Module
@@ -22,11 +20,12 @@ class Execute : public Module
     using Register = typename FuncInstr::Register;
     using Instr = PerfInstr<FuncInstr>;
     using RegisterUInt = typename FuncInstr::RegisterUInt;
-    using InstructionOutput = std::array< RegisterUInt, MAX_DST_NUM>;
+    using InstructionOutput = BypassedData<RegisterUInt>;
 
     private:
         static constexpr const uint8 SRC_REGISTERS_NUM = 2;
         const Latency last_execution_stage_latency;
+        const bool is_ideal_alu; // long arithmetic is executed by simple ALU
 
         /* Inputs */
         ReadPort<Instr>* rp_datapath = nullptr;
@@ -34,11 +33,12 @@ class Execute : public Module
         ReadPort<bool>* rp_flush = nullptr;
         ReadPort<bool>* rp_trap = nullptr;
 
-        struct BypassPorts {
-            ReadPort<BypassCommand<Register>>* command_port;
-            std::array<ReadPort<InstructionOutput>*, RegisterStage::BYPASSING_STAGES_NUMBER> data_ports;
-        };
-        std::array<BypassPorts, SRC_REGISTERS_NUM> rps_bypass;
+        std::array<ReadPort<BypassCommand<Register>>*, SRC_REGISTERS_NUM> rps_command;
+        std::array<ReadPort<InstructionOutput>*, RegisterStage::BYPASSING_STAGES_NUMBER> rps_bypass;
+
+        /* Bypass commands and data received in the current cycle */
+        std::array<std::vector<BypassCommand<Register>>, SRC_REGISTERS_NUM> commands;
+        std::array<std::vector<InstructionOutput>, RegisterStage::BYPASSING_STAGES_NUMBER> bypassed_data;
 
         /* Outputs */
         WritePort<Instr>* wp_mem_datapath = nullptr;
@@ -47,8 +47,14 @@ class Execute : public Module
         WritePort<Instr>* wp_long_latency_execution_unit = nullptr;
         WritePort<InstructionOutput>* wp_bypass = nullptr;
         WritePort<InstructionOutput>* wp_long_arithmetic_bypass = nullptr;
+        WritePort<bool>* wp_long_alu_busy = nullptr; // for CPI stack of the core
 
         Latency flush_expiration_latency = 0_lt;
+        Cycle long_alu_ready_cycle = 0_cl; // the youngest instruction leaves long ALU
+
+        void read_bypass_ports( Cycle cycle);
+        void bypass_sources( Instr* instr) const;
+        void execute_instr( Instr instr, Cycle cycle);
 
         void save_flush() { flush_expiration_latency = last_execution_stage_latency; }
         void clock_saved_flush()
@@ -59,7 +65,7 @@ class Execute : public Module
         auto has_flush_expired() const { return flush_expiration_latency == 0_lt; }
 
     public:
-        explicit Execute( Module* parent);
+        Execute( Module* parent, const PerfConfig& config);
         void clock( Cycle cycle);
 };
 
@@ -12,12 +12,27 @@
 
 #include <iosfwd>
 
+/* type of branch instruction stored in BTB */
+struct BranchKind {
+    bool is_conditional = true;
+    bool is_call = false;
+    bool is_return = false;
+    bool is_indirect = false;
+};
+
 /*the structure of data sent from memory to fetch stage */
 struct BPInterface {
     Addr pc = NO_VAL32;
     bool is_taken = false;
     Addr target = NO_VAL32;
     bool is_hit = true;
+    BranchKind kind;
+
+    /* speculative state before the prediction, to repair it after misprediction */
+    uint64 history = 0;
+    uint64 indirect_history = 0;
+    uint32 ras_pointer = 0;
+    Addr ras_top = NO_VAL32;
 
     BPInterface() = default;
 
@@ -0,0 +1,332 @@
+/*
+ * bpglobal.cpp - branch predictors with global history
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include "bpglobal.h"
+#include "bpu.h"
+
+#include <infra/macro.h>
+
+#include <bit>
+#include <cmath>
+#include <string>
+
+static const constexpr uint32 max_history_length = bitwidth<uint64>;
+
+static uint32 get_index_bits( const std::string& mode, uint32 table_size)
+{
+    if ( !is_power_of_two( table_size))
+        throw BPInvalidMode( mode, "table size should be a power of two");
+
+    return narrow_cast<uint32>( std::countr_zero( table_size));
+}
+
+static uint32 check_history_length( const std::string& mode, uint32 length)
+{
+    if ( length == 0 || length > max_history_length)
+        throw BPInvalidMode( mode, "global history length should be from 1 to " + std::to_string( max_history_length));
+
+    return length;
+}
+
+// XOR of 'bits'-wide chunks of the latest 'length' history bits
+static uint64 fold( uint64 history, uint32 length, uint32 bits)
+{
+    if ( bits == 0)
+        return 0;
+
+    uint64 value = history & bitmask<uint64>( length);
+    uint64 result = 0;
+    for ( ; value != 0; value >>= bits)
+        result ^= value & bitmask<uint64>( bits);
+
+    return result;
+}
+
+static uint64 get_pc_hash( Addr PC, uint32 bits)
+{
+    const uint64 pc = PC >> 2U;
+    return ( pc ^ ( pc >> bits)) & bitmask<uint64>( bits);
+}
+
+GShare::GShare( const PerfConfig::BP& config)
+    : history_length( check_history_length( "gshare", config.global_history))
+    , index_bits( get_index_bits( "gshare", config.table_size))
+    , table( config.table_size)
+{ }
+
+size_t GShare::get_index( Addr PC, uint64 history) const
+{
+    return narrow_cast<size_t>( get_pc_hash( PC, index_bits) ^ fold( history, history_length, index_bits));
+}
+
+// Geometric series of history lengths of tagged tables
+static std::vector<uint32> get_geometric_history_lengths( const std::string& mode, const PerfConfig::BP& config)
+{
+    const auto min_length = check_history_length( mode, config.tage_min_history);
+    const auto max_length = check_history_length( mode, config.tage_max_history);
+    if ( min_length > max_length)
+        throw BPInvalidMode( mode, "minimal history length should not exceed maximal");
+
+    if ( config.tage_tables == 0)
+        throw BPInvalidMode( mode, "at least one tagged table is required");
+
+    const auto ratio = double( max_length) / double( min_length);
+    const auto last = std::max<uint32>( config.tage_tables - 1, 1);
+    std::vector<uint32> result;
+    for ( uint32 i = 0; i < config.tage_tables; ++i)
+        result.push_back( narrow_cast<uint32>( std::lround( min_length * std::pow( ratio, double( i) / last))));
+
+    return result;
+}
+
+static uint32 check_tag_bits( const std::string& mode, uint32 tag_bits)
+{
+    if ( tag_bits == 0 || tag_bits > 16)
+        throw BPInvalidMode( mode, "tag width should be from 1 to 16 bits");
+
+    return tag_bits;
+}
+
+static uint32 get_tag_hash( Addr PC, uint64 history, uint32 length, uint32 bits)
+{
+    const uint64 hash = ( PC >> 2U) ^ fold( history, length, bits) ^ ( fold( history, length, bits - 1) << 1U);
+    return narrow_cast<uint32>( hash & bitmask<uint64>( bits));
+}
+
+TAGE::TAGE( const PerfConfig::BP& config)
+    : index_bits( get_index_bits( "tage", config.table_size))
+    , tag_bits( check_tag_bits( "tage", config.tage_tag_bits))
+    , history_lengths( get_geometric_history_lengths( "tage", config))
+    , base( config.table_size)
+    , tables( config.tage_tables, std::vector<Entry>( config.table_size))
+{
+    use_alternate_on_weak.reset( false);
+}
+
+size_t TAGE::get_base_index( Addr PC) const
+{
+    return narrow_cast<size_t>( get_pc_hash( PC, index_bits));
+}
+
+size_t TAGE::get_index( size_t table, Addr PC, uint64 history) const
+{
+    return narrow_cast<size_t>( get_pc_hash( PC, index_bits) ^ fold( history, history_lengths[ table], index_bits));
+}
+
+uint32 TAGE::get_tag( size_t table, Addr PC, uint64 history) const
+{
+    return get_tag_hash( PC, history, history_lengths[ table], tag_bits);
+}
+
+TAGE::Lookup TAGE::lookup( Addr PC, uint64 history) const
+{
+    Lookup result;
+    for ( size_t i = tables.size(); i-- > 0;) {
+        if ( get_entry( i, PC, history).tag != get_tag( i, PC, history))
+            continue;
+
+        if ( result.provider == NO_VAL<size_t>) {
+            result.provider = i;
+        }
+        else {
+            result.alternate = i;
+            break;
+        }
+    }
+
+    result.alternate_prediction = result.alternate == NO_VAL<size_t>
+        ? base[ get_base_index( PC)].is_taken()
+        : get_entry( result.alternate, PC, history).counter.is_taken();
+
+    if ( result.provider == NO_VAL<size_t>) {
+        result.prediction = result.alternate_prediction;
+        return result;
+    }
+
+    // Newly allocated entries are weak and not useful yet, their alternate may be better
+    const auto& entry = get_entry( result.provider, PC, history);
+    result.provider_prediction = entry.counter.is_taken();
+    const bool is_new = entry.counter.is_weak() && entry.useful == 0;
+    result.prediction = is_new && use_alternate_on_weak.is_taken()
+        ? result.alternate_prediction
+        : result.provider_prediction;
+
+    return result;
+}
+
+void TAGE::allocate( size_t first_table, Addr PC, uint64 history, bool is_taken)
+{
+    for ( size_t i = first_table; i < tables.size(); ++i) {
+        auto& entry = get_entry( i, PC, history);
+        if ( entry.useful == 0) {
+            entry.tag = get_tag( i, PC, history);
+            entry.counter.reset( is_taken);
+            return;
+        }
+    }
+
+    // No free entries, age the candidates to free them for next allocations
+    for ( size_t i = first_table; i < tables.size(); ++i)
+        --get_entry( i, PC, history).useful;
+}
+
+void TAGE::update( Addr PC, uint64 history, bool is_taken)
+{
+    const auto result = lookup( PC, history);
+    if ( result.provider == NO_VAL<size_t>) {
+        base[ get_base_index( PC)].update( is_taken);
+    }
+    else {
+        auto& entry = get_entry( result.provider, PC, history);
+        if ( result.provider_prediction != result.alternate_prediction) {
+            if ( entry.counter.is_weak() && entry.useful == 0)
+                use_alternate_on_weak.update( result.alternate_prediction == is_taken);
+
+            if ( result.provider_prediction == is_taken)
+                entry.useful = std::min( entry.useful + 1, max_useful);
+            else if ( entry.useful > 0)
+                --entry.useful;
+        }
+        entry.counter.update( is_taken);
+    }
+
+    if ( result.prediction != is_taken) {
+        const auto first_table = result.provider == NO_VAL<size_t> ? 0 : result.provider + 1;
+        allocate( first_table, PC, history, is_taken);
+    }
+
+    if ( ++updates % useful_reset_period == 0)
+        for ( auto& table : tables)
+            for ( auto& entry : table)
+                entry.useful >>= 1U;
+}
+
+static int32 get_perceptron_threshold( size_t weights_num)
+{
+    // Jimenez and Lin, 2001: 1.93 * n + 14
+    return narrow_cast<int32>( ( 193 * weights_num) / 100 + 14);
+}
+
+HashedPerceptron::HashedPerceptron( const PerfConfig::BP& config)
+    : history_length( check_history_length( "perceptron", config.global_history))
+    , index_bits( get_index_bits( "perceptron", config.table_size))
+    , weights( 1 + ( history_length + segment_length - 1) / segment_length,
+               std::vector<SignedCounter<8>>( config.table_size))
+    , threshold( get_perceptron_threshold( weights.size()))
+{ }
+
+size_t HashedPerceptron::get_index( size_t table, Addr PC, uint64 history) const
+{
+    const auto pc_hash = get_pc_hash( PC, index_bits);
+    if ( table == 0)
+        return narrow_cast<size_t>( pc_hash);
+
+    const auto offset = narrow_cast<uint32>( ( table - 1) * segment_length);
+    const auto length = std::min( segment_length, history_length - offset);
+    return narrow_cast<size_t>( pc_hash ^ fold( history >> offset, length, index_bits));
+}
+
+int32 HashedPerceptron::get_output( Addr PC, uint64 history) const
+{
+    int32 sum = 0;
+    for ( size_t i = 0; i < weights.size(); ++i)
+        sum += weights[ i][ get_index( i, PC, history)].get_value();
+
+    return sum;
+}
+
+void HashedPerceptron::update( Addr PC, uint64 history, bool is_taken)
+{
+    const auto output = get_output( PC, history);
+    if ( ( output >= 0) == is_taken && std::abs( output) > threshold)
+        return;
+
+    for ( size_t i = 0; i < weights.size(); ++i)
+        weights[ i][ get_index( i, PC, history)].update( is_taken);
+}
+
+ITTAGE::ITTAGE( const PerfConfig::BP& config)
+    : index_bits( get_index_bits( "ittage", config.table_size))
+    , tag_bits( check_tag_bits( "ittage", config.tage_tag_bits))
+    , history_lengths( get_geometric_history_lengths( "ittage", config))
+    , tables( history_lengths.size(), std::vector<Entry>( config.table_size))
+{ }
+
+size_t ITTAGE::get_index( size_t table, Addr PC, uint64 history) const
+{
+    return narrow_cast<size_t>( get_pc_hash( PC, index_bits) ^ fold( history, history_lengths[ table], index_bits));
+}
+
+uint32 ITTAGE::get_tag( size_t table, Addr PC, uint64 history) const
+{
+    return get_tag_hash( PC, history, history_lengths[ table], tag_bits);
+}
+
+ITTAGE::Lookup ITTAGE::lookup( Addr PC, uint64 history) const
+{
+    Lookup result;
+    for ( size_t i = tables.size(); i-- > 0;) {
+        const auto& entry = get_entry( i, PC, history);
+        if ( entry.target == NO_VAL32 || entry.tag != get_tag( i, PC, history))
+            continue;
+
+        if ( result.provider == NO_VAL<size_t>) {
+            result.provider = i;
+            result.prediction = entry.target;
+        }
+        else {
+            result.alternate_prediction = entry.target;
+            break;
+        }
+    }
+
+    // Targets without confidence are replaced by the alternate
+    if ( result.provider != NO_VAL<size_t>
+        && get_entry( result.provider, PC, history).confidence == 0
+        && result.alternate_prediction != NO_VAL32)
+    {
+        result.prediction = result.alternate_prediction;
+    }
+
+    return result;
+}
+
+void ITTAGE::allocate( size_t first_table, Addr PC, uint64 history, Addr target)
+{
+    for ( size_t i = first_table; i < tables.size(); ++i) {
+        auto& entry = get_entry( i, PC, history);
+        if ( !entry.is_useful) {
+            entry = { target, get_tag( i, PC, history), 0, false};
+            return;
+        }
+    }
+
+    for ( size_t i = first_table; i < tables.size(); ++i)
+        get_entry( i, PC, history).is_useful = false;
+}
+
+void ITTAGE::update( Addr PC, uint64 history, Addr target)
+{
+    const auto result = lookup( PC, history);
+    if ( result.provider != NO_VAL<size_t>) {
+        auto& entry = get_entry( result.provider, PC, history);
+        if ( entry.target == target) {
+            entry.confidence = std::min( entry.confidence + 1, max_confidence);
+            entry.is_useful = entry.is_useful || result.alternate_prediction != target;
+        }
+        else if ( entry.confidence > 0) {
+            --entry.confidence;
+        }
+        else {
+            entry.target = target;
+            entry.is_useful = false;
+        }
+    }
+
+    if ( result.prediction != target) {
+        const auto first_table = result.provider == NO_VAL<size_t> ? 0 : result.provider + 1;
+        allocate( first_table, PC, history, target);
+    }
+}
@@ -0,0 +1,187 @@
+/*
+ * bpglobal.h - branch predictors with global history
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef BRANCH_PREDICTION_GLOBAL
+#define BRANCH_PREDICTION_GLOBAL
+
+#include "bpentry.h"
+
+#include <infra/types.h>
+#include <modules/core/perf_config.h>
+
+#include <algorithm>
+#include <vector>
+
+/*
+ * Global history is a shift register of conditional branch directions,
+ * the latest direction is the least significant bit. Predictors do not
+ * own the history: BPU updates it speculatively, and each update comes
+ * with the history which was used for the corresponding prediction.
+ */
+
+/* signed saturating counter, non-negative values mean 'taken' */
+template<size_t BITS>
+class SignedCounter
+{
+    static const constexpr int32 max_value = ( 1 << ( BITS - 1)) - 1;
+    static const constexpr int32 min_value = -( 1 << ( BITS - 1));
+    int32 value = 0;
+
+public:
+    int32 get_value() const { return value; }
+    bool is_taken() const { return value >= 0; }
+    bool is_weak() const { return value == 0 || value == -1; }
+
+    void update( bool is_taken)
+    {
+        value = is_taken ? std::min( value + 1, max_value) : std::max( value - 1, min_value);
+    }
+
+    void reset( bool is_taken) { value = is_taken ? 0 : -1; }
+};
+
+/* two-bit counters indexed by PC xor global history (McFarling, 1993) */
+class GShare
+{
+public:
+    explicit GShare( const PerfConfig::BP& config);
+
+    bool is_taken( Addr PC, uint64 history) const { return table[ get_index( PC, history)].is_taken(); }
+    void update( Addr PC, uint64 history, bool is_taken) { table[ get_index( PC, history)].update( is_taken); }
+
+private:
+    size_t get_index( Addr PC, uint64 history) const;
+
+    const uint32 history_length;
+    const uint32 index_bits;
+    std::vector<BPEntryTwoBit::State> table;
+};
+
+/*
+ * TAGE (Seznec and Michaud, 2006): bimodal base predictor and tagged tables
+ * indexed with geometrically increasing history lengths. The longest
+ * matching table provides the prediction, mispredictions allocate entries
+ * in tables with longer histories.
+ */
+class TAGE
+{
+public:
+    explicit TAGE( const PerfConfig::BP& config);
+
+    bool is_taken( Addr PC, uint64 history) const { return lookup( PC, history).prediction; }
+    void update( Addr PC, uint64 history, bool is_taken);
+
+    const auto& get_history_lengths() const { return history_lengths; }
+
+private:
+    static const constexpr uint32 max_useful = 3;
+    static const constexpr uint64 useful_reset_period = 1ULL << 18U;
+
+    struct Entry
+    {
+        SignedCounter<3> counter;
+        uint32 tag = 0;
+        uint32 useful = 0;
+    };
+
+    struct Lookup
+    {
+        size_t provider = NO_VAL<size_t>;   // NO_VAL means base predictor
+        size_t alternate = NO_VAL<size_t>;
+        bool provider_prediction = false;
+        bool alternate_prediction = false;
+        bool prediction = false;
+    };
+
+    Lookup lookup( Addr PC, uint64 history) const;
+    size_t get_index( size_t table, Addr PC, uint64 history) const;
+    uint32 get_tag( size_t table, Addr PC, uint64 history) const;
+    size_t get_base_index( Addr PC) const;
+    Entry& get_entry( size_t table, Addr PC, uint64 history) { return tables[ table][ get_index( table, PC, history)]; }
+    const Entry& get_entry( size_t table, Addr PC, uint64 history) const { return tables[ table][ get_index( table, PC, history)]; }
+    void allocate( size_t first_table, Addr PC, uint64 history, bool is_taken);
+
+    const uint32 index_bits;
+    const uint32 tag_bits;
+    std::vector<uint32> history_lengths;
+    std::vector<BPEntryTwoBit::State> base;
+    std::vector<std::vector<Entry>> tables;
+    SignedCounter<4> use_alternate_on_weak;
+    uint64 updates = 0;
+};
+
+/*
+ * Hashed perceptron (Tarjan and Skadron, 2005): global history is split
+ * into segments, each segment hashed with PC selects a weight from its own
+ * table. Sum of the weights and a per-PC bias gives the prediction.
+ */
+class HashedPerceptron
+{
+public:
+    explicit HashedPerceptron( const PerfConfig::BP& config);
+
+    bool is_taken( Addr PC, uint64 history) const { return get_output( PC, history) >= 0; }
+    void update( Addr PC, uint64 history, bool is_taken);
+
+    size_t get_tables_num() const { return weights.size(); }
+
+private:
+    static const constexpr uint32 segment_length = 8;
+
+    int32 get_output( Addr PC, uint64 history) const;
+    size_t get_index( size_t table, Addr PC, uint64 history) const;
+
+    const uint32 history_length;
+    const uint32 index_bits;
+    std::vector<std::vector<SignedCounter<8>>> weights; // the first table holds biases
+    const int32 threshold;
+};
+
+/*
+ * ITTAGE (Seznec, 2011): TAGE-like tagged tables which store targets
+ * of indirect jumps instead of directions. If no table matches,
+ * the target is taken from BTB.
+ */
+class ITTAGE
+{
+public:
+    explicit ITTAGE( const PerfConfig::BP& config);
+
+    // NO_VAL32 if there is no matching entry
+    Addr get_target( Addr PC, uint64 history) const { return lookup( PC, history).prediction; }
+    void update( Addr PC, uint64 history, Addr target);
+
+private:
+    static const constexpr uint32 max_confidence = 3;
+
+    struct Entry
+    {
+        Addr target = NO_VAL32;
+        uint32 tag = 0;
+        uint32 confidence = 0;
+        bool is_useful = false;
+    };
+
+    struct Lookup
+    {
+        size_t provider = NO_VAL<size_t>;
+        Addr alternate_prediction = NO_VAL32;
+        Addr prediction = NO_VAL32;
+    };
+
+    Lookup lookup( Addr PC, uint64 history) const;
+    size_t get_index( size_t table, Addr PC, uint64 history) const;
+    uint32 get_tag( size_t table, Addr PC, uint64 history) const;
+    Entry& get_entry( size_t table, Addr PC, uint64 history) { return tables[ table][ get_index( table, PC, history)]; }
+    const Entry& get_entry( size_t table, Addr PC, uint64 history) const { return tables[ table][ get_index( table, PC, history)]; }
+    void allocate( size_t first_table, Addr PC, uint64 history, Addr target);
+
+    const uint32 index_bits;
+    const uint32 tag_bits;
+    std::vector<uint32> history_lengths;
+    std::vector<std::vector<Entry>> tables;
+};
+
+#endif
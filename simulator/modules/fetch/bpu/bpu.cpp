@@ -5,11 +5,13 @@
  */
 
 #include "bpentry.h"
+#include "bpglobal.h"
 #include "bpu.h"
+#include "btb.h"
+#include "ras.h"
 
 // MIPT_MIPS modules
 #include <infra/cache/cache_tag_array.h>
-#include <infra/config/config.h>
 
 // C++ generic modules
 #include <map>
@@ -17,88 +19,263 @@
 #include <sstream>
 #include <vector>
 
-namespace config {
-    static const Value<std::string> bp_mode = { "bp-mode", "saturating_two_bits", "branch prediction mode"};
-    static const Value<std::string> bp_lru = { "bp-lru", "pseudo-LRU", "branch prediction replacement policy"};
-    static const Value<uint32> bp_size = { "bp-size", 128, "BTB size in entries"};
-    static const Value<uint32> bp_ways = { "bp-ways", 16, "number of ways in BTB"};
-} // namespace config
+// BTB keeps entries per way, so ideal tag arrays without ways cannot back it
+static const std::string& check_btb_lru( const std::string& lru)
+{
+    if ( lru == "always_hit" || lru == "infinite")
+        throw BPInvalidMode( "\"" + lru + "\" tag array cannot be used for BTB", "use one of the replacement policies");
+
+    return lru;
+}
 
 template<typename T>
 class BP final: public BaseBP
 {
-    std::vector<std::vector<T>> directions;
-    std::vector<std::vector<Addr>> targets;
-    std::unique_ptr<CacheTagArray> tags = nullptr;
-
-    bool is_way_taken( size_t way, Addr PC, Addr target) const
+    struct Entry
     {
-        return directions[ way][ tags->set(PC)].is_taken( PC, target);
-    }
+        T direction;
+        Addr target = NO_VAL32;
+        BranchKind kind;
+    };
+
+    BTB<Entry> btb;
+
 public:
     BP( const std::string& lru, uint32 size_in_entries, uint32 ways, uint32 branch_ip_size_in_bits) try
-        : directions( ways, std::vector<T>( size_in_entries / ways))
-        , targets( ways, std::vector<Addr>( size_in_entries / ways))
+        : btb( check_btb_lru( lru), size_in_entries, ways, branch_ip_size_in_bits)
+    { }
+    catch (const CacheTagArrayInvalidSizeException& e) {
+        throw BPInvalidMode( e.what(), "");
+    }
+
+    // Single lookup instead of separate is_hit, is_taken and get_target
+    BPInterface get_bp_info( Addr PC) const final
+    {
+        const auto* entry = btb.find( PC);
+        if ( entry == nullptr)
+            return BPInterface( PC, false, PC + 4, false);
+
+        const bool is_taken = entry->direction.is_taken( PC, entry->target);
+        BPInterface info( PC, is_taken, is_taken ? entry->target : PC + 4, true);
+        info.kind = entry->kind;
+        return info;
+    }
+
+    /* prediction, LRU information is not updated */
+    bool is_taken( Addr PC) const final { return get_bp_info( PC).is_taken; }
+    bool is_hit( Addr PC) const final { return btb.find( PC) != nullptr; }
+
+    // return saved target only in case it is predicted taken
+    Addr get_target( Addr PC) const final { return get_bp_info( PC).target; }
+
+    /* update */
+    void update( const BPInterface& bp_upd) final
+    {
+        bool is_new = false;
+        auto& entry = btb.get_entry_for_update( bp_upd.pc, &is_new);
+        if ( is_new)
+            entry.direction.reset();
+
+        entry.direction.update( bp_upd.is_taken);
+        entry.target = bp_upd.target;
+        entry.kind = bp_upd.kind;
+    }
+};
+
+/*
+ * BTB provides targets and tells conditional branches from jumps,
+ * directions of conditional branches are predicted by global history
+ */
+template<typename T>
+class GlobalBP final: public BaseBP
+{
+    struct Entry
+    {
+        Addr target = NO_VAL32;
+        BranchKind kind;
+    };
+
+    T directions;
+    BTB<Entry> btb;
+    uint64 history = 0; // speculative, updated at prediction
+
+    void shift_history( bool is_taken)
     {
-        // we're reusing existing CacheTagArray functionality,
-        // but here we don't split memory in blocks, storing
-        // IP's only, so hardcoding here the granularity of 4 bytes:
-        tags = CacheTagArray::create( lru, size_in_entries, ways, 4, branch_ip_size_in_bits);
+        history = ( history << 1U) | ( is_taken ? 1U : 0U);
     }
+public:
+    GlobalBP( const PerfConfig::BP& config, uint32 branch_ip_size_in_bits) try
+        : directions( config)
+        , btb( check_btb_lru( config.lru), config.size, config.ways, branch_ip_size_in_bits)
+    { }
     catch (const CacheTagArrayInvalidSizeException& e) {
         throw BPInvalidMode( e.what(), "");
     }
 
-    /* prediction */
-    bool is_taken( Addr PC) const final
+    BPInterface get_bp_info( Addr PC) const final
     {
-        // do not update LRU information on prediction,
-        // so "no_touch" version of "tags->read" is used:
-        const auto[ is_hit, way] = tags->read_no_touch( PC);
-        return is_hit && is_way_taken( way, PC, targets[ way][ tags->set(PC)]);
+        const auto* entry = btb.find( PC);
+        BPInterface info( PC, false, PC + 4, false);
+        if ( entry != nullptr) {
+            info.is_hit = true;
+            info.kind = entry->kind;
+            info.is_taken = !entry->kind.is_conditional || directions.is_taken( PC, history);
+            info.target = info.is_taken ? entry->target : PC + 4;
+        }
+        info.history = history;
+        return info;
     }
 
-    bool is_hit( Addr PC) const final
+    bool is_taken( Addr PC) const final { return get_bp_info( PC).is_taken; }
+    bool is_hit( Addr PC) const final { return get_bp_info( PC).is_hit; }
+    Addr get_target( Addr PC) const final { return get_bp_info( PC).target; }
+
+    BPInterface predict( Addr PC) final
     {
-        // do not update LRU information on this check,
-        // so "no_touch" version of "tags->read" is used:
-        return tags->read_no_touch( PC).first;
+        auto info = get_bp_info( PC);
+        if ( info.is_hit && info.kind.is_conditional)
+            shift_history( info.is_taken);
+        return info;
     }
 
-    Addr get_target( Addr PC) const final
+    void squash( const BPInterface& prediction) final
     {
-        // do not update LRU information on prediction,
-        // so "no_touch" version of "tags->read" is used:
-        const auto[ is_hit, way] = tags->read_no_touch( PC);
-
-        // return saved target only in case it is predicted taken
-        if ( is_hit && is_way_taken( way, PC, targets[ way][ tags->set(PC)]))
-            return targets[ way][ tags->set(PC)];
+        history = prediction.history;
+    }
 
-        return PC + 4;
+    void repair( const BPInterface& bp_upd) final
+    {
+        history = bp_upd.history;
+        if ( bp_upd.kind.is_conditional)
+            shift_history( bp_upd.is_taken);
     }
 
-    /* update */
     void update( const BPInterface& bp_upd) final
     {
-        const auto set = tags->set( bp_upd.pc);
-        auto[ is_hit, way] = tags->read( bp_upd.pc);
+        bool is_new = false;
+        auto& entry = btb.get_entry_for_update( bp_upd.pc, &is_new);
+        entry.target = bp_upd.target;
+        entry.kind = bp_upd.kind;
 
-        if ( !is_hit) { // miss
-            way = tags->write( bp_upd.pc); // add new entry to cache
-            auto& entry = directions[ way][ set];
-            entry.reset();
-        }
+        if ( bp_upd.kind.is_conditional)
+            directions.update( bp_upd.pc, bp_upd.history, bp_upd.is_taken);
+    }
+};
 
-        directions[ way][ set].update( bp_upd.is_taken);
-        targets[ way][ set] = bp_upd.target;
+/*
+ * Return address stack and indirect target predictor refine targets
+ * of any BP. They keep their own speculative state, checkpointed in
+ * each prediction and repaired as global history is.
+ */
+class TargetBP final: public BaseBP
+{
+    std::unique_ptr<BaseBP> bp;
+    ReturnAddressStack ras;
+    std::unique_ptr<ITTAGE> ittage;
+    uint64 history = 0; // directions of conditional branches and bits of indirect targets
+
+    static std::unique_ptr<ITTAGE> create_ittage( const PerfConfig::BP& config)
+    {
+        if ( config.indirect_mode == "ittage")
+            return std::make_unique<ITTAGE>( config);
+        if ( config.indirect_mode == "btb")
+            return nullptr;
+
+        throw BPInvalidMode( config.indirect_mode, "Supported indirect prediction modes: btb, ittage");
+    }
+
+    static bool is_indirect_non_return( const BranchKind& kind) { return kind.is_indirect && !kind.is_return; }
+
+    // Apply effect of the branch to the speculative state
+    void advance( const BPInterface& info)
+    {
+        if ( info.kind.is_conditional)
+            history = ( history << 1U) | ( info.is_taken ? 1U : 0U);
+        else if ( is_indirect_non_return( info.kind))
+            history = ( history << 2U) | ( ( info.target >> 2U) & 3U);
+
+        if ( !info.is_taken)
+            return;
+
+        if ( info.kind.is_return)
+            ras.pop();
+        if ( info.kind.is_call)
+            ras.push( info.pc + 4);
+    }
+
+    void restore( const BPInterface& checkpoint)
+    {
+        history = checkpoint.indirect_history;
+        ras.restore( checkpoint.ras_pointer, checkpoint.ras_top);
+    }
+public:
+    TargetBP( std::unique_ptr<BaseBP> bp, const PerfConfig::BP& config)
+        : bp( std::move( bp))
+        , ras( config.ras_size)
+        , ittage( create_ittage( config))
+    { }
+
+    BPInterface get_bp_info( Addr PC) const final
+    {
+        auto info = bp->get_bp_info( PC);
+        info.indirect_history = history;
+        info.ras_pointer = ras.get_pointer();
+        info.ras_top = ras.top();
+        if ( !info.is_hit || !info.is_taken)
+            return info;
+
+        const auto target = info.kind.is_return ? ras.top()
+                          : is_indirect_non_return( info.kind) && ittage != nullptr ? ittage->get_target( PC, history)
+                          : NO_VAL32;
+        if ( target != NO_VAL32)
+            info.target = target;
+
+        return info;
+    }
+
+    bool is_taken( Addr PC) const final { return get_bp_info( PC).is_taken; }
+    bool is_hit( Addr PC) const final { return get_bp_info( PC).is_hit; }
+    Addr get_target( Addr PC) const final { return get_bp_info( PC).target; }
+
+    BPInterface predict( Addr PC) final
+    {
+        // direction predictor shifts its own history, so the lookup goes first
+        const auto info = get_bp_info( PC);
+        auto prediction = bp->predict( PC);
+        prediction.target = info.target;
+        prediction.indirect_history = info.indirect_history;
+        prediction.ras_pointer = info.ras_pointer;
+        prediction.ras_top = info.ras_top;
+        if ( prediction.is_hit)
+            advance( prediction);
+
+        return prediction;
+    }
+
+    void squash( const BPInterface& prediction) final
+    {
+        bp->squash( prediction);
+        restore( prediction);
+    }
+
+    void repair( const BPInterface& bp_upd) final
+    {
+        bp->repair( bp_upd);
+        restore( bp_upd);
+        advance( bp_upd);
+    }
+
+    void update( const BPInterface& bp_upd) final
+    {
+        bp->update( bp_upd);
+        if ( ittage != nullptr && is_indirect_non_return( bp_upd.kind))
+            ittage->update( bp_upd.pc, bp_upd.indirect_history, bp_upd.target);
     }
 };
 
 class BPFactory {
     struct BaseBPCreator {
-        virtual std::unique_ptr<BaseBP> create( const std::string& lru, uint32 size_in_entries, uint32 ways,
-                                               uint32 branch_ip_size_in_bits) const = 0;
+        virtual std::unique_ptr<BaseBP> create( const PerfConfig::BP& config, uint32 branch_ip_size_in_bits) const = 0;
         BaseBPCreator() = default;
         virtual ~BaseBPCreator() = default;
         BaseBPCreator( const BaseBPCreator&) = delete;
@@ -109,15 +286,23 @@ class BPFactory {
 
     template<typename T>
     struct BPCreator : BaseBPCreator {
-        std::unique_ptr<BaseBP> create( const std::string& lru, uint32 size_in_entries, uint32 ways,
-                                       uint32 branch_ip_size_in_bits) const final
+        std::unique_ptr<BaseBP> create( const PerfConfig::BP& config, uint32 branch_ip_size_in_bits) const final
         {
-            return std::make_unique<BP<T>>( lru, size_in_entries,
-                                            ways, branch_ip_size_in_bits);
+            return std::make_unique<BP<T>>( config.lru, config.size,
+                                            config.ways, branch_ip_size_in_bits);
         }
         BPCreator() = default;
     };
 
+    template<typename T>
+    struct GlobalBPCreator : BaseBPCreator {
+        std::unique_ptr<BaseBP> create( const PerfConfig::BP& config, uint32 branch_ip_size_in_bits) const final
+        {
+            return std::make_unique<GlobalBP<T>>( config, branch_ip_size_in_bits);
+        }
+        GlobalBPCreator() = default;
+    };
+
     using Map = std::map<std::string, std::unique_ptr<BaseBPCreator>>;
     const Map map;
 
@@ -130,6 +315,9 @@ class BPFactory {
         my_map.emplace("saturating_one_bit", std::make_unique<BPCreator<BPEntryOneBit>>());
         my_map.emplace("saturating_two_bits", std::make_unique<BPCreator<BPEntryTwoBit>>());
         my_map.emplace("adaptive_two_levels", std::make_unique<BPCreator<BPEntryAdaptive<2>>>());
+        my_map.emplace("gshare", std::make_unique<GlobalBPCreator<GShare>>());
+        my_map.emplace("tage", std::make_unique<GlobalBPCreator<TAGE>>());
+        my_map.emplace("perceptron", std::make_unique<GlobalBPCreator<HashedPerceptron>>());
         return my_map;
     }
 
@@ -145,26 +333,33 @@ class BPFactory {
 public:
     BPFactory() : map( generate_map()) { }
 
-    auto create( const std::string& name, const std::string& lru,
-                 uint32 size_in_entries, uint32 ways,
-                 uint32 branch_ip_size_in_bits) const
+    auto create( const PerfConfig::BP& config, uint32 branch_ip_size_in_bits) const
     {
-        auto it = map.find( name);
+        auto it = map.find( config.mode);
         if ( it != map.end())
-            return it->second->create( lru, size_in_entries, ways, branch_ip_size_in_bits);
+            return it->second->create( config, branch_ip_size_in_bits);
 
-        throw BPInvalidMode( name, print_map());
+        throw BPInvalidMode( config.mode, print_map());
     }
 };
 
 std::unique_ptr<BaseBP> BaseBP::create_bp( const std::string& name, const std::string& lru, 
                                            uint32 size_in_entries, uint32 ways, uint32 branch_ip_size_in_bits)
 {
-    static const BPFactory factory;
-    return factory.create(name, lru, size_in_entries, ways, branch_ip_size_in_bits);
+    PerfConfig::BP config;
+    config.mode = name;
+    config.lru = lru;
+    config.size = size_in_entries;
+    config.ways = ways;
+    return create_bp( config, branch_ip_size_in_bits);
 }
 
-std::unique_ptr<BaseBP> BaseBP::create_configured_bp()
+std::unique_ptr<BaseBP> BaseBP::create_bp( const PerfConfig::BP& config, uint32 branch_ip_size_in_bits)
 {
-    return create_bp( config::bp_mode, config::bp_lru, config::bp_size, config::bp_ways, 32);
+    static const BPFactory factory;
+    auto bp = factory.create( config, branch_ip_size_in_bits);
+    if ( config.ras_size == 0 && config.indirect_mode == "btb")
+        return bp;
+
+    return std::make_unique<TargetBP>( std::move( bp), config);
 }
@@ -12,6 +12,7 @@
 // MIPT_MIPS modules
 #include <infra/exception.h>
 #include <infra/types.h>
+#include <modules/core/perf_config.h>
 
 #include <memory>
 #include <string>
@@ -40,7 +41,7 @@ public:
     virtual Addr get_target( Addr PC) const = 0;
     virtual void update( const BPInterface& bp_upd) = 0;
 
-    BPInterface get_bp_info( Addr PC) const
+    virtual BPInterface get_bp_info( Addr PC) const
     {
         if ( is_hit( PC))
             return BPInterface( PC, is_taken( PC), get_target( PC), true);
@@ -48,13 +49,22 @@ public:
         return BPInterface( PC, false, PC + 4, false);
     }
 
+    /*
+     * Predictors with global history shift the predicted direction into
+     * the history at fetch. The prediction carries the previous history,
+     * so it can be restored if the prediction is dropped or mispredicted.
+     */
+    virtual BPInterface predict( Addr PC) { return get_bp_info( PC); }
+    virtual void squash( const BPInterface& /* prediction */) { }
+    virtual void repair( const BPInterface& /* bp_upd */) { }
+
     virtual ~BaseBP() = default;
     BaseBP& operator=( const BaseBP&) = default;
     BaseBP& operator=( BaseBP&&) = default;
     
     static std::unique_ptr<BaseBP> create_bp(const std::string& name, const std::string& lru,
                 uint32 size_in_entries, uint32 ways, uint32 branch_ip_size_in_bits);
-    static std::unique_ptr<BaseBP> create_configured_bp();
+    static std::unique_ptr<BaseBP> create_bp( const PerfConfig::BP& config, uint32 branch_ip_size_in_bits);
 };
 
 #endif
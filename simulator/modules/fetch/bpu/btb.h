@@ -0,0 +1,58 @@
+/*
+ * btb.h - branch target buffer storage
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef BRANCH_TARGET_BUFFER
+#define BRANCH_TARGET_BUFFER
+
+#include <infra/cache/flat_tag_array.h>
+#include <infra/types.h>
+
+#include <string>
+#include <vector>
+
+/*
+ * Entries of all ways of a set are contiguous, so a prediction is
+ * a single probe of the set tags followed by a single entry read.
+ */
+template<typename Entry>
+class BTB
+{
+public:
+    BTB( const std::string& lru, uint32 size_in_entries, uint32 ways, uint32 branch_ip_size_in_bits)
+        // we're reusing existing tag array functionality,
+        // but here we don't split memory in blocks, storing
+        // IP's only, so hardcoding here the granularity of 4 bytes:
+        : tags( lru, size_in_entries, ways, 4, branch_ip_size_in_bits)
+        , entries( size_t{ tags.get_sets()} * ways)
+    { }
+
+    // Does not update LRU information, nullptr on miss
+    const Entry* find( Addr PC) const
+    {
+        const auto[ set, way] = tags.probe( PC);
+        return way < 0 ? nullptr : &entries[ get_index( set, way)];
+    }
+
+    // Touches the entry or allocates a new one for the PC
+    Entry& get_entry_for_update( Addr PC, bool* is_new)
+    {
+        auto[ set, way] = tags.probe( PC);
+        *is_new = way < 0;
+        if ( *is_new)
+            way = tags.write( PC);
+        else
+            tags.touch( set, way);
+
+        return entries[ get_index( set, way)];
+    }
+
+private:
+    size_t get_index( uint32 set, int32 way) const { return size_t{ set} * tags.get_ways() + narrow_cast<size_t>( way); }
+
+    FlatTagArray tags;
+    std::vector<Entry> entries;
+};
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ * ras.h - return address stack
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef RETURN_ADDRESS_STACK_H
+#define RETURN_ADDRESS_STACK_H
+
+#include <infra/types.h>
+
+#include <vector>
+
+/*
+ * Circular stack: overflow overwrites the oldest entries. Speculative
+ * calls and returns are undone by restoring the pointer and the top entry
+ * saved before them (Skadron et al., 1998). It does not repair entries
+ * below the top which were popped and then overwritten on the wrong path.
+ */
+class ReturnAddressStack
+{
+public:
+    explicit ReturnAddressStack( uint32 size) : stack( size, NO_VAL32) { }
+
+    // NO_VAL32 if stack is disabled or empty
+    Addr top() const { return stack.empty() ? NO_VAL32 : stack[ pointer]; }
+    uint32 get_pointer() const { return pointer; }
+
+    void push( Addr address)
+    {
+        if ( stack.empty())
+            return;
+
+        pointer = narrow_cast<uint32>( ( pointer + 1) % stack.size());
+        stack[ pointer] = address;
+    }
+
+    void pop()
+    {
+        if ( stack.empty())
+            return;
+
+        stack[ pointer] = NO_VAL32;
+        pointer = narrow_cast<uint32>( ( pointer + stack.size() - 1) % stack.size());
+    }
+
+    void restore( uint32 saved_pointer, Addr saved_top)
+    {
+        if ( stack.empty())
+            return;
+
+        pointer = saved_pointer;
+        stack[ pointer] = saved_top;
+    }
+
+private:
+    std::vector<Addr> stack;
+    uint32 pointer = 0;
+};
+
+#endif
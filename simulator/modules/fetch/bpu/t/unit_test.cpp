@@ -6,7 +6,9 @@
 
 #include <catch.hpp>
 #include <infra/replacement/cache_replacement.h>
+#include <modules/fetch/bpu/bpglobal.h>
 #include <modules/fetch/bpu/bpu.h>
+#include <modules/fetch/bpu/ras.h>
 
 #include <cassert>
 #include <cstdlib>
@@ -18,6 +20,8 @@ TEST_CASE( "Initialization: WrongParameters")
     CHECK_THROWS_AS( BaseBP::create_bp( "saturating_three_bits", "LRU", 128, 16, 32), BPInvalidMode);
     CHECK_THROWS_AS( BaseBP::create_bp( "saturating_two_bits", "URL", 128, 16, 32), CacheReplacementException);
     CHECK_THROWS_AS( BaseBP::create_bp( "saturating_two_bits", "LRU", 100, 20, 32), BPInvalidMode);
+    CHECK_THROWS_AS( BaseBP::create_bp( "saturating_two_bits", "always_hit", 128, 16, 32), BPInvalidMode);
+    CHECK_THROWS_AS( BaseBP::create_bp( "saturating_two_bits", "infinite", 128, 16, 32), BPInvalidMode);
 }
 
 static auto to_string( const BPInterface& info)
@@ -280,3 +284,231 @@ TEST_CASE( "Overload: LRU")
     CHECK( bp->is_taken(PCconst) );
     CHECK( bp->get_target(PCconst) == target);
 }
+
+static PerfConfig::BP get_global_bp_config( const std::string& mode)
+{
+    PerfConfig::BP config;
+    config.mode = mode;
+    config.table_size = 1024;
+    return config;
+}
+
+TEST_CASE( "Global history predictors: wrong parameters")
+{
+    auto config = get_global_bp_config( "gshare");
+    config.table_size = 1000;
+    CHECK_THROWS_AS( BaseBP::create_bp( config, 32), BPInvalidMode);
+
+    config = get_global_bp_config( "perceptron");
+    config.global_history = 65;
+    CHECK_THROWS_AS( BaseBP::create_bp( config, 32), BPInvalidMode);
+
+    config = get_global_bp_config( "tage");
+    config.tage_min_history = 32;
+    config.tage_max_history = 16;
+    CHECK_THROWS_AS( BaseBP::create_bp( config, 32), BPInvalidMode);
+
+    config = get_global_bp_config( "tage");
+    config.tage_tables = 0;
+    CHECK_THROWS_AS( BaseBP::create_bp( config, 32), BPInvalidMode);
+
+    config = get_global_bp_config( "tage");
+    config.ways = 20;
+    CHECK_THROWS_AS( BaseBP::create_bp( config, 32), BPInvalidMode);
+
+    config = get_global_bp_config( "gshare");
+    config.lru = "infinite";
+    CHECK_THROWS_AS( BaseBP::create_bp( config, 32), BPInvalidMode);
+}
+
+TEST_CASE( "TAGE: geometric history lengths")
+{
+    auto config = get_global_bp_config( "tage");
+    config.tage_tables = 5;
+    config.tage_min_history = 4;
+    config.tage_max_history = 64;
+    CHECK( TAGE( config).get_history_lengths() == std::vector<uint32>{ 4, 8, 16, 32, 64});
+}
+
+TEST_CASE( "Hashed perceptron: history segments")
+{
+    auto config = get_global_bp_config( "perceptron");
+    config.global_history = 20;
+    CHECK( HashedPerceptron( config).get_tables_num() == 4);
+}
+
+// Predict at fetch and update at branch resolution, repairing history on misprediction
+static uint32 run_branch_pattern( BaseBP* bp, Addr PC, Addr target, const std::vector<bool>& pattern, uint32 iterations)
+{
+    uint32 mispredictions = 0;
+    for ( uint32 i = 0; i < iterations; ++i) {
+        const bool is_taken = pattern[ i % pattern.size()];
+        const auto prediction = bp->predict( PC);
+
+        BPInterface bp_upd( PC, is_taken, target, true);
+        bp_upd.history = prediction.history;
+        bp->update( bp_upd);
+
+        if ( prediction.is_taken != is_taken) {
+            bp->repair( bp_upd);
+            ++mispredictions;
+        }
+    }
+    return mispredictions;
+}
+
+TEST_CASE( "Global history predictors: repeating pattern")
+{
+    const std::vector<bool> pattern = { true, true, false, true, false, false};
+    for ( const auto& mode : { "gshare", "tage", "perceptron"}) {
+        auto bp = BaseBP::create_bp( get_global_bp_config( mode), 32);
+        run_branch_pattern( bp.get(), 0x1000, 0x2000, pattern, 3000);
+        CHECK( run_branch_pattern( bp.get(), 0x1000, 0x2000, pattern, 600) == 0);
+    }
+}
+
+TEST_CASE( "Two bit predictor fails on repeating pattern")
+{
+    const std::vector<bool> pattern = { true, true, false, true, false, false};
+    auto bp = BaseBP::create_bp( "saturating_two_bits", "LRU", 128, 16, 32);
+    run_branch_pattern( bp.get(), 0x1000, 0x2000, pattern, 3000);
+    CHECK( run_branch_pattern( bp.get(), 0x1000, 0x2000, pattern, 600) != 0);
+}
+
+TEST_CASE( "Global history predictors: squash and repair of history")
+{
+    auto bp = BaseBP::create_bp( get_global_bp_config( "gshare"), 32);
+    const Addr PC = 0x1000;
+    bp->update( BPInterface( PC, true, 0x2000, true));
+
+    // Refetched instruction does not shift the history twice
+    const auto first = bp->predict( PC);
+    bp->squash( first);
+    const auto second = bp->predict( PC);
+    CHECK( second.history == first.history);
+    CHECK( bp->get_bp_info( PC).history == ( ( first.history << 1U) | ( first.is_taken ? 1U : 0U)));
+
+    // Misprediction replaces the predicted direction with the actual one
+    BPInterface bp_upd( PC, !second.is_taken, 0x2000, true);
+    bp_upd.history = second.history;
+    bp->repair( bp_upd);
+    CHECK( bp->get_bp_info( PC).history == ( ( second.history << 1U) | ( second.is_taken ? 0U : 1U)));
+}
+
+TEST_CASE( "Global history predictors: unconditional jumps")
+{
+    auto bp = BaseBP::create_bp( get_global_bp_config( "tage"), 32);
+    const Addr PC = 0x1000;
+    BPInterface bp_upd( PC, true, 0x3000, true);
+    bp_upd.kind.is_conditional = false;
+    bp->update( bp_upd);
+
+    const auto prediction = bp->predict( PC);
+    CHECK( prediction.is_taken);
+    CHECK( prediction.target == 0x3000);
+    CHECK( bp->get_bp_info( PC).history == prediction.history);
+}
+
+TEST_CASE( "Return address stack: overflow and repair")
+{
+    ReturnAddressStack ras( 2);
+    CHECK( ras.top() == NO_VAL32);
+
+    ras.push( 0x10);
+    ras.push( 0x20);
+    ras.push( 0x30);
+    CHECK( ras.top() == 0x30);
+    ras.pop();
+    CHECK( ras.top() == 0x20);
+
+    // Wrong path pops and pushes other address
+    const auto pointer = ras.get_pointer();
+    const auto top = ras.top();
+    ras.pop();
+    ras.push( 0x40);
+    ras.restore( pointer, top);
+    CHECK( ras.top() == 0x20);
+
+    CHECK( ReturnAddressStack( 0).top() == NO_VAL32);
+}
+
+static BPInterface get_jump_update( Addr PC, Addr target, const BPInterface& prediction, BranchKind kind)
+{
+    auto bp_upd = prediction;
+    bp_upd.pc = PC;
+    bp_upd.is_taken = true;
+    bp_upd.target = target;
+    bp_upd.is_hit = true;
+    bp_upd.kind = kind;
+    return bp_upd;
+}
+
+TEST_CASE( "Return address stack: returns to different call sites")
+{
+    auto config = get_global_bp_config( "saturating_two_bits");
+    config.ras_size = 8;
+    auto bp = BaseBP::create_bp( config, 32);
+
+    const BranchKind call{ false, true, false, false};
+    const BranchKind ret{ false, false, true, true};
+    const Addr function = 0x4000;
+    const Addr return_pc = 0x4010;
+
+    uint32 mispredictions = 0;
+    for ( uint32 i = 0; i < 100; ++i) {
+        const Addr call_pc = 0x1000 + ( i % 4) * 0x100;
+
+        const auto call_prediction = bp->predict( call_pc);
+        const auto call_upd = get_jump_update( call_pc, function, call_prediction, call);
+        bp->update( call_upd);
+        if ( !call_prediction.is_taken || call_prediction.target != function)
+            bp->repair( call_upd);
+
+        const auto prediction = bp->predict( return_pc);
+        const auto ret_upd = get_jump_update( return_pc, call_pc + 4, prediction, ret);
+        bp->update( ret_upd);
+        if ( !prediction.is_taken || prediction.target != call_pc + 4) {
+            bp->repair( ret_upd);
+            ++mispredictions;
+        }
+    }
+
+    // The first return is not in BTB yet
+    CHECK( mispredictions == 1);
+}
+
+TEST_CASE( "ITTAGE: target correlated with branch history")
+{
+    auto config = get_global_bp_config( "tage");
+    config.indirect_mode = "ittage";
+    auto bp = BaseBP::create_bp( config, 32);
+
+    const BranchKind indirect{ false, false, false, true};
+    const Addr branch_pc = 0x1000;
+    const Addr jump_pc = 0x1100;
+
+    const auto run = [&]( uint32 iterations) {
+        uint32 mispredictions = 0;
+        for ( uint32 i = 0; i < iterations; ++i) {
+            // Switch case is selected by the preceding condition
+            const bool is_taken = i % 3 == 0;
+            run_branch_pattern( bp.get(), branch_pc, 0x2000, { is_taken}, 1);
+
+            const Addr target = is_taken ? 0x3000 : 0x3100;
+            const auto prediction = bp->predict( jump_pc);
+            const auto bp_upd = get_jump_update( jump_pc, target, prediction, indirect);
+            bp->update( bp_upd);
+            if ( prediction.target != target) {
+                bp->repair( bp_upd);
+                ++mispredictions;
+            }
+        }
+        return mispredictions;
+    };
+
+    run( 300);
+    CHECK( run( 300) == 0);
+
+    config.indirect_mode = "last-target";
+    CHECK_THROWS_AS( BaseBP::create_bp( config, 32), BPInvalidMode);
+}
@@ -0,0 +1,98 @@
+/*
+ * branch_oracle.cpp - perfect branch prediction for limit studies
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include "branch_oracle.h"
+
+#include <func_sim/func_sim.h>
+#include <infra/exception.h>
+#include <kernel/kernel.h>
+#include <memory/memory.h>
+
+template <typename ISA>
+FuncSimOracle<ISA>::FuncSimOracle( std::endian endian, Kernel* kernel, std::string_view isa)
+    : sim( std::make_shared<FuncSim<ISA>>( endian, false, isa))
+{
+    auto memory = FuncMemory::create_default_hierarchied_memory();
+    sim->set_memory( memory);
+    kernel->add_replica_simulator( sim);
+    kernel->add_replica_memory( memory);
+}
+
+template <typename ISA>
+bool FuncSimOracle<ISA>::step()
+{
+    if ( is_waiting)
+        return false;
+
+    try {
+        const auto instr = sim->step();
+        outcomes.push_back( { instr.get_PC(), instr.is_taken(), instr.get_new_PC()});
+
+        /* kernel handles system calls at writeback and updates the replica itself */
+        if ( instr.has_trap())
+        {
+            if ( instr.trap_type() != Trap::SYSCALL)
+                sim->driver_step( instr);
+            is_waiting = true;
+        }
+    }
+    catch ( const Exception&) {
+        /* fetch runs past the end of the program until writeback halts the simulation */
+        is_waiting = true;
+        return false;
+    }
+    return true;
+}
+
+template <typename ISA>
+bool FuncSimOracle<ISA>::predict( const Target& pc, BPInterface* prediction)
+{
+    if ( pc.sequence_id < first_id)
+        return false;
+
+    while ( pc.sequence_id - first_id >= outcomes.size())
+        if ( !step())
+            return false;
+
+    const auto& outcome = outcomes.at( pc.sequence_id - first_id);
+    if ( outcome.pc != pc.address)
+        return false;
+
+    prediction->is_taken = outcome.is_taken;
+    prediction->target = outcome.target;
+    prediction->is_hit = true;
+    return true;
+}
+
+template <typename ISA>
+void FuncSimOracle<ISA>::redirect( const Target& target)
+{
+    sim->set_target( target);
+    outcomes.clear();
+    first_id = target.sequence_id;
+    is_waiting = false;
+}
+
+template <typename ISA>
+void FuncSimOracle<ISA>::retire( uint64 id)
+{
+    for ( ; !outcomes.empty() && first_id <= id; ++first_id)
+        outcomes.pop_front();
+}
+
+#include <mips/mips.h>
+#include <risc_v/risc_v.h>
+
+template class FuncSimOracle<MIPSI>;
+template class FuncSimOracle<MIPSII>;
+template class FuncSimOracle<MIPSIII>;
+template class FuncSimOracle<MIPSIV>;
+template class FuncSimOracle<MIPS32>;
+template class FuncSimOracle<MIPS64>;
+template class FuncSimOracle<MARS>;
+template class FuncSimOracle<MARS64>;
+template class FuncSimOracle<RISCV32>;
+template class FuncSimOracle<RISCV64>;
+template class FuncSimOracle<RISCV128>;
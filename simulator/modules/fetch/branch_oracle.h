@@ -0,0 +1,72 @@
+/*
+ * branch_oracle.h - perfect branch prediction for limit studies
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef BRANCH_ORACLE_H
+#define BRANCH_ORACLE_H
+
+#include "bpu/bp_interface.h"
+
+#include <infra/target.h>
+#include <infra/types.h>
+
+#include <bit>
+#include <deque>
+#include <memory>
+#include <string_view>
+
+class Kernel;
+
+template <typename ISA>
+class FuncSim;
+
+// Knows actual outcomes of instructions on the path executed by the program
+class BranchOracle
+{
+public:
+    BranchOracle() = default;
+    virtual ~BranchOracle() = default;
+    BranchOracle( const BranchOracle&) = delete;
+    BranchOracle( BranchOracle&&) = delete;
+    BranchOracle& operator=( const BranchOracle&) = delete;
+    BranchOracle& operator=( BranchOracle&&) = delete;
+
+    // Fills direction and target of the instruction, returns false if it is off the executed path
+    virtual bool predict( const Target& pc, BPInterface* prediction) = 0;
+
+    // Writeback has redirected the thread, e.g. to a trap handler
+    virtual void redirect( const Target& target) = 0;
+
+    // Instructions up to the given one are retired and are not fetched again
+    virtual void retire( uint64 id) = 0;
+};
+
+// Functional simulator runs ahead of fetch over a replica of the program state, like a checker.
+// It stops after a trap until writeback redirects the thread, as kernel changes the state at writeback.
+template <typename ISA>
+class FuncSimOracle final : public BranchOracle
+{
+public:
+    FuncSimOracle( std::endian endian, Kernel* kernel, std::string_view isa);
+    bool predict( const Target& pc, BPInterface* prediction) final;
+    void redirect( const Target& target) final;
+    void retire( uint64 id) final;
+
+private:
+    struct Outcome
+    {
+        Addr pc = 0;
+        bool is_taken = false;
+        Addr target = 0;
+    };
+
+    bool step();
+
+    std::shared_ptr<FuncSim<ISA>> sim;
+    std::deque<Outcome> outcomes; // of executed instructions which are not retired yet
+    uint64 first_id = 0;          // sequence id of the first outcome
+    bool is_waiting = false;      // for writeback to redirect the thread after a trap
+};
+
+#endif // BRANCH_ORACLE_H
@@ -3,64 +3,128 @@
  * Copyright 2015-2018 MIPT-MIPS
  */
 
-#include <infra/config/config.h>
-
 #include "fetch.h"
 
-namespace config {
-    /* Cache parameters */
-    static const Value<std::string> instruction_cache_type = { "icache-type", "LRU", "Type of instruction level 1 cache (in bytes)"};
-    static const Value<uint32> instruction_cache_size = { "icache-size", 2048, "Size of instruction level 1 cache (in bytes)"};
-    static const Value<uint32> instruction_cache_ways = { "icache-ways", 4, "Amount of ways in instruction level 1 cache"};
-    static const Value<uint32> instruction_cache_line_size = { "icache-line-size", 64, "Line size of instruction level 1 cache (in bytes)"};
-    /* Prefetch parameters */
-    static const Value<uint32> fetchahead_distance = { "fetchahead-size", 32, "Fetchahead distance size"};
-    static const Value<std::string> prefetch_method = { "prefetch-method", "wrong-path", "Type of a Instruction prefetching method"};
-} // namespace config
+#include <algorithm>
+#include <string>
 
 template <typename FuncInstr>
-Fetch<FuncInstr>::Fetch( Module* parent) : Module( parent, "fetch")
+Fetch<FuncInstr>::Fetch( Module* parent, const PerfConfig& config) : Module( parent, "fetch")
+    , memories( config.smt.threads)
+    , oracles( config.smt.threads)
+    , width( config.pipeline.width)
+    , fetch_block_size( config.icache.line_size)
+    , policy( config.smt.fetch_policy, config.smt.threads)
+    , oldest_ids( config.smt.threads)
+    , redirects( config.smt.threads)
 {
-    wp_datapath = make_write_port<Instr>("FETCH_2_DECODE", Port::BW);
+    wp_datapath = make_write_port<Instr>("FETCH_2_DECODE", width);
     rp_stall = make_read_port<bool>("DECODE_2_FETCH_STALL", Port::LATENCY);
 
     rp_flush_target = make_read_port<Target>("BRANCH_2_FETCH_TARGET", Port::LATENCY);
 
-    wp_target = make_write_port<Target>("TARGET", Port::BW);
-    rp_target = make_read_port<Target>("TARGET", Port::LATENCY);
+    /* each hardware thread has its own PC */
+    for ( size_t i = 0; i < config.smt.threads; ++i)
+    {
+        wp_targets.emplace_back( make_write_port<Target>("TARGET_" + std::to_string( i), Port::BW));
+        rp_targets.emplace_back( make_read_port<Target>("TARGET_" + std::to_string( i), Port::LATENCY));
+        oldest_ids.at( i) = Target::get_first_sequence_id( i);
+    }
 
     wp_hold_pc = make_write_port<Target>("HOLD_PC", Port::BW);
     rp_hold_pc = make_read_port<Target>("HOLD_PC", Port::LATENCY);
 
     rp_external_target = make_read_port<Target>("WRITEBACK_2_FETCH_TARGET", Port::LATENCY);
+    rp_retired = make_read_port<InstructionOutput>("WRITEBACK_2_EXECUTE_BYPASS", Port::LATENCY);
 
     rp_bp_update = make_read_port<BPInterface>("BRANCH_2_FETCH", Port::LATENCY);
 
-    wp_long_latency_pc_holder = make_write_port<Target>("LONG_LATENCY_PC_HOLDER", Port::BW);
-    rp_long_latency_pc_holder = make_read_port<Target>("LONG_LATENCY_PC_HOLDER", Port::LONG_LATENCY);
-
     wp_hit_or_miss = make_write_port<bool>("HIT_OR_MISS", Port::BW);
     rp_hit_or_miss = make_read_port<bool>("HIT_OR_MISS", Port::LATENCY);
+    wp_icache_miss = make_write_port<Target>("FETCH_2_CORE_ICACHE_MISS", Port::BW);
 
     /* port needed for handling misprediction at decode stage */
     rp_bp_update_from_decode = make_read_port<BPInterface>("DECODE_2_FETCH", Port::LATENCY);
     rp_flush_target_from_decode = make_read_port<Target>("DECODE_2_FETCH_TARGET", Port::LATENCY);
 
-    bp = BaseBP::create_configured_bp();
+    bp = BaseBP::create_bp( config.bp, 32);
+    const auto icache = config.get_icache();
     tags = CacheTagArray::create(
-        config::instruction_cache_type,
-        config::instruction_cache_size,
-        config::instruction_cache_ways,
-        config::instruction_cache_line_size,
+        icache.type,
+        icache.size,
+        icache.ways,
+        icache.line_size,
         32
     );
+    prefetcher = InstrPrefetcher::create( config.prefetch, config.icache.line_size, bp.get());
+    if ( config.prefetch.method == "fdip" && config.smt.threads > 1)
+        throw PrefetchMethodException( "fetch target queue keeps predictions of a single hardware thread");
+}
 
-    _fetchahead_size = config::fetchahead_distance;
-    _prefetch_method = config::prefetch_method;
+template <typename FuncInstr>
+Target Fetch<FuncInstr>::read_target( size_t thread, Cycle cycle)
+{
+    auto* port = rp_targets.at( thread);
+    return port->is_ready( cycle) ? port->read( cycle) : Target();
+}
+
+template <typename FuncInstr>
+void Fetch<FuncInstr>::read_redirects( Cycle cycle)
+{
+    std::fill( redirects.begin(), redirects.end(), Target());
+    decode_redirect_thread = FetchPolicy::NO_THREAD;
 
-    if ( _prefetch_method != "next-line" && _prefetch_method != "wrong-path" && _prefetch_method != "no-prefetch")
-        throw PrefetchMethodException("\"" + _prefetch_method +
-            "\" prefetch method is not defined, supported methods are:\nnext-line\nwrong-path\nno-prefetch\n");
+    /* writeback redirects are caused by older instructions than branch ones, and branch ones than decode ones */
+    while ( rp_external_target->is_ready( cycle))
+    {
+        const auto target = rp_external_target->read( cycle);
+        redirects.at( target.get_thread()) = target;
+        oldest_ids.at( target.get_thread()) = target.sequence_id;
+        if ( oracles.at( target.get_thread()) != nullptr)
+            oracles.at( target.get_thread())->redirect( target);
+    }
+
+    if ( rp_flush_target->is_ready( cycle))
+    {
+        const auto target = rp_flush_target->read( cycle);
+        if ( !redirects.at( target.get_thread()).valid)
+            redirects.at( target.get_thread()) = target;
+    }
+
+    if ( rp_flush_target_from_decode->is_ready( cycle))
+    {
+        const auto target = rp_flush_target_from_decode->read( cycle);
+        if ( !redirects.at( target.get_thread()).valid)
+        {
+            redirects.at( target.get_thread()) = target;
+            decode_redirect_thread = target.get_thread();
+        }
+    }
+}
+
+template <typename FuncInstr>
+void Fetch<FuncInstr>::read_retired( Cycle cycle)
+{
+    while ( rp_retired->is_ready( cycle))
+    {
+        const auto id = rp_retired->read( cycle).producer_id;
+        oldest_ids.at( Target::get_thread( id)) = id + 1;
+        if ( oracles.at( Target::get_thread( id)) != nullptr)
+            oracles.at( Target::get_thread( id))->retire( id);
+    }
+}
+
+template <typename FuncInstr>
+std::vector<uint64> Fetch<FuncInstr>::get_in_flight( const std::vector<Target>& targets) const
+{
+    std::vector<uint64> result;
+    for ( size_t thread = 0; thread < targets.size(); ++thread)
+    {
+        const auto next_id = targets.at( thread).sequence_id;
+        const auto oldest_id = oldest_ids.at( thread);
+        result.emplace_back( targets.at( thread).valid && next_id > oldest_id ? next_id - oldest_id : 0);
+    }
+    return result;
 }
 
 template <typename FuncInstr>
@@ -70,83 +134,143 @@ Target Fetch<FuncInstr>::get_target( Cycle cycle)
     const bool is_stall = rp_stall->is_ready( cycle) && rp_stall->read( cycle);
 
     /* Receive all possible PC */
-    const Target external_target = rp_external_target->is_ready( cycle) ? rp_external_target->read( cycle) : Target();
-    const Target hold_target     = rp_hold_pc->is_ready( cycle) ? rp_hold_pc->read( cycle) : Target();
-    const Target flushed_target  = rp_flush_target->is_ready( cycle) ? rp_flush_target->read( cycle) : Target();
-    const Target flushed_target_from_decode = rp_flush_target_from_decode->is_ready( cycle) ?
-                                                                rp_flush_target_from_decode->read( cycle) : Target();
-    const Target branch_target   = rp_target->is_ready( cycle) ? rp_target->read( cycle) : Target();
-
-    if ( _prefetch_method == "wrong-path")
-        is_wrong_path = false;
+    const Target hold_target = rp_hold_pc->is_ready( cycle) ? rp_hold_pc->read( cycle) : Target();
+    read_redirects( cycle);
 
-    /* Multiplexing */
-    if ( external_target.valid)
-        return external_target;
+    is_decode_redirect = false;
+    is_hold = false;
 
-    if ( flushed_target.valid)
-        return flushed_target;
+    if ( decode_redirect_thread != FetchPolicy::NO_THREAD)
+    {
+        prefetcher->on_decode_redirect( redirects.at( decode_redirect_thread).address, &prefetch_lines);
+        prefetch_lines_if_missing( cycle);
+    }
 
-    if ( flushed_target_from_decode.valid)
+    /* Multiplexing, the group dropped by stalled decode is fetched again */
+    std::vector<Target> targets;
+    std::vector<bool> is_ready;
+    auto held_thread = FetchPolicy::NO_THREAD;
+    for ( size_t thread = 0; thread < rp_targets.size(); ++thread)
     {
-        if ( _prefetch_method == "wrong-path") // prefetch wrong path if prefetch enabled and defined
+        const Target branch_target = read_target( thread, cycle);
+        const bool has_hold = hold_target.valid && hold_target.get_thread() == thread;
+
+        if ( redirects.at( thread).valid)
         {
-            is_wrong_path = true;
-            if ( !tags->lookup( flushed_target_from_decode.address))
-                tags->write( flushed_target_from_decode.address);
+            targets.emplace_back( redirects.at( thread));
         }
-        return flushed_target_from_decode;
+        else if ( !( is_stall && has_hold) && branch_target.valid)
+        {
+            targets.emplace_back( branch_target);
+        }
+        else if ( has_hold)
+        {
+            targets.emplace_back( hold_target);
+            held_thread = thread;
+        }
+        else
+        {
+            targets.emplace_back( Target());
+        }
+        is_ready.push_back( targets.back().valid);
     }
 
-    if ( !is_stall && branch_target.valid)
-        return branch_target;
+    /* held group goes first, as its younger instructions have not been fetched */
+    const auto thread = held_thread != FetchPolicy::NO_THREAD ? held_thread : policy.select( is_ready, get_in_flight( targets));
 
-    if ( hold_target.valid)
-        return hold_target;
+    /* the other threads keep their PC */
+    for ( size_t i = 0; i < targets.size(); ++i)
+        if ( i != thread && targets.at( i).valid)
+            wp_targets.at( i)->write( targets.at( i), cycle);
 
-    return Target();
+    if ( thread == FetchPolicy::NO_THREAD)
+        return Target();
+
+    is_decode_redirect = thread == decode_redirect_thread;
+    is_hold = thread == held_thread;
+    return targets.at( thread);
 }
 
 template <typename FuncInstr>
 void Fetch<FuncInstr>::clock_bp( Cycle cycle)
 {
     /* Process BP updates */
-    if ( rp_bp_update->is_ready( cycle))
-        bp->update( rp_bp_update->read( cycle));
-    if ( rp_bp_update_from_decode->is_ready( cycle))
-        bp->update( rp_bp_update_from_decode->read(cycle));
+    const bool has_update = rp_bp_update->is_ready( cycle);
+    const auto update = has_update ? rp_bp_update->read( cycle) : BPInterface();
+    if ( has_update)
+        bp->update( update);
+
+    const bool has_update_from_decode = rp_bp_update_from_decode->is_ready( cycle);
+    const auto update_from_decode = has_update_from_decode ? rp_bp_update_from_decode->read( cycle) : BPInterface();
+    if ( has_update_from_decode)
+        bp->update( update_from_decode);
+
+    /* Repair global history, misprediction at branch is older than one at decode */
+    if ( has_update_from_decode)
+        bp->repair( update_from_decode);
+    if ( has_update && rp_flush_target->is_ready( cycle))
+        bp->repair( update);
+
+    /* predictions made ahead of fetch are dropped, writeback flushes are not caused by branches */
+    if ( rp_external_target->is_ready( cycle))
+        prefetcher->on_flush( false);
+    else if ( rp_flush_target->is_ready( cycle) || rp_flush_target_from_decode->is_ready( cycle))
+        prefetcher->on_flush( true);
 }
 
 template <typename FuncInstr>
 void Fetch<FuncInstr>::clock_instr_cache( Cycle cycle)
 {
-    if ( rp_long_latency_pc_holder->is_ready( cycle))
+    if ( miss_ready <= cycle)
     {
-        /* get PC from long-latency port if it's possible */
-        auto target = rp_long_latency_pc_holder->read( cycle);
-
         /* write new PC to tags array */
-        tags->write( target.address);
+        tags->write( miss_target.address);
 
         /* save PC to the next stage */
-        wp_hold_pc->write( target, cycle);
+        wp_hold_pc->write( miss_target, cycle);
         return;
     }
     wp_hit_or_miss->write( false, cycle);
 }
 
+template <typename FuncInstr>
+Latency Fetch<FuncInstr>::get_miss_latency( Addr addr, Cycle cycle)
+{
+    if ( hierarchy == nullptr)
+        return Port::LONG_LATENCY;
+
+    return hierarchy->read( addr, hierarchy->get_time( cycle));
+}
+
+template <typename FuncInstr>
+void Fetch<FuncInstr>::prefetch_lines_if_missing( Cycle cycle)
+{
+    for ( const auto addr : prefetch_lines)
+    {
+        if ( tags->lookup( addr))
+            continue;
+
+        tags->write( addr);
+        ++icache_prefetches;
+
+        /* prefetches occupy lower levels, but the pipeline does not wait for them */
+        if ( hierarchy != nullptr)
+            hierarchy->read( addr, hierarchy->get_time( cycle));
+    }
+    prefetch_lines.clear();
+}
+
 template <typename FuncInstr>
 void Fetch<FuncInstr>::save_flush( Cycle cycle)
 {
-    /* save PC in the case of flush signal */
-    if( rp_flush_target->is_ready( cycle))
-        wp_target->write( rp_flush_target->read( cycle), cycle);
-    else if( rp_flush_target_from_decode->is_ready( cycle))
-        wp_target->write( rp_flush_target_from_decode->read( cycle), cycle);
-    else if( rp_target->is_ready( cycle))
-        wp_target->write( rp_target->read( cycle), cycle);
-    else if( rp_external_target->is_ready( cycle))
-        wp_target->write( rp_external_target->read( cycle), cycle);
+    /* save PC in the case of flush signal, priorities are the same as in get_target */
+    read_redirects( cycle);
+    for ( size_t thread = 0; thread < rp_targets.size(); ++thread)
+    {
+        const auto target = redirects.at( thread).valid ? redirects.at( thread) : read_target( thread, cycle);
+        if ( target.valid)
+            wp_targets.at( thread)->write( target, cycle);
+    }
 }
 
 template <typename FuncInstr>
@@ -167,68 +291,114 @@ Target Fetch<FuncInstr>::get_cached_target( Cycle cycle)
     if ( !target.valid)
         return Target();
 
+    prefetcher->on_fetch_request( target.address, is_hold);
+
     /* hit or miss */
     auto is_hit = tags->lookup( target.address);
 
     if ( is_hit)
         return target;
 
+    ++icache_misses;
+    wp_icache_miss->write( target, cycle);
+
     /* send miss to the next cycle */
     wp_hit_or_miss->write( is_hit, cycle);
 
     /* send PC to cache*/
-    wp_long_latency_pc_holder->write( target, cycle);
+    miss_target = target;
+    miss_ready = cycle + get_miss_latency( target.address, cycle);
     return Target();
 }
 
 
+template <typename FuncInstr>
+BPInterface Fetch<FuncInstr>::predict( const Target& pc)
+{
+    /* decoupled front end predicts ahead of fetch, otherwise BP predicts now */
+    BPInterface prediction;
+    is_predicted_ahead = prefetcher->get_prediction( pc.address, &prediction);
+    if ( !is_predicted_ahead)
+        prediction = bp->predict( pc.address);
+
+    /* BP keeps its speculative history, oracle corrects only direction and target */
+    const auto& oracle = oracles.at( pc.get_thread());
+    if ( oracle != nullptr)
+        oracle->predict( pc, &prediction);
+
+    return prediction;
+}
+
+template <typename FuncInstr>
+void Fetch<FuncInstr>::fetch_block( const Target& target, Cycle cycle)
+{
+    auto pc = target;
+    for ( uint32 fetched = 1; ; ++fetched)
+    {
+        auto bp_info = predict( pc);
+        if ( fetched == 1)
+        {
+            last_prediction = bp_info;
+            last_prediction_id = pc.sequence_id;
+        }
+
+        Instr instr( memories.at( target.get_thread())->fetch_instr( pc.address), bp_info);
+        instr.set_sequence_id( pc.sequence_id);
+        pc = instr.get_predicted_target();
+
+        /* log */
+        sout << "fetch   cycle " << std::dec << cycle << ": " << instr << " " << bp_info << std::endl;
+
+        /* only one jump is allowed in a group, and taken jumps leave the fetch block */
+        const bool is_last = fetched == width
+            || instr.is_jump()
+            || pc.address / fetch_block_size != target.address / fetch_block_size;
+
+        /* sending to decode */
+        wp_datapath->write( std::move( instr), cycle);
+
+        if ( is_last)
+        {
+            fetched_instrs.add( fetched);
+            break;
+        }
+    }
+
+    /* set next target according to prediction */
+    wp_targets.at( target.get_thread())->write( pc, cycle);
+}
+
 template <typename FuncInstr>
 void Fetch<FuncInstr>::clock( Cycle cycle)
 {
     clock_bp( cycle);
+    read_retired( cycle);
+
+    /* decoupled prefetchers run ahead even if fetch waits for a miss */
+    prefetcher->on_cycle( &prefetch_lines);
+    prefetch_lines_if_missing( cycle);
 
     /* getting PC */
     auto target = get_cached_target( cycle);
 
     /* push bubble */
     if ( !target.valid)
+    {
+        fetched_instrs.add( 0);
         return;
+    }
 
     /* hold PC for the stall case */
     wp_hold_pc->write( target, cycle);
 
-    auto bp_info = bp->get_bp_info( target.address);
-    Instr instr( memory->fetch_instr( target.address), bp_info);
-    instr.set_sequence_id( target.sequence_id);
-
-    /* set next target according to prediction */
-    wp_target->write( instr.get_predicted_target(), cycle);
-
-    /* log */
-    sout << "fetch   cycle " << std::dec << cycle << ": " << instr << " " << bp_info << std::endl;
-
-    /* sending to decode */
-    wp_datapath->write( std::move( instr), cycle);
-
-    if ( _prefetch_method != "no-prefetch" && !is_wrong_path)  // prefetch next line if enabled and wrong path isn't used
-        prefetch_next_line( target.address);
-}
-
-template<typename FuncInstr>
-void Fetch<FuncInstr>::prefetch_next_line( Addr requested_addr)
-{
-    uint32 line_size( config::instruction_cache_line_size); // line size
-    size_t line_bits = std::countr_zero( line_size); // number of offset bits
-
-    Addr addr_mask = bitmask<Addr>( line_bits); // bit mask to extract the offset value
-    Addr offset = requested_addr & addr_mask; // offset
+    /* group held by stall is fetched again, its previous predictions are dropped */
+    if ( is_hold && target.sequence_id == last_prediction_id && !is_predicted_ahead)
+        bp->squash( last_prediction);
 
-    Addr next_line_addr = requested_addr + line_size; // the address that will be on the next line
-    uint32 fetchahead_distance = _fetchahead_size; // setting the fetchahead
+    fetch_block( target, cycle);
 
-   /* if the fetchahead is reached and there is no line in the cache, write the line to the cache */
-   if ( offset >= (line_size - fetchahead_distance) && !tags->lookup( next_line_addr))
-       tags->write( next_line_addr);
+    prefetcher->on_fetch( target.address, is_decode_redirect, &prefetch_lines);
+    prefetch_lines_if_missing( cycle);
 }
 
 #include <mips/mips.h>
@@ -6,30 +6,63 @@
 #ifndef FETCH_H
 #define FETCH_H
 
+#include "branch_oracle.h"
 #include "bpu/bpu.h"
+#include "fetch_policy.h"
+#include "instr_prefetcher.h"
 
 #include <func_sim/instr_memory.h>
 #include <infra/cache/cache_tag_array.h>
+#include <modules/core/perf_config.h>
 #include <modules/core/perf_instr.h>
+#include <modules/core/width_histogram.h>
+#include <modules/mem/memory_hierarchy.h>
 #include <modules/ports_instance.h>
+
+#include <vector>
  
 template <typename FuncInstr>
 class Fetch : public Module
 {
     using Instr = PerfInstr<FuncInstr>;
+    using InstructionOutput = BypassedData<typename FuncInstr::RegisterUInt>;
 
 public:
-    explicit Fetch( Module* parent);
+    Fetch( Module* parent, const PerfConfig& config);
     void clock( Cycle cycle);
-    void set_memory( std::unique_ptr<InstrMemoryIface<FuncInstr>> mem)
+    void set_memory( std::unique_ptr<InstrMemoryIface<FuncInstr>> mem, size_t thread = 0)
     {
-        memory = std::move( mem);
+        memories.at( thread) = std::move( mem);
     }
+    void set_memory_hierarchy( std::shared_ptr<MemoryHierarchy> value) { hierarchy = std::move( value); }
+    void set_oracle( std::unique_ptr<BranchOracle> value, size_t thread = 0) { oracles.at( thread) = std::move( value); }
+    uint64 get_icache_misses() const { return icache_misses; }
+    uint64 get_icache_prefetches() const { return icache_prefetches; }
+    const auto& get_width_statistics() const { return fetched_instrs; }
 
 private:
-    std::unique_ptr<InstrMemoryIface<FuncInstr>> memory = nullptr;
+    // hardware threads have their own address spaces
+    std::vector<std::unique_ptr<InstrMemoryIface<FuncInstr>>> memories;
     std::unique_ptr<BaseBP> bp = nullptr;
+    std::vector<std::unique_ptr<BranchOracle>> oracles; // override predictions of BP if set
     std::unique_ptr<CacheTagArray> tags = nullptr;
+    std::shared_ptr<MemoryHierarchy> hierarchy = nullptr;
+    std::unique_ptr<InstrPrefetcher> prefetcher = nullptr;
+    std::vector<Addr> prefetch_lines;
+
+    /* Instructions of one cycle are fetched from the same instruction cache line */
+    const uint32 width;
+    const uint32 fetch_block_size;
+
+    /* Hardware thread fetched in each cycle */
+    FetchPolicy policy;
+    std::vector<uint64> oldest_ids; // instructions of a thread from the oldest one are in flight
+    std::vector<Target> redirects;  // received in this cycle, the oldest one for each thread
+    size_t decode_redirect_thread = FetchPolicy::NO_THREAD;
+
+    /* Instruction cache miss being served */
+    Target miss_target;
+    Cycle miss_ready = 0_cl;
     
     /* Input signals */
     ReadPort<bool>* rp_stall = nullptr;
@@ -43,37 +76,43 @@ private:
     ReadPort<Target>* rp_flush_target = nullptr;
     ReadPort<Target>* rp_external_target = nullptr;
     ReadPort<Target>* rp_hold_pc = nullptr;
-    ReadPort<Target>* rp_target = nullptr;
-    ReadPort<Target>* rp_long_latency_pc_holder = nullptr;
+    std::vector<ReadPort<Target>*> rp_targets;
+    ReadPort<InstructionOutput>* rp_retired = nullptr;
 
     /* Outputs */
     WritePort<Instr>* wp_datapath = nullptr;
     WritePort<Target>* wp_hold_pc = nullptr;
-    WritePort<Target>* wp_target = nullptr;
-    WritePort<Target>* wp_long_latency_pc_holder = nullptr;
+    std::vector<WritePort<Target>*> wp_targets;
     WritePort<bool>* wp_hit_or_miss = nullptr;
+    WritePort<Target>* wp_icache_miss = nullptr; // for CPI stack of the core
 
     /* port needed for handling misprediction at decode stage */
     ReadPort<Target>* rp_flush_target_from_decode = nullptr;
 
     Target get_target( Cycle cycle);
+    Target read_target( size_t thread, Cycle cycle);
+    void read_redirects( Cycle cycle);
+    void read_retired( Cycle cycle);
+    std::vector<uint64> get_in_flight( const std::vector<Target>& targets) const;
     Target get_cached_target( Cycle cycle);
     void clock_bp( Cycle cycle);
     void clock_instr_cache( Cycle cycle);
     void save_flush( Cycle cycle);
+    Latency get_miss_latency( Addr addr, Cycle cycle);
+    void prefetch_lines_if_missing( Cycle cycle);
+    void fetch_block( const Target& target, Cycle cycle);
+    BPInterface predict( const Target& pc);
 
-    uint32 _fetchahead_size; // value of fetchahead distance size
-    std::string _prefetch_method; // value of prefetch method
+    bool is_decode_redirect = false;
+    bool is_hold = false;
 
-    bool is_wrong_path = false;
-    void prefetch_next_line(Addr requested_addr);
-};
-
-struct PrefetchMethodException final : Exception
-{
-    explicit PrefetchMethodException( const std::string& msg)
-            : Exception( "Invalid prefetch method name", msg)
-    { }
+    /* First prediction of the latest group to restore BP history if it is fetched again */
+    BPInterface last_prediction;
+    uint64 last_prediction_id = NO_VAL64;
+    bool is_predicted_ahead = false; // predictions of the latest group are taken from the prefetcher
+    uint64 icache_misses = 0;
+    uint64 icache_prefetches = 0;
+    WidthHistogram fetched_instrs;
 };
 
 #endif
@@ -0,0 +1,79 @@
+/*
+ * fetch_policy.h - selection of hardware thread to fetch
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef FETCH_POLICY_H
+#define FETCH_POLICY_H
+
+#include <infra/exception.h>
+#include <infra/macro.h>
+#include <infra/types.h>
+
+#include <string>
+#include <vector>
+
+struct InvalidSMTConfiguration final : Exception
+{
+    explicit InvalidSMTConfiguration( const std::string& msg)
+        : Exception( "Invalid simultaneous multithreading configuration", msg)
+    { }
+};
+
+// Threads are checked in round-robin order starting after the last fetched one.
+// ICOUNT policy prefers the thread with the fewest instructions in flight,
+// so threads blocked by long latency events do not clog the shared backend.
+class FetchPolicy
+{
+public:
+    static constexpr const size_t NO_THREAD = NO_VAL<size_t>;
+
+    FetchPolicy( const std::string& mode, size_t threads)
+        : is_icount( is_icount_mode( mode))
+        , threads( threads)
+    {
+        if ( threads == 0)
+            throw InvalidSMTConfiguration( "core should have at least one hardware thread");
+    }
+
+    // returns NO_THREAD if no thread may be fetched
+    size_t select( const std::vector<bool>& is_ready, const std::vector<uint64>& in_flight)
+    {
+        size_t result = NO_THREAD;
+        for ( size_t i = 1; i <= threads; ++i)
+        {
+            const auto thread = ( last_thread + i) % threads;
+            if ( !is_ready.at( thread))
+                continue;
+
+            if ( result == NO_THREAD || ( is_icount && in_flight.at( thread) < in_flight.at( result)))
+                result = thread;
+
+            if ( !is_icount)
+                break;
+        }
+
+        if ( result != NO_THREAD)
+            last_thread = result;
+
+        return result;
+    }
+
+private:
+    static bool is_icount_mode( const std::string& mode)
+    {
+        if ( mode == "round-robin")
+            return false;
+
+        if ( mode == "icount")
+            return true;
+
+        throw InvalidSMTConfiguration( "unknown fetch policy " + mode);
+    }
+
+    const bool is_icount;
+    const size_t threads;
+    size_t last_thread = 0;
+};
+
+#endif // FETCH_POLICY_H
@@ -0,0 +1,229 @@
+/*
+ * instr_prefetcher.cpp - instruction prefetching methods
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include "instr_prefetcher.h"
+#include "bpu/bpu.h"
+
+#include <infra/macro.h>
+
+#include <bit>
+#include <deque>
+#include <map>
+#include <vector>
+#include <type_traits>
+
+namespace {
+
+class NoInstrPrefetcher final : public InstrPrefetcher { };
+
+// Next line is prefetched when fetch comes close to the end of the current one
+class NextLineInstrPrefetcher : public InstrPrefetcher
+{
+public:
+    NextLineInstrPrefetcher( uint32 fetchahead_distance, uint32 line_size)
+        : fetchahead_distance( fetchahead_distance)
+        , line_size( line_size)
+        , offset_mask( bitmask<Addr>( std::countr_zero( line_size)))
+    { }
+
+    void on_fetch( Addr pc, bool /* is_redirected */, std::vector<Addr>* lines) override
+    {
+        if ( ( pc & offset_mask) >= line_size - fetchahead_distance)
+            lines->push_back( pc + line_size);
+    }
+
+private:
+    const uint32 fetchahead_distance;
+    const uint32 line_size;
+    const Addr offset_mask;
+};
+
+// Target of decode redirect is prefetched instead of the next line
+class WrongPathInstrPrefetcher final : public NextLineInstrPrefetcher
+{
+public:
+    using NextLineInstrPrefetcher::NextLineInstrPrefetcher;
+
+    void on_decode_redirect( Addr target, std::vector<Addr>* lines) final
+    {
+        lines->push_back( target);
+    }
+
+    void on_fetch( Addr pc, bool is_redirected, std::vector<Addr>* lines) final
+    {
+        if ( !is_redirected)
+            NextLineInstrPrefetcher::on_fetch( pc, is_redirected, lines);
+    }
+};
+
+/*
+ * Fetch-directed instruction prefetching (Reinman, Calder, Austin, 1999).
+ * Branch predictor is decoupled from fetch and runs ahead of it,
+ * filling the fetch target queue (FTQ) with predicted fetch blocks.
+ * A fetch block is a sequence of instructions in a single line ending
+ * with a predicted taken branch or at the line boundary. Lines of enqueued
+ * blocks are prefetched, so instruction cache misses overlap with the
+ * fetch of preceding blocks and with other misses.
+ * Fetch takes its predictions from the FTQ, so speculative state of BP
+ * is advanced when blocks are enqueued, and it is restored to the first
+ * unused prediction if the queue is dropped without a repair.
+ */
+class FDIPInstrPrefetcher final : public InstrPrefetcher
+{
+public:
+    FDIPInstrPrefetcher( const PerfConfig::Prefetch& config, uint32 line_size, BaseBP* bp)
+        : ftq_size( config.ftq_size)
+        , line_mask( ~bitmask<Addr>( std::countr_zero( line_size)))
+        , bp( bp)
+    {
+        if ( ftq_size == 0)
+            throw PrefetchMethodException( "fetch target queue should have at least one entry");
+    }
+
+    void on_flush( bool is_repaired) final
+    {
+        if ( is_repaired)
+            clear();
+        else
+            drop();
+    }
+
+    void on_fetch_request( Addr pc, bool is_hold) final
+    {
+        if ( is_hold)
+            consumed = group_start;
+        else
+            pop_consumed();
+
+        // Fetch has left the predicted path without a flush, e.g. following a branch oracle
+        if ( !ftq.empty() && ftq.front()[consumed].pc != pc)
+            drop();
+
+        // Empty queue is filled with the first block at once, as a coupled BP would predict it
+        if ( ftq.empty())
+            restart( pc);
+
+        group_start = consumed;
+    }
+
+    bool get_prediction( Addr pc, BPInterface* prediction) final
+    {
+        if ( ftq.empty() || consumed == ftq.front().size() || ftq.front()[consumed].pc != pc) {
+            drop();
+            restart( pc);
+        }
+
+        *prediction = ftq.front()[consumed++];
+        return true;
+    }
+
+    void on_cycle( std::vector<Addr>* lines) final
+    {
+        if ( runahead_pc == NO_VAL<Addr>)
+            return;
+
+        for ( uint32 i = 0; i < blocks_per_cycle && ftq.size() < ftq_size; ++i) {
+            lines->push_back( runahead_pc);
+            push_block();
+        }
+    }
+
+private:
+    using FetchBlock = std::vector<BPInterface>; // predictions of the block instructions
+
+    // Instructions have 4 bytes as in branch predictor
+    void push_block()
+    {
+        const Addr start = runahead_pc;
+        auto& block = ftq.emplace_back();
+        for ( Addr pc = start; ; pc += 4) {
+            block.push_back( bp->predict( pc));
+            if ( block.back().is_taken) {
+                runahead_pc = block.back().target;
+                return;
+            }
+            if ( ( ( pc + 4) & line_mask) != ( start & line_mask)) {
+                runahead_pc = pc + 4;
+                return;
+            }
+        }
+    }
+
+    void restart( Addr pc)
+    {
+        runahead_pc = pc;
+        push_block();
+    }
+
+    void pop_consumed()
+    {
+        while ( !ftq.empty() && consumed == ftq.front().size()) {
+            ftq.pop_front();
+            consumed = 0;
+        }
+    }
+
+    void clear()
+    {
+        ftq.clear();
+        consumed = 0;
+        group_start = 0;
+        runahead_pc = NO_VAL<Addr>;
+    }
+
+    // Speculative state of BP returns to the first prediction not used by fetch
+    void drop()
+    {
+        pop_consumed();
+        if ( !ftq.empty())
+            bp->squash( ftq.front()[consumed]);
+        clear();
+    }
+
+    // Branch predictor bandwidth
+    static const constexpr uint32 blocks_per_cycle = 2;
+
+    const uint32 ftq_size;
+    const Addr line_mask;
+    BaseBP* const bp;
+
+    std::deque<FetchBlock> ftq;
+    size_t consumed = 0;    // instructions of the front block taken by fetch
+    size_t group_start = 0; // the first instruction of the latest fetch group in the front block
+    Addr runahead_pc = NO_VAL<Addr>;
+};
+
+template<typename T>
+std::unique_ptr<InstrPrefetcher> create_prefetcher( const PerfConfig::Prefetch& config, uint32 line_size, BaseBP* bp)
+{
+    if constexpr ( std::is_same_v<T, NoInstrPrefetcher>)
+        return std::make_unique<T>();
+    else if constexpr ( std::is_same_v<T, FDIPInstrPrefetcher>)
+        return std::make_unique<T>( config, line_size, bp);
+    else
+        return std::make_unique<T>( config.fetchahead_distance, line_size);
+}
+
+} // namespace
+
+std::unique_ptr<InstrPrefetcher> InstrPrefetcher::create( const PerfConfig::Prefetch& config, uint32 line_size, BaseBP* bp)
+{
+    using Creator = std::unique_ptr<InstrPrefetcher> (*)( const PerfConfig::Prefetch&, uint32, BaseBP*);
+    static const std::map<std::string, Creator> creators = {
+        { "next-line",   create_prefetcher<NextLineInstrPrefetcher> },
+        { "wrong-path",  create_prefetcher<WrongPathInstrPrefetcher> },
+        { "fdip",        create_prefetcher<FDIPInstrPrefetcher> },
+        { "no-prefetch", create_prefetcher<NoInstrPrefetcher> },
+    };
+
+    const auto it = creators.find( config.method);
+    if ( it != creators.end())
+        return it->second( config, line_size, bp);
+
+    std::string list;
+    for ( const auto& creator : creators)
+        list += creator.first + '\n';
+    throw PrefetchMethodException( "\"" + config.method + "\" prefetch method is not defined, supported methods are:\n" + list);
+}
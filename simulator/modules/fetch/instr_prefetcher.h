@@ -0,0 +1,61 @@
+/*
+ * instr_prefetcher.h - instruction prefetching methods
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef INSTR_PREFETCHER_H
+#define INSTR_PREFETCHER_H
+
+#include <infra/exception.h>
+#include <infra/types.h>
+#include <modules/core/perf_config.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class BaseBP;
+struct BPInterface;
+
+struct PrefetchMethodException final : Exception
+{
+    explicit PrefetchMethodException( const std::string& msg)
+            : Exception( "Invalid prefetch method name", msg)
+    { }
+};
+
+// Prefetcher proposes lines, fetch unit skips the ones which are already cached
+class InstrPrefetcher
+{
+public:
+    // Branch predictor is not owned, decoupled prefetchers make predictions for fetch with it
+    static std::unique_ptr<InstrPrefetcher> create( const PerfConfig::Prefetch& config, uint32 line_size, BaseBP* bp);
+
+    InstrPrefetcher() = default;
+    virtual ~InstrPrefetcher() = default;
+    InstrPrefetcher( const InstrPrefetcher&) = delete;
+    InstrPrefetcher( InstrPrefetcher&&) = delete;
+    InstrPrefetcher& operator=( const InstrPrefetcher&) = delete;
+    InstrPrefetcher& operator=( InstrPrefetcher&&) = delete;
+
+    // Decode stage has redirected fetch to the target
+    virtual void on_decode_redirect( Addr /* target */, std::vector<Addr>* /* lines */) { }
+
+    // Instruction is fetched, 'is_redirected' is set for the target of decode redirect
+    virtual void on_fetch( Addr /* pc */, bool /* is_redirected */, std::vector<Addr>* /* lines */) { }
+
+    // Fetch is flushed, 'is_repaired' is set if the mispredicted branch has repaired speculative state of BP
+    virtual void on_flush( bool /* is_repaired */) { }
+
+    // Fetch unit requests the address from instruction cache, either hit or miss,
+    // 'is_hold' is set if the previous group is requested again after a stall or a miss
+    virtual void on_fetch_request( Addr /* pc */, bool /* is_hold */) { }
+
+    // Prediction made ahead of fetch for the instruction, false if BP has to predict it now
+    virtual bool get_prediction( Addr /* pc */, BPInterface* /* prediction */) { return false; }
+
+    // Called every cycle, including cycles of instruction cache misses
+    virtual void on_cycle( std::vector<Addr>* /* lines */) { }
+};
+
+#endif // INSTR_PREFETCHER_H
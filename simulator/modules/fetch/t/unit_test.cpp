@@ -0,0 +1,167 @@
+/**
+ * Unit tests for instruction prefetchers
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include <catch.hpp>
+#include <modules/fetch/bpu/bpu.h>
+#include <modules/fetch/fetch_policy.h>
+#include <modules/fetch/instr_prefetcher.h>
+
+static PerfConfig::Prefetch get_prefetch( const std::string& method)
+{
+    PerfConfig::Prefetch prefetch;
+    prefetch.method = method;
+    prefetch.fetchahead_distance = 16;
+    prefetch.ftq_size = 4;
+    return prefetch;
+}
+
+static std::vector<Addr> run_cycle( InstrPrefetcher* prefetcher)
+{
+    std::vector<Addr> lines;
+    prefetcher->on_cycle( &lines);
+    return lines;
+}
+
+static std::vector<Addr> fetch( InstrPrefetcher* prefetcher, Addr pc, bool is_redirected)
+{
+    std::vector<Addr> lines;
+    prefetcher->on_fetch( pc, is_redirected, &lines);
+    return lines;
+}
+
+TEST_CASE( "InstrPrefetcher: invalid configuration")
+{
+    auto bp = BaseBP::create_bp( "always_taken", "LRU", 128, 16, 32);
+    CHECK_THROWS_AS( InstrPrefetcher::create( get_prefetch( "previous-line"), 64, bp.get()), PrefetchMethodException);
+
+    auto no_ftq = get_prefetch( "fdip");
+    no_ftq.ftq_size = 0;
+    CHECK_THROWS_AS( InstrPrefetcher::create( no_ftq, 64, bp.get()), PrefetchMethodException);
+}
+
+TEST_CASE( "InstrPrefetcher: next line and wrong path")
+{
+    auto bp = BaseBP::create_bp( "always_taken", "LRU", 128, 16, 32);
+    auto next_line = InstrPrefetcher::create( get_prefetch( "next-line"), 64, bp.get());
+    CHECK( fetch( next_line.get(), 0x1020, false).empty());
+    CHECK( fetch( next_line.get(), 0x1030, false) == std::vector<Addr>{ 0x1070 });
+    CHECK( fetch( next_line.get(), 0x1030, true) == std::vector<Addr>{ 0x1070 });
+
+    auto wrong_path = InstrPrefetcher::create( get_prefetch( "wrong-path"), 64, bp.get());
+    std::vector<Addr> lines;
+    wrong_path->on_decode_redirect( 0x2000, &lines);
+    CHECK( lines == std::vector<Addr>{ 0x2000 });
+    CHECK( fetch( wrong_path.get(), 0x2030, true).empty());
+    CHECK( fetch( wrong_path.get(), 0x2030, false) == std::vector<Addr>{ 0x2070 });
+}
+
+// Fetch of a group of instructions, returns the prediction of the last one
+static BPInterface fetch_group( InstrPrefetcher* prefetcher, Addr pc, uint32 size, bool is_hold = false)
+{
+    prefetcher->on_fetch_request( pc, is_hold);
+    BPInterface prediction;
+    for ( uint32 i = 0; i < size; ++i, pc += 4)
+        CHECK( prefetcher->get_prediction( pc, &prediction));
+    return prediction;
+}
+
+TEST_CASE( "InstrPrefetcher: FDIP runs ahead of fetch")
+{
+    auto bp = BaseBP::create_bp( "always_taken", "LRU", 128, 16, 32);
+    auto fdip = InstrPrefetcher::create( get_prefetch( "fdip"), 64, bp.get());
+    CHECK( run_cycle( fdip.get()).empty());
+
+    // The first block is predicted at once, the line is requested by fetch itself
+    fdip->on_fetch_request( 0x1000, false);
+    CHECK( run_cycle( fdip.get()) == std::vector<Addr>{ 0x1040, 0x1080 });
+    CHECK( run_cycle( fdip.get()) == std::vector<Addr>{ 0x10c0 });
+    CHECK( run_cycle( fdip.get()).empty());
+
+    // Fetch leaves the first block
+    CHECK( fetch_group( fdip.get(), 0x1000, 16).pc == 0x103c);
+    CHECK( run_cycle( fdip.get()).empty());
+    CHECK( fetch_group( fdip.get(), 0x1040, 1).pc == 0x1040);
+    CHECK( run_cycle( fdip.get()) == std::vector<Addr>{ 0x1100 });
+}
+
+TEST_CASE( "InstrPrefetcher: FDIP follows predicted branches and restarts on flush")
+{
+    auto bp = BaseBP::create_bp( "always_taken", "LRU", 128, 16, 32);
+    bp->update( BPInterface( 0x1008, true, 0x2000, true));
+    auto fdip = InstrPrefetcher::create( get_prefetch( "fdip"), 64, bp.get());
+
+    fdip->on_fetch_request( 0x1000, false);
+    CHECK( run_cycle( fdip.get()) == std::vector<Addr>{ 0x2000, 0x2040 });
+
+    const auto prediction = fetch_group( fdip.get(), 0x1000, 3);
+    CHECK( prediction.is_taken);
+    CHECK( prediction.target == 0x2000);
+
+    fdip->on_flush( true);
+    CHECK( run_cycle( fdip.get()).empty());
+    fdip->on_fetch_request( 0x100c, false);
+    CHECK( run_cycle( fdip.get()) == std::vector<Addr>{ 0x1040, 0x1080 });
+}
+
+TEST_CASE( "InstrPrefetcher: FDIP advances history of BP when blocks are predicted")
+{
+    PerfConfig::BP config;
+    config.mode = "gshare";
+    config.table_size = 1024;
+    auto bp = BaseBP::create_bp( config, 32);
+    // Loop of three instructions, taken with any history it reaches
+    for ( uint64 history : { 0U, 1U, 3U, 7U}) {
+        BPInterface loop( 0x1008, true, 0x1000, true);
+        loop.history = history;
+        bp->update( loop);
+    }
+    auto fdip = InstrPrefetcher::create( get_prefetch( "fdip"), 64, bp.get());
+
+    fdip->on_fetch_request( 0x1000, false);
+    CHECK( bp->get_bp_info( 0x1008).history == 1);
+
+    // Group held by a stall gets the same predictions again
+    CHECK( fetch_group( fdip.get(), 0x1000, 3).history == 0);
+    CHECK( fetch_group( fdip.get(), 0x1000, 3, true).history == 0);
+    CHECK( bp->get_bp_info( 0x1008).history == 1);
+
+    CHECK( run_cycle( fdip.get()) == std::vector<Addr>{ 0x1000, 0x1000 });
+    CHECK( bp->get_bp_info( 0x1008).history == 7);
+    const auto prediction = fetch_group( fdip.get(), 0x1000, 3);
+    CHECK( prediction.is_taken);
+    CHECK( prediction.history == 1);
+
+    // Blocks of the flushed path are not used, history returns to the first of them
+    fdip->on_flush( false);
+    CHECK( bp->get_bp_info( 0x1008).history == 3);
+}
+
+TEST_CASE( "FetchPolicy: invalid configuration")
+{
+    CHECK_THROWS_AS( FetchPolicy( "round-robin", 0), InvalidSMTConfiguration);
+    CHECK_THROWS_AS( FetchPolicy( "random", 2), InvalidSMTConfiguration);
+}
+
+TEST_CASE( "FetchPolicy: round-robin skips threads which are not ready")
+{
+    FetchPolicy policy( "round-robin", 3);
+    const std::vector<uint64> in_flight = { 0, 0, 0};
+    CHECK( policy.select( { true, true, true}, in_flight) == 1);
+    CHECK( policy.select( { true, true, true}, in_flight) == 2);
+    CHECK( policy.select( { true, true, true}, in_flight) == 0);
+    CHECK( policy.select( { true, false, true}, in_flight) == 2);
+    CHECK( policy.select( { false, false, false}, in_flight) == FetchPolicy::NO_THREAD);
+    CHECK( policy.select( { true, false, false}, in_flight) == 0);
+}
+
+TEST_CASE( "FetchPolicy: icount prefers threads with fewer instructions in flight")
+{
+    FetchPolicy policy( "icount", 3);
+    CHECK( policy.select( { true, true, true}, { 5, 1, 3}) == 1);
+    CHECK( policy.select( { true, false, true}, { 5, 1, 3}) == 2);
+    // ties are broken in round-robin order
+    CHECK( policy.select( { true, true, true}, { 2, 2, 2}) == 0);
+    CHECK( policy.select( { true, true, true}, { 2, 2, 2}) == 1);
+}
@@ -0,0 +1,55 @@
+/*
+ * cache_lines.cpp - tag array of a cache level with addresses and dirty bits of its lines
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include "cache_lines.h"
+
+#include <utility>
+
+static const uint32 ADDR_SIZE_IN_BITS = 32;
+
+static bool has_ways( const PerfConfig::Cache& geometry)
+{
+    return geometry.type != "always_hit" && geometry.type != "infinite";
+}
+
+CacheLines::CacheLines( const PerfConfig::Cache& geometry)
+    : ways( geometry.ways)
+    , tags( CacheTagArray::create( geometry.type, geometry.size, geometry.ways, geometry.line_size, ADDR_SIZE_IN_BITS))
+    , lines( has_ways( geometry) ? geometry.size / geometry.line_size : 0)
+{ }
+
+CacheLines::Line* CacheLines::find( Addr line, int32 way)
+{
+    if ( way < 0)
+        return nullptr;
+
+    return &lines[ size_t{ tags->set( line)} * ways + narrow_cast<size_t>( way)];
+}
+
+bool CacheLines::lookup( Addr line, bool is_write)
+{
+    const auto [is_hit, way] = tags->read( line);
+    auto* entry = is_hit && is_write ? find( line, way) : nullptr;
+    if ( entry != nullptr)
+        entry->is_dirty = true;
+    return is_hit;
+}
+
+void CacheLines::set_dirty( Addr line)
+{
+    const auto [is_hit, way] = tags->read_no_touch( line);
+    auto* entry = is_hit ? find( line, way) : nullptr;
+    if ( entry != nullptr)
+        entry->is_dirty = true;
+}
+
+CacheLines::Line CacheLines::fill( Addr line, bool is_dirty)
+{
+    auto* entry = find( line, tags->write( line));
+    if ( entry == nullptr)
+        return Line();
+
+    return std::exchange( *entry, Line{ line, true, is_dirty});
+}
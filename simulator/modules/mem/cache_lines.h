@@ -0,0 +1,47 @@
+/*
+ * cache_lines.h - tag array of a cache level with addresses and dirty bits of its lines
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef CACHE_LINES_H
+#define CACHE_LINES_H
+
+#include <infra/cache/cache_tag_array.h>
+#include <infra/types.h>
+#include <modules/core/perf_config.h>
+
+#include <memory>
+#include <vector>
+
+// Address and dirty bit of a line are kept in the same way as its tag,
+// so the victim of a fill is read from the way returned by the tag array.
+// Ideal "always_hit" and "infinite" tag arrays have no ways and never evict lines.
+class CacheLines
+{
+public:
+    struct Line
+    {
+        Addr addr = 0;
+        bool is_valid = false;
+        bool is_dirty = false;
+    };
+
+    explicit CacheLines( const PerfConfig::Cache& geometry);
+
+    // Hit updates replacement information and marks the line dirty if 'is_write' is set
+    bool lookup( Addr line, bool is_write);
+    bool is_present( Addr line) const { return tags->read_no_touch( line).first; }
+    void set_dirty( Addr line);
+
+    // Return the evicted line, it is not valid if the way was empty
+    Line fill( Addr line, bool is_dirty);
+
+private:
+    Line* find( Addr line, int32 way);
+
+    const uint32 ways;
+    std::unique_ptr<CacheTagArray> tags;
+    std::vector<Line> lines; // indexed by set and way of the tag array
+};
+
+#endif // CACHE_LINES_H
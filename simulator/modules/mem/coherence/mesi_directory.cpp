@@ -0,0 +1,277 @@
+/*
+ * mesi_directory.cpp - MESI directory of private data caches
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include "mesi_directory.h"
+
+#include <infra/macro.h>
+
+#include <algorithm>
+#include <ostream>
+#include <string>
+
+static const uint32 ADDR_SIZE_IN_BITS = 32;
+
+MESIDirectory::MESIDirectory( size_t cores, const PerfConfig::Cache& cache, const PerfConfig::Coherence& latencies)
+    : line_size( cache.line_size)
+    , ways( cache.ways)
+    , latencies( latencies)
+    , caches( cores)
+{
+    if ( cores == 0)
+        throw InvalidCoherenceConfiguration( "at least one core is required");
+
+    if ( cores > bitwidth<uint64>)
+        throw InvalidCoherenceConfiguration( "directory supports up to 64 cores, got " + std::to_string( cores));
+
+    // States are kept per way, ideal tag arrays have no ways
+    if ( cache.type == "always_hit" || cache.type == "infinite")
+        throw InvalidCoherenceConfiguration( "\"" + cache.type + "\" data cache cannot be kept coherent");
+
+    for ( auto& c : caches) {
+        c.tags = CacheTagArray::create( cache.type, cache.size, cache.ways, cache.line_size, ADDR_SIZE_IN_BITS);
+        c.lines.resize( cache.size / cache.line_size);
+    }
+}
+
+Addr MESIDirectory::get_line( Addr addr) const
+{
+    return addr & ~Addr{ line_size - 1} & bitmask<Addr>( ADDR_SIZE_IN_BITS);
+}
+
+MESIState MESIDirectory::get_state( size_t core, Addr addr) const
+{
+    std::lock_guard lock( mutex);
+    return get_state_unlocked( core, get_line( addr));
+}
+
+CoherenceStatistics MESIDirectory::get_statistics( size_t core) const
+{
+    std::lock_guard lock( mutex);
+    return caches.at( core).stats;
+}
+
+MESIState MESIDirectory::get_state_unlocked( size_t core, Addr line) const
+{
+    const auto index = find_line( core, line);
+    return index == NO_LINE ? MESIState::INVALID : caches.at( core).lines[index].state;
+}
+
+size_t MESIDirectory::find_line( size_t core, Addr line) const
+{
+    const auto [is_hit, way] = caches.at( core).tags->read_no_touch( line);
+    return is_hit ? get_index( core, line, way) : NO_LINE;
+}
+
+size_t MESIDirectory::get_index( size_t core, Addr line, int32 way) const
+{
+    return size_t{ caches[core].tags->set( line)} * ways + narrow_cast<size_t>( way);
+}
+
+CoherenceResult MESIDirectory::access( size_t core, Addr addr, bool is_store)
+{
+    std::lock_guard lock( mutex);
+    auto& cache = caches.at( core);
+    const Addr line = get_line( addr);
+    auto& entry = directory[line];
+    const auto state = get_state_unlocked( core, line);
+
+    CoherenceResult result;
+    if ( !is_store) {
+        ++cache.stats.loads;
+        result.hit = state != MESIState::INVALID;
+        if ( !result.hit)
+            result = handle_load_miss( core, line, &entry);
+    }
+    else {
+        ++cache.stats.stores;
+        result.hit = state == MESIState::MODIFIED || state == MESIState::EXCLUSIVE;
+        if ( result.hit) {
+            // E -> M transition is silent
+            set_state( core, line, MESIState::MODIFIED);
+            update_writer( core, &entry);
+        }
+        else {
+            result = handle_store_miss( core, line, &entry, state);
+        }
+    }
+
+    if ( result.hit) {
+        ++cache.stats.hits;
+        cache.tags->read( line);
+    }
+    else {
+        ++cache.stats.misses;
+    }
+
+    cache.stats.latency += result.latency;
+    return result;
+}
+
+CoherenceResult MESIDirectory::handle_load_miss( size_t core, Addr line, DirectoryEntry* entry)
+{
+    CoherenceResult result;
+    result.latency = latencies.directory_latency;
+
+    const auto owner = find_owner( line, *entry);
+    if ( owner != NO_CORE) {
+        // Owner forwards the line and keeps a shared copy, dirty data goes to memory
+        if ( get_state_unlocked( owner, line) == MESIState::MODIFIED)
+            ++caches[owner].stats.writebacks;
+        set_state( owner, line, MESIState::SHARED);
+        ++caches[core].stats.cache_to_cache;
+        result.latency += latencies.cache_to_cache_latency;
+        fill( core, line, MESIState::SHARED);
+    }
+    else {
+        result.memory_access = true;
+        fill( core, line, entry->sharers == 0 ? MESIState::EXCLUSIVE : MESIState::SHARED);
+    }
+
+    return result;
+}
+
+CoherenceResult MESIDirectory::handle_store_miss( size_t core, Addr line, DirectoryEntry* entry, MESIState state)
+{
+    CoherenceResult result;
+    result.latency = latencies.directory_latency;
+
+    if ( state == MESIState::SHARED) {
+        // Data is already here, only other copies have to be removed
+        ++caches[core].stats.upgrades;
+        result.latency += invalidate_sharers( core, line, entry);
+        set_state( core, line, MESIState::MODIFIED);
+        caches[core].tags->read( line);
+    }
+    else {
+        const auto owner = find_owner( line, *entry);
+        if ( owner != NO_CORE) {
+            // Ownership of dirty line is transferred without writeback
+            ++caches[core].stats.cache_to_cache;
+            result.latency += latencies.cache_to_cache_latency;
+            invalidate_sharers( core, line, entry);
+        }
+        else {
+            result.memory_access = true;
+            result.latency += invalidate_sharers( core, line, entry);
+        }
+        fill( core, line, MESIState::MODIFIED);
+    }
+
+    update_writer( core, entry);
+    return result;
+}
+
+void MESIDirectory::fill( size_t core, Addr line, MESIState state)
+{
+    auto& cache = caches[core];
+    auto& victim = cache.lines.at( get_index( core, line, cache.tags->write( line)));
+    if ( victim.state != MESIState::INVALID)
+        evict( core, victim);
+
+    victim = Line{ line, state};
+    directory[line].sharers |= uint64{ 1} << core;
+}
+
+void MESIDirectory::evict( size_t core, const Line& victim)
+{
+    if ( victim.state == MESIState::MODIFIED)
+        ++caches[core].stats.writebacks;
+
+    auto it = directory.find( victim.addr);
+    if ( it != directory.end())
+        it->second.sharers &= ~( uint64{ 1} << core);
+}
+
+void MESIDirectory::invalidate( size_t core, Addr line)
+{
+    auto& cache = caches[core];
+    const auto index = find_line( core, line);
+    if ( index != NO_LINE)
+        cache.lines[index].state = MESIState::INVALID;
+
+    cache.tags->invalidate( line);
+    ++cache.stats.invalidations_received;
+}
+
+uint64 MESIDirectory::invalidate_sharers( size_t core, Addr line, DirectoryEntry* entry)
+{
+    uint64 invalidated = 0;
+    for ( size_t i = 0; i < caches.size(); ++i) {
+        if ( i == core || ( entry->sharers & ( uint64{ 1} << i)) == 0)
+            continue;
+
+        invalidate( i, line);
+        ++invalidated;
+    }
+
+    entry->sharers &= uint64{ 1} << core;
+    caches[core].stats.invalidations_sent += invalidated;
+    return invalidated != 0 ? latencies.invalidation_latency : 0;
+}
+
+void MESIDirectory::update_writer( size_t core, DirectoryEntry* entry)
+{
+    if ( entry->last_writer != NO_CORE && entry->last_writer != core) {
+        ++entry->transfers;
+        ++caches[core].stats.ping_pongs;
+    }
+    entry->last_writer = core;
+}
+
+size_t MESIDirectory::find_owner( Addr line, const DirectoryEntry& entry) const
+{
+    for ( size_t i = 0; i < caches.size(); ++i) {
+        if ( ( entry.sharers & ( uint64{ 1} << i)) == 0)
+            continue;
+
+        const auto state = get_state_unlocked( i, line);
+        if ( state == MESIState::MODIFIED || state == MESIState::EXCLUSIVE)
+            return i;
+    }
+    return NO_CORE;
+}
+
+std::vector<std::pair<Addr, uint64>> MESIDirectory::get_ping_pong_lines( size_t max_lines) const
+{
+    std::lock_guard lock( mutex);
+    std::vector<std::pair<Addr, uint64>> lines;
+    for ( const auto& [line, entry] : directory)
+        if ( entry.transfers != 0)
+            lines.emplace_back( line, entry.transfers);
+
+    std::sort( lines.begin(), lines.end(), []( const auto& lhs, const auto& rhs) {
+        return lhs.second != rhs.second ? lhs.second > rhs.second : lhs.first < rhs.first;
+    });
+
+    if ( lines.size() > max_lines)
+        lines.resize( max_lines);
+
+    return lines;
+}
+
+void MESIDirectory::dump_statistics( std::ostream& out) const
+{
+    for ( size_t i = 0; i < caches.size(); ++i) {
+        const auto stats = get_statistics( i);
+        out << "core " << i << " L1D coherence:"
+            << std::endl << "    loads/stores:  " << stats.loads << " / " << stats.stores
+            << std::endl << "    hits/misses:   " << stats.hits << " / " << stats.misses
+            << std::endl << "    upgrades:      " << stats.upgrades
+            << std::endl << "    invalidations: sent " << stats.invalidations_sent << ", received " << stats.invalidations_received
+            << std::endl << "    cache-to-cache transfers: " << stats.cache_to_cache
+            << std::endl << "    writebacks:    " << stats.writebacks
+            << std::endl << "    ping-pongs:    " << stats.ping_pongs
+            << std::endl << "    latency:       " << stats.latency << " cycles"
+            << std::endl;
+    }
+
+    const auto lines = get_ping_pong_lines( 8);
+    if ( lines.empty())
+        return;
+
+    out << "most contended lines:" << std::endl;
+    for ( const auto& [line, transfers] : lines)
+        out << "    0x" << std::hex << line << std::dec << ": " << transfers << " transfers" << std::endl;
+}
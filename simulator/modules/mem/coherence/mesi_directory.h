@@ -0,0 +1,149 @@
+/*
+ * mesi_directory.h - MESI directory of private data caches
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef MESI_DIRECTORY_H
+#define MESI_DIRECTORY_H
+
+#include <infra/cache/cache_tag_array.h>
+#include <infra/exception.h>
+#include <infra/types.h>
+#include <modules/core/perf_config.h>
+
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct InvalidCoherenceConfiguration final : Exception
+{
+    explicit InvalidCoherenceConfiguration( const std::string& msg)
+        : Exception( "Invalid coherence configuration", msg)
+    { }
+};
+
+enum class MESIState : uint8
+{
+    INVALID,
+    SHARED,
+    EXCLUSIVE,
+    MODIFIED
+};
+
+struct CoherenceStatistics
+{
+    uint64 loads = 0;
+    uint64 stores = 0;
+    uint64 hits = 0;
+    uint64 misses = 0;
+    uint64 upgrades = 0;              // S -> M transitions
+    uint64 invalidations_sent = 0;    // copies removed from other caches
+    uint64 invalidations_received = 0;
+    uint64 cache_to_cache = 0;        // lines got from another cache
+    uint64 writebacks = 0;            // dirty lines written to memory
+    uint64 ping_pongs = 0;            // lines taken from the previous writer
+    uint64 latency = 0;               // total coherence latency in cycles
+};
+
+struct CoherenceResult
+{
+    bool hit = false;            // the line is present with enough permissions
+    bool memory_access = false;  // data is fetched from memory, not from another cache
+    uint64 latency = 0;          // coherence latency in cycles
+};
+
+// Private L1 data caches of several cores kept coherent by a full-map directory.
+// Only tags and states are modeled, data always lives in the shared functional memory.
+class MESIDirectory
+{
+public:
+    MESIDirectory( size_t cores, const PerfConfig::Cache& cache, const PerfConfig::Coherence& latencies);
+
+    CoherenceResult load( size_t core, Addr addr) { return access( core, addr, false); }
+    CoherenceResult store( size_t core, Addr addr) { return access( core, addr, true); }
+
+    size_t get_cores_num() const { return caches.size(); }
+    MESIState get_state( size_t core, Addr addr) const;
+    CoherenceStatistics get_statistics( size_t core) const;
+
+    // Lines which moved between writers most often, sorted by number of transfers
+    std::vector<std::pair<Addr, uint64>> get_ping_pong_lines( size_t max_lines) const;
+
+    void dump_statistics( std::ostream& out) const;
+
+private:
+    struct DirectoryEntry
+    {
+        uint64 sharers = 0; // bit mask of cores with valid copies
+        size_t last_writer = NO_CORE;
+        uint64 transfers = 0;
+    };
+
+    struct Line
+    {
+        Addr addr = 0;
+        MESIState state = MESIState::INVALID;
+    };
+
+    struct PrivateCache
+    {
+        std::unique_ptr<CacheTagArray> tags;
+        std::vector<Line> lines; // indexed by set and way of the tag array
+        CoherenceStatistics stats;
+    };
+
+    static constexpr size_t NO_CORE = MAX_VAL64;
+    static constexpr size_t NO_LINE = MAX_VAL64;
+
+    CoherenceResult access( size_t core, Addr addr, bool is_store);
+    CoherenceResult handle_load_miss( size_t core, Addr line, DirectoryEntry* entry);
+    CoherenceResult handle_store_miss( size_t core, Addr line, DirectoryEntry* entry, MESIState state);
+    void fill( size_t core, Addr line, MESIState state);
+    void evict( size_t core, const Line& victim);
+    void invalidate( size_t core, Addr line);
+    uint64 invalidate_sharers( size_t core, Addr line, DirectoryEntry* entry);
+    void update_writer( size_t core, DirectoryEntry* entry);
+
+    MESIState get_state_unlocked( size_t core, Addr line) const;
+    void set_state( size_t core, Addr line, MESIState state) { caches[core].lines.at( find_line( core, line)).state = state; }
+    size_t find_line( size_t core, Addr line) const; // NO_LINE on miss
+    size_t get_index( size_t core, Addr line, int32 way) const;
+    size_t find_owner( Addr line, const DirectoryEntry& entry) const;
+    Addr get_line( Addr addr) const;
+
+    const uint32 line_size;
+    const uint32 ways;
+    const PerfConfig::Coherence latencies;
+    std::vector<PrivateCache> caches;
+    std::unordered_map<Addr, DirectoryEntry> directory;
+    mutable std::mutex mutex;
+};
+
+// Port of a single core to the directory. Function passed as an argument
+// is called before each access to order accesses of several host threads.
+class CoherentCache
+{
+public:
+    CoherentCache( std::shared_ptr<MESIDirectory> directory, size_t core, std::function<void()> wait_for_turn = nullptr)
+        : directory( std::move( directory)), core( core), wait_for_turn( std::move( wait_for_turn))
+    { }
+
+    CoherenceResult access( Addr addr, bool is_store)
+    {
+        if ( wait_for_turn != nullptr)
+            wait_for_turn();
+        return is_store ? directory->store( core, addr) : directory->load( core, addr);
+    }
+
+    size_t get_core() const { return core; }
+
+private:
+    std::shared_ptr<MESIDirectory> directory;
+    const size_t core;
+    std::function<void()> wait_for_turn;
+};
+
+#endif // MESI_DIRECTORY_H
@@ -0,0 +1,164 @@
+/**
+ * Unit tests for MESI directory
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include <catch.hpp>
+#include <modules/mem/coherence/mesi_directory.h>
+
+#include <sstream>
+
+static PerfConfig::Cache get_small_cache()
+{
+    PerfConfig::Cache cache;
+    cache.type = "LRU";
+    cache.size = 256;
+    cache.ways = 2;
+    cache.line_size = 64;
+    return cache;
+}
+
+static auto create_directory( size_t cores)
+{
+    return MESIDirectory( cores, get_small_cache(), PerfConfig::Coherence());
+}
+
+TEST_CASE( "MESI: invalid number of cores")
+{
+    CHECK_THROWS_AS( create_directory( 0), InvalidCoherenceConfiguration);
+    CHECK_THROWS_AS( create_directory( 65), InvalidCoherenceConfiguration);
+}
+
+TEST_CASE( "MESI: ideal caches are not supported")
+{
+    auto cache = get_small_cache();
+    cache.type = "infinite";
+    CHECK_THROWS_AS( MESIDirectory( 2, cache, PerfConfig::Coherence()), InvalidCoherenceConfiguration);
+    cache.type = "always_hit";
+    CHECK_THROWS_AS( MESIDirectory( 2, cache, PerfConfig::Coherence()), InvalidCoherenceConfiguration);
+}
+
+TEST_CASE( "MESI: exclusive and shared loads")
+{
+    auto directory = create_directory( 2);
+    const PerfConfig::Coherence latencies;
+
+    auto first = directory.load( 0, 0x1000);
+    CHECK_FALSE( first.hit);
+    CHECK( first.memory_access);
+    CHECK( first.latency == latencies.directory_latency);
+    CHECK( directory.get_state( 0, 0x1000) == MESIState::EXCLUSIVE);
+    CHECK( directory.load( 0, 0x1008).hit);
+
+    auto second = directory.load( 1, 0x1010);
+    CHECK_FALSE( second.hit);
+    CHECK_FALSE( second.memory_access);
+    CHECK( second.latency == latencies.directory_latency + latencies.cache_to_cache_latency);
+    CHECK( directory.get_state( 0, 0x1000) == MESIState::SHARED);
+    CHECK( directory.get_state( 1, 0x1000) == MESIState::SHARED);
+    CHECK( directory.get_statistics( 1).cache_to_cache == 1);
+    CHECK( directory.get_statistics( 0).hits == 1);
+}
+
+TEST_CASE( "MESI: silent upgrade of exclusive line")
+{
+    auto directory = create_directory( 2);
+    directory.load( 0, 0x1000);
+    auto result = directory.store( 0, 0x1000);
+    CHECK( result.hit);
+    CHECK( result.latency == 0);
+    CHECK( directory.get_state( 0, 0x1000) == MESIState::MODIFIED);
+    CHECK( directory.get_statistics( 0).upgrades == 0);
+}
+
+TEST_CASE( "MESI: upgrade invalidates sharers")
+{
+    auto directory = create_directory( 3);
+    const PerfConfig::Coherence latencies;
+    directory.load( 0, 0x1000);
+    directory.load( 1, 0x1000);
+    directory.load( 2, 0x1000);
+
+    auto result = directory.store( 1, 0x1000);
+    CHECK_FALSE( result.hit);
+    CHECK_FALSE( result.memory_access);
+    CHECK( result.latency == latencies.directory_latency + latencies.invalidation_latency);
+    CHECK( directory.get_state( 0, 0x1000) == MESIState::INVALID);
+    CHECK( directory.get_state( 1, 0x1000) == MESIState::MODIFIED);
+    CHECK( directory.get_state( 2, 0x1000) == MESIState::INVALID);
+
+    auto stats = directory.get_statistics( 1);
+    CHECK( stats.upgrades == 1);
+    CHECK( stats.invalidations_sent == 2);
+    CHECK( directory.get_statistics( 0).invalidations_received == 1);
+    CHECK( directory.get_statistics( 2).invalidations_received == 1);
+}
+
+TEST_CASE( "MESI: load of modified line")
+{
+    auto directory = create_directory( 2);
+    directory.store( 0, 0x1000);
+    CHECK( directory.get_state( 0, 0x1000) == MESIState::MODIFIED);
+
+    auto result = directory.load( 1, 0x1000);
+    CHECK_FALSE( result.memory_access);
+    CHECK( directory.get_state( 0, 0x1000) == MESIState::SHARED);
+    CHECK( directory.get_state( 1, 0x1000) == MESIState::SHARED);
+    CHECK( directory.get_statistics( 0).writebacks == 1);
+}
+
+TEST_CASE( "MESI: false sharing ping-pong")
+{
+    auto directory = create_directory( 2);
+    for ( int i = 0; i < 5; ++i) {
+        directory.store( 0, 0x1000);
+        directory.store( 1, 0x1008);
+    }
+
+    CHECK( directory.get_statistics( 0).ping_pongs == 4);
+    CHECK( directory.get_statistics( 1).ping_pongs == 5);
+    CHECK( directory.get_statistics( 1).cache_to_cache == 5);
+    CHECK( directory.get_statistics( 0).writebacks == 0);
+
+    auto lines = directory.get_ping_pong_lines( 4);
+    REQUIRE( lines.size() == 1);
+    CHECK( lines.front().first == 0x1000);
+    CHECK( lines.front().second == 9);
+
+    std::ostringstream oss;
+    directory.dump_statistics( oss);
+    CHECK( oss.str().find( "0x1000: 9 transfers") != std::string::npos);
+}
+
+TEST_CASE( "MESI: eviction of modified line")
+{
+    auto directory = create_directory( 2);
+    directory.store( 0, 0x0);
+    directory.load( 0, 0x80);
+    directory.load( 0, 0x100);
+
+    CHECK( directory.get_state( 0, 0x0) == MESIState::INVALID);
+    CHECK( directory.get_state( 0, 0x80) == MESIState::EXCLUSIVE);
+    CHECK( directory.get_statistics( 0).writebacks == 1);
+
+    // Directory has forgotten about the evicted copy
+    CHECK( directory.load( 1, 0x0).memory_access);
+    CHECK( directory.get_state( 1, 0x0) == MESIState::EXCLUSIVE);
+}
+
+TEST_CASE( "MESI: refill after invalidation")
+{
+    auto directory = create_directory( 2);
+    directory.load( 0, 0x0);
+    directory.load( 1, 0x0);
+    directory.store( 1, 0x0);
+    CHECK( directory.get_state( 0, 0x0) == MESIState::INVALID);
+
+    directory.load( 0, 0x0);
+    directory.load( 0, 0x80);
+    directory.load( 0, 0x100);
+    CHECK( directory.get_state( 0, 0x0) == MESIState::INVALID);
+    CHECK( directory.get_state( 0, 0x80) == MESIState::EXCLUSIVE);
+    CHECK( directory.get_state( 0, 0x100) == MESIState::EXCLUSIVE);
+    CHECK( directory.get_state( 1, 0x0) == MESIState::SHARED);
+}
@@ -0,0 +1,227 @@
+/*
+ * data_cache.cpp - timing model of level 1 data cache
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include "data_cache.h"
+
+#include "memory_hierarchy.h"
+
+#include <modules/mem/coherence/mesi_directory.h>
+
+#include <algorithm>
+
+static Latency to_latency( uint64 cycles)
+{
+    return Latency( narrow_cast<int64>( cycles));
+}
+
+DataCache::DataCache( const PerfConfig::Cache& geometry, const PerfConfig::DataCacheTiming& timing)
+    : line_size( geometry.line_size)
+    , hit_stall( to_latency( std::max<uint64>( timing.hit_latency, 1) - 1))
+    , miss_latency( to_latency( timing.miss_latency))
+    , mshrs_num( timing.mshrs)
+    , is_write_back( timing.write_policy == "write-back")
+    , lines( geometry)
+{
+    if ( timing.write_policy != "write-back" && timing.write_policy != "write-through")
+        throw InvalidDataCacheConfiguration( "\"" + timing.write_policy + "\" write policy is not defined, supported policies are:\nwrite-back\nwrite-through\n");
+
+    if ( mshrs_num == 0)
+        throw InvalidDataCacheConfiguration( "at least one MSHR is required");
+
+    mshrs.reserve( mshrs_num);
+}
+
+Latency DataCache::load( Addr addr, Cycle now)
+{
+    return access( addr, now, false, lines.lookup( get_line( addr), false), 0_lt, true, true);
+}
+
+Latency DataCache::store( Addr addr, Cycle now)
+{
+    return access( addr, now, true, lines.lookup( get_line( addr), is_write_back), 0_lt, true, true);
+}
+
+Latency DataCache::load( Addr addr, Cycle now, const CoherenceResult& coherence)
+{
+    return access( addr, now, false, coherence.hit, to_latency( coherence.latency), coherence.memory_access, false);
+}
+
+Latency DataCache::store( Addr addr, Cycle now, const CoherenceResult& coherence)
+{
+    return access( addr, now, true, coherence.hit, to_latency( coherence.latency), coherence.memory_access, false);
+}
+
+void DataCache::set_prefetcher( const PerfConfig::DataPrefetch& config)
+{
+    prefetcher = DataPrefetcher::create( config, line_size);
+    prefetch_queue_size = config.queue_size;
+}
+
+size_t DataCache::get_busy_mshrs( Cycle now)
+{
+    retire_mshrs( now);
+    return mshrs.size();
+}
+
+Latency DataCache::access( Addr addr, Cycle now, bool is_store, bool is_hit, Latency extra, bool needs_memory, bool has_tags)
+{
+    const Addr line = get_line( addr);
+    retire_mshrs( now);
+    ++( is_store ? stats.stores : stats.loads);
+
+    if ( const auto* pending = find_fill( line); pending != nullptr) {
+        ++stats.mshr_merges;
+        is_prefetch_trigger = use_prefetched( line);
+        stats.late_prefetches += is_prefetch_trigger ? 1 : 0;
+        if ( is_store && is_write_back && has_tags)
+            lines.set_dirty( line);
+        if ( is_store)
+            return account( hit_stall);
+        return account( std::max( pending->ready - now - 1_lt, hit_stall));
+    }
+
+    if ( is_hit) {
+        is_prefetch_trigger = use_prefetched( line);
+        /* write-back hit has marked the line dirty */
+        if ( !is_store || is_write_back)
+            return account( hit_stall);
+
+        ++stats.memory_writes;
+        const auto& mshr = allocate_mshr( line, now, extra, needs_memory, false, has_tags, false);
+        return account( std::max( mshr.issue - now, hit_stall));
+    }
+
+    ++( is_store ? stats.store_misses : stats.load_misses);
+    is_prefetch_trigger = true;
+    if ( is_store && !is_write_back) {
+        ++stats.memory_writes;
+        const auto& mshr = allocate_mshr( line, now, extra, needs_memory, false, has_tags, false);
+        return account( std::max( mshr.issue - now, hit_stall));
+    }
+
+    // Write-back cache allocates a dirty line on store miss
+    const auto& mshr = allocate_mshr( line, now, extra, needs_memory, true, has_tags, is_store);
+    if ( is_store)
+        return account( std::max( mshr.issue - now, hit_stall));
+
+    return account( mshr.ready - now - 1_lt);
+}
+
+// The request leaves for memory when an MSHR is available
+const DataCache::MSHR& DataCache::allocate_mshr( Addr line, Cycle now, Latency extra, bool needs_memory, bool is_fill, bool has_tags, bool is_dirty)
+{
+    auto issue = now;
+    if ( mshrs.size() >= mshrs_num) {
+        ++stats.mshr_full;
+        auto earliest = std::min_element( mshrs.begin(), mshrs.end(), []( const auto& lhs, const auto& rhs) {
+            return lhs.ready < rhs.ready;
+        });
+        issue = std::max( issue, earliest->ready);
+        retire_mshrs( issue);
+    }
+
+    if ( is_fill && has_tags)
+        fill( line, issue, is_dirty);
+
+    const auto latency = extra + ( needs_memory ? memory_latency( line, issue + extra, !is_fill) : 0_lt);
+    mshrs.push_back( { line, issue, issue + latency, is_fill});
+    return mshrs.back();
+}
+
+Latency DataCache::memory_latency( Addr line, Cycle issue, bool is_write)
+{
+    if ( lower_level == nullptr)
+        return miss_latency;
+
+    return is_write ? lower_level->write( line, issue) : lower_level->read( line, issue);
+}
+
+bool DataCache::use_prefetched( Addr line)
+{
+    if ( prefetched_lines.erase( line) == 0)
+        return false;
+
+    ++stats.useful_prefetches;
+    return true;
+}
+
+void DataCache::prefetch( Addr pc, Addr addr, Cycle now)
+{
+    if ( prefetcher == nullptr)
+        return;
+
+    prefetcher->train( pc, addr, is_prefetch_trigger, &prefetch_candidates);
+    for ( const auto candidate : prefetch_candidates) {
+        const Addr line = get_line( candidate);
+        if ( is_requested( line) || std::find( prefetch_queue.begin(), prefetch_queue.end(), line) != prefetch_queue.end())
+            continue;
+
+        prefetch_queue.push_back( line);
+        if ( prefetch_queue.size() > prefetch_queue_size) {
+            prefetch_queue.pop_front();
+            ++stats.dropped_prefetches;
+        }
+    }
+    prefetch_candidates.clear();
+    issue_prefetches( now);
+}
+
+bool DataCache::is_requested( Addr line) const
+{
+    return lines.is_present( line) || find_fill( line) != nullptr;
+}
+
+void DataCache::issue_prefetches( Cycle now)
+{
+    retire_mshrs( now);
+    while ( !prefetch_queue.empty() && mshrs.size() + 1 < mshrs_num) {
+        const Addr line = prefetch_queue.front();
+        prefetch_queue.pop_front();
+        if ( is_requested( line))
+            continue;
+
+        fill( line, now, false);
+        prefetched_lines.insert( line);
+        mshrs.push_back( { line, now, now + memory_latency( line, now, false), true});
+        ++stats.prefetches;
+    }
+}
+
+const DataCache::MSHR* DataCache::find_fill( Addr line) const
+{
+    auto it = std::find_if( mshrs.begin(), mshrs.end(), [line]( const auto& mshr) {
+        return mshr.is_fill && mshr.line == line;
+    });
+    return it == mshrs.end() ? nullptr : &*it;
+}
+
+void DataCache::retire_mshrs( Cycle now)
+{
+    mshrs.erase( std::remove_if( mshrs.begin(), mshrs.end(), [now]( const auto& mshr) {
+        return mshr.ready <= now;
+    }), mshrs.end());
+}
+
+void DataCache::fill( Addr line, Cycle now, bool is_dirty)
+{
+    const auto victim = lines.fill( line, is_dirty);
+    if ( !victim.is_valid)
+        return;
+
+    if ( prefetched_lines.erase( victim.addr) != 0)
+        ++stats.useless_prefetches;
+
+    if ( victim.is_dirty) {
+        ++stats.writebacks;
+        if ( lower_level != nullptr)
+            lower_level->write( victim.addr, now);
+    }
+}
+
+Latency DataCache::account( Latency stall)
+{
+    stats.stall_cycles += stall.to_size_t();
+    return stall;
+}
@@ -0,0 +1,119 @@
+/*
+ * data_cache.h - timing model of level 1 data cache
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef DATA_CACHE_H
+#define DATA_CACHE_H
+
+#include "cache_lines.h"
+#include "data_prefetcher.h"
+
+#include <infra/exception.h>
+#include <infra/ports/timing.h>
+#include <modules/core/perf_config.h>
+
+#include <deque>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+struct CoherenceResult;
+class MemoryHierarchy;
+
+struct InvalidDataCacheConfiguration final : Exception
+{
+    explicit InvalidDataCacheConfiguration( const std::string& msg)
+        : Exception( "Invalid data cache configuration", msg)
+    { }
+};
+
+struct DataCacheStatistics
+{
+    uint64 loads = 0;
+    uint64 stores = 0;
+    uint64 load_misses = 0;
+    uint64 store_misses = 0;
+    uint64 mshr_merges = 0;     // misses to a line which is already requested
+    uint64 mshr_full = 0;       // misses waited for a free MSHR
+    uint64 writebacks = 0;      // dirty lines evicted to memory
+    uint64 memory_writes = 0;   // stores sent to memory by write-through cache
+    uint64 stall_cycles = 0;
+    uint64 prefetches = 0;          // lines requested by prefetcher
+    uint64 useful_prefetches = 0;   // prefetched lines accessed by demand
+    uint64 late_prefetches = 0;     // useful prefetches which have not arrived before demand
+    uint64 useless_prefetches = 0;  // prefetched lines evicted before use
+    uint64 dropped_prefetches = 0;  // predictions dropped from full prefetch queue
+};
+
+// Non-blocking cache: every miss occupies a miss status holding register (MSHR)
+// until the line arrives. Loads wait for their data, stores retire immediately,
+// so the pipeline stalls on store misses only if all MSHRs are busy.
+// Write-back cache allocates lines on store misses, write-through cache sends
+// every store to memory through MSHRs and does not allocate lines on store misses.
+// Memory is either a fixed miss latency or the lower levels of memory hierarchy.
+// Prefetches wait in a queue until an MSHR is free, the last free MSHR is kept for demand misses.
+class DataCache
+{
+public:
+    DataCache( const PerfConfig::Cache& geometry, const PerfConfig::DataCacheTiming& timing);
+
+    // Return number of cycles the access delays the pipeline
+    Latency load( Addr addr, Cycle now);
+    Latency store( Addr addr, Cycle now);
+
+    // Hits and misses are determined by the coherence directory which owns the tags
+    Latency load( Addr addr, Cycle now, const CoherenceResult& coherence);
+    Latency store( Addr addr, Cycle now, const CoherenceResult& coherence);
+
+    void set_lower_level( MemoryHierarchy* hierarchy) { lower_level = hierarchy; }
+    void set_prefetcher( const PerfConfig::DataPrefetch& config);
+
+    // Trains prefetcher with the last access and issues predicted lines
+    void prefetch( Addr pc, Addr addr, Cycle now);
+
+    const DataCacheStatistics& get_statistics() const { return stats; }
+    size_t get_busy_mshrs( Cycle now);
+
+private:
+    struct MSHR
+    {
+        Addr line;
+        Cycle issue;
+        Cycle ready;
+        bool is_fill; // false for write-through stores
+    };
+
+    // 'extra' is a latency of coherence actions, it precedes the memory access if 'needs_memory' is set
+    Latency access( Addr addr, Cycle now, bool is_store, bool is_hit, Latency extra, bool needs_memory, bool has_tags);
+    const MSHR& allocate_mshr( Addr line, Cycle now, Latency extra, bool needs_memory, bool is_fill, bool has_tags, bool is_dirty);
+    Latency memory_latency( Addr line, Cycle issue, bool is_write);
+    bool use_prefetched( Addr line);
+    bool is_requested( Addr line) const;
+    void issue_prefetches( Cycle now);
+    const MSHR* find_fill( Addr line) const;
+    void retire_mshrs( Cycle now);
+    void fill( Addr line, Cycle now, bool is_dirty);
+    Latency account( Latency stall);
+    Addr get_line( Addr addr) const { return addr & ~Addr{ line_size - 1}; }
+
+    const uint32 line_size;
+    const Latency hit_stall; // pipeline spends one cycle in memory stage anyway
+    const Latency miss_latency;
+    const size_t mshrs_num;
+    const bool is_write_back;
+
+    CacheLines lines;
+    MemoryHierarchy* lower_level = nullptr;
+    std::vector<MSHR> mshrs;
+    DataCacheStatistics stats;
+
+    std::unique_ptr<DataPrefetcher> prefetcher;
+    size_t prefetch_queue_size = 0;
+    std::deque<Addr> prefetch_queue;
+    std::unordered_set<Addr> prefetched_lines; // not accessed by demand yet
+    std::vector<Addr> prefetch_candidates;
+    bool is_prefetch_trigger = false;
+};
+
+#endif // DATA_CACHE_H
@@ -0,0 +1,206 @@
+/*
+ * data_prefetcher.cpp - hardware prefetchers of level 1 data cache
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include "data_prefetcher.h"
+
+#include <infra/macro.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+
+namespace {
+
+class NoDataPrefetcher final : public DataPrefetcher
+{
+public:
+    NoDataPrefetcher( const PerfConfig::DataPrefetch& /* config */, uint32 /* line_size */) { }
+    void train( Addr /* pc */, Addr /* addr */, bool /* is_trigger */, std::vector<Addr>* /* addrs */) final { }
+};
+
+// Tagged next-line prefetcher: misses and useful prefetches request following lines
+class NextLineDataPrefetcher final : public DataPrefetcher
+{
+public:
+    NextLineDataPrefetcher( const PerfConfig::DataPrefetch& config, uint32 line_size)
+        : degree( config.degree), line_size( line_size)
+    { }
+
+    void train( Addr /* pc */, Addr addr, bool is_trigger, std::vector<Addr>* addrs) final
+    {
+        if ( !is_trigger)
+            return;
+
+        for ( uint32 i = 1; i <= degree; ++i)
+            addrs->push_back( addr + Addr{ i} * line_size);
+    }
+
+private:
+    const uint32 degree;
+    const uint32 line_size;
+};
+
+// Reference prediction table indexed by PC of memory instruction.
+// Prefetches are issued after the same stride is observed twice in a row.
+class StrideDataPrefetcher final : public DataPrefetcher
+{
+public:
+    StrideDataPrefetcher( const PerfConfig::DataPrefetch& config, uint32 line_size)
+        : degree( config.degree), line_size( line_size), table( config.table_size)
+    {
+        if ( table.empty())
+            throw InvalidDataPrefetcher( "stride table should have at least one entry");
+    }
+
+    void train( Addr pc, Addr addr, bool /* is_trigger */, std::vector<Addr>* addrs) final
+    {
+        auto& entry = table[ narrow_cast<size_t>( ( pc >> 2U) % table.size())];
+        if ( !entry.is_valid || entry.pc != pc) {
+            entry = { pc, addr, 0, 0, true };
+            return;
+        }
+
+        const auto stride = static_cast<int64>( addr - entry.last_addr);
+        if ( stride == entry.stride) {
+            entry.confidence = std::min( entry.confidence + 1, max_confidence);
+        }
+        else {
+            entry.stride = stride;
+            entry.confidence = 0;
+        }
+        entry.last_addr = addr;
+
+        if ( entry.confidence < threshold || stride == 0)
+            return;
+
+        // Strides shorter than a line would request the same line several times
+        const auto step = std::abs( stride) >= line_size ? stride : ( stride > 0 ? 1 : -1) * int64{ line_size};
+        for ( uint32 i = 1; i <= degree; ++i)
+            addrs->push_back( addr + static_cast<Addr>( step * i));
+    }
+
+private:
+    struct Entry
+    {
+        Addr pc = 0;
+        Addr last_addr = 0;
+        int64 stride = 0;
+        int confidence = 0;
+        bool is_valid = false;
+    };
+
+    static const constexpr int max_confidence = 3;
+    static const constexpr int threshold = 1;
+
+    const uint32 degree;
+    const uint32 line_size;
+    std::vector<Entry> table;
+};
+
+// Stream prefetcher detects sequences of misses to close lines,
+// a confirmed stream requests lines ahead in its direction on each access inside the window
+class StreamDataPrefetcher final : public DataPrefetcher
+{
+public:
+    StreamDataPrefetcher( const PerfConfig::DataPrefetch& config, uint32 line_size)
+        : degree( config.degree), line_size( line_size), streams( config.streams)
+    {
+        if ( streams.empty())
+            throw InvalidDataPrefetcher( "at least one stream should be tracked");
+    }
+
+    void train( Addr /* pc */, Addr addr, bool is_trigger, std::vector<Addr>* addrs) final
+    {
+        const Addr line = addr / line_size;
+        for ( auto& stream : streams) {
+            if ( stream.is_valid && stream.direction != 0 && is_in_window( line, stream.last_line, stream.direction)) {
+                advance( &stream, line, addrs);
+                return;
+            }
+        }
+
+        if ( !is_trigger)
+            return;
+
+        for ( auto& stream : streams) {
+            if ( !stream.is_valid || stream.direction != 0)
+                continue;
+            for ( const int64 direction : { 1, -1 }) {
+                if ( is_in_window( line, stream.last_line, direction)) {
+                    stream.direction = direction;
+                    advance( &stream, line, addrs);
+                    return;
+                }
+            }
+        }
+
+        auto victim = std::min_element( streams.begin(), streams.end(), []( const auto& lhs, const auto& rhs) {
+            return lhs.last_use < rhs.last_use;
+        });
+        *victim = { line, 0, ++clock, true };
+    }
+
+private:
+    struct Stream
+    {
+        Addr last_line = 0;
+        int64 direction = 0; // 0 if the stream is not confirmed yet
+        uint64 last_use = 0;
+        bool is_valid = false;
+    };
+
+    static const constexpr int64 window = 4; // in lines
+
+    static bool is_in_window( Addr line, Addr last_line, int64 direction)
+    {
+        const auto distance = static_cast<int64>( line - last_line) * direction;
+        return distance > 0 && distance <= window;
+    }
+
+    void advance( Stream* stream, Addr line, std::vector<Addr>* addrs)
+    {
+        stream->last_line = line;
+        stream->last_use = ++clock;
+        for ( uint32 i = 1; i <= degree; ++i)
+            addrs->push_back( ( line + static_cast<Addr>( stream->direction * i)) * line_size);
+    }
+
+    const uint32 degree;
+    const uint32 line_size;
+    std::vector<Stream> streams;
+    uint64 clock = 0;
+};
+
+template<typename T>
+std::unique_ptr<DataPrefetcher> create_prefetcher( const PerfConfig::DataPrefetch& config, uint32 line_size)
+{
+    return std::make_unique<T>( config, line_size);
+}
+
+} // namespace
+
+std::unique_ptr<DataPrefetcher> DataPrefetcher::create( const PerfConfig::DataPrefetch& config, uint32 line_size)
+{
+    using Creator = std::unique_ptr<DataPrefetcher> (*)( const PerfConfig::DataPrefetch&, uint32);
+    static const std::map<std::string, Creator> creators = {
+        { "no-prefetch", create_prefetcher<NoDataPrefetcher> },
+        { "next-line",   create_prefetcher<NextLineDataPrefetcher> },
+        { "stride",      create_prefetcher<StrideDataPrefetcher> },
+        { "stream",      create_prefetcher<StreamDataPrefetcher> },
+    };
+
+    const auto it = creators.find( config.method);
+    if ( it == creators.end()) {
+        std::string list;
+        for ( const auto& creator : creators)
+            list += creator.first + '\n';
+        throw InvalidDataPrefetcher( "\"" + config.method + "\" data prefetch method is not defined, supported methods are:\n" + list);
+    }
+
+    if ( config.degree == 0)
+        throw InvalidDataPrefetcher( "prefetch degree should be greater than zero");
+
+    return it->second( config, line_size);
+}
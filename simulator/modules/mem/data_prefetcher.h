@@ -0,0 +1,43 @@
+/*
+ * data_prefetcher.h - hardware prefetchers of level 1 data cache
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef DATA_PREFETCHER_H
+#define DATA_PREFETCHER_H
+
+#include <infra/exception.h>
+#include <infra/types.h>
+#include <modules/core/perf_config.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+struct InvalidDataPrefetcher final : Exception
+{
+    explicit InvalidDataPrefetcher( const std::string& msg)
+        : Exception( "Invalid data prefetcher configuration", msg)
+    { }
+};
+
+// Prefetcher observes demand accesses and proposes addresses,
+// data cache filters out cached lines and throttles the rest
+class DataPrefetcher
+{
+public:
+    static std::unique_ptr<DataPrefetcher> create( const PerfConfig::DataPrefetch& config, uint32 line_size);
+
+    DataPrefetcher() = default;
+    virtual ~DataPrefetcher() = default;
+    DataPrefetcher( const DataPrefetcher&) = delete;
+    DataPrefetcher( DataPrefetcher&&) = delete;
+    DataPrefetcher& operator=( const DataPrefetcher&) = delete;
+    DataPrefetcher& operator=( DataPrefetcher&&) = delete;
+
+    // 'is_trigger' is set for misses and for first accesses to prefetched lines,
+    // so useful prefetches keep the prefetcher running ahead of demand accesses
+    virtual void train( Addr pc, Addr addr, bool is_trigger, std::vector<Addr>* addrs) = 0;
+};
+
+#endif // DATA_PREFETCHER_H
@@ -6,18 +6,48 @@
 #include "mem.h"
 #include <memory/memory.h>
 
+#include <algorithm>
+
 template <typename FuncInstr>
-Mem<FuncInstr>::Mem( Module* parent) : Module( parent, "mem")
+Mem<FuncInstr>::Mem( Module* parent, const PerfConfig& config) : Module( parent, "mem")
+    , dcache( config.get_dcache(), config.dcache_timing)
 {
-    wp_datapath = make_write_port<Instr>("MEMORY_2_WRITEBACK", Port::BW);
+    dcache.set_prefetcher( config.data_prefetch);
+
+    wp_datapath = make_write_port<Instr>("MEMORY_2_WRITEBACK", config.pipeline.mem_ports);
     rp_datapath = make_read_port<Instr>("EXECUTE_2_MEMORY", Port::LATENCY);
     rp_trap = make_read_port<bool>("WRITEBACK_2_ALL_FLUSH", Port::LATENCY);
 
     rp_flush = make_read_port<bool>("BRANCH_2_ALL_FLUSH", Port::LATENCY);
 
-    wp_bypass = make_write_port<InstructionOutput>("MEMORY_2_EXECUTE_BYPASS", Port::BW);
+    wp_bypass = make_write_port<InstructionOutput>("MEMORY_2_EXECUTE_BYPASS", config.pipeline.mem_ports);
+    wp_stall = make_write_port<Latency>("MEMORY_2_CORE_STALL", Port::BW);
+}
+
+template <typename FuncInstr>
+Latency Mem<FuncInstr>::access_data_cache( const Instr& instr, Cycle cycle)
+{
+    // Pipeline cycles do not advance while the core is stalled
+    const auto now = cycle + Latency( narrow_cast<int64>( stalled_cycles));
+    const auto addr = instr.get_mem_addr();
+
+    // Atomics and store-conditionals wait for data, but take the line in exclusive state as stores do.
+    // Load-reserved is a plain load for coherence, a shared copy is enough.
+    const bool waits_for_data = instr.is_load();
+    if ( coherent_cache != nullptr)
+    {
+        const auto result = coherent_cache->access( addr, instr.is_store());
+        return waits_for_data ? dcache.load( addr, now, result) : dcache.store( addr, now, result);
+    }
+
+    const auto stall = waits_for_data ? dcache.load( addr, now) : dcache.store( addr, now);
+
+    // Prefetched lines would bypass the coherence directory, so prefetching is private-cache only
+    dcache.prefetch( instr.get_PC(), addr, now);
+    return stall;
 }
 
+
 template <typename FuncInstr>
 void Mem<FuncInstr>::clock( Cycle cycle)
 {
@@ -40,19 +70,39 @@ void Mem<FuncInstr>::clock( Cycle cycle)
         return;
     }
 
-    auto instr = rp_datapath->read( cycle);
+    /* memory ports work in parallel, so the core waits for the longest access */
+    auto stall = 0_lt;
+    while ( rp_datapath->is_ready( cycle))
+        stall = std::max( stall, access_memory( rp_datapath->read( cycle), cycle));
+
+    /* stall the core until data cache serves the accesses */
+    if ( stall != 0_lt)
+    {
+        wp_stall->write( stall, cycle);
+        stalled_cycles += stall.to_size_t();
+        if ( hierarchy != nullptr)
+            hierarchy->add_pipeline_stall( stall);
+    }
+}
 
+template <typename FuncInstr>
+Latency Mem<FuncInstr>::access_memory( Instr instr, Cycle cycle)
+{
     /* perform required loads and stores */
-    memory->load_store( &instr);
-    
+    memory->load_store( &instr, &reservation);
+
+    const auto stall = instr.is_load() || instr.is_store() ? access_data_cache( instr, cycle) : 0_lt;
+    if ( stall != 0_lt)
+        sout << "L1D stall for " << stall << " cycles ";
+
     /* bypass data */
-    wp_bypass->write( instr.get_v_dst(), cycle);
+    wp_bypass->write( instr.get_bypassed_data(), cycle);
     
     /* data path */
     wp_datapath->write( std::move( instr), cycle);
+    return stall;
 }
 
-
 #include <mips/mips.h>
 #include <risc_v/risc_v.h>
 
@@ -8,20 +8,29 @@
 #define MEM_H
 
 #include <func_sim/operation.h>
+#include "data_cache.h"
+#include "memory_hierarchy.h"
+
+#include <memory/memory.h>
+#include <modules/core/perf_config.h>
 #include <modules/core/perf_instr.h>
+#include <modules/mem/coherence/mesi_directory.h>
 #include <modules/ports_instance.h>
 
-class FuncMemory;
-
 template <typename FuncInstr>
 class Mem : public Module
 {
     using Instr = PerfInstr<FuncInstr>;
     using RegisterUInt = typename FuncInstr::RegisterUInt;
-    using InstructionOutput = std::array< RegisterUInt, MAX_DST_NUM>;
+    using InstructionOutput = BypassedData<RegisterUInt>;
     
     private:
         std::shared_ptr<FuncMemory> memory;
+        Reservation reservation;
+        std::shared_ptr<CoherentCache> coherent_cache;
+        DataCache dcache;
+        std::shared_ptr<MemoryHierarchy> hierarchy;
+        uint64 stalled_cycles = 0;
 
         WritePort<Instr>* wp_datapath = nullptr;
         ReadPort<Instr>* rp_datapath = nullptr;
@@ -30,11 +39,22 @@ class Mem : public Module
         ReadPort<bool>* rp_trap = nullptr;
 
         WritePort<InstructionOutput>* wp_bypass = nullptr;
+        WritePort<Latency>* wp_stall = nullptr;
+
+        Latency access_data_cache( const Instr& instr, Cycle cycle);
+        Latency access_memory( Instr instr, Cycle cycle);
 
     public:
-        explicit Mem( Module* parent);
+        Mem( Module* parent, const PerfConfig& config);
         void clock( Cycle cycle);
         void set_memory( const std::shared_ptr<FuncMemory>& mem) { memory = mem; }
+        void set_coherent_cache( std::shared_ptr<CoherentCache> cache) { coherent_cache = std::move( cache); }
+        void set_memory_hierarchy( std::shared_ptr<MemoryHierarchy> value)
+        {
+            hierarchy = std::move( value);
+            dcache.set_lower_level( hierarchy.get());
+        }
+        const auto& get_dcache_statistics() const { return dcache.get_statistics(); }
 };
 
 
@@ -0,0 +1,149 @@
+/*
+ * memory_hierarchy.cpp - timing model of unified lower cache levels and DRAM
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include "memory_hierarchy.h"
+
+#include <algorithm>
+#include <ostream>
+
+static Latency to_latency( uint64 cycles)
+{
+    return Latency( narrow_cast<int64>( cycles));
+}
+
+DRAM::DRAM( const PerfConfig::DRAM& config)
+    : row_size( config.row_size)
+    , row_hit_latency( to_latency( config.row_hit_latency))
+    , row_empty_latency( to_latency( config.row_empty_latency))
+    , row_conflict_latency( to_latency( config.row_conflict_latency))
+    , burst_latency( to_latency( config.burst_cycles))
+    , banks( config.banks)
+{
+    if ( config.banks == 0)
+        throw InvalidMemoryHierarchyConfiguration( "at least one DRAM bank is required");
+
+    if ( row_size == 0)
+        throw InvalidMemoryHierarchyConfiguration( "DRAM row size should be greater than zero");
+}
+
+Latency DRAM::access( Addr addr, Cycle now, bool is_write)
+{
+    ++( is_write ? stats.writes : stats.reads);
+
+    const Addr row = addr / row_size;
+    auto& bank = banks[ narrow_cast<size_t>( row % banks.size())];
+
+    const auto start = std::max( now, bank.ready);
+    stats.queue_cycles += ( start - now).to_size_t();
+
+    Latency latency = row_empty_latency;
+    if ( !bank.is_open) {
+        ++stats.row_empty;
+    }
+    else if ( bank.row == row) {
+        ++stats.row_hits;
+        latency = row_hit_latency;
+    }
+    else {
+        ++stats.row_conflicts;
+        latency = row_conflict_latency;
+    }
+
+    bank.is_open = true;
+    bank.row = row;
+    bank.ready = start + latency;
+
+    bus_ready = std::max( bank.ready, bus_ready) + burst_latency;
+    const auto result = bus_ready - now;
+    stats.total_latency += result.to_size_t();
+    return result;
+}
+
+MemoryHierarchy::MemoryHierarchy( const PerfConfig& config)
+    : memory_latency( to_latency( config.dcache_timing.miss_latency))
+{
+    const auto add_level = [this]( const std::string& name, const PerfConfig::Cache& geometry, uint64 latency) {
+        if ( geometry.size == 0)
+            return;
+        levels.push_back( { name, to_latency( latency), geometry.line_size, CacheLines( geometry), {}});
+    };
+
+    add_level( "L2", config.memory.l2, config.memory.l2_latency);
+    add_level( "L3", config.memory.l3, config.memory.l3_latency);
+
+    if ( config.memory.dram.banks != 0)
+        dram = std::make_unique<DRAM>( config.memory.dram);
+}
+
+Latency MemoryHierarchy::get_worst_latency() const
+{
+    auto result = dram == nullptr ? memory_latency : dram->get_worst_latency();
+    for ( const auto& level : levels)
+        result = result + level.latency;
+    return result;
+}
+
+bool MemoryHierarchy::is_enabled( const PerfConfig& config)
+{
+    return config.memory.l2.size != 0 || config.memory.l3.size != 0 || config.memory.dram.banks != 0;
+}
+
+Latency MemoryHierarchy::access_memory( Addr addr, Cycle now, bool is_write)
+{
+    if ( dram == nullptr)
+        return memory_latency;
+
+    return dram->access( addr, now, is_write);
+}
+
+Latency MemoryHierarchy::access( size_t level_num, Addr addr, Cycle now, bool is_write)
+{
+    if ( level_num == levels.size())
+        return access_memory( addr, now, is_write);
+
+    auto& level = levels[ level_num];
+    const Addr line = level.get_line( addr);
+    ++( is_write ? level.stats.writes : level.stats.reads);
+
+    if ( level.lines.lookup( line, is_write))
+        return level.latency;
+
+    ++( is_write ? level.stats.write_misses : level.stats.read_misses);
+
+    // Written lines come from the upper level, so they are not read from below
+    const auto victim = level.lines.fill( line, is_write);
+    const auto lookup_done = now + level.latency;
+    if ( victim.is_dirty) {
+        ++level.stats.writebacks;
+        access( level_num + 1, victim.addr, lookup_done, true);
+    }
+
+    if ( is_write)
+        return level.latency;
+
+    return level.latency + access( level_num + 1, line, lookup_done, false);
+}
+
+void MemoryHierarchy::dump_statistics( std::ostream& out) const
+{
+    const auto rate = []( uint64 misses, uint64 accesses) {
+        return accesses != 0 ? 100.0 * double( misses) / double( accesses) : 0;
+    };
+
+    for ( const auto& level : levels)
+        out << level.name << " misses:  reads - " << rate( level.stats.read_misses, level.stats.reads)
+            << "% of " << level.stats.reads << ", writes - " << rate( level.stats.write_misses, level.stats.writes)
+            << "% of " << level.stats.writes << ", writebacks - " << level.stats.writebacks << std::endl;
+
+    if ( dram == nullptr)
+        return;
+
+    const auto& stats = dram->get_statistics();
+    const auto accesses = stats.reads + stats.writes;
+    out << "DRAM:       reads - " << stats.reads << ", writes - " << stats.writes
+        << ", row hits - " << rate( stats.row_hits, accesses) << "%, row conflicts - " << rate( stats.row_conflicts, accesses) << "%" << std::endl
+        << "DRAM time:  average latency - " << ( accesses != 0 ? double( stats.total_latency) / double( accesses) : 0)
+        << " cycles, queueing - " << stats.queue_cycles << " cycles" << std::endl;
+}
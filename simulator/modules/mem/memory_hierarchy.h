@@ -0,0 +1,138 @@
+/*
+ * memory_hierarchy.h - timing model of unified lower cache levels and DRAM
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef MEMORY_HIERARCHY_H
+#define MEMORY_HIERARCHY_H
+
+#include "cache_lines.h"
+
+#include <infra/exception.h>
+#include <infra/ports/timing.h>
+#include <modules/core/perf_config.h>
+
+#include <algorithm>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct InvalidMemoryHierarchyConfiguration final : Exception
+{
+    explicit InvalidMemoryHierarchyConfiguration( const std::string& msg)
+        : Exception( "Invalid memory hierarchy configuration", msg)
+    { }
+};
+
+struct CacheLevelStatistics
+{
+    uint64 reads = 0;
+    uint64 writes = 0;          // writebacks from upper levels and write-through stores
+    uint64 read_misses = 0;
+    uint64 write_misses = 0;
+    uint64 writebacks = 0;      // dirty lines evicted to the next level
+};
+
+struct DRAMStatistics
+{
+    uint64 reads = 0;
+    uint64 writes = 0;
+    uint64 row_hits = 0;
+    uint64 row_empty = 0;
+    uint64 row_conflicts = 0;
+    uint64 queue_cycles = 0;    // cycles spent waiting for busy banks
+    uint64 total_latency = 0;
+};
+
+// Open-page DRAM: each bank keeps the last accessed row in its row buffer.
+// Consecutive rows are interleaved between banks, banks serve requests
+// in parallel, but line transfers are serialized on the shared data bus.
+class DRAM
+{
+public:
+    explicit DRAM( const PerfConfig::DRAM& config);
+
+    Latency access( Addr addr, Cycle now, bool is_write);
+    Latency get_worst_latency() const { return std::max( { row_hit_latency, row_empty_latency, row_conflict_latency}) + burst_latency; }
+    const DRAMStatistics& get_statistics() const { return stats; }
+
+private:
+    struct Bank
+    {
+        bool is_open = false;
+        Addr row = 0;
+        Cycle ready = 0_cl;
+    };
+
+    const uint32 row_size;
+    const Latency row_hit_latency;
+    const Latency row_empty_latency;
+    const Latency row_conflict_latency;
+    const Latency burst_latency;
+
+    std::vector<Bank> banks;
+    Cycle bus_ready = 0_cl;
+    DRAMStatistics stats;
+};
+
+// Unified non-inclusive write-back cache levels below L1 caches.
+// Instruction fetch and data accesses share the levels and the DRAM,
+// so they compete for capacity, banks and the data bus.
+class MemoryHierarchy
+{
+public:
+    explicit MemoryHierarchy( const PerfConfig& config);
+
+    static bool is_enabled( const PerfConfig& config);
+
+    // Return number of cycles until the line is delivered to L1
+    Latency read( Addr addr, Cycle now) { return track( now, access( 0, addr, now, false)); }
+
+    // Return number of cycles until the line is accepted
+    Latency write( Addr addr, Cycle now) { return track( now, access( 0, addr, now, true)); }
+
+    // Pipeline cycles do not advance while the core is stalled, but memory does
+    void add_pipeline_stall( Latency stall) { stall_cycles += stall.to_size_t(); }
+    Cycle get_time( Cycle pipeline_cycle) const { return pipeline_cycle + Latency( narrow_cast<int64>( stall_cycles)); }
+
+    // Latency of a read which misses everywhere and waits for a row conflict, without queueing
+    Latency get_worst_latency() const;
+
+    // Pipeline may wait for memory as long as some request is not served yet
+    bool has_outstanding_requests( Cycle pipeline_cycle) const { return get_time( pipeline_cycle) < last_request_done; }
+
+    size_t get_levels_num() const { return levels.size(); }
+    const CacheLevelStatistics& get_statistics( size_t level) const { return levels.at( level).stats; }
+    const DRAM* get_dram() const { return dram.get(); }
+
+    void dump_statistics( std::ostream& out) const;
+
+private:
+    struct CacheLevel
+    {
+        std::string name;
+        Latency latency;
+        uint32 line_size;
+        CacheLines lines;
+        CacheLevelStatistics stats;
+
+        Addr get_line( Addr addr) const { return addr & ~Addr{ line_size - 1}; }
+    };
+
+    Latency access( size_t level, Addr addr, Cycle now, bool is_write);
+    Latency access_memory( Addr addr, Cycle now, bool is_write);
+    Latency track( Cycle now, Latency latency)
+    {
+        last_request_done = std::max( last_request_done, now + latency);
+        return latency;
+    }
+
+    std::vector<CacheLevel> levels;
+    std::unique_ptr<DRAM> dram;
+    const Latency memory_latency; // used if DRAM model is disabled
+    uint64 stall_cycles = 0;
+    Cycle last_request_done = 0_cl;
+};
+
+#endif // MEMORY_HIERARCHY_H
@@ -0,0 +1,373 @@
+/**
+ * Unit tests for data cache, prefetchers and lower memory levels timing models
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include <catch.hpp>
+#include <modules/mem/cache_lines.h>
+#include <modules/mem/coherence/mesi_directory.h>
+#include <modules/mem/data_cache.h>
+#include <modules/mem/data_prefetcher.h>
+#include <modules/mem/memory_hierarchy.h>
+
+static PerfConfig::Cache get_small_cache()
+{
+    PerfConfig::Cache cache;
+    cache.size = 256;
+    cache.ways = 2;
+    cache.line_size = 64;
+    return cache;
+}
+
+static PerfConfig::DataCacheTiming get_timing( uint32 mshrs, const std::string& write_policy)
+{
+    PerfConfig::DataCacheTiming timing;
+    timing.hit_latency = 2;
+    timing.miss_latency = 20;
+    timing.mshrs = mshrs;
+    timing.write_policy = write_policy;
+    return timing;
+}
+
+TEST_CASE( "CacheLines: victims and dirty bits are kept per way")
+{
+    CacheLines lines( get_small_cache());
+    CHECK_FALSE( lines.fill( 0x1000, false).is_valid);
+    CHECK_FALSE( lines.fill( 0x1080, true).is_valid);
+    CHECK( lines.lookup( 0x1000, true));
+    CHECK_FALSE( lines.lookup( 0x1100, true));
+
+    // Both lines are dirty, the least recently used one is evicted first
+    auto victim = lines.fill( 0x1100, false);
+    CHECK( victim.is_valid);
+    CHECK( victim.addr == 0x1080);
+    CHECK( victim.is_dirty);
+    CHECK_FALSE( lines.is_present( 0x1080));
+
+    lines.set_dirty( 0x1100);
+    CHECK( lines.lookup( 0x1000, false));
+    victim = lines.fill( 0x1180, false);
+    CHECK( victim.addr == 0x1100);
+    CHECK( victim.is_dirty);
+
+    victim = lines.fill( 0x1200, false);
+    CHECK( victim.addr == 0x1000);
+    CHECK( victim.is_dirty);
+    victim = lines.fill( 0x1280, false);
+    CHECK( victim.addr == 0x1180);
+    CHECK_FALSE( victim.is_dirty);
+}
+
+TEST_CASE( "CacheLines: ideal tag arrays do not evict")
+{
+    auto geometry = get_small_cache();
+    geometry.type = "infinite";
+    CacheLines lines( geometry);
+    for ( Addr line = 0; line < 0x10000; line += 64)
+        CHECK_FALSE( lines.fill( line, true).is_valid);
+    CHECK( lines.is_present( 0x1000));
+}
+
+TEST_CASE( "DataCache: invalid configuration")
+{
+    CHECK_THROWS_AS( DataCache( get_small_cache(), get_timing( 0, "write-back")), InvalidDataCacheConfiguration);
+    CHECK_THROWS_AS( DataCache( get_small_cache(), get_timing( 1, "write-around")), InvalidDataCacheConfiguration);
+}
+
+TEST_CASE( "DataCache: load miss and hit")
+{
+    DataCache cache( get_small_cache(), get_timing( 2, "write-back"));
+    CHECK( cache.load( 0x1000, 0_cl) == 19_lt);
+    CHECK( cache.load( 0x1008, 20_cl) == 1_lt);
+    CHECK( cache.get_statistics().loads == 2);
+    CHECK( cache.get_statistics().load_misses == 1);
+    CHECK( cache.get_statistics().stall_cycles == 20);
+}
+
+TEST_CASE( "DataCache: secondary miss waits for the primary one")
+{
+    DataCache cache( get_small_cache(), get_timing( 2, "write-back"));
+    CHECK( cache.store( 0x1000, 0_cl) == 1_lt);
+    CHECK( cache.get_busy_mshrs( 1_cl) == 1);
+    CHECK( cache.load( 0x1010, 5_cl) == 14_lt);
+    CHECK( cache.get_statistics().mshr_merges == 1);
+    CHECK( cache.get_busy_mshrs( 20_cl) == 0);
+}
+
+TEST_CASE( "DataCache: store misses overlap until MSHRs are exhausted")
+{
+    DataCache cache( get_small_cache(), get_timing( 2, "write-back"));
+    CHECK( cache.store( 0x1000, 0_cl) == 1_lt);
+    CHECK( cache.store( 0x2000, 1_cl) == 1_lt);
+    CHECK( cache.store( 0x3000, 2_cl) == 18_lt);
+    CHECK( cache.get_statistics().mshr_full == 1);
+    CHECK( cache.get_statistics().store_misses == 3);
+}
+
+TEST_CASE( "DataCache: write-back of dirty victim")
+{
+    DataCache cache( get_small_cache(), get_timing( 4, "write-back"));
+    cache.store( 0x0, 0_cl);
+    cache.load( 0x80, 100_cl);
+    cache.load( 0x100, 200_cl);
+    CHECK( cache.get_statistics().writebacks == 1);
+    CHECK( cache.load( 0x0, 300_cl) == 19_lt);
+}
+
+TEST_CASE( "DataCache: write-through does not allocate")
+{
+    DataCache cache( get_small_cache(), get_timing( 1, "write-through"));
+    CHECK( cache.store( 0x1000, 0_cl) == 1_lt);
+    CHECK( cache.store( 0x1000, 1_cl) == 19_lt);
+    CHECK( cache.load( 0x1000, 100_cl) == 19_lt);
+    CHECK( cache.get_statistics().memory_writes == 2);
+    CHECK( cache.get_statistics().store_misses == 2);
+    CHECK( cache.get_statistics().writebacks == 0);
+}
+
+TEST_CASE( "DataCache: hits and misses are taken from coherence directory")
+{
+    DataCache cache( get_small_cache(), get_timing( 2, "write-back"));
+    CoherenceResult remote_hit;
+    remote_hit.latency = 30;
+    CHECK( cache.load( 0x1000, 0_cl, remote_hit) == 29_lt);
+
+    CoherenceResult memory_miss;
+    memory_miss.memory_access = true;
+    memory_miss.latency = 10;
+    CHECK( cache.load( 0x2000, 100_cl, memory_miss) == 29_lt);
+
+    CoherenceResult hit;
+    hit.hit = true;
+    CHECK( cache.load( 0x3000, 200_cl, hit) == 1_lt);
+}
+
+static PerfConfig get_hierarchy_config( uint32 l2_size, uint32 l2_ways, uint32 dram_banks)
+{
+    PerfConfig config;
+    config.dcache_timing = get_timing( 2, "write-back");
+    config.memory.l2 = { "LRU", l2_size, l2_ways, 64 };
+    config.memory.l2_latency = 10;
+    config.memory.dram.banks = dram_banks;
+    config.memory.dram.row_size = 1024;
+    return config;
+}
+
+TEST_CASE( "MemoryHierarchy: disabled by default")
+{
+    CHECK_FALSE( MemoryHierarchy::is_enabled( PerfConfig()));
+    CHECK( MemoryHierarchy::is_enabled( get_hierarchy_config( 0, 1, 1)));
+    CHECK( MemoryHierarchy::is_enabled( get_hierarchy_config( 256, 1, 0)));
+}
+
+TEST_CASE( "MemoryHierarchy: invalid DRAM configuration")
+{
+    auto config = get_hierarchy_config( 0, 1, 2);
+    config.memory.dram.row_size = 0;
+    CHECK_THROWS_AS( MemoryHierarchy( config), InvalidMemoryHierarchyConfiguration);
+}
+
+TEST_CASE( "DRAM: row buffer hits, misses and conflicts")
+{
+    DRAM dram( get_hierarchy_config( 0, 1, 2).memory.dram);
+    CHECK( dram.access( 0x0, 0_cl, false) == 44_lt);
+    CHECK( dram.access( 0x40, 100_cl, false) == 24_lt);
+    CHECK( dram.access( 0x800, 200_cl, false) == 64_lt);
+    CHECK( dram.access( 0x400, 300_cl, true) == 44_lt);
+    CHECK( dram.get_statistics().row_hits == 1);
+    CHECK( dram.get_statistics().row_empty == 2);
+    CHECK( dram.get_statistics().row_conflicts == 1);
+    CHECK( dram.get_statistics().writes == 1);
+}
+
+TEST_CASE( "DRAM: banks work in parallel, but share the bus")
+{
+    DRAM dram( get_hierarchy_config( 0, 1, 2).memory.dram);
+    CHECK( dram.access( 0x0, 0_cl, false) == 44_lt);
+    CHECK( dram.access( 0x400, 0_cl, false) == 48_lt);
+    CHECK( dram.access( 0x40, 0_cl, false) == 64_lt);
+    CHECK( dram.get_statistics().queue_cycles == 40);
+}
+
+TEST_CASE( "MemoryHierarchy: L2 hit and miss")
+{
+    MemoryHierarchy hierarchy( get_hierarchy_config( 256, 2, 0));
+    CHECK( hierarchy.read( 0x1000, 0_cl) == 30_lt);
+    CHECK( hierarchy.read( 0x1020, 50_cl) == 10_lt);
+    CHECK( hierarchy.get_levels_num() == 1);
+    CHECK( hierarchy.get_statistics( 0).reads == 2);
+    CHECK( hierarchy.get_statistics( 0).read_misses == 1);
+    CHECK( hierarchy.get_dram() == nullptr);
+}
+
+TEST_CASE( "MemoryHierarchy: dirty victim delays a read from DRAM")
+{
+    MemoryHierarchy hierarchy( get_hierarchy_config( 128, 1, 2));
+    CHECK( hierarchy.write( 0x0, 0_cl) == 10_lt);
+    CHECK( hierarchy.read( 0x80, 10_cl) == 74_lt);
+    CHECK( hierarchy.get_statistics( 0).write_misses == 1);
+    CHECK( hierarchy.get_statistics( 0).writebacks == 1);
+    CHECK( hierarchy.get_dram()->get_statistics().writes == 1);
+    CHECK( hierarchy.get_dram()->get_statistics().reads == 1);
+    CHECK( hierarchy.get_dram()->get_statistics().row_hits == 1);
+    CHECK( hierarchy.get_worst_latency() == 74_lt);
+}
+
+TEST_CASE( "MemoryHierarchy: L3 keeps lines evicted from L2")
+{
+    auto config = get_hierarchy_config( 128, 1, 0);
+    config.memory.l3 = { "LRU", 1024, 4, 64 };
+    config.memory.l3_latency = 30;
+    MemoryHierarchy hierarchy( config);
+    CHECK( hierarchy.read( 0x0, 0_cl) == 60_lt);
+    CHECK( hierarchy.read( 0x80, 100_cl) == 60_lt);
+    CHECK( hierarchy.read( 0x0, 200_cl) == 40_lt);
+    CHECK( hierarchy.get_levels_num() == 2);
+    CHECK( hierarchy.get_statistics( 1).reads == 3);
+    CHECK( hierarchy.get_statistics( 1).read_misses == 2);
+    CHECK( hierarchy.get_worst_latency() == 60_lt);
+}
+
+TEST_CASE( "MemoryHierarchy: pipeline stalls advance memory time")
+{
+    MemoryHierarchy hierarchy( get_hierarchy_config( 256, 2, 0));
+    CHECK( hierarchy.get_time( 10_cl) == 10_cl);
+    hierarchy.add_pipeline_stall( 5_lt);
+    CHECK( hierarchy.get_time( 10_cl) == 15_cl);
+}
+
+TEST_CASE( "MemoryHierarchy: outstanding requests")
+{
+    MemoryHierarchy hierarchy( get_hierarchy_config( 128, 1, 2));
+    CHECK_FALSE( hierarchy.has_outstanding_requests( 0_cl));
+    CHECK( hierarchy.write( 0x0, 0_cl) == 10_lt);
+    CHECK( hierarchy.read( 0x80, 10_cl) == 74_lt);
+    CHECK( hierarchy.has_outstanding_requests( 83_cl));
+    CHECK_FALSE( hierarchy.has_outstanding_requests( 84_cl));
+    hierarchy.add_pipeline_stall( 5_lt);
+    CHECK_FALSE( hierarchy.has_outstanding_requests( 79_cl));
+}
+
+TEST_CASE( "DataCache: misses are served by L2")
+{
+    auto config = get_hierarchy_config( 4096, 4, 0);
+    MemoryHierarchy hierarchy( config);
+    DataCache cache( get_small_cache(), config.dcache_timing);
+    cache.set_lower_level( &hierarchy);
+    CHECK( cache.store( 0x1000, 0_cl) == 1_lt);
+    CHECK( cache.load( 0x2000, 100_cl) == 29_lt);
+    CHECK( cache.load( 0x3000, 200_cl) == 29_lt);
+    CHECK( cache.load( 0x1000, 300_cl) == 9_lt);
+    CHECK( cache.get_statistics().writebacks == 1);
+    CHECK( hierarchy.get_statistics( 0).writes == 1);
+    CHECK( hierarchy.get_statistics( 0).write_misses == 0);
+    CHECK( hierarchy.get_statistics( 0).read_misses == 3);
+}
+
+static PerfConfig::DataPrefetch get_prefetch( const std::string& method, uint32 degree)
+{
+    PerfConfig::DataPrefetch prefetch;
+    prefetch.method = method;
+    prefetch.degree = degree;
+    prefetch.queue_size = 2;
+    return prefetch;
+}
+
+static std::vector<Addr> train( DataPrefetcher* prefetcher, Addr pc, Addr addr, bool is_trigger)
+{
+    std::vector<Addr> addrs;
+    prefetcher->train( pc, addr, is_trigger, &addrs);
+    return addrs;
+}
+
+TEST_CASE( "DataPrefetcher: invalid configuration")
+{
+    CHECK_THROWS_AS( DataPrefetcher::create( get_prefetch( "previous-line", 1), 64), InvalidDataPrefetcher);
+    CHECK_THROWS_AS( DataPrefetcher::create( get_prefetch( "next-line", 0), 64), InvalidDataPrefetcher);
+
+    auto no_table = get_prefetch( "stride", 1);
+    no_table.table_size = 0;
+    CHECK_THROWS_AS( DataPrefetcher::create( no_table, 64), InvalidDataPrefetcher);
+
+    auto no_streams = get_prefetch( "stream", 1);
+    no_streams.streams = 0;
+    CHECK_THROWS_AS( DataPrefetcher::create( no_streams, 64), InvalidDataPrefetcher);
+}
+
+TEST_CASE( "DataPrefetcher: next line")
+{
+    auto prefetcher = DataPrefetcher::create( get_prefetch( "next-line", 2), 64);
+    CHECK( train( prefetcher.get(), 0x400, 0x1000, true) == std::vector<Addr>{ 0x1040, 0x1080 });
+    CHECK( train( prefetcher.get(), 0x400, 0x1040, false).empty());
+    CHECK( train( DataPrefetcher::create( get_prefetch( "no-prefetch", 2), 64).get(), 0x400, 0x1000, true).empty());
+}
+
+TEST_CASE( "DataPrefetcher: PC stride")
+{
+    auto prefetcher = DataPrefetcher::create( get_prefetch( "stride", 2), 64);
+    CHECK( train( prefetcher.get(), 0x400, 0x1000, true).empty());
+    CHECK( train( prefetcher.get(), 0x400, 0x1100, true).empty());
+    CHECK( train( prefetcher.get(), 0x400, 0x1200, false) == std::vector<Addr>{ 0x1300, 0x1400 });
+
+    // Short strides request next lines
+    CHECK( train( prefetcher.get(), 0x404, 0x2008, true).empty());
+    CHECK( train( prefetcher.get(), 0x404, 0x2004, false).empty());
+    CHECK( train( prefetcher.get(), 0x404, 0x2000, false) == std::vector<Addr>{ 0x1fc0, 0x1f80 });
+
+    // Other instruction replaces the entry
+    CHECK( train( prefetcher.get(), 0x400 + 64 * 4, 0x1300, true).empty());
+    CHECK( train( prefetcher.get(), 0x400, 0x1300, false).empty());
+}
+
+TEST_CASE( "DataPrefetcher: stream")
+{
+    auto prefetcher = DataPrefetcher::create( get_prefetch( "stream", 2), 64);
+    CHECK( train( prefetcher.get(), 0, 0x1000, true).empty());
+    CHECK( train( prefetcher.get(), 0, 0x1040, true) == std::vector<Addr>{ 0x1080, 0x10c0 });
+    CHECK( train( prefetcher.get(), 0, 0x1080, false) == std::vector<Addr>{ 0x10c0, 0x1100 });
+    CHECK( train( prefetcher.get(), 0, 0x8000, false).empty());
+
+    CHECK( train( prefetcher.get(), 0, 0x8000, true).empty());
+    CHECK( train( prefetcher.get(), 0, 0x7fc0, true) == std::vector<Addr>{ 0x7f80, 0x7f40 });
+}
+
+TEST_CASE( "DataCache: prefetches are useful, late and useless")
+{
+    DataCache cache( get_small_cache(), get_timing( 4, "write-back"));
+    cache.set_prefetcher( get_prefetch( "next-line", 1));
+
+    CHECK( cache.load( 0x1000, 0_cl) == 19_lt);
+    cache.prefetch( 0x400, 0x1000, 0_cl);
+    CHECK( cache.get_statistics().prefetches == 1);
+
+    CHECK( cache.load( 0x1040, 10_cl) == 9_lt);
+    cache.prefetch( 0x400, 0x1040, 10_cl);
+    CHECK( cache.load( 0x1080, 100_cl) == 1_lt);
+    cache.prefetch( 0x400, 0x1080, 100_cl);
+
+    CHECK( cache.get_statistics().prefetches == 3);
+    CHECK( cache.get_statistics().useful_prefetches == 2);
+    CHECK( cache.get_statistics().late_prefetches == 1);
+    CHECK( cache.get_statistics().load_misses == 1);
+
+    CHECK( cache.load( 0x2000, 200_cl) == 19_lt);
+    cache.prefetch( 0x400, 0x2000, 200_cl);
+    CHECK( cache.load( 0x3040, 300_cl) == 19_lt);
+    CHECK( cache.get_statistics().useless_prefetches == 1);
+}
+
+TEST_CASE( "DataCache: prefetches do not take the last MSHR")
+{
+    DataCache cache( get_small_cache(), get_timing( 2, "write-back"));
+    cache.set_prefetcher( get_prefetch( "next-line", 4));
+
+    CHECK( cache.load( 0x1000, 0_cl) == 19_lt);
+    cache.prefetch( 0x400, 0x1000, 0_cl);
+    CHECK( cache.get_statistics().prefetches == 0);
+    CHECK( cache.get_statistics().dropped_prefetches == 2);
+
+    CHECK( cache.load( 0x1000, 30_cl) == 1_lt);
+    cache.prefetch( 0x400, 0x1000, 30_cl);
+    CHECK( cache.get_statistics().prefetches == 1);
+    CHECK( cache.get_busy_mshrs( 30_cl) == 1);
+}
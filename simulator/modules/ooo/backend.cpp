@@ -0,0 +1,766 @@
+/*
+ * backend.cpp - out-of-order core: rename, issue, execution and commit
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include "backend.h"
+
+#include <modules/decode/decode.h>
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+template <typename FuncInstr>
+Backend<FuncInstr>::Backend( Module* parent, const PerfConfig& config) : Module( parent, "backend")
+    , width( config.pipeline.width)
+    , rob_size( config.ooo.rob_size)
+    // long ALU is pipelined, but there is only one
+    , unit_ports{ config.pipeline.width, 1, config.pipeline.mem_ports, 1 }
+    , long_alu_latency( config.oracle.alu ? 1_lt : Latency( narrow_cast<int64>( config.long_alu_latency)))
+    , lsq_size( config.ooo.lsq_size)
+    , rename_map( config.ooo.rename_registers, config.smt.threads)
+    , physical_rf( config.ooo.rename_registers)
+    , issue_queues( config.ooo.iq_mode, config.ooo.iq_size)
+    , store_sets( config.ooo.ssit_size, config.ooo.lfst_size)
+    , has_store_sets( config.ooo.memory_dependence == "store-sets")
+    , store_buffer_size( config.ooo.store_buffer_size)
+    , dcache( config.get_dcache(), config.dcache_timing)
+    , flushed_threads( config.smt.threads)
+{
+    if ( config.ooo.rob_size == 0 || config.ooo.lsq_size == 0 || config.ooo.store_buffer_size == 0)
+        throw InvalidOOOConfiguration( "reorder buffer, load-store queue and store buffer can not be empty");
+
+    if ( config.ooo.ssit_size == 0 || config.ooo.lfst_size == 0)
+        throw InvalidOOOConfiguration( "store set tables can not be empty");
+
+    if ( config.ooo.rename_registers < MAX_DST_NUM)
+        throw InvalidOOOConfiguration( "there should be a rename register for each destination of an instruction");
+
+    const bool is_speculative = is_speculative_mode( config.ooo.memory_dependence);
+    threads.reserve( config.smt.threads);
+    for ( uint32 i = 0; i < config.smt.threads; ++i)
+        threads.emplace_back( config.ooo.lsq_size, is_speculative);
+
+    dcache.set_prefetcher( config.data_prefetch);
+
+    rp_datapath = make_read_port<Instr>("FETCH_2_DECODE", Port::LATENCY);
+    rp_stall_datapath = make_read_port<Instr>("DECODE_2_DECODE", Port::LATENCY);
+    rp_flush_fetch = make_read_port<bool>("DECODE_2_FETCH_FLUSH", Port::LATENCY);
+    rp_flush = make_read_port<bool>("BRANCH_2_ALL_FLUSH", Port::LATENCY);
+    rp_trap = make_read_port<bool>("WRITEBACK_2_ALL_FLUSH", Port::LATENCY);
+    rp_retired = make_read_port<InstructionOutput>("WRITEBACK_2_EXECUTE_BYPASS", Port::LATENCY);
+    rp_decode_flush_target = make_read_port<Target>("DECODE_2_FETCH_TARGET", Port::LATENCY);
+    rp_flush_target = make_read_port<Target>("BRANCH_2_FETCH_TARGET", Port::LATENCY);
+    rp_trap_target = make_read_port<Target>("WRITEBACK_2_FETCH_TARGET", Port::LATENCY);
+
+    wp_stall_datapath = make_write_port<Instr>("DECODE_2_DECODE", width);
+    wp_stall = make_write_port<bool>("DECODE_2_FETCH_STALL", Port::BW);
+    wp_flush_fetch = make_write_port<bool>("DECODE_2_FETCH_FLUSH", Port::BW);
+    wp_decode_flush_target = make_write_port<Target>("DECODE_2_FETCH_TARGET", Port::BW);
+    wp_decode_bp_update = make_write_port<BPInterface>("DECODE_2_FETCH", Port::BW);
+    wp_flush = make_write_port<bool>("BRANCH_2_ALL_FLUSH", Port::BW);
+    wp_flush_target = make_write_port<Target>("BRANCH_2_FETCH_TARGET", Port::BW);
+    wp_bp_update = make_write_port<BPInterface>("BRANCH_2_FETCH", Port::BW);
+    wp_execute_datapath = make_write_port<Instr>("EXECUTE_2_WRITEBACK", width);
+    wp_mem_datapath = make_write_port<Instr>("MEMORY_2_WRITEBACK", width);
+    wp_branch_datapath = make_write_port<Instr>("BRANCH_2_WRITEBACK", width);
+}
+
+template <typename FuncInstr>
+ExecutionUnit Backend<FuncInstr>::get_unit( const Instr& instr)
+{
+    if ( instr.is_jump())
+        return UNIT_BRANCH;
+
+    if ( is_memory_access( instr))
+        return UNIT_MEMORY;
+
+    if ( instr.is_long_arithmetic())
+        return UNIT_LONG_ALU;
+
+    return UNIT_ALU;
+}
+
+template <typename FuncInstr>
+bool Backend<FuncInstr>::is_serializing( const Instr& instr)
+{
+    return instr.is_system() || instr.is_atomic() || instr.is_load_reserved() || instr.is_store_conditional();
+}
+
+template <typename FuncInstr>
+bool Backend<FuncInstr>::is_forwardable( const Instr& instr)
+{
+    /* partial stores merge data with memory */
+    const auto full_mask = bitmask<RegisterUInt>( instr.get_mem_size() * CHAR_BIT);
+    return instr.is_store() && !is_serializing( instr)
+        && ( instr.get_mask() & full_mask) == full_mask
+        && !instr.has_trap();
+}
+
+template <typename FuncInstr>
+bool Backend<FuncInstr>::is_speculative_mode( const std::string& mode)
+{
+    if ( mode == "conservative")
+        return false;
+
+    if ( mode == "aggressive" || mode == "store-sets")
+        return true;
+
+    throw InvalidOOOConfiguration( "unknown memory dependence mode " + mode);
+}
+
+template <typename FuncInstr>
+void Backend<FuncInstr>::clock( Cycle cycle)
+{
+    sout << "backend cycle " << std::dec << cycle << ": ";
+
+    has_squash = false;
+    read_flushes( cycle);
+    release_retired( cycle);
+    access_memory( cycle);
+    issue( cycle);
+    commit( cycle);
+    drain_store_buffer( cycle);
+    dispatch( cycle);
+    collect_statistics();
+    first_thread = ( first_thread + 1) % threads.size();
+}
+
+template <typename FuncInstr>
+void Backend<FuncInstr>::read_flushes( Cycle cycle)
+{
+    std::fill( flushed_threads.begin(), flushed_threads.end(), false);
+
+    /* flush signals are sent together with targets of the flushed threads */
+    const auto read_thread = []( ReadPort<Target>* port, Cycle cycle) {
+        return port->is_ready( cycle) ? port->read( cycle).get_thread() : NO_VAL<size_t>;
+    };
+
+    const auto decode_flushed_thread = read_thread( rp_decode_flush_target, cycle);
+    if ( rp_flush_fetch->is_ready( cycle) && rp_flush_fetch->read( cycle))
+        flushed_threads.at( decode_flushed_thread) = true;
+
+    const auto flushed_thread = read_thread( rp_flush_target, cycle);
+    if ( rp_flush->is_ready( cycle) && rp_flush->read( cycle))
+        flushed_threads.at( flushed_thread) = true;
+
+    /* trap or syscall at writeback, architectural register file is up to date */
+    if ( rp_trap->is_ready( cycle) && rp_trap->read( cycle))
+    {
+        // only the simulator interface redirects several threads at once
+        while ( rp_trap_target->is_ready( cycle))
+        {
+            const auto trapped_thread = read_thread( rp_trap_target, cycle);
+            flush( trapped_thread);
+            flushed_threads.at( trapped_thread) = true;
+        }
+        sout << "flush ";
+    }
+}
+
+template <typename FuncInstr>
+void Backend<FuncInstr>::flush( size_t thread)
+{
+    auto& context = threads.at( thread);
+    for ( const auto& entry : context.rob)
+        if ( !entry.is_issued)
+            issue_queues.release( entry.unit);
+
+    context.rob.clear();
+    context.lsq.clear();
+    context.retiring.clear();
+    rename_map.reset( thread);
+}
+
+template <typename FuncInstr>
+void Backend<FuncInstr>::release_retired( Cycle cycle)
+{
+    while ( rp_retired->is_ready( cycle))
+    {
+        const auto retired_id = rp_retired->read( cycle).producer_id;
+        const auto thread = Target::get_thread( retired_id);
+        auto& retiring = threads.at( thread).retiring;
+        while ( !retiring.empty() && retiring.front().id <= retired_id)
+        {
+            for ( const auto physical : retiring.front().prev_dsts)
+                rename_map.release( physical);
+
+            for ( const auto physical : retiring.front().dsts)
+                retire_to_rf( physical, thread);
+
+            retiring.pop_front();
+        }
+    }
+}
+
+template <typename FuncInstr>
+void Backend<FuncInstr>::retire_to_rf( size_t physical, size_t thread)
+{
+    if ( !rename_map.retire( physical, thread))
+        return;
+
+    /* waiting consumers read the value from the architectural register file */
+    for ( auto& entry : threads.at( thread).rob)
+        std::replace( entry.operands.begin(), entry.operands.end(), physical, NO_REGISTER);
+}
+
+template <typename FuncInstr>
+bool Backend<FuncInstr>::is_ready( const Entry& entry, Cycle cycle) const
+{
+    return std::all_of( entry.operands.begin(), entry.operands.end(), [&]( size_t physical) {
+        return physical == NO_REGISTER || physical_rf.is_ready( physical, cycle);
+    });
+}
+
+template <typename FuncInstr>
+typename Backend<FuncInstr>::RegisterUInt Backend<FuncInstr>::read_operand( const Entry& entry, size_t index) const
+{
+    const auto physical = entry.operands.at( index);
+    if ( physical != NO_REGISTER)
+        return physical_rf.read( physical);
+
+    const auto reg = index < SRC_REGISTERS_NUM ? entry.instr.get_src( index) : entry.instr.get_dst( index - SRC_REGISTERS_NUM);
+    return threads.at( get_thread( entry.instr)).rf->read( reg);
+}
+
+template <typename FuncInstr>
+void Backend<FuncInstr>::write_results( Entry* entry, Cycle ready_cycle)
+{
+    const auto& instr = entry->instr;
+
+    /* conditional moves, partial loads and accumulations depend on previous values of destinations */
+    if ( !instr.is_bypassible())
+    {
+        for ( size_t i = 0; i < MAX_DST_NUM; ++i)
+            merge_rf.write( instr.get_dst( i), read_operand( *entry, SRC_REGISTERS_NUM + i));
+
+        merge_rf.write_dst( instr);
+    }
+
+    for ( size_t i = 0; i < MAX_DST_NUM; ++i)
+    {
+        if ( entry->dsts.at( i) == NO_REGISTER)
+            continue;
+
+        const auto value = instr.is_bypassible() ? instr.get_v_dst( i) : merge_rf.read( instr.get_dst( i));
+        physical_rf.write( entry->dsts.at( i), value, ready_cycle);
+    }
+
+    entry->is_executed = true;
+    entry->complete_cycle = ready_cycle;
+}
+
+template <typename FuncInstr>
+Latency Backend<FuncInstr>::access_data_cache( const Instr& instr, Cycle cycle)
+{
+    const auto addr = instr.get_mem_addr();
+    const bool waits_for_data = instr.is_load();
+    if ( coherent_cache != nullptr)
+    {
+        const auto result = coherent_cache->access( addr, instr.is_store());
+        return waits_for_data ? dcache.load( addr, cycle, result) : dcache.store( addr, cycle, result);
+    }
+
+    const auto stall = waits_for_data ? dcache.load( addr, cycle) : dcache.store( addr, cycle);
+    dcache.prefetch( instr.get_PC(), addr, cycle);
+    return stall;
+}
+
+template <typename FuncInstr>
+bool Backend<FuncInstr>::load( Entry* entry, Cycle cycle)
+{
+    auto& thread = threads.at( get_thread( entry->instr));
+    try {
+        thread.memory->load_store( &entry->instr, &thread.reservation);
+    }
+    catch ( const FuncMemoryOutOfRange&) {
+        // wrong path address is not an error until the load becomes the oldest instruction
+        if ( entry != &thread.rob.front())
+            return false;
+        throw;
+    }
+
+    const auto stall = access_data_cache( entry->instr, cycle);
+    thread.lsq.set_executed( entry->instr.get_sequence_id(), NO_VAL64);
+    write_results( entry, cycle + 1_lt + stall);
+    sout << entry->instr << ( stall != 0_lt ? " (L1D miss)\n" : "\n");
+    return true;
+}
+
+template <typename FuncInstr>
+void Backend<FuncInstr>::forward( Entry* entry, uint64 store_id, Cycle cycle)
+{
+    /* store data is put over the memory for the load only */
+    auto& thread = threads.at( get_thread( entry->instr));
+    const auto& store = find_entry( get_thread( entry->instr), store_id)->instr;
+    ForwardingMemory view( *thread.memory);
+    view.put_store( store);
+    view.load_store( &entry->instr);
+
+    thread.lsq.set_executed( entry->instr.get_sequence_id(), store_id);
+    ++stats.forwarded_loads;
+    write_results( entry, cycle + 1_lt);
+    sout << entry->instr << " (forwarded)\n";
+}
+
+template <typename FuncInstr>
+typename Backend<FuncInstr>::Entry* Backend<FuncInstr>::find_entry( size_t thread, uint64 id)
+{
+    auto& rob = threads.at( thread).rob;
+    const auto it = std::lower_bound( rob.begin(), rob.end(), id, []( const Entry& entry, uint64 value) {
+        return entry.instr.get_sequence_id() < value;
+    });
+    return it != rob.end() && it->instr.get_sequence_id() == id ? &*it : nullptr;
+}
+
+template <typename FuncInstr>
+void Backend<FuncInstr>::check_memory_order( const Instr& store, Cycle cycle)
+{
+    const auto thread = get_thread( store);
+    const auto load_id = threads.at( thread).lsq.find_violation( store.get_sequence_id());
+    if ( load_id == NO_VAL64)
+        return;
+
+    /* the load and younger instructions are fetched again */
+    const auto& load = find_entry( thread, load_id)->instr;
+    const Target target( load.get_PC(), load_id);
+    if ( has_store_sets)
+        store_sets.train( load.get_PC(), store.get_PC());
+
+    const auto rob_occupancy = threads.at( thread).rob.size();
+    squash( thread, load_id - 1);
+    ++stats.order_violations;
+    stats.replayed_instrs += rob_occupancy - threads.at( thread).rob.size();
+
+    has_squash = true;
+    flushed_threads.at( thread) = true;
+    wp_flush->write( true, cycle);
+    wp_flush_target->write( target, cycle);
+    sout << "memory order violation on ";
+}
+
+template <typename FuncInstr>
+void Backend<FuncInstr>::access_memory( Cycle cycle)
+{
+    uint32 accesses = 0;
+    for ( size_t i = 0; i < threads.size(); ++i)
+    {
+        auto& thread = threads.at( ( first_thread + i) % threads.size());
+        for ( auto& entry : thread.rob)
+        {
+            if ( accesses == unit_ports.at( UNIT_MEMORY))
+                return;
+
+            if ( !entry.is_issued || entry.is_executed || !entry.instr.is_load())
+                continue;
+
+            const auto source = thread.lsq.get_load_source( entry.instr.get_sequence_id());
+            switch ( source.status)
+            {
+            case LOAD_WAITS_FOR_ADDRESS: ++stats.address_waits; break;
+            case LOAD_WAITS_FOR_STORE: ++stats.store_waits; break;
+            case LOAD_FORWARDED: forward( &entry, source.store_id, cycle); ++accesses; break;
+            case LOAD_FROM_MEMORY: accesses += load( &entry, cycle) ? 1 : 0; break;
+            }
+        }
+    }
+}
+
+template <typename FuncInstr>
+void Backend<FuncInstr>::drain_store_buffer( Cycle cycle)
+{
+    if ( store_buffer.empty() || store_ready_cycle > cycle)
+        return;
+
+    store_ready_cycle = cycle + access_data_cache( store_buffer.front(), cycle);
+    store_buffer.pop_front();
+}
+
+template <typename FuncInstr>
+void Backend<FuncInstr>::execute( Entry* entry, Cycle cycle)
+{
+    auto& instr = entry->instr;
+    for ( size_t i = 0; i < SRC_REGISTERS_NUM; ++i)
+        instr.set_v_src( read_operand( *entry, i), i);
+
+    instr.execute();
+    entry->is_issued = true;
+    issue_queues.release( entry->unit);
+
+    if ( is_memory_access( instr))
+    {
+        threads.at( get_thread( instr)).lsq.set_address( instr.get_sequence_id(), instr.get_mem_addr(), instr.get_mem_size(), is_forwardable( instr));
+
+        /* stores write memory at commit */
+        if ( instr.is_store() && !is_serializing( instr))
+        {
+            entry->is_executed = true;
+            entry->complete_cycle = cycle + 1_lt;
+            if ( has_store_sets)
+                store_sets.execute_store( instr.get_PC(), instr.get_sequence_id());
+        }
+        /* atomics have no speculative state, they access memory immediately */
+        else if ( is_serializing( instr))
+        {
+            load( entry, cycle);
+        }
+
+        /* younger loads may have passed the store speculatively */
+        if ( instr.is_store())
+            check_memory_order( instr, cycle);
+        return;
+    }
+
+    const auto latency = entry->unit == UNIT_LONG_ALU ? long_alu_latency : 1_lt;
+    write_results( entry, cycle + latency);
+    sout << instr << std::endl;
+}
+
+template <typename FuncInstr>
+void Backend<FuncInstr>::issue( Cycle cycle)
+{
+    std::array<uint32, UNITS_NUM> used_ports = {};
+    size_t issued = 0;
+    for ( size_t i = 0; i < threads.size() && issued < width && !has_squash; ++i)
+        issue_thread( ( first_thread + i) % threads.size(), &used_ports, &issued, cycle);
+
+    issued_instrs.add( issued);
+}
+
+template <typename FuncInstr>
+void Backend<FuncInstr>::issue_thread( size_t thread, std::array<uint32, UNITS_NUM>* used_ports, size_t* issued, Cycle cycle)
+{
+    auto& rob = threads.at( thread).rob;
+    for ( auto& entry : rob)
+    {
+        if ( *issued == width)
+            break;
+
+        if ( entry.is_issued || used_ports->at( entry.unit) == unit_ports.at( entry.unit))
+            continue;
+
+        if ( is_serializing( entry.instr) && &entry != &rob.front())
+            continue;
+
+        if ( !is_ready( entry, cycle))
+            continue;
+
+        ++used_ports->at( entry.unit);
+        ++*issued;
+        execute( &entry, cycle);
+        if ( entry.instr.is_jump())
+            resolve_jump( &entry, cycle);
+
+        /* younger instructions are squashed on misprediction or memory order violation */
+        if ( has_squash)
+            break;
+    }
+}
+
+template <typename FuncInstr>
+void Backend<FuncInstr>::resolve_jump( Entry* entry, Cycle cycle)
+{
+    const auto& instr = entry->instr;
+
+    /* acquiring real information for BPU */
+    wp_bp_update->write( instr.get_bp_upd(), cycle);
+
+    if ( !Branch<FuncInstr>::is_misprediction( instr, instr.get_bp_data()))
+        return;
+
+    entry->is_mispredicted = true;
+    has_squash = true;
+    flushed_threads.at( get_thread( instr)) = true;
+    squash( get_thread( instr), instr.get_sequence_id());
+    wp_flush->write( true, cycle);
+    wp_flush_target->write( instr.get_actual_target(), cycle);
+    sout << "misprediction on ";
+}
+
+template <typename FuncInstr>
+void Backend<FuncInstr>::squash( size_t thread, uint64 id)
+{
+    /* restore the rename map walking from the youngest instruction */
+    auto& rob = threads.at( thread).rob;
+    while ( !rob.empty() && rob.back().instr.get_sequence_id() > id)
+    {
+        auto& entry = rob.back();
+        for ( size_t i = MAX_DST_NUM; i-- > 0;)
+            if ( entry.dsts.at( i) != NO_REGISTER)
+                rename_map.restore( entry.instr.get_dst( i), entry.prev_dsts.at( i), thread);
+
+        if ( !entry.is_issued)
+            issue_queues.release( entry.unit);
+
+        rob.pop_back();
+    }
+    threads.at( thread).lsq.squash( id);
+}
+
+template <typename FuncInstr>
+void Backend<FuncInstr>::count_jump( const Instr& instr, bool is_misprediction)
+{
+    ++jumps;
+    if ( is_misprediction)
+        ++mispredictions;
+
+    auto* stats = instr.is_branch() ? &conditional_stats
+                : instr.is_return() ? &return_stats
+                : instr.is_indirect_jump() ? &indirect_stats
+                : nullptr;
+
+    if ( stats == nullptr)
+        return;
+
+    ++stats->jumps;
+    if ( is_misprediction)
+        ++stats->mispredictions;
+}
+
+template <typename FuncInstr>
+void Backend<FuncInstr>::send_to_writeback( Instr&& instr, Cycle cycle)
+{
+    if ( instr.is_jump())
+        wp_branch_datapath->write( std::move( instr), cycle);
+    else if ( is_memory_access( instr))
+        wp_mem_datapath->write( std::move( instr), cycle);
+    else
+        wp_execute_datapath->write( std::move( instr), cycle);
+}
+
+template <typename FuncInstr>
+void Backend<FuncInstr>::commit( Cycle cycle)
+{
+    uint32 committed = 0;
+    for ( size_t i = 0; i < threads.size() && committed < width && commit_ready_cycle <= cycle; ++i)
+        commit_thread( ( first_thread + i) % threads.size(), &committed, cycle);
+}
+
+template <typename FuncInstr>
+void Backend<FuncInstr>::commit_thread( size_t thread, uint32* committed, Cycle cycle)
+{
+    auto& context = threads.at( thread);
+    for ( uint32 thread_committed = 0; *committed < width && !context.rob.empty(); ++thread_committed, ++*committed)
+    {
+        auto& entry = context.rob.front();
+        if ( !entry.is_executed || entry.complete_cycle > cycle)
+            break;
+
+        /* stores change memory, so no older instruction of the group may trap */
+        const bool is_store = entry.instr.is_store() && !is_serializing( entry.instr);
+        if ( is_store && thread_committed != 0)
+            break;
+
+        if ( is_store && store_buffer.size() >= store_buffer_size)
+        {
+            ++stats.store_buffer_full;
+            break;
+        }
+
+        if ( is_store)
+        {
+            context.memory->load_store( &entry.instr, &context.reservation);
+            store_buffer.push_back( entry.instr);
+        }
+
+        if ( entry.instr.is_jump())
+            count_jump( entry.instr, entry.is_mispredicted);
+
+        const auto id = entry.instr.get_sequence_id();
+        if ( is_memory_access( entry.instr))
+            context.lsq.erase( id);
+
+        /* younger instructions are flushed by writeback */
+        const bool is_last = entry.instr.has_trap() || entry.instr.is_system();
+
+        context.retiring.push_back( { id, entry.dsts, entry.prev_dsts});
+        send_to_writeback( std::move( entry.instr), cycle);
+        context.rob.pop_front();
+
+        /* writeback flushes the thread in the next cycle, so stores must not reach memory meanwhile,
+         * and instructions of other threads coming in the cycle of flush would be dropped */
+        if ( is_last)
+        {
+            commit_ready_cycle = cycle + 2_lt;
+            break;
+        }
+    }
+}
+
+template <typename FuncInstr>
+auto Backend<FuncInstr>::read_instrs( Cycle cycle) const
+{
+    const bool from_stall = rp_stall_datapath->is_ready( cycle);
+    auto* port = from_stall ? rp_stall_datapath : rp_datapath;
+
+    std::vector<Instr> result;
+    while ( port->is_ready( cycle))
+        result.emplace_back( port->read( cycle));
+
+    return std::pair{ std::move( result), from_stall};
+}
+
+template <typename FuncInstr>
+size_t Backend<FuncInstr>::get_rob_occupancy() const
+{
+    return std::accumulate( threads.begin(), threads.end(), size_t{ 0}, []( size_t sum, const Thread& thread) {
+        return sum + thread.rob.size();
+    });
+}
+
+template <typename FuncInstr>
+size_t Backend<FuncInstr>::get_lsq_occupancy() const
+{
+    return std::accumulate( threads.begin(), threads.end(), size_t{ 0}, []( size_t sum, const Thread& thread) {
+        return sum + thread.lsq.get_occupancy();
+    });
+}
+
+template <typename FuncInstr>
+bool Backend<FuncInstr>::has_resources( const Instr& instr)
+{
+    if ( get_rob_occupancy() >= rob_size)
+    {
+        ++stats.rob_full;
+        return false;
+    }
+
+    if ( !issue_queues.has_space( get_unit( instr)))
+    {
+        ++stats.iq_full;
+        return false;
+    }
+
+    if ( is_memory_access( instr) && get_lsq_occupancy() >= lsq_size)
+    {
+        ++stats.lsq_full;
+        return false;
+    }
+
+    size_t dsts = 0;
+    for ( size_t i = 0; i < MAX_DST_NUM; ++i)
+        if ( !instr.get_dst( i).is_zero())
+            ++dsts;
+
+    if ( rename_map.get_free_num() < dsts)
+    {
+        ++stats.registers_full;
+        return false;
+    }
+
+    return true;
+}
+
+template <typename FuncInstr>
+void Backend<FuncInstr>::handle_decode_misprediction( const Instr& instr, bool is_stall, Cycle cycle)
+{
+    if ( instr.is_jump())
+        ++decode_jumps;
+
+    if ( !Decode<FuncInstr>::is_misprediction( instr, instr.get_bp_data()))
+        return;
+
+    ++decode_mispredictions;
+
+    /* acquiring real information for BPU */
+    wp_decode_bp_update->write( instr.get_bp_upd(), cycle);
+
+    /* instructions fetched in this cycle come next clock, they are flushed */
+    if ( !is_stall)
+        wp_flush_fetch->write( true, cycle);
+
+    /* sending valid PC to fetch stage */
+    wp_decode_flush_target->write( instr.get_actual_decoded_target(), cycle);
+    sout << "misprediction on ";
+}
+
+template <typename FuncInstr>
+void Backend<FuncInstr>::rename( Instr&& instr)
+{
+    Entry entry( std::move( instr));
+    const auto& renamed = entry.instr;
+    const auto thread = get_thread( renamed);
+    entry.unit = get_unit( renamed);
+
+    for ( size_t i = 0; i < SRC_REGISTERS_NUM; ++i)
+        entry.operands.at( i) = rename_map.lookup( renamed.get_src( i), thread);
+
+    for ( size_t i = 0; i < MAX_DST_NUM; ++i)
+    {
+        const auto dst = renamed.get_dst( i);
+        entry.operands.at( SRC_REGISTERS_NUM + i) = renamed.is_bypassible() ? NO_REGISTER : rename_map.lookup( dst, thread);
+        entry.dsts.at( i) = NO_REGISTER;
+        entry.prev_dsts.at( i) = NO_REGISTER;
+        if ( dst.is_zero())
+            continue;
+
+        const auto [physical, previous] = rename_map.rename( dst, thread);
+        physical_rf.invalidate( physical);
+        entry.dsts.at( i) = physical;
+        entry.prev_dsts.at( i) = previous;
+    }
+
+    issue_queues.allocate( entry.unit);
+    if ( is_memory_access( renamed))
+    {
+        const auto id = renamed.get_sequence_id();
+        const auto predicted_store = has_store_sets && renamed.is_load() ? store_sets.get_dependence( renamed.get_PC()) : NO_VAL64;
+        if ( has_store_sets && renamed.is_store())
+            store_sets.dispatch_store( renamed.get_PC(), id);
+
+        threads.at( thread).lsq.push( id, renamed.is_store(), predicted_store);
+    }
+
+    sout << renamed << std::endl;
+    threads.at( thread).rob.emplace_back( std::move( entry));
+}
+
+template <typename FuncInstr>
+void Backend<FuncInstr>::dispatch( Cycle cycle)
+{
+    if ( !rp_datapath->is_ready( cycle) && !rp_stall_datapath->is_ready( cycle))
+        return;
+
+    /* a group belongs to a single thread, it is dropped if fetched before a flush of the thread */
+    auto[instrs, from_stall] = read_instrs( cycle);
+    if ( flushed_threads.at( get_thread( instrs.front())))
+        return;
+
+    bool is_stall = false;
+    for ( auto& instr : instrs)
+    {
+        /* instructions are dispatched in order, so the rest of the group waits for the stalled one */
+        is_stall = is_stall || !has_resources( instr);
+
+        /* stalled instructions have already been checked when they came from fetch */
+        if ( !from_stall)
+            handle_decode_misprediction( instr, is_stall, cycle);
+
+        if ( is_stall)
+            wp_stall_datapath->write( std::move( instr), cycle);
+        else
+            rename( std::move( instr));
+    }
+
+    if ( is_stall)
+        wp_stall->write( true, cycle);
+}
+
+template <typename FuncInstr>
+void Backend<FuncInstr>::collect_statistics()
+{
+    ++stats.cycles;
+    stats.rob_occupancy += get_rob_occupancy();
+    stats.iq_occupancy += issue_queues.get_occupancy();
+    stats.lsq_occupancy += get_lsq_occupancy();
+}
+
+#include <mips/mips.h>
+#include <risc_v/risc_v.h>
+
+template class Backend<BaseMIPSInstr<uint32>>;
+template class Backend<BaseMIPSInstr<uint64>>;
+template class Backend<RISCVInstr<uint32>>;
+template class Backend<RISCVInstr<uint64>>;
+template class Backend<RISCVInstr<uint128>>;
@@ -0,0 +1,228 @@
+/*
+ * backend.h - out-of-order core: rename, issue, execution and commit
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef OOO_BACKEND_H
+#define OOO_BACKEND_H
+
+#include "forwarding_memory.h"
+#include "issue_queue.h"
+#include "load_store_queue.h"
+#include "rename_map.h"
+#include "store_sets.h"
+
+#include <func_sim/rf/rf.h>
+#include <memory/memory.h>
+#include <modules/branch/branch.h>
+#include <modules/core/perf_config.h>
+#include <modules/core/perf_instr.h>
+#include <modules/core/width_histogram.h>
+#include <modules/mem/coherence/mesi_directory.h>
+#include <modules/mem/data_cache.h>
+#include <modules/mem/memory_hierarchy.h>
+#include <modules/ports_instance.h>
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+struct OOOStatistics
+{
+    uint64 cycles = 0;
+    uint64 rob_occupancy = 0;   // summed over all cycles
+    uint64 iq_occupancy = 0;
+    uint64 lsq_occupancy = 0;
+    // cycles in which dispatch waited for a resource
+    uint64 rob_full = 0;
+    uint64 iq_full = 0;
+    uint64 lsq_full = 0;
+    uint64 registers_full = 0;
+    uint64 store_buffer_full = 0;
+    // memory ordering
+    uint64 forwarded_loads = 0;
+    uint64 address_waits = 0;   // cycles of loads waiting for addresses of older stores
+    uint64 store_waits = 0;     // cycles of loads partially overlapped by older stores
+    uint64 order_violations = 0;
+    uint64 replayed_instrs = 0; // squashed by memory order violations
+};
+
+// Replaces decode, execute, memory and branch stages of the in-order pipeline.
+// Instructions are renamed and dispatched in program order, issued to execution units
+// oldest ready first, and sent to writeback in program order from the reorder buffer.
+// Hardware threads have their own reorder buffers and load-store queues, but share
+// their capacity, physical registers, issue queues, execution units and data cache.
+template <typename FuncInstr>
+class Backend : public Module
+{
+    using Register = typename FuncInstr::Register;
+    using RegisterUInt = typename FuncInstr::RegisterUInt;
+    using Instr = PerfInstr<FuncInstr>;
+    using InstructionOutput = BypassedData<RegisterUInt>;
+    static constexpr const size_t SRC_REGISTERS_NUM = 2;
+    static constexpr const size_t NO_REGISTER = RenameMap<Register>::IN_RF;
+
+    struct Entry
+    {
+        explicit Entry( Instr&& value) : instr( std::move( value)) { }
+
+        Instr instr;
+        ExecutionUnit unit = UNIT_ALU;
+        // sources, then previous values of destinations merged by non-bypassible instructions
+        std::array<size_t, SRC_REGISTERS_NUM + MAX_DST_NUM> operands = {};
+        std::array<size_t, MAX_DST_NUM> dsts = {};
+        std::array<size_t, MAX_DST_NUM> prev_dsts = {};
+        bool is_issued = false;
+        bool is_executed = false;   // loads are executed when they access memory
+        bool is_mispredicted = false;
+        Cycle complete_cycle = 0_cl;
+    };
+
+    struct RetiringEntry
+    {
+        uint64 id = NO_VAL64;
+        std::array<size_t, MAX_DST_NUM> dsts = {};
+        std::array<size_t, MAX_DST_NUM> prev_dsts = {};
+    };
+
+    struct Thread
+    {
+        Thread( uint32 lsq_size, bool is_speculative) : lsq( lsq_size, is_speculative) { }
+
+        RF<FuncInstr>* rf = nullptr;
+        std::shared_ptr<FuncMemory> memory;
+        Reservation reservation;
+        std::deque<Entry> rob;
+        LoadStoreQueue lsq;
+        // instructions sent to writeback, their physical registers are released on retirement
+        std::deque<RetiringEntry> retiring;
+    };
+
+public:
+    Backend( Module* parent, const PerfConfig& config);
+    void clock( Cycle cycle);
+    void set_RF( RF<FuncInstr>* value, size_t thread = 0) { threads.at( thread).rf = value; }
+    void set_memory( const std::shared_ptr<FuncMemory>& mem, size_t thread = 0) { threads.at( thread).memory = mem; }
+    void set_coherent_cache( std::shared_ptr<CoherentCache> cache) { coherent_cache = std::move( cache); }
+    void set_memory_hierarchy( std::shared_ptr<MemoryHierarchy> value)
+    {
+        hierarchy = std::move( value);
+        dcache.set_lower_level( hierarchy.get());
+    }
+
+    auto get_decode_mispredictions_num() const { return decode_mispredictions; }
+    auto get_decode_jumps_num() const { return decode_jumps; }
+    auto get_mispredictions_num() const { return mispredictions; }
+    auto get_jumps_num() const { return jumps; }
+    const auto& get_conditional_statistics() const { return conditional_stats; }
+    const auto& get_return_statistics() const { return return_stats; }
+    const auto& get_indirect_statistics() const { return indirect_stats; }
+    const auto& get_dcache_statistics() const { return dcache.get_statistics(); }
+    const auto& get_statistics() const { return stats; }
+    const auto& get_width_statistics() const { return issued_instrs; }
+
+private:
+    static ExecutionUnit get_unit( const Instr& instr);
+    // executed only by the oldest instruction, as their effects can not be undone
+    static bool is_serializing( const Instr& instr);
+    static bool is_memory_access( const Instr& instr) { return instr.is_load() || instr.is_store(); }
+    static bool is_forwardable( const Instr& instr);
+    static bool is_speculative_mode( const std::string& mode);
+    static size_t get_thread( const Instr& instr) { return Target::get_thread( instr.get_sequence_id()); }
+
+    void read_flushes( Cycle cycle);
+    void flush( size_t thread);
+    void release_retired( Cycle cycle);
+    void retire_to_rf( size_t physical, size_t thread);
+    void access_memory( Cycle cycle);
+    void drain_store_buffer( Cycle cycle);
+    void issue( Cycle cycle);
+    void issue_thread( size_t thread, std::array<uint32, UNITS_NUM>* used_ports, size_t* issued, Cycle cycle);
+    void commit( Cycle cycle);
+    void commit_thread( size_t thread, uint32* committed, Cycle cycle);
+    void dispatch( Cycle cycle);
+    void collect_statistics();
+
+    auto read_instrs( Cycle cycle) const;
+    size_t get_rob_occupancy() const;
+    size_t get_lsq_occupancy() const;
+    bool has_resources( const Instr& instr);
+    void handle_decode_misprediction( const Instr& instr, bool is_stall, Cycle cycle);
+    void rename( Instr&& instr);
+
+    bool is_ready( const Entry& entry, Cycle cycle) const;
+    RegisterUInt read_operand( const Entry& entry, size_t index) const;
+    void write_results( Entry* entry, Cycle ready_cycle);
+    void execute( Entry* entry, Cycle cycle);
+    bool load( Entry* entry, Cycle cycle);
+    void forward( Entry* entry, uint64 store_id, Cycle cycle);
+    void check_memory_order( const Instr& store, Cycle cycle);
+    Entry* find_entry( size_t thread, uint64 id);
+    void resolve_jump( Entry* entry, Cycle cycle);
+    void squash( size_t thread, uint64 id);
+    Latency access_data_cache( const Instr& instr, Cycle cycle);
+    void count_jump( const Instr& instr, bool is_misprediction);
+    void send_to_writeback( Instr&& instr, Cycle cycle);
+
+    const uint32 width;
+    const uint32 rob_size;
+    const std::array<uint32, UNITS_NUM> unit_ports;
+    const Latency long_alu_latency;
+    const uint32 lsq_size;
+
+    std::vector<Thread> threads;
+    size_t first_thread = 0; // threads take turns to be the first to issue and commit
+    RF<FuncInstr> merge_rf; // merges results of non-bypassible instructions with previous values
+    RenameMap<Register> rename_map;
+    PhysicalRF<RegisterUInt> physical_rf;
+    IssueQueues issue_queues;
+    StoreSets store_sets;
+    const bool has_store_sets;
+    std::deque<Instr> store_buffer; // committed stores are written to the data cache in order
+    const uint32 store_buffer_size;
+
+    std::shared_ptr<CoherentCache> coherent_cache;
+    DataCache dcache;
+    std::shared_ptr<MemoryHierarchy> hierarchy;
+    Cycle store_ready_cycle = 0_cl; // stores wait for a free MSHR
+    Cycle commit_ready_cycle = 0_cl; // commit waits for writeback after traps
+    bool has_squash = false; // younger instructions are squashed in this cycle
+    std::vector<bool> flushed_threads; // instructions fetched before a flush are dropped
+
+    uint64 decode_jumps = 0;
+    uint64 decode_mispredictions = 0;
+    uint64 jumps = 0;
+    uint64 mispredictions = 0;
+    JumpStatistics conditional_stats;
+    JumpStatistics return_stats;
+    JumpStatistics indirect_stats;
+    OOOStatistics stats;
+    WidthHistogram issued_instrs;
+
+    /* Inputs */
+    ReadPort<Instr>* rp_datapath = nullptr;
+    ReadPort<Instr>* rp_stall_datapath = nullptr;
+    ReadPort<bool>* rp_flush_fetch = nullptr;
+    ReadPort<bool>* rp_flush = nullptr;
+    ReadPort<bool>* rp_trap = nullptr;
+    ReadPort<InstructionOutput>* rp_retired = nullptr;
+    // flushed threads are known from their new targets
+    ReadPort<Target>* rp_decode_flush_target = nullptr;
+    ReadPort<Target>* rp_flush_target = nullptr;
+    ReadPort<Target>* rp_trap_target = nullptr;
+
+    /* Outputs */
+    WritePort<Instr>* wp_stall_datapath = nullptr;
+    WritePort<bool>* wp_stall = nullptr;
+    WritePort<bool>* wp_flush_fetch = nullptr;
+    WritePort<Target>* wp_decode_flush_target = nullptr;
+    WritePort<BPInterface>* wp_decode_bp_update = nullptr;
+    WritePort<bool>* wp_flush = nullptr;
+    WritePort<Target>* wp_flush_target = nullptr;
+    WritePort<BPInterface>* wp_bp_update = nullptr;
+    WritePort<Instr>* wp_execute_datapath = nullptr;
+    WritePort<Instr>* wp_mem_datapath = nullptr;
+    WritePort<Instr>* wp_branch_datapath = nullptr;
+};
+
+#endif // OOO_BACKEND_H
@@ -0,0 +1,59 @@
+/*
+ * forwarding_memory.h - memory view with data of stores which are not committed yet
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef FORWARDING_MEMORY_H
+#define FORWARDING_MEMORY_H
+
+#include <memory/memory.h>
+
+#include <iterator>
+#include <utility>
+#include <vector>
+
+// Writes are kept aside, and reads see them over the primary memory.
+// Used to get data of a store to a younger load without changing the memory.
+class ForwardingMemory final : public FuncMemory
+{
+public:
+    explicit ForwardingMemory( const FuncMemory& primary) : primary( primary) { }
+
+    size_t memcpy_guest_to_host( std::byte* dst, Addr src, size_t size) const noexcept final
+    {
+        const auto result = primary.memcpy_guest_to_host( dst, src, size);
+        for ( const auto& [addr, value] : bytes)
+            if ( addr >= src && addr - src < size)
+                *std::next( dst, narrow_cast<std::ptrdiff_t>( addr - src)) = value;
+
+        return result;
+    }
+
+    size_t memcpy_host_to_guest( Addr dst, const std::byte* src, size_t size) final
+    {
+        for ( size_t i = 0; i < size; ++i)
+            bytes.emplace_back( dst + i, *std::next( src, narrow_cast<std::ptrdiff_t>( i)));
+
+        return size;
+    }
+
+    // Unlike FuncMemory::store, allows address zero: a store on a wrong path may have any address
+    template<typename Instr> void put_store( const Instr& store)
+    {
+        using SrcType = decltype( std::declval<Instr>().get_v_src( 1));
+        if ( store.get_endian() == std::endian::little)
+            write_integer<SrcType, std::endian::little>( store.get_v_src( 1), store.get_mem_addr(), store.get_mem_size());
+        else
+            write_integer<SrcType, std::endian::big>( store.get_v_src( 1), store.get_mem_addr(), store.get_mem_size());
+    }
+
+    void duplicate_to( std::shared_ptr<WriteableMemory> target) const final { primary.duplicate_to( std::move( target)); }
+    std::string dump() const final { return primary.dump(); }
+    size_t strlen( Addr addr) const final { return primary.strlen( addr); }
+
+private:
+    const FuncMemory& primary;
+    std::vector<std::pair<Addr, std::byte>> bytes;
+};
+
+#endif // FORWARDING_MEMORY_H
@@ -0,0 +1,71 @@
+/*
+ * issue_queue.h - issue queues of out-of-order core
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef ISSUE_QUEUE_H
+#define ISSUE_QUEUE_H
+
+#include <infra/exception.h>
+#include <infra/types.h>
+
+#include <array>
+#include <numeric>
+#include <string>
+
+struct InvalidOOOConfiguration final : Exception
+{
+    explicit InvalidOOOConfiguration( const std::string& msg)
+        : Exception( "Invalid out-of-order core configuration", msg)
+    { }
+};
+
+enum ExecutionUnit : uint8
+{
+    UNIT_ALU,
+    UNIT_LONG_ALU,
+    UNIT_MEMORY,
+    UNIT_BRANCH,
+    UNITS_NUM
+};
+
+// Dispatched instructions wait for their operands either in a single unified queue
+// or in distributed queues, one per execution unit. Selection of the oldest ready
+// instructions is done by the core, queues only limit the number of waiting instructions.
+class IssueQueues
+{
+public:
+    IssueQueues( const std::string& mode, uint32 size)
+        : is_distributed( is_distributed_mode( mode))
+        , size( size)
+    {
+        if ( size == 0)
+            throw InvalidOOOConfiguration( "issue queue should have at least one entry");
+    }
+
+    bool has_space( ExecutionUnit unit) const { return occupancy.at( get_queue( unit)) < size; }
+    void allocate( ExecutionUnit unit) { ++occupancy.at( get_queue( unit)); }
+    void release( ExecutionUnit unit) { --occupancy.at( get_queue( unit)); }
+    void clear() { occupancy.fill( 0); }
+    uint32 get_occupancy() const { return std::accumulate( occupancy.begin(), occupancy.end(), uint32{ 0}); }
+
+private:
+    size_t get_queue( ExecutionUnit unit) const { return is_distributed ? unit : 0; }
+
+    static bool is_distributed_mode( const std::string& mode)
+    {
+        if ( mode == "unified")
+            return false;
+
+        if ( mode == "distributed")
+            return true;
+
+        throw InvalidOOOConfiguration( "unknown issue queue mode " + mode);
+    }
+
+    const bool is_distributed;
+    const uint32 size;
+    std::array<uint32, UNITS_NUM> occupancy = {};
+};
+
+#endif // ISSUE_QUEUE_H
@@ -0,0 +1,177 @@
+/*
+ * load_store_queue.h - memory instructions of out-of-order core
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef LOAD_STORE_QUEUE_H
+#define LOAD_STORE_QUEUE_H
+
+#include <infra/types.h>
+
+#include <algorithm>
+#include <deque>
+#include <iterator>
+
+enum LoadStatus : uint8
+{
+    LOAD_FROM_MEMORY,
+    LOAD_FORWARDED,         // data is taken from an older store
+    LOAD_WAITS_FOR_ADDRESS, // an older store may write the same bytes
+    LOAD_WAITS_FOR_STORE    // an older store overlaps the load, but can not forward all its bytes
+};
+
+struct LoadSource
+{
+    LoadStatus status = LOAD_FROM_MEMORY;
+    uint64 store_id = NO_VAL64;
+};
+
+// Loads and stores in program order from dispatch to commit.
+// Stores write memory at commit, so loads take data of older stores from the queue.
+// Speculative loads pass older stores with unknown addresses
+// unless a dependence on the store is predicted.
+class LoadStoreQueue
+{
+    struct Entry
+    {
+        uint64 id = NO_VAL64;
+        bool is_store = false;
+        uint64 predicted_store = NO_VAL64;
+        bool has_address = false;
+        bool is_forwardable = false;
+        Addr addr = 0;
+        uint32 size = 0;
+        bool is_executed = false;
+        uint64 forwarded_from = NO_VAL64;
+    };
+
+public:
+    LoadStoreQueue( uint32 size, bool is_speculative) : size( size), is_speculative( is_speculative) { }
+
+    bool is_full() const { return entries.size() >= size; }
+    size_t get_occupancy() const { return entries.size(); }
+
+    // instructions are dispatched in program order
+    void push( uint64 id, bool is_store, uint64 predicted_store = NO_VAL64)
+    {
+        Entry entry;
+        entry.id = id;
+        entry.is_store = is_store;
+        entry.predicted_store = predicted_store;
+        entries.push_back( entry);
+    }
+
+    void set_address( uint64 id, Addr addr, uint32 bytes, bool is_forwardable = false)
+    {
+        auto entry = find( id);
+        if ( entry == entries.end())
+            return;
+
+        entry->has_address = true;
+        entry->is_forwardable = is_forwardable;
+        entry->addr = addr;
+        entry->size = bytes;
+    }
+
+    // the youngest older store writing bytes of the load provides data
+    LoadSource get_load_source( uint64 id) const
+    {
+        const auto load = find( id);
+        if ( load == entries.end() || !load->has_address)
+            return { LOAD_WAITS_FOR_ADDRESS, NO_VAL64};
+
+        for ( auto it = std::make_reverse_iterator( load); it != entries.rend(); ++it)
+        {
+            if ( !it->is_store)
+                continue;
+
+            if ( !it->has_address)
+            {
+                if ( !is_speculative || it->id == load->predicted_store)
+                    return { LOAD_WAITS_FOR_ADDRESS, it->id};
+                continue;
+            }
+
+            if ( !is_overlapped( *it, *load))
+                continue;
+
+            if ( it->is_forwardable && is_covered( *load, *it))
+                return { LOAD_FORWARDED, it->id};
+
+            return { LOAD_WAITS_FOR_STORE, it->id};
+        }
+
+        return { LOAD_FROM_MEMORY, NO_VAL64};
+    }
+
+    void set_executed( uint64 id, uint64 forwarded_from)
+    {
+        auto entry = find( id);
+        if ( entry == entries.end())
+            return;
+
+        entry->is_executed = true;
+        entry->forwarded_from = forwarded_from;
+    }
+
+    // returns the oldest younger load which has missed data of the store, or NO_VAL64
+    uint64 find_violation( uint64 store_id) const
+    {
+        const auto store = find( store_id);
+        if ( store == entries.end())
+            return NO_VAL64;
+
+        const auto load = std::find_if( store, entries.end(), [&store]( const auto& entry) {
+            return !entry.is_store && entry.is_executed && is_overlapped( *store, entry)
+                && ( entry.forwarded_from == NO_VAL64 || entry.forwarded_from < store->id);
+        });
+
+        return load != entries.end() ? load->id : NO_VAL64;
+    }
+
+    void erase( uint64 id)
+    {
+        auto entry = find( id);
+        if ( entry != entries.end())
+            entries.erase( entry);
+    }
+
+    // removes instructions younger than the given one
+    void squash( uint64 id)
+    {
+        while ( !entries.empty() && entries.back().id > id)
+            entries.pop_back();
+    }
+
+    void clear() { entries.clear(); }
+
+private:
+    static bool is_overlapped( const Entry& lhs, const Entry& rhs)
+    {
+        return lhs.addr < rhs.addr + rhs.size && rhs.addr < lhs.addr + lhs.size;
+    }
+
+    static bool is_covered( const Entry& inner, const Entry& outer)
+    {
+        return outer.addr <= inner.addr && inner.addr + inner.size <= outer.addr + outer.size;
+    }
+
+    // entries are sorted by program order
+    template<typename Entries>
+    static auto find( Entries& entries, uint64 id) -> decltype( entries.begin())
+    {
+        const auto it = std::lower_bound( entries.begin(), entries.end(), id, []( const auto& entry, uint64 value) {
+            return entry.id < value;
+        });
+        return it != entries.end() && it->id == id ? it : entries.end();
+    }
+
+    std::deque<Entry>::const_iterator find( uint64 id) const { return find( entries, id); }
+    std::deque<Entry>::iterator find( uint64 id) { return find( entries, id); }
+
+    const uint32 size;
+    const bool is_speculative;
+    std::deque<Entry> entries;
+};
+
+#endif // LOAD_STORE_QUEUE_H
@@ -0,0 +1,134 @@
+/*
+ * rename_map.h - register renaming of out-of-order core
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef RENAME_MAP_H
+#define RENAME_MAP_H
+
+#include <infra/macro.h>
+#include <infra/ports/timing.h>
+#include <infra/types.h>
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+// Maps architectural registers to physical ones, hardware threads have their own maps
+// and share physical registers.
+// Registers which are not renamed since the last reset are read from the architectural register file,
+// so physical registers are needed only for results of instructions in flight.
+template <typename Register>
+class RenameMap
+{
+public:
+    static constexpr const size_t IN_RF = NO_VAL<size_t>;
+
+    explicit RenameMap( size_t physical_registers, size_t threads = 1)
+        : maps( threads), owners( physical_registers, NO_THREAD)
+    {
+        free_list.resize( physical_registers);
+        std::iota( free_list.begin(), free_list.end(), size_t{ 0});
+        reset();
+    }
+
+    // all instructions in flight are flushed, the architectural register files are up to date
+    void reset()
+    {
+        for ( size_t thread = 0; thread < maps.size(); ++thread)
+            reset( thread);
+    }
+
+    // instructions of the thread are flushed, its physical registers are freed
+    void reset( size_t thread)
+    {
+        maps.at( thread).fill( IN_RF);
+        for ( size_t physical = 0; physical < owners.size(); ++physical)
+            if ( owners[physical] == thread)
+                release( physical);
+    }
+
+    size_t lookup( Register reg, size_t thread = 0) const
+    {
+        return reg.is_zero() ? IN_RF : maps.at( thread).at( reg.to_rf_index());
+    }
+
+    size_t get_free_num() const { return free_list.size(); }
+
+    // maps a register to a new physical register, returns it together with the previous mapping
+    std::pair<size_t, size_t> rename( Register reg, size_t thread = 0)
+    {
+        const auto previous = lookup( reg, thread);
+        const auto physical = free_list.front();
+        free_list.pop_front();
+        owners.at( physical) = thread;
+        maps.at( thread).at( reg.to_rf_index()) = physical;
+        return { physical, previous};
+    }
+
+    // undoes renaming of a squashed instruction
+    void restore( Register reg, size_t previous, size_t thread = 0)
+    {
+        release( lookup( reg, thread));
+        maps.at( thread).at( reg.to_rf_index()) = previous;
+    }
+
+    void release( size_t physical)
+    {
+        if ( physical == IN_RF || owners.at( physical) == NO_THREAD)
+            return;
+
+        owners.at( physical) = NO_THREAD;
+        free_list.push_back( physical);
+    }
+
+    // the value is written to the architectural register file, so the physical register
+    // is freed if it is still the latest mapping of its register
+    bool retire( size_t physical, size_t thread = 0)
+    {
+        auto& map = maps.at( thread);
+        const auto it = std::find( map.begin(), map.end(), physical);
+        if ( physical == IN_RF || it == map.end())
+            return false;
+
+        *it = IN_RF;
+        release( physical);
+        return true;
+    }
+
+private:
+    static constexpr const size_t NO_THREAD = NO_VAL<size_t>;
+
+    std::vector<std::array<size_t, Register::MAX_REG>> maps;
+    std::vector<size_t> owners; // thread which has allocated a physical register
+    std::deque<size_t> free_list;
+};
+
+// Values of physical registers and cycles when they become available for consumers
+template <typename RegisterUInt>
+class PhysicalRF
+{
+public:
+    explicit PhysicalRF( size_t size) : values( size), ready( size, Cycle( MAX_VAL64)) { }
+
+    bool is_ready( size_t physical, Cycle cycle) const { return ready.at( physical) <= cycle; }
+    const auto& read( size_t physical) const { return values.at( physical); }
+
+    void write( size_t physical, RegisterUInt value, Cycle ready_cycle)
+    {
+        values.at( physical) = value;
+        ready.at( physical) = ready_cycle;
+    }
+
+    // a newly allocated register waits for its producer
+    void invalidate( size_t physical) { ready.at( physical) = Cycle( MAX_VAL64); }
+
+private:
+    std::vector<RegisterUInt> values;
+    std::vector<Cycle> ready;
+};
+
+#endif // RENAME_MAP_H
@@ -0,0 +1,68 @@
+/*
+ * store_sets.h - store set memory dependence predictor
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#ifndef STORE_SETS_H
+#define STORE_SETS_H
+
+#include <infra/types.h>
+
+#include <algorithm>
+#include <vector>
+
+// Loads and stores which have once violated memory order are put into the same store set.
+// A load waits for the last dispatched store of its set, other stores are passed speculatively.
+class StoreSets
+{
+public:
+    StoreSets( uint32 ssit_size, uint32 lfst_size)
+        : ssit( ssit_size, NO_VAL32)
+        , lfst( lfst_size, NO_VAL64)
+    { }
+
+    // returns the store which the load should wait for, or NO_VAL64
+    uint64 get_dependence( Addr load_pc) const
+    {
+        const auto set = get_set( load_pc);
+        return set != NO_VAL32 ? lfst.at( set) : NO_VAL64;
+    }
+
+    void dispatch_store( Addr store_pc, uint64 id)
+    {
+        const auto set = get_set( store_pc);
+        if ( set != NO_VAL32)
+            lfst.at( set) = id;
+    }
+
+    // the store address is known, so the store does not block loads any more
+    void execute_store( Addr store_pc, uint64 id)
+    {
+        const auto set = get_set( store_pc);
+        if ( set != NO_VAL32 && lfst.at( set) == id)
+            lfst.at( set) = NO_VAL64;
+    }
+
+    void train( Addr load_pc, Addr store_pc)
+    {
+        auto& load_set = ssit.at( get_index( load_pc));
+        auto& store_set = ssit.at( get_index( store_pc));
+        if ( load_set == NO_VAL32 && store_set == NO_VAL32)
+            load_set = store_set = narrow_cast<uint32>( get_index( store_pc) % lfst.size());
+        else if ( load_set == NO_VAL32)
+            load_set = store_set;
+        else if ( store_set == NO_VAL32)
+            store_set = load_set;
+        else
+            load_set = store_set = std::min( load_set, store_set);
+    }
+
+private:
+    size_t get_index( Addr pc) const { return ( pc >> 2U) % ssit.size(); }
+    uint32 get_set( Addr pc) const { return ssit.at( get_index( pc)); }
+
+    std::vector<uint32> ssit;
+    std::vector<uint64> lfst;
+};
+
+#endif // STORE_SETS_H
@@ -0,0 +1,396 @@
+/**
+ * Unit tests for structures of out-of-order core
+ * Copyright 2020 MIPT-MIPS
+ */
+
+#include <catch.hpp>
+#include <mips/mips.h>
+#include <mips/mips_register/mips_register.h>
+#include <modules/ooo/backend.h>
+#include <modules/ooo/forwarding_memory.h>
+#include <modules/ooo/issue_queue.h>
+#include <modules/ooo/load_store_queue.h>
+#include <modules/ooo/rename_map.h>
+#include <modules/ooo/store_sets.h>
+
+TEST_CASE( "RenameMap: registers are read from RF until renamed")
+{
+    RenameMap<MIPSRegister> map( 4);
+    const auto reg = MIPSRegister::from_cpu_index( 5);
+    CHECK( map.lookup( reg) == RenameMap<MIPSRegister>::IN_RF);
+    CHECK( map.get_free_num() == 4);
+
+    const auto [physical, previous] = map.rename( reg);
+    CHECK( previous == RenameMap<MIPSRegister>::IN_RF);
+    CHECK( map.lookup( reg) == physical);
+    CHECK( map.get_free_num() == 3);
+}
+
+TEST_CASE( "RenameMap: restore on squash")
+{
+    RenameMap<MIPSRegister> map( 4);
+    const auto reg = MIPSRegister::from_cpu_index( 5);
+    const auto first = map.rename( reg);
+    const auto second = map.rename( reg);
+    CHECK( second.second == first.first);
+    CHECK( map.get_free_num() == 2);
+
+    map.restore( reg, second.second);
+    CHECK( map.lookup( reg) == first.first);
+    CHECK( map.get_free_num() == 3);
+
+    map.reset();
+    CHECK( map.lookup( reg) == RenameMap<MIPSRegister>::IN_RF);
+    CHECK( map.get_free_num() == 4);
+}
+
+TEST_CASE( "RenameMap: retired register is freed if it is the latest mapping")
+{
+    RenameMap<MIPSRegister> map( 4);
+    const auto reg = MIPSRegister::from_cpu_index( 5);
+    const auto first = map.rename( reg).first;
+    const auto second = map.rename( reg).first;
+
+    CHECK( !map.retire( first));
+    CHECK( map.get_free_num() == 2);
+    CHECK( map.retire( second));
+    CHECK( map.lookup( reg) == RenameMap<MIPSRegister>::IN_RF);
+    CHECK( map.get_free_num() == 3);
+}
+
+TEST_CASE( "RenameMap: zero register is not renamed")
+{
+    RenameMap<MIPSRegister> map( 4);
+    CHECK( map.lookup( MIPSRegister::zero()) == RenameMap<MIPSRegister>::IN_RF);
+    map.release( RenameMap<MIPSRegister>::IN_RF);
+    CHECK( map.get_free_num() == 4);
+}
+
+TEST_CASE( "RenameMap: hardware threads share physical registers")
+{
+    RenameMap<MIPSRegister> map( 4, 2);
+    const auto reg = MIPSRegister::from_cpu_index( 5);
+    const auto first = map.rename( reg, 0).first;
+    const auto second = map.rename( reg, 1).first;
+    map.rename( reg, 1);
+    CHECK( map.lookup( reg, 0) == first);
+    CHECK( map.get_free_num() == 1);
+
+    // retirement checks the map of its own thread only
+    CHECK( !map.retire( second, 0));
+    CHECK( map.retire( first, 0));
+    CHECK( map.get_free_num() == 2);
+
+    map.reset( 1);
+    CHECK( map.lookup( reg, 1) == RenameMap<MIPSRegister>::IN_RF);
+    CHECK( map.get_free_num() == 4);
+}
+
+TEST_CASE( "PhysicalRF: ready cycle")
+{
+    PhysicalRF<uint32> rf( 2);
+    CHECK( !rf.is_ready( 0, 100_cl));
+    rf.write( 0, 42, 10_cl);
+    CHECK( !rf.is_ready( 0, 9_cl));
+    CHECK( rf.is_ready( 0, 10_cl));
+    CHECK( rf.read( 0) == 42);
+    rf.invalidate( 0);
+    CHECK( !rf.is_ready( 0, 100_cl));
+}
+
+TEST_CASE( "IssueQueues: unified")
+{
+    IssueQueues queues( "unified", 2);
+    queues.allocate( UNIT_ALU);
+    queues.allocate( UNIT_MEMORY);
+    CHECK( !queues.has_space( UNIT_BRANCH));
+    CHECK( queues.get_occupancy() == 2);
+    queues.release( UNIT_ALU);
+    CHECK( queues.has_space( UNIT_BRANCH));
+}
+
+TEST_CASE( "IssueQueues: distributed")
+{
+    IssueQueues queues( "distributed", 1);
+    queues.allocate( UNIT_ALU);
+    CHECK( !queues.has_space( UNIT_ALU));
+    CHECK( queues.has_space( UNIT_MEMORY));
+    queues.allocate( UNIT_MEMORY);
+    CHECK( queues.get_occupancy() == 2);
+    queues.clear();
+    CHECK( queues.get_occupancy() == 0);
+}
+
+TEST_CASE( "IssueQueues: invalid configuration")
+{
+    CHECK_THROWS_AS( IssueQueues( "centralized", 2), InvalidOOOConfiguration);
+    CHECK_THROWS_AS( IssueQueues( "unified", 0), InvalidOOOConfiguration);
+}
+
+TEST_CASE( "LoadStoreQueue: loads wait for older stores")
+{
+    LoadStoreQueue lsq( 4, false);
+    lsq.push( 1, true);
+    lsq.push( 2, false);
+    lsq.push( 3, false);
+    CHECK( lsq.get_occupancy() == 3);
+
+    // load address is unknown
+    CHECK( lsq.get_load_source( 2).status == LOAD_WAITS_FOR_ADDRESS);
+    lsq.set_address( 2, 0x100, 4);
+    // store address is unknown
+    CHECK( lsq.get_load_source( 2).status == LOAD_WAITS_FOR_ADDRESS);
+    CHECK( lsq.get_load_source( 2).store_id == 1);
+    lsq.set_address( 1, 0x102, 2, true);
+    // store covers only a half of the load
+    CHECK( lsq.get_load_source( 2).status == LOAD_WAITS_FOR_STORE);
+    lsq.set_address( 3, 0x104, 4);
+    CHECK( lsq.get_load_source( 3).status == LOAD_FROM_MEMORY);
+
+    lsq.erase( 1);
+    CHECK( lsq.get_load_source( 2).status == LOAD_FROM_MEMORY);
+}
+
+TEST_CASE( "LoadStoreQueue: store to load forwarding")
+{
+    LoadStoreQueue lsq( 4, false);
+    lsq.push( 1, true);
+    lsq.push( 2, true);
+    lsq.push( 3, false);
+    lsq.set_address( 1, 0x100, 8, true);
+    lsq.set_address( 2, 0x200, 4, false);
+    lsq.set_address( 3, 0x104, 2);
+    CHECK( lsq.get_load_source( 3).status == LOAD_FORWARDED);
+    CHECK( lsq.get_load_source( 3).store_id == 1);
+
+    // partial stores can not forward
+    lsq.set_address( 3, 0x200, 2);
+    CHECK( lsq.get_load_source( 3).status == LOAD_WAITS_FOR_STORE);
+    CHECK( lsq.get_load_source( 3).store_id == 2);
+}
+
+TEST_CASE( "LoadStoreQueue: speculative loads")
+{
+    LoadStoreQueue lsq( 4, true);
+    lsq.push( 1, true);
+    lsq.push( 2, true);
+    lsq.push( 3, false, 1);
+    lsq.push( 4, false);
+    lsq.set_address( 3, 0x100, 4);
+    lsq.set_address( 4, 0x200, 4);
+
+    // load 3 is predicted to depend on store 1
+    CHECK( lsq.get_load_source( 3).status == LOAD_WAITS_FOR_ADDRESS);
+    CHECK( lsq.get_load_source( 4).status == LOAD_FROM_MEMORY);
+    lsq.set_executed( 4, NO_VAL64);
+
+    lsq.set_address( 1, 0x300, 4, true);
+    CHECK( lsq.find_violation( 1) == NO_VAL64);
+    CHECK( lsq.get_load_source( 3).status == LOAD_FROM_MEMORY);
+
+    lsq.set_address( 2, 0x200, 4, true);
+    CHECK( lsq.find_violation( 2) == 4);
+}
+
+TEST_CASE( "LoadStoreQueue: forwarded load is not violated by older stores")
+{
+    LoadStoreQueue lsq( 4, true);
+    lsq.push( 1, true);
+    lsq.push( 2, true);
+    lsq.push( 3, false);
+    lsq.set_address( 2, 0x100, 4, true);
+    lsq.set_address( 3, 0x100, 4);
+    CHECK( lsq.get_load_source( 3).status == LOAD_FORWARDED);
+    lsq.set_executed( 3, 2);
+
+    lsq.set_address( 1, 0x100, 4, true);
+    CHECK( lsq.find_violation( 1) == NO_VAL64);
+}
+
+TEST_CASE( "LoadStoreQueue: squash")
+{
+    LoadStoreQueue lsq( 2, false);
+    lsq.push( 1, false);
+    lsq.push( 5, true);
+    CHECK( lsq.is_full());
+    lsq.squash( 1);
+    CHECK( lsq.get_occupancy() == 1);
+    lsq.clear();
+    CHECK( lsq.get_occupancy() == 0);
+}
+
+TEST_CASE( "StoreSets: load waits for the last store of its set")
+{
+    StoreSets sets( 1024, 128);
+    sets.dispatch_store( 0x1000, 1);
+    CHECK( sets.get_dependence( 0x2000) == NO_VAL64);
+
+    sets.train( 0x2000, 0x1000);
+    sets.dispatch_store( 0x1000, 2);
+    CHECK( sets.get_dependence( 0x2000) == 2);
+
+    // stores of the same set are merged
+    sets.train( 0x2000, 0x1004);
+    sets.dispatch_store( 0x1004, 3);
+    CHECK( sets.get_dependence( 0x2000) == 3);
+
+    sets.execute_store( 0x1004, 3);
+    CHECK( sets.get_dependence( 0x2000) == NO_VAL64);
+}
+
+TEST_CASE( "ForwardingMemory: store data over memory")
+{
+    auto memory = FuncMemory::create_4M_plain_memory();
+    memory->write<uint32, std::endian::little>( 0x11223344, 0x100);
+
+    ForwardingMemory view( *memory);
+    view.write<uint16, std::endian::little>( 0xaabb, 0x102);
+    CHECK( view.read<uint32, std::endian::little>( 0x100) == 0xaabb3344);
+    CHECK( memory->read<uint32, std::endian::little>( 0x100) == 0x11223344);
+}
+
+namespace Test {
+
+using OOOFuncInstr = BaseMIPSInstr<uint32>;
+using OOOInstr = PerfInstr<OOOFuncInstr>;
+
+/* Emulates fetch and writeback around the backend */
+class BackendTestingEnvironment : public Module {
+public:
+    using InstructionOutput = BypassedData<uint32>;
+
+    WritePort<OOOInstr>* wp_datapath = nullptr;
+    WritePort<bool>* wp_trap = nullptr;
+    WritePort<Target>* wp_trap_target = nullptr;
+    WritePort<InstructionOutput>* wp_retired = nullptr;
+
+    ReadPort<bool>* rp_stall = nullptr;
+    ReadPort<Target>* rp_decode_target = nullptr;
+    ReadPort<BPInterface>* rp_decode_bp_update = nullptr;
+    ReadPort<Target>* rp_flush_target = nullptr;
+    ReadPort<BPInterface>* rp_bp_update = nullptr;
+    ReadPort<OOOInstr>* rp_execute = nullptr;
+    ReadPort<OOOInstr>* rp_memory = nullptr;
+    ReadPort<OOOInstr>* rp_branch = nullptr;
+
+    explicit BackendTestingEnvironment( Module* parent) : Module( parent, "backend_testing_environment")
+    {
+        wp_datapath = make_write_port<OOOInstr>( "FETCH_2_DECODE", 4);
+        wp_trap = make_write_port<bool>( "WRITEBACK_2_ALL_FLUSH", Port::BW);
+        wp_trap_target = make_write_port<Target>( "WRITEBACK_2_FETCH_TARGET", Port::BW);
+        wp_retired = make_write_port<InstructionOutput>( "WRITEBACK_2_EXECUTE_BYPASS", 4);
+
+        rp_stall = make_read_port<bool>( "DECODE_2_FETCH_STALL", Port::LATENCY);
+        rp_decode_target = make_read_port<Target>( "DECODE_2_FETCH_TARGET", Port::LATENCY);
+        rp_decode_bp_update = make_read_port<BPInterface>( "DECODE_2_FETCH", Port::LATENCY);
+        rp_flush_target = make_read_port<Target>( "BRANCH_2_FETCH_TARGET", Port::LATENCY);
+        rp_bp_update = make_read_port<BPInterface>( "BRANCH_2_FETCH", Port::LATENCY);
+        rp_execute = make_read_port<OOOInstr>( "EXECUTE_2_WRITEBACK", Port::LATENCY);
+        rp_memory = make_read_port<OOOInstr>( "MEMORY_2_WRITEBACK", Port::LATENCY);
+        rp_branch = make_read_port<OOOInstr>( "BRANCH_2_WRITEBACK", Port::LATENCY);
+    }
+};
+
+struct BackendTester : public Root {
+    RF<OOOFuncInstr> rf;
+    std::shared_ptr<FuncMemory> memory = FuncMemory::create_4M_plain_memory();
+    Backend<OOOFuncInstr> backend;
+    BackendTestingEnvironment env;
+    std::vector<OOOInstr> written_back;
+    std::vector<Target> flush_targets;
+
+    explicit BackendTester( const PerfConfig& config) : Root( "backend_tester"), backend( this, config), env( this)
+    {
+        init_portmap();
+        backend.set_RF( &rf);
+        backend.set_memory( memory);
+    }
+
+    void fetch( const std::vector<uint32>& program, Cycle cycle)
+    {
+        Addr pc = 0x400000;
+        for ( size_t i = 0; i < program.size(); ++i, pc += 4) {
+            OOOInstr instr( OOOFuncInstr( MIPSVersion::v32, std::endian::little, program[i], pc), BPInterface( pc, false, pc + 4, false));
+            instr.set_sequence_id( i);
+            env.wp_datapath->write( std::move( instr), cycle);
+        }
+    }
+
+    void run( Cycle cycles)
+    {
+        for ( auto cycle = 1_cl; cycle < cycles; cycle.inc()) {
+            backend.clock( cycle);
+            for ( auto* port : { env.rp_execute, env.rp_memory, env.rp_branch})
+                while ( port->is_ready( cycle))
+                    written_back.emplace_back( port->read( cycle));
+
+            if ( env.rp_flush_target->is_ready( cycle))
+                flush_targets.emplace_back( env.rp_flush_target->read( cycle));
+        }
+    }
+};
+
+TEST_CASE( "Backend: store to load forwarding")
+{
+    PerfConfig config;
+    config.pipeline.width = 4;
+    config.pipeline.mem_ports = 2;
+    BackendTester t( config);
+    t.rf.write( MIPSRegister::from_cpu_index( 9), 0x1000);  // $t1
+    t.rf.write( MIPSRegister::from_cpu_index( 17), 42);     // $s1
+
+    // the first load misses in the data cache, so the store can not commit
+    t.fetch( { 0x8c0a0300,    // lw $t2, 0x300($zero)
+               0xad310100,    // sw $s1, 0x100($t1)
+               0x8d320100 },  // lw $s2, 0x100($t1)
+             0_cl);
+    t.run( 1000_cl);
+
+    REQUIRE( t.written_back.size() == 3);
+    CHECK( t.written_back.back().get_v_dst( 0) == 42);
+    CHECK( t.backend.get_statistics().forwarded_loads == 1);
+    CHECK( t.memory->read<uint32, std::endian::little>( 0x1100) == 42);
+}
+
+TEST_CASE( "Backend: trapped store is not forwarded")
+{
+    PerfConfig config;
+    config.pipeline.width = 4;
+    config.pipeline.mem_ports = 2;
+    BackendTester t( config);
+    t.rf.write( MIPSRegister::from_cpu_index( 9), 0x1000);  // $t1
+    t.rf.write( MIPSRegister::from_cpu_index( 17), 42);     // $s1
+
+    t.fetch( { 0x8c0a0300,    // lw $t2, 0x300($zero)
+               0xad310102,    // sw $s1, 0x102($t1), unaligned
+               0x85320102 },  // lh $s2, 0x102($t1)
+             0_cl);
+    t.run( 1000_cl);
+
+    CHECK( t.backend.get_statistics().forwarded_loads == 0);
+}
+
+TEST_CASE( "Backend: load passing a store is replayed")
+{
+    PerfConfig config;
+    config.pipeline.width = 4;
+    config.pipeline.mem_ports = 2;
+    config.ooo.memory_dependence = "aggressive";
+    BackendTester t( config);
+    t.memory->write<uint32, std::endian::little>( 0x1000, 0x200);
+    t.rf.write( MIPSRegister::from_cpu_index( 17), 42);     // $s1
+
+    t.fetch( { 0x8c090200,    // lw $t1, 0x200($zero)
+               0xad310100,    // sw $s1, 0x100($t1)
+               0x8c121100 },  // lw $s2, 0x1100($zero)
+             0_cl);
+    t.run( 1000_cl);
+
+    CHECK( t.backend.get_statistics().order_violations == 1);
+    CHECK( t.backend.get_statistics().replayed_instrs == 1);
+    REQUIRE( t.flush_targets.size() == 1);
+    CHECK( t.flush_targets.front().address == 0x400008);
+    CHECK( t.flush_targets.front().sequence_id == 2);
+}
+
+} // namespace Test
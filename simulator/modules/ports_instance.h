@@ -42,6 +42,7 @@ template<typename T> class PerfInstr;
 class MIPSRegister;
 class RISCVRegister;
 template<typename T> class BypassCommand;
+template<typename T> struct BypassedData;
 
 #define PORT_TOKEN(x) \
     extern template class PortQueue<std::pair<x, Cycle>>; \
@@ -17,6 +17,9 @@ public:
     	target = branch_target;
     	is_taken_branch = is_taken;
     }
+
+    static bool is_call() { return false; }
+    static bool is_return() { return false; }
 };
 
 inline std::ostream&
@@ -10,8 +10,9 @@
 #include <sstream>
 
 template <typename ISA>
-void Checker<ISA>::init( std::endian endian, Kernel* kernel, std::string_view isa)
+void Checker<ISA>::init( std::endian endian, Kernel* kernel, std::string_view isa, size_t thread)
 {
+    first_sequence_id = Target::get_first_sequence_id( thread);
     auto memory = FuncMemory::create_default_hierarchied_memory();
     sim = std::make_shared<FuncSim<ISA>>( endian, false, isa);
     sim->set_memory( memory);
@@ -40,7 +41,9 @@ void Checker<ISA>::check( const FuncInstr& instr)
     if (!active)
         return;
 
-    const auto func_dump = sim->step();
+    auto func_dump = sim->step();
+    /* drivers of functional simulator restart sequence ids from zero */
+    func_dump.set_sequence_id( first_sequence_id | func_dump.get_sequence_id());
 
     if ( func_dump.is_same_checker(instr))
         return;
@@ -25,12 +25,14 @@ class Checker {
 public:
     void disable() { active = false; }
     void check( const FuncInstr& instr);
-    void init( std::endian endian, Kernel* kernel, std::string_view isa);
+    // sequence ids of a hardware thread are compared without its number
+    void init( std::endian endian, Kernel* kernel, std::string_view isa, size_t thread = 0);
     void set_target( const Target& value);
     void driver_step( const FuncInstr& instr);
 private:
     std::shared_ptr<FuncSim<ISA>> sim;
     bool active = false;
+    uint64 first_sequence_id = 0;
 };
 
 #endif // CHECKER_H
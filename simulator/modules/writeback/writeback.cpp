@@ -2,28 +2,44 @@
 
 #include <kernel/kernel.h>
 
+#include <list>
+
 template <typename ISA>
-Writeback<ISA>::Writeback( Module* parent, std::endian endian) : Module( parent, "writeback"), endian( endian)
+Writeback<ISA>::Writeback( Module* parent, std::endian endian, const PerfConfig& config) : Module( parent, "writeback")
+    , endian( endian)
+    , threads( config.smt.threads)
 {
+    // branch, memory, simple and long ALUs may finish in the same cycle
+    const auto bandwidth = 3 * config.pipeline.width + config.pipeline.mem_ports;
+
     rp_mem_datapath = make_read_port<Instr>("MEMORY_2_WRITEBACK", Port::LATENCY);
     rp_execute_datapath = make_read_port<Instr>("EXECUTE_2_WRITEBACK", Port::LATENCY);
     rp_branch_datapath = make_read_port<Instr>("BRANCH_2_WRITEBACK", Port::LATENCY);
     rp_trap = make_read_port<bool>("WRITEBACK_2_ALL_FLUSH", Port::LATENCY);
 
-    wp_bypass = make_write_port<InstructionOutput>("WRITEBACK_2_EXECUTE_BYPASS", Port::BW);
-    wp_halt = make_write_port<Trap>("WRITEBACK_2_CORE_HALT", Port::BW);
-    wp_trap = make_write_port<bool>("WRITEBACK_2_ALL_FLUSH", Port::BW);
-    wp_target = make_write_port<Target>("WRITEBACK_2_FETCH_TARGET", Port::BW);
+    wp_bypass = make_write_port<InstructionOutput>("WRITEBACK_2_EXECUTE_BYPASS", bandwidth);
+    wp_halt = make_write_port<Trap>("WRITEBACK_2_CORE_HALT", bandwidth);
+    // all threads may be redirected before simulation
+    wp_trap = make_write_port<bool>("WRITEBACK_2_ALL_FLUSH", config.smt.threads);
+    wp_target = make_write_port<Target>("WRITEBACK_2_FETCH_TARGET", config.smt.threads);
 }
 
 template <typename ISA>
 Writeback<ISA>::~Writeback() = default;
 
 template <typename ISA>
-void Writeback<ISA>::set_kernel( const std::shared_ptr<Kernel>& k, std::string_view isa)
+void Writeback<ISA>::set_kernel( const std::shared_ptr<Kernel>& k, std::string_view isa, size_t thread)
+{
+    auto& context = threads.at( thread);
+    context.kernel = k;
+    context.checker.init( endian, context.kernel.get(), isa, thread);
+}
+
+template <typename ISA>
+void Writeback<ISA>::disable_checker()
 {
-    kernel = k;
-    checker.init( endian, kernel.get(), isa);
+    for ( auto& thread : threads)
+        thread.checker.disable();
 }
 
 template<typename ISA>
@@ -36,7 +52,9 @@ void Writeback<ISA>::set_target( const Target& value, Cycle cycle)
 template<typename ISA>
 void Writeback<ISA>::set_writeback_target( const Target& value, Cycle cycle)
 {
-    next_PC = value.address;
+    auto& thread = threads.at( value.get_thread());
+    thread.next_PC = value.address;
+    thread.has_flush = true;
     wp_trap->write( true, cycle);
     wp_target->write( value, cycle);
 }
@@ -44,19 +62,25 @@ void Writeback<ISA>::set_writeback_target( const Target& value, Cycle cycle)
 template<typename ISA>
 void Writeback<ISA>::set_checker_target( const Target& value)
 {
-    checker.set_target( value);
+    threads.at( value.get_thread()).checker.set_target( value);
 }
 
 template <typename ISA>
 auto Writeback<ISA>::read_instructions( Cycle cycle)
 {
     auto ports = { rp_branch_datapath, rp_mem_datapath, rp_execute_datapath };
-    std::vector<Instr> result;
+    // instructions are not assignable, so the list is sorted by relinking
+    std::list<Instr> result;
 
     for ( auto& port : ports)
-        if ( port->is_ready( cycle))
+        while ( port->is_ready( cycle))
             result.emplace_back( port->read( cycle));
 
+    /* units have different latencies, but instructions are written back in program order */
+    result.sort( []( const auto& lhs, const auto& rhs) {
+        return lhs.get_sequence_id() < rhs.get_sequence_id();
+    });
+
     return result;
 }
 
@@ -66,6 +90,7 @@ void Writeback<ISA>::clock( Cycle cycle)
     sout << "wb      cycle " << std::dec << cycle << ": ";
     if ( rp_trap->is_ready( cycle) && rp_trap->read( cycle)) {
         writeback_bubble( cycle);
+        retired_instrs.add( 0);
         return;
     }
 
@@ -73,19 +98,34 @@ void Writeback<ISA>::clock( Cycle cycle)
 
     if ( instrs.empty())
         writeback_bubble( cycle);
-    else for ( auto& instr : instrs)
-        writeback_instruction_system( &instr, cycle);
+
+    /* instructions younger than a trap are flushed */
+    for ( auto& thread : threads)
+        thread.has_flush = false;
+
+    size_t retired = 0;
+    for ( auto& instr : instrs) {
+        if ( get_thread( instr).has_flush)
+            continue;
+
+        ++retired;
+        if ( !writeback_instruction_system( &instr, cycle))
+            get_thread( instr).has_flush = true;
+    }
+
+    retired_instrs.add( retired);
 }
 
 template <typename ISA>
-void Writeback<ISA>::writeback_instruction_system( Writeback<ISA>::Instr* instr, Cycle cycle)
+bool Writeback<ISA>::writeback_instruction_system( Writeback<ISA>::Instr* instr, Cycle cycle)
 {
+    auto& thread = get_thread( *instr);
     writeback_instruction( *instr, cycle);
     bool has_syscall = instr->trap_type() == Trap::SYSCALL;
-    kernel->handle_instruction( instr);
-    auto result_trap = driver->handle_trap( *instr);
-    checker.driver_step( *instr);
-    if ( executed_instrs >= instrs_to_run)
+    thread.kernel->handle_instruction( instr);
+    auto result_trap = thread.driver->handle_trap( *instr);
+    thread.checker.driver_step( *instr);
+    if ( thread.executed_instrs >= instrs_to_run)
         wp_halt->write( Trap( Trap::BREAKPOINT), cycle);     
     else
         wp_halt->write( result_trap, cycle);
@@ -94,39 +134,50 @@ void Writeback<ISA>::writeback_instruction_system( Writeback<ISA>::Instr* instr,
         set_writeback_target( instr->get_actual_target(), cycle);
     else if ( result_trap != Trap::NO_TRAP)
         set_target( instr->get_actual_target(), cycle);
+
+    return !thread.has_flush && result_trap == Trap::NO_TRAP && thread.executed_instrs < instrs_to_run;
 }
 
 template <typename ISA>
 void Writeback<ISA>::writeback_bubble( Cycle cycle)
 {
     sout << "bubble\n";
-    if ( cycle >= last_writeback_cycle + 100_lt)
+
+    // Queues of lower memory levels have no fixed bound, so the timeout starts when memory is idle
+    if ( hierarchy != nullptr && hierarchy->has_outstanding_requests( cycle))
+        last_writeback_cycle = cycle;
+
+    if ( cycle >= last_writeback_cycle + deadlock_timeout)
         throw Deadlock( "");
 }
 
 template <typename ISA>
 void Writeback<ISA>::writeback_instruction( const Writeback<ISA>::Instr& instr, Cycle cycle)
 {
-    rf->write_dst( instr);
-    wp_bypass->write( instr.get_v_dst(), cycle);
+    auto& thread = get_thread( instr);
+    thread.rf->write_dst( instr);
+    wp_bypass->write( instr.get_bypassed_data(), cycle);
 
     sout << instr << std::endl;
 
-    checker.check( instr);
+    thread.checker.check( instr);
+    ++thread.executed_instrs;
     ++executed_instrs;
     last_writeback_cycle = cycle;
-    next_PC = instr.get_actual_target().address;
+    thread.next_PC = instr.get_actual_target().address;
 }
 
 template <typename ISA>
-int Writeback<ISA>::get_exit_code() const noexcept
+int Writeback<ISA>::get_exit_code( size_t thread) const noexcept
 {
-    return 0;
+    const auto& kernel = threads[thread].kernel;
+    return kernel != nullptr ? kernel->get_exit_code() : 0;
 }
 
 template <typename ISA>
-void Writeback<ISA>::enable_driver_hooks()
+void Writeback<ISA>::enable_driver_hooks( size_t thread)
 {
+    auto& driver = threads.at( thread).driver;
     driver = Driver::create_hooked_driver( driver.get());
 }
 
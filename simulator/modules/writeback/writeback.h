@@ -11,9 +11,14 @@
 #include <func_sim/driver/driver.h>
 #include <func_sim/operation.h>
 #include <infra/exception.h>
+#include <modules/core/perf_config.h>
 #include <modules/core/perf_instr.h>
+#include <modules/core/width_histogram.h>
+#include <modules/mem/memory_hierarchy.h>
 #include <modules/ports_instance.h>
 
+#include <vector>
+
 struct Deadlock final : Exception
 {
     explicit Deadlock(const std::string& msg)
@@ -29,25 +34,38 @@ class Writeback final : public Module
     using FuncInstr = typename ISA::FuncInstr;
     using Instr = PerfInstr<FuncInstr>;
     using RegisterUInt = typename ISA::RegisterUInt;
-    using InstructionOutput = std::array< RegisterUInt, MAX_DST_NUM>;
+    using InstructionOutput = BypassedData<RegisterUInt>;
 
 private:
+    // Architectural state of a hardware thread
+    struct Thread
+    {
+        uint64 executed_instrs = 0;
+        Addr next_PC = 0;
+        bool has_flush = false;
+        Checker<ISA> checker;
+        std::shared_ptr<Kernel> kernel;
+        std::unique_ptr<Driver> driver;
+        RF<FuncInstr>* rf = nullptr;
+    };
+
     /* Instrumentation */
-    uint64 instrs_to_run = 0;
+    uint64 instrs_to_run = 0; // each thread stops the core after this number of instructions
     uint64 executed_instrs = 0;
+    WidthHistogram retired_instrs;
     Cycle last_writeback_cycle = 0_cl;
-    Addr next_PC = 0;
+    Latency deadlock_timeout = 100_lt;
     const std::endian endian;
-    Checker<ISA> checker;
-    std::shared_ptr<Kernel> kernel;
-    std::unique_ptr<Driver> driver;
 
     /* Simulator internals */
-    RF<FuncInstr>* rf = nullptr;
+    std::vector<Thread> threads;
+    std::shared_ptr<const MemoryHierarchy> hierarchy = nullptr;
 
+    Thread& get_thread( const Instr& instr) { return threads.at( Target::get_thread( instr.get_sequence_id())); }
     auto read_instructions( Cycle cycle);
     void writeback_instruction( const Writeback<ISA>::Instr& instr, Cycle cycle);
-    void writeback_instruction_system( Writeback<ISA>::Instr* instr, Cycle cycle);
+    // returns false if younger instructions have to be flushed
+    bool writeback_instruction_system( Writeback<ISA>::Instr* instr, Cycle cycle);
     void writeback_bubble( Cycle cycle);
     void set_writeback_target( const Target& value, Cycle cycle);
     void set_checker_target( const Target& value);
@@ -65,7 +83,7 @@ private:
     WritePort<Target>* wp_target = nullptr;
 
 public:
-    Writeback( Module* parent, std::endian endian);
+    Writeback( Module* parent, std::endian endian, const PerfConfig& config);
 
     // Keep dtors in the same translation unit
     ~Writeback() final;
@@ -75,16 +93,20 @@ public:
     Writeback& operator=( Writeback&&) = delete;
 
     void clock( Cycle cycle);
-    void set_RF( RF<FuncInstr>* value) { rf = value; }
-    void disable_checker() { checker.disable(); }
+    void set_RF( RF<FuncInstr>* value, size_t thread = 0) { threads.at( thread).rf = value; }
+    void set_memory_hierarchy( std::shared_ptr<const MemoryHierarchy> value) { hierarchy = std::move( value); }
+    void disable_checker();
+    void disable_checker( size_t thread) { threads.at( thread).checker.disable(); }
     void set_target( const Target& value, Cycle cycle);
     void set_instrs_to_run( uint64 value) { instrs_to_run = value; }
     auto get_executed_instrs() const { return executed_instrs; }
-    Addr get_next_PC() const { return next_PC; }
-    int get_exit_code() const noexcept;
-    void set_kernel( const std::shared_ptr<Kernel>& k, std::string_view isa);
-    void set_driver( std::unique_ptr<Driver> d) { driver = std::move( d); }
-    void enable_driver_hooks();
+    auto get_executed_instrs( size_t thread) const { return threads.at( thread).executed_instrs; }
+    const auto& get_width_statistics() const { return retired_instrs; }
+    Addr get_next_PC( size_t thread = 0) const { return threads.at( thread).next_PC; }
+    int get_exit_code( size_t thread = 0) const noexcept;
+    void set_kernel( const std::shared_ptr<Kernel>& k, std::string_view isa, size_t thread = 0);
+    void set_driver( std::unique_ptr<Driver> d, size_t thread = 0) { threads.at( thread).driver = std::move( d); }
+    void enable_driver_hooks( size_t thread = 0);
 };
 
 #endif
@@ -92,6 +92,22 @@ template<typename I> const auto execute_div = RISCVMultALU<I>::template div<sign
 template<typename I> const auto execute_divu = RISCVMultALU<I>::template div<typename I::RegisterUInt>;
 template<typename I> const auto execute_rem = RISCVMultALU<I>::template rem<sign_t<typename I::RegisterUInt>>;
 template<typename I> const auto execute_remu = RISCVMultALU<I>::template rem<typename I::RegisterUInt>;
+// A
+template<typename I> const auto execute_lr = RISCVALU<I>::load_addr_aligned;
+template<typename I> const auto execute_sc = RISCVALU<I>::riscv_store_conditional;
+template<typename I> const auto execute_amoswap = RISCVALU<I>::template atomic<RISCVALU<I>::amo_swap>;
+template<typename I> const auto execute_amoadd = RISCVALU<I>::template atomic<RISCVALU<I>::amo_add>;
+template<typename I> const auto execute_amoxor = RISCVALU<I>::template atomic<RISCVALU<I>::amo_xor>;
+template<typename I> const auto execute_amoand = RISCVALU<I>::template atomic<RISCVALU<I>::amo_and>;
+template<typename I> const auto execute_amoor = RISCVALU<I>::template atomic<RISCVALU<I>::amo_or>;
+template<typename I> const auto execute_amomin_w = RISCVALU<I>::template atomic<RISCVALU<I>::template amo_min<uint32>>;
+template<typename I> const auto execute_amomax_w = RISCVALU<I>::template atomic<RISCVALU<I>::template amo_max<uint32>>;
+template<typename I> const auto execute_amominu_w = RISCVALU<I>::template atomic<RISCVALU<I>::template amo_minu<uint32>>;
+template<typename I> const auto execute_amomaxu_w = RISCVALU<I>::template atomic<RISCVALU<I>::template amo_maxu<uint32>>;
+template<typename I> const auto execute_amomin_d = RISCVALU<I>::template atomic<RISCVALU<I>::template amo_min<uint64>>;
+template<typename I> const auto execute_amomax_d = RISCVALU<I>::template atomic<RISCVALU<I>::template amo_max<uint64>>;
+template<typename I> const auto execute_amominu_d = RISCVALU<I>::template atomic<RISCVALU<I>::template amo_minu<uint64>>;
+template<typename I> const auto execute_amomaxu_d = RISCVALU<I>::template atomic<RISCVALU<I>::template amo_maxu<uint64>>;
 // B
 template<typename I> const auto execute_bfp = RISCVALU<I>::bit_field_place;
 template<typename I> const auto execute_clmul = RISCVALU<I>::template clmul<typename I::RegisterUInt>;
@@ -282,6 +298,29 @@ static const std::vector<RISCVTableEntry<I>> cmd_desc =
     {'M', instr_divu,       execute_divu<I>,   OUT_ARITHM, ' ', Imm::NO,    { Src::RS1,  Src::RS2 },  { Dst::RD },            0, 32 | 64 | 128}, // NOLINT(hicpp-signed-bitwise) https://bugs.llvm.org/show_bug.cgi?id=44977
     {'M', instr_rem,        execute_rem<I>,    OUT_ARITHM, ' ', Imm::NO,    { Src::RS1,  Src::RS2 },  { Dst::RD },            0, 32 | 64 | 128}, // NOLINT(hicpp-signed-bitwise) https://bugs.llvm.org/show_bug.cgi?id=44977
     {'M', instr_remu,       execute_remu<I>,   OUT_ARITHM, ' ', Imm::NO,    { Src::RS1,  Src::RS2 },  { Dst::RD },            0, 32 | 64 | 128}, // NOLINT(hicpp-signed-bitwise) https://bugs.llvm.org/show_bug.cgi?id=44977
+    /*-------------- A --------------*/
+    {'A', instr_lr_w,      execute_lr<I>,       OUT_LOAD_RESERVED,     ' ', Imm::NO,    { Src::RS1,  Src::ZERO },  { Dst::RD },           4, 32 | 64 | 128}, // NOLINT(hicpp-signed-bitwise) https://bugs.llvm.org/show_bug.cgi?id=44977
+    {'A', instr_sc_w,      execute_sc<I>,       OUT_STORE_CONDITIONAL, ' ', Imm::NO,    { Src::RS1,  Src::RS2 },   { Dst::RD },           4, 32 | 64 | 128}, // NOLINT(hicpp-signed-bitwise) https://bugs.llvm.org/show_bug.cgi?id=44977
+    {'A', instr_amoswap_w, execute_amoswap<I>,  OUT_ATOMIC,            ' ', Imm::NO,    { Src::RS1,  Src::RS2 },   { Dst::RD },           4, 32 | 64 | 128}, // NOLINT(hicpp-signed-bitwise) https://bugs.llvm.org/show_bug.cgi?id=44977
+    {'A', instr_amoadd_w,  execute_amoadd<I>,   OUT_ATOMIC,            ' ', Imm::NO,    { Src::RS1,  Src::RS2 },   { Dst::RD },           4, 32 | 64 | 128}, // NOLINT(hicpp-signed-bitwise) https://bugs.llvm.org/show_bug.cgi?id=44977
+    {'A', instr_amoxor_w,  execute_amoxor<I>,   OUT_ATOMIC,            ' ', Imm::NO,    { Src::RS1,  Src::RS2 },   { Dst::RD },           4, 32 | 64 | 128}, // NOLINT(hicpp-signed-bitwise) https://bugs.llvm.org/show_bug.cgi?id=44977
+    {'A', instr_amoand_w,  execute_amoand<I>,   OUT_ATOMIC,            ' ', Imm::NO,    { Src::RS1,  Src::RS2 },   { Dst::RD },           4, 32 | 64 | 128}, // NOLINT(hicpp-signed-bitwise) https://bugs.llvm.org/show_bug.cgi?id=44977
+    {'A', instr_amoor_w,   execute_amoor<I>,    OUT_ATOMIC,            ' ', Imm::NO,    { Src::RS1,  Src::RS2 },   { Dst::RD },           4, 32 | 64 | 128}, // NOLINT(hicpp-signed-bitwise) https://bugs.llvm.org/show_bug.cgi?id=44977
+    {'A', instr_amomin_w,  execute_amomin_w<I>, OUT_ATOMIC,            ' ', Imm::NO,    { Src::RS1,  Src::RS2 },   { Dst::RD },           4, 32 | 64 | 128}, // NOLINT(hicpp-signed-bitwise) https://bugs.llvm.org/show_bug.cgi?id=44977
+    {'A', instr_amomax_w,  execute_amomax_w<I>, OUT_ATOMIC,            ' ', Imm::NO,    { Src::RS1,  Src::RS2 },   { Dst::RD },           4, 32 | 64 | 128}, // NOLINT(hicpp-signed-bitwise) https://bugs.llvm.org/show_bug.cgi?id=44977
+    {'A', instr_amominu_w, execute_amominu_w<I>, OUT_ATOMIC,            ' ', Imm::NO,    { Src::RS1,  Src::RS2 },   { Dst::RD },           4, 32 | 64 | 128}, // NOLINT(hicpp-signed-bitwise) https://bugs.llvm.org/show_bug.cgi?id=44977
+    {'A', instr_amomaxu_w, execute_amomaxu_w<I>, OUT_ATOMIC,            ' ', Imm::NO,    { Src::RS1,  Src::RS2 },   { Dst::RD },           4, 32 | 64 | 128}, // NOLINT(hicpp-signed-bitwise) https://bugs.llvm.org/show_bug.cgi?id=44977
+    {'A', instr_lr_d,      execute_lr<I>,       OUT_LOAD_RESERVED,     ' ', Imm::NO,    { Src::RS1,  Src::ZERO },  { Dst::RD },           8,      64 | 128},
+    {'A', instr_sc_d,      execute_sc<I>,       OUT_STORE_CONDITIONAL, ' ', Imm::NO,    { Src::RS1,  Src::RS2 },   { Dst::RD },           8,      64 | 128},
+    {'A', instr_amoswap_d, execute_amoswap<I>,  OUT_ATOMIC,            ' ', Imm::NO,    { Src::RS1,  Src::RS2 },   { Dst::RD },           8,      64 | 128},
+    {'A', instr_amoadd_d,  execute_amoadd<I>,   OUT_ATOMIC,            ' ', Imm::NO,    { Src::RS1,  Src::RS2 },   { Dst::RD },           8,      64 | 128},
+    {'A', instr_amoxor_d,  execute_amoxor<I>,   OUT_ATOMIC,            ' ', Imm::NO,    { Src::RS1,  Src::RS2 },   { Dst::RD },           8,      64 | 128},
+    {'A', instr_amoand_d,  execute_amoand<I>,   OUT_ATOMIC,            ' ', Imm::NO,    { Src::RS1,  Src::RS2 },   { Dst::RD },           8,      64 | 128},
+    {'A', instr_amoor_d,   execute_amoor<I>,    OUT_ATOMIC,            ' ', Imm::NO,    { Src::RS1,  Src::RS2 },   { Dst::RD },           8,      64 | 128},
+    {'A', instr_amomin_d,  execute_amomin_d<I>, OUT_ATOMIC,            ' ', Imm::NO,    { Src::RS1,  Src::RS2 },   { Dst::RD },           8,      64 | 128},
+    {'A', instr_amomax_d,  execute_amomax_d<I>, OUT_ATOMIC,            ' ', Imm::NO,    { Src::RS1,  Src::RS2 },   { Dst::RD },           8,      64 | 128},
+    {'A', instr_amominu_d, execute_amominu_d<I>, OUT_ATOMIC,            ' ', Imm::NO,    { Src::RS1,  Src::RS2 },   { Dst::RD },           8,      64 | 128},
+    {'A', instr_amomaxu_d, execute_amomaxu_d<I>, OUT_ATOMIC,            ' ', Imm::NO,    { Src::RS1,  Src::RS2 },   { Dst::RD },           8,      64 | 128},
     /*-------------- C --------------*/
     // Breakpoint
     {'C', instr_c_ebreak,   execute_ebreak<I>, OUT_BREAK,  ' ',                       Imm::NO,       { Src::ZERO,     Src::ZERO },     { Dst::ZERO },     0, 32 | 64 | 128}, // NOLINT(hicpp-signed-bitwise) https://bugs.llvm.org/show_bug.cgi?id=44977
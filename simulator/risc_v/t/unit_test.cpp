@@ -395,3 +395,90 @@ TEST_CASE("RISCV ecall")
     instr.execute();
     CHECK( instr.trap_type() == Trap::SYSCALL);
 }
+
+TEST_CASE( "RISCV amoadd.w")
+{
+    auto memory = FuncMemory::create_default_hierarchied_memory();
+    memory->write<uint32, std::endian::little>( 0xffff'fffe, 0x1000);
+
+    RISCVInstr<uint64> instr( "amoadd_w", 0);
+    instr.set_v_src( 0x1000, 0);
+    instr.set_v_src( 3, 1);
+    instr.execute();
+    memory->load_store( &instr);
+    CHECK( instr.get_v_dst( 0) == 0xffff'ffff'ffff'fffe);
+    CHECK( memory->read<uint32, std::endian::little>( 0x1000) == 1);
+}
+
+TEST_CASE( "RISCV amomin.w/amomaxu.w")
+{
+    auto memory = FuncMemory::create_default_hierarchied_memory();
+    memory->write<uint32, std::endian::little>( 0xffff'fffe, 0x1000);
+
+    RISCVInstr<uint32> min( "amomin_w", 0);
+    RISCVInstr<uint32> maxu( "amomaxu_w", 0);
+    for ( auto* instr : { &min, &maxu }) {
+        instr->set_v_src( 0x1000, 0);
+        instr->set_v_src( 5, 1);
+        instr->execute();
+    }
+    memory->load_store( &min);
+    CHECK( memory->read<uint32, std::endian::little>( 0x1000) == 0xffff'fffe);
+    memory->load_store( &maxu);
+    CHECK( memory->read<uint32, std::endian::little>( 0x1000) == 0xffff'fffe);
+}
+
+TEST_CASE( "RISCV amoswap.d unaligned")
+{
+    RISCVInstr<uint64> instr( "amoswap_d", 0);
+    instr.set_v_src( 0x1004, 0);
+    instr.execute();
+    CHECK( instr.trap_type() == Trap::UNALIGNED_STORE);
+}
+
+TEST_CASE( "RISCV lr.w/sc.w")
+{
+    auto memory = FuncMemory::create_default_hierarchied_memory();
+    memory->write<uint32, std::endian::little>( 0x10, 0x1000);
+    Reservation reservation;
+
+    RISCVInstr<uint32> lr( "lr_w", 0);
+    RISCVInstr<uint32> sc( "sc_w", 0);
+    RISCVInstr<uint32> sc_again( "sc_w", 0);
+    for ( auto* instr : { &lr, &sc, &sc_again }) {
+        instr->set_v_src( 0x1000, 0);
+        instr->set_v_src( 0x20, 1);
+        instr->execute();
+    }
+
+    memory->load_store( &lr, &reservation);
+    CHECK( lr.get_v_dst( 0) == 0x10);
+    memory->load_store( &sc, &reservation);
+    CHECK( sc.get_v_dst( 0) == 0);
+    CHECK( memory->read<uint32, std::endian::little>( 0x1000) == 0x20);
+
+    // Reservation is consumed by the first store
+    memory->load_store( &sc_again, &reservation);
+    CHECK( sc_again.get_v_dst( 0) == 1);
+}
+
+TEST_CASE( "RISCV sc.w fails after a foreign store")
+{
+    auto memory = FuncMemory::create_default_hierarchied_memory();
+    memory->write<uint32, std::endian::little>( 0x10, 0x1000);
+    Reservation reservation;
+
+    RISCVInstr<uint32> lr( "lr_w", 0);
+    RISCVInstr<uint32> sc( "sc_w", 0);
+    for ( auto* instr : { &lr, &sc }) {
+        instr->set_v_src( 0x1000, 0);
+        instr->set_v_src( 0x20, 1);
+        instr->execute();
+    }
+
+    memory->load_store( &lr, &reservation);
+    memory->write<uint32, std::endian::little>( 0x11, 0x1000);
+    memory->load_store( &sc, &reservation);
+    CHECK( sc.get_v_dst( 0) == 1);
+    CHECK( memory->read<uint32, std::endian::little>( 0x1000) == 0x11);
+}
@@ -9,6 +9,7 @@
  
 // Simulators
 #include <func_sim/func_sim.h>
+#include <modules/core/ooo_perf_sim.h>
 #include <modules/core/perf_sim.h>
 
 // ISAs
@@ -34,8 +35,8 @@ void CPUModel::duplicate_all_registers_to( CPUModel* model) const
 
 class SimulatorFactory {
     struct Builder {
-        virtual std::unique_ptr<Simulator> get_funcsim( bool log) = 0;
-        virtual std::unique_ptr<CycleAccurateSimulator> get_perfsim() = 0;
+        virtual std::unique_ptr<BasicFuncSim> get_funcsim( bool log) = 0;
+        virtual std::unique_ptr<CycleAccurateSimulator> get_perfsim( const PerfConfig& config) = 0;
         Builder() = default;
         virtual ~Builder() = default;
         Builder( const Builder&) = delete;
@@ -49,8 +50,14 @@ class SimulatorFactory {
         const std::string isa;
         const std::endian e;
         TBuilder( std::string_view isa, std::endian e) : isa( isa), e( e) { }
-        std::unique_ptr<Simulator> get_funcsim( bool log) final { return std::make_unique<FuncSim<T>>( e, log, isa); }
-        std::unique_ptr<CycleAccurateSimulator> get_perfsim() final { return std::make_unique<PerfSim<T>>( e, isa); }
+        std::unique_ptr<BasicFuncSim> get_funcsim( bool log) final { return std::make_unique<FuncSim<T>>( e, log, isa); }
+        std::unique_ptr<CycleAccurateSimulator> get_perfsim( const PerfConfig& config) final
+        {
+            if ( config.ooo.enabled)
+                return std::make_unique<OOOPerfSim<T>>( e, isa, config);
+
+            return std::make_unique<PerfSim<T>>( e, isa, config);
+        }
     };
 
     std::map<std::string, std::unique_ptr<Builder>> map;
@@ -123,9 +130,9 @@ public:
         return get_factory( name)->get_funcsim( log);
     }
 
-    auto get_perfsim( const std::string& name) const
+    auto get_perfsim( const std::string& name, const PerfConfig& config) const
     {
-        return get_factory( name)->get_perfsim();
+        return get_factory( name)->get_perfsim( config);
     }
 };
 
@@ -136,12 +143,18 @@ Simulator::get_supported_isa()
 }
 
 std::shared_ptr<Simulator>
-Simulator::create_simulator( const std::string& isa, bool functional_only, bool log)
+Simulator::create_simulator( const std::string& isa, bool functional_only, bool log, const PerfConfig& config)
 {
     if ( functional_only)
         return SimulatorFactory::get_instance().get_funcsim( isa, log);
 
-    return CycleAccurateSimulator::create_simulator( isa);
+    return CycleAccurateSimulator::create_simulator( isa, config);
+}
+
+std::shared_ptr<Simulator>
+Simulator::create_simulator( const std::string& isa, bool functional_only, bool log)
+{
+    return create_simulator( isa, functional_only, log, PerfConfig::create_configured());
 }
 
 std::shared_ptr<Simulator>
@@ -162,9 +175,27 @@ Simulator::create_configured_isa_simulator( const std::string& isa)
     return create_simulator( isa, config::functional_only, config::disassembly_on);
 }
 
+std::shared_ptr<BasicFuncSim>
+BasicFuncSim::create_simulator( const std::string& isa, bool log)
+{
+    return SimulatorFactory::get_instance().get_funcsim( isa, log);
+}
+
+std::shared_ptr<BasicFuncSim>
+BasicFuncSim::create_configured_simulator()
+{
+    return create_simulator( config::isa, config::disassembly_on);
+}
+
+std::shared_ptr<CycleAccurateSimulator>
+CycleAccurateSimulator::create_simulator( const std::string& isa, const PerfConfig& config)
+{
+    return SimulatorFactory::get_instance().get_perfsim( isa, config);
+}
+
 std::shared_ptr<CycleAccurateSimulator>
 CycleAccurateSimulator::create_simulator( const std::string& isa)
 {
-    return SimulatorFactory::get_instance().get_perfsim( isa);
+    return create_simulator( isa, PerfConfig::create_configured());
 }
 
@@ -57,8 +57,11 @@ public:
     void duplicate_all_registers_to( CPUModel* model) const;
 };
 
+class CoherentCache;
 class FuncMemory;
 class Kernel;
+class ReadableMemory;
+struct PerfConfig;
 
 class Simulator : public CPUModel
 {
@@ -72,9 +75,14 @@ public:
     virtual int get_exit_code() const noexcept = 0;
     std::string_view get_isa() const final { return isa; }
 
+    // Hardware threads sharing the simulated core, the simulator itself controls the first one
+    virtual size_t get_threads_num() const { return 1; }
+    virtual std::shared_ptr<Simulator> get_thread( size_t /* index */) { return nullptr; }
+
     Trap run_no_limit() { return run( MAX_VAL64); }
 
     static std::vector<std::string> get_supported_isa();
+    static std::shared_ptr<Simulator> create_simulator( const std::string& isa, bool functional_only, bool log, const PerfConfig& config);
     static std::shared_ptr<Simulator> create_simulator( const std::string& isa, bool functional_only, bool log);
     static std::shared_ptr<Simulator> create_simulator( const std::string& isa, bool functional_only);
     static std::shared_ptr<Simulator> create_configured_simulator();
@@ -97,7 +105,20 @@ class CycleAccurateSimulator : public Simulator, public Root
 public:
     explicit CycleAccurateSimulator( std::string_view isa) : Simulator( isa), Root( "cpu") { }
     virtual void clock() = 0;
-    static std::shared_ptr<CycleAccurateSimulator> create_simulator(const std::string& isa);
+
+    // Allow to clock the model externally: 'run' is 'start' and 'clock' until a trap
+    virtual void start( uint64 instrs_to_run) = 0;
+    virtual Trap get_trap() const = 0;
+    virtual void dump_statistics() const = 0;
+
+    // Private data cache kept coherent with caches of other cores
+    virtual void set_coherent_cache( std::shared_ptr<CoherentCache> cache) = 0;
+
+    // Instruction fetch reads memory set by 'set_memory' unless another view is set after it
+    virtual void set_instruction_memory( std::shared_ptr<ReadableMemory> memory) = 0;
+
+    static std::shared_ptr<CycleAccurateSimulator> create_simulator( const std::string& isa, const PerfConfig& config);
+    static std::shared_ptr<CycleAccurateSimulator> create_simulator( const std::string& isa);
 };
 
 #endif // SIMULATOR_H